@@ -20,7 +20,9 @@
 #include <IconsLucide.h>
 
 #include <CoffeeEngine/Scripting/Script.h>
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <glm/fwd.hpp>
@@ -222,14 +224,22 @@ namespace Coffee {
 
             if(ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen))
             {
+                bool transformChanged = false;
+
                 ImGui::Text("Position");
-                ImGui::DragFloat3("##Position", glm::value_ptr(transformComponent.Position), 0.1f);
+                transformChanged |= ImGui::DragFloat3("##Position", glm::value_ptr(transformComponent.Position), 0.1f);
 
                 ImGui::Text("Rotation");
-                ImGui::DragFloat3("##Rotation", glm::value_ptr(transformComponent.Rotation),  0.1f);
+                transformChanged |= ImGui::DragFloat3("##Rotation", glm::value_ptr(transformComponent.Rotation),  0.1f);
 
                 ImGui::Text("Scale");
-                ImGui::DragFloat3("##Scale", glm::value_ptr(transformComponent.Scale),  0.1f);
+                transformChanged |= ImGui::DragFloat3("##Scale", glm::value_ptr(transformComponent.Scale),  0.1f);
+
+                // Only the dirty transforms are recomputed by the scene tree
+                if(transformChanged)
+                {
+                    entity.PatchComponent<TransformComponent>();
+                }
             }
         }
 
@@ -335,6 +345,41 @@ namespace Coffee {
                     ImGui::Text("Attenuation");
                     ImGui::DragFloat("##Attenuation", &lightComponent.Attenuation, 0.1f);
                 }
+
+                if(lightComponent.type == LightComponent::Type::SpotLight)
+                {
+                    ImGui::Text("Angle");
+                    ImGui::DragFloat("##Angle", &lightComponent.Angle, 0.1f, 1.0f, 85.0f);
+                }
+
+                ImGui::Checkbox("Cast Shadows", &lightComponent.CastShadows);
+
+                if(lightComponent.CastShadows)
+                {
+                    if(lightComponent.type == LightComponent::Type::DirectionalLight)
+                    {
+                        ImGui::Text("Cascades");
+                        ImGui::SliderInt("##Cascades", &lightComponent.ShadowCascadeCount, 1, 4);
+
+                        ImGui::Text("Shadow Distance");
+                        ImGui::DragFloat("##Shadow Distance", &lightComponent.ShadowDistance, 0.5f, 1.0f, 1000.0f);
+                    }
+
+                    ImGui::Text("Shadow Resolution");
+                    const char* resolutions[] = { "256", "512", "1024", "2048", "4096" };
+                    int resolutionIndex = std::clamp(static_cast<int>(std::log2(lightComponent.ShadowResolution)) - 8, 0, 4);
+                    if(ImGui::Combo("##Shadow Resolution", &resolutionIndex, resolutions, IM_ARRAYSIZE(resolutions)))
+                    {
+                        lightComponent.ShadowResolution = 256u << resolutionIndex;
+                    }
+
+                    ImGui::Text("Update Interval (frames)");
+                    ImGui::SliderInt("##Update Interval", &lightComponent.ShadowUpdateInterval, 1, 30);
+
+                    ImGui::Text("Shadow Bias");
+                    ImGui::DragFloat("##Shadow Bias", &lightComponent.ShadowBias, 0.0001f, 0.0f, 0.1f, "%.4f");
+                }
+
                 if(!isCollapsingHeaderOpen)
                 {
                     entity.RemoveComponent<LightComponent>();
@@ -359,34 +404,42 @@ namespace Coffee {
                     if(ImGui::MenuItem("Quad"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateQuad();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Cube"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateCube();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Sphere"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateSphere();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Plane"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreatePlane();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Cylinder"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateCylinder();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Cone"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateCone();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Torus"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateTorus();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Capsule"))
                     {
                         meshComponent.mesh = PrimitiveMesh::CreateCapsule();
+                        entity.PatchComponent<MeshComponent>();
                     }
                     if(ImGui::MenuItem("Save Mesh"))
                     {
@@ -395,6 +448,13 @@ namespace Coffee {
                     ImGui::EndPopup();
                 }
                 ImGui::Checkbox("Draw AABB", &meshComponent.drawAABB);
+                // The render proxy of the mesh is only updated when the component is patched
+                bool shadowFlagsChanged = ImGui::Checkbox("Cast Shadows", &meshComponent.castShadows);
+                shadowFlagsChanged |= ImGui::Checkbox("Static", &meshComponent.isStatic);
+                if(shadowFlagsChanged)
+                {
+                    entity.PatchComponent<MeshComponent>();
+                }
 
                 if(!isCollapsingHeaderOpen)
                 {
@@ -5,27 +5,35 @@
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Core/FileDialog.h"
 #include "CoffeeEngine/Core/Input.h"
+#include "CoffeeEngine/Core/JobSystem.h"
 #include "CoffeeEngine/Core/Log.h"
 #include "CoffeeEngine/Core/MouseCodes.h"
+#include "CoffeeEngine/Core/SystemInfo.h"
 #include "CoffeeEngine/Events/ApplicationEvent.h"
 #include "CoffeeEngine/Events/KeyEvent.h"
 #include "CoffeeEngine/IO/ResourceLoader.h"
 #include "CoffeeEngine/IO/ResourceRegistry.h"
 #include "CoffeeEngine/IO/ResourceUtils.h"
 #include "CoffeeEngine/Project/Project.h"
+#include "CoffeeEngine/Renderer/CullingService.h"
 #include "CoffeeEngine/Renderer/DebugRenderer.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
 #include "CoffeeEngine/Renderer/Renderer.h"
+#include "CoffeeEngine/Renderer/ShadowRenderer.h"
 #include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/EntityPool.h"
+#include "CoffeeEngine/Scene/Prefab.h"
 #include "CoffeeEngine/Scene/PrimitiveMesh.h"
 #include "CoffeeEngine/Scene/Scene.h"
 #include "CoffeeEngine/Scene/SceneCamera.h"
 #include "CoffeeEngine/Scene/SceneTree.h"
+#include "CoffeeEngine/Scene/WorldPartition.h"
 #include "Panels/SceneTreePanel.h"
 #include "entt/entity/entity.hpp"
 #include "imgui_internal.h"
 
 #include <ImGuizmo.h>
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <glm/fwd.hpp>
@@ -41,6 +49,10 @@ namespace Coffee {
 
     static RendererStats s_RendererData;
 
+    static bool s_DrawSpatialIndex = false;
+    static float s_SectorSize = 128.0f;
+    static float s_AutosaveInterval = 0.0f; // Seconds between autosaves, 0 disables them
+
     EditorLayer::EditorLayer() : Layer("Example")
     {
 
@@ -78,6 +90,25 @@ namespace Coffee {
             break;
 
         }
+
+        if(m_SaveTask and m_SaveTask->IsDone())
+        {
+            if(m_SaveTask->Succeeded())
+                COFFEE_INFO("Scene saved to {0}", m_SaveTask->GetPath().string());
+            else
+                COFFEE_ERROR("Scene could not be saved to {0}", m_SaveTask->GetPath().string());
+
+            m_SaveTask.reset();
+        }
+
+        // The autosave writes the edited scene over its file, the scenes that were never saved have no file yet
+        m_TimeSinceAutosave += dt;
+        if(s_AutosaveInterval > 0.0f and m_TimeSinceAutosave >= s_AutosaveInterval and !m_SaveTask and
+           m_SceneState == SceneState::Edit and !m_EditorScene->m_FilePath.empty())
+        {
+            m_TimeSinceAutosave = 0.0f;
+            m_SaveTask = Scene::SaveAsync(m_EditorScene->m_FilePath, m_EditorScene);
+        }
     }
 
     void EditorLayer::OnEvent(Coffee::Event& event)
@@ -183,6 +214,9 @@ namespace Coffee {
         ZoneScoped;
 
         m_ActiveScene->OnExitEditor();
+
+        if(m_SaveTask)
+            m_SaveTask->Wait();
     }
 
     void EditorLayer::OnImGuiRender()
@@ -475,10 +509,37 @@ namespace Coffee {
         //---------TESTING---------
         ImGui::Begin("Render Settings");
 
+        const char* renderPaths[] = { "Forward", "Deferred" };
+        int currentRenderPath = static_cast<int>(Renderer::GetRenderSettings().Path);
+        if (ImGui::Combo("Render Path", &currentRenderPath, renderPaths, IM_ARRAYSIZE(renderPaths)))
+        {
+            Renderer::GetRenderSettings().Path = static_cast<RenderPath>(currentRenderPath);
+        }
+
         ImGui::Checkbox("Post Processing", &Renderer::GetRenderSettings().PostProcessing);
 
         ImGui::DragFloat("Exposure", &Renderer::GetRenderSettings().Exposure, 0.001f, 100.0f);
 
+        const ShadowStats& shadowStats = ShadowRenderer::GetStats();
+        ImGui::Text("Shadow Views: %u (static renders: %u, dynamic renders: %u)", shadowStats.Views, shadowStats.StaticRenders, shadowStats.DynamicRenders);
+
+        ImGui::Checkbox("Parallel Transform Update", &SceneTree::GetSettings().ParallelUpdate);
+        ImGui::Checkbox("Parallel Culling", &CullingService::GetSettings().Parallel);
+        ImGui::Checkbox("Coherent Culling", &CullingService::GetSettings().Coherent);
+
+        // The pool is restarted once the slider is released, the save in progress finishes first
+        static int workerThreads = static_cast<int>(JobSystem::GetThreadCount());
+        ImGui::SliderInt("Worker Threads", &workerThreads, 1, static_cast<int>(std::max(SystemInfo::GetLogicalProcessorCount(), 1u)));
+        if (ImGui::IsItemDeactivatedAfterEdit() && static_cast<uint32_t>(workerThreads) != JobSystem::GetThreadCount())
+        {
+            if (m_SaveTask)
+                m_SaveTask->Wait();
+
+            JobSystem::GetSettings().ThreadCount = static_cast<uint32_t>(workerThreads);
+            JobSystem::Shutdown();
+            JobSystem::Init();
+        }
+
         ImGui::End();
 
         // Debug Window for testing the ResourceRegistry
@@ -526,16 +587,120 @@ namespace Coffee {
         
         ImGui::End();
 
-        //Debug Scene Octree
-        ImGui::Begin("Octree Debug");
-        if(ImGui::Button("Clear Octree"))
+        //Debug Scene Spatial Index
+        const DynamicAABBTree& spatialIndex = m_ActiveScene->GetRenderWorld().GetSpatialIndex();
+        ImGui::Begin("Spatial Index Debug");
+        ImGui::Text("Objects: %u", spatialIndex.GetObjectCount());
+        ImGui::Text("Height: %d", spatialIndex.GetHeight());
+        ImGui::Checkbox("Draw Bounds", &s_DrawSpatialIndex);
+        ImGui::End();
+
+        WorldPartition& worldPartition = m_ActiveScene->GetWorldPartition();
+        WorldPartitionSettings& partitionSettings = WorldPartition::GetSettings();
+        ImGui::Begin("World Partition");
+        if(worldPartition.IsOpen())
         {
-            m_ActiveScene->m_Octree.Clear();
+            ImGui::Text("Sectors: %u (loaded: %u)", worldPartition.GetSectorCount(), worldPartition.GetLoadedSectorCount());
         }
-        if(ImGui::Button("Add Point"))
+        ImGui::DragFloat("Load Distance", &partitionSettings.LoadDistance, 1.0f, 0.0f, 100000.0f);
+        ImGui::DragFloat("Unload Distance", &partitionSettings.UnloadDistance, 1.0f, partitionSettings.LoadDistance, 100000.0f);
+        ImGui::DragFloat("Sector Size", &s_SectorSize, 1.0f, 1.0f, 100000.0f);
+
+        // The sectors are written next to the scene file and the scene file is saved without them, so it needs a path
+        ImGui::BeginDisabled(m_ActiveScene->m_FilePath.empty() || m_SceneState != SceneState::Edit);
+        if(ImGui::Button("Build Sectors"))
         {
-            //m_ActiveScene->m_Octree.Insert({{rand() % 20 - 10, rand() % 20 - 10, rand() % 20 - 10}});
+            worldPartition.Build(m_ActiveScene->m_FilePath, s_SectorSize);
         }
+        ImGui::EndDisabled();
+        ImGui::End();
+
+        ImGui::Begin("Entity Pools");
+        for(auto& [prefab, pool] : m_ActiveScene->GetEntityPools())
+        {
+            const EntityPoolStats& stats = pool->GetStats();
+            ImGui::PushID(prefab);
+            ImGui::Text("%u nodes: %u/%u active, %u grows", prefab->GetNodeCount(), stats.Active, stats.Capacity, stats.Grows);
+            ImGui::Text("Spawns: %llu, Despawns: %llu", (unsigned long long)stats.Spawns, (unsigned long long)stats.Despawns);
+            int growSize = (int)pool->GetGrowSize();
+            if(ImGui::DragInt("Grow Size", &growSize, 1.0f, 1, 4096))
+            {
+                pool->SetGrowSize((uint32_t)growSize);
+            }
+            ImGui::Separator();
+            ImGui::PopID();
+        }
+        ImGui::End();
+
+        // The systems of a level run at the same time, each one waits for the systems its arrows come from
+        SystemScheduler& scheduler = m_ActiveScene->GetSystemScheduler();
+        const std::vector<ScheduledSystem>& systems = scheduler.GetSystems();
+        ImGui::Begin("System Scheduler");
+        ImGui::Text("Systems: %zu, Levels: %u, Last Run: %.3f ms", systems.size(), scheduler.GetLevelCount(), scheduler.GetLastTime());
+        if(ImGui::BeginTable("Systems", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("System");
+            ImGui::TableSetupColumn("Level");
+            ImGui::TableSetupColumn("Thread");
+            ImGui::TableSetupColumn("Time (ms)");
+            ImGui::TableHeadersRow();
+            for(const ScheduledSystem& system : systems)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(system.Name.c_str());
+                ImGui::TableNextColumn(); ImGui::Text("%u", system.Level);
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(system.Flags & SystemFlags::MainThread ? "Main" : "Worker");
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", system.LastTime);
+            }
+            ImGui::EndTable();
+        }
+
+        if(ImGui::CollapsingHeader("Execution Graph"))
+        {
+            const ImVec2 nodeSize(120.0f, 22.0f);
+            const ImVec2 spacing(40.0f, 8.0f);
+            const ImVec2 origin = ImGui::GetCursorScreenPos();
+            ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+            std::vector<ImVec2> positions(systems.size());
+            std::vector<uint32_t> levelRows(scheduler.GetLevelCount(), 0);
+            float height = 0.0f;
+            for(size_t i = 0; i < systems.size(); i++)
+            {
+                uint32_t row = levelRows[systems[i].Level]++;
+                positions[i] = ImVec2(origin.x + systems[i].Level * (nodeSize.x + spacing.x), origin.y + row * (nodeSize.y + spacing.y));
+                height = std::max(height, (row + 1) * (nodeSize.y + spacing.y));
+            }
+
+            for(size_t i = 0; i < systems.size(); i++)
+            {
+                for(uint32_t dependency : systems[i].Dependencies)
+                {
+                    ImVec2 from(positions[dependency].x + nodeSize.x, positions[dependency].y + nodeSize.y * 0.5f);
+                    ImVec2 to(positions[i].x, positions[i].y + nodeSize.y * 0.5f);
+                    drawList->AddLine(from, to, IM_COL32(150, 150, 150, 255));
+                }
+            }
+
+            for(size_t i = 0; i < systems.size(); i++)
+            {
+                ImVec2 max(positions[i].x + nodeSize.x, positions[i].y + nodeSize.y);
+                ImU32 color = systems[i].Flags & SystemFlags::MainThread ? IM_COL32(120, 80, 50, 255) : IM_COL32(50, 100, 120, 255);
+                drawList->AddRectFilled(positions[i], max, color, 4.0f);
+                drawList->AddText(ImVec2(positions[i].x + 4.0f, positions[i].y + 4.0f), IM_COL32_WHITE, systems[i].Name.c_str());
+            }
+
+            ImGui::Dummy(ImVec2(scheduler.GetLevelCount() * (nodeSize.x + spacing.x), height));
+        }
+        ImGui::End();
+
+        ImGui::Begin("Scene Saving");
+        if(m_SaveTask)
+        {
+            ImGui::Text("Saving %s", m_SaveTask->GetPath().filename().string().c_str());
+            ImGui::ProgressBar(m_SaveTask->GetProgress());
+        }
+        ImGui::DragFloat("Autosave Interval", &s_AutosaveInterval, 1.0f, 0.0f, 3600.0f, s_AutosaveInterval > 0.0f ? "%.0f s" : "Disabled");
         ImGui::End();
     }
 
@@ -576,6 +741,11 @@ namespace Coffee {
 
         }
 
+        if(s_DrawSpatialIndex)
+        {
+            m_ActiveScene->GetRenderWorld().GetSpatialIndex().DebugDraw();
+        }
+
         auto view = m_ActiveScene->GetAllEntitiesWithComponents<LightComponent, TransformComponent>();
 
         for(auto entity : view)
@@ -640,17 +810,10 @@ namespace Coffee {
 
     void EditorLayer::OnScenePlay()
     {
-        if(m_ActiveScene->m_FilePath.empty())
-        {
-            COFFEE_ERROR("Scene is not saved! Please save the scene before playing.");
-            return;
-        }
-
         m_SceneState = SceneState::Play;
 
-        Scene::Save(m_EditorScene->m_FilePath, m_EditorScene);
-
-        m_ActiveScene = Scene::Load(m_ActiveScene->m_FilePath);
+        // The runtime plays a copy, stopping switches back to the edited scene as it was
+        m_ActiveScene = Scene::Copy(m_EditorScene);
         m_ActiveScene->OnInitRuntime();
 
         m_SceneTreePanel.SetContext(m_ActiveScene);
@@ -732,10 +895,10 @@ namespace Coffee {
     void EditorLayer::OpenScene()
     {
         FileDialogArgs args;
-        args.Filters = {{"Coffee Scene", "TeaScene"}};
+        args.Filters = {{"Coffee Scene", "TeaScene,TeaSceneBin"}};
         const std::filesystem::path& path = FileDialog::OpenFile(args);
 
-        if (!path.empty() and path.extension() == ".TeaScene")
+        if (!path.empty() and (path.extension() == ".TeaScene" or path.extension() == ".TeaSceneBin"))
         {
             m_EditorScene = Scene::Load(path);
             m_ActiveScene = m_EditorScene;
@@ -755,12 +918,17 @@ namespace Coffee {
     void EditorLayer::SaveScene()
     {
         FileDialogArgs args;
-        args.Filters = {{"Coffee Scene", "TeaScene"}};
+        args.Filters = {{"Coffee Scene", "TeaScene"}, {"Coffee Binary Scene", "TeaSceneBin"}};
         const std::filesystem::path& path = FileDialog::SaveFile(args);
 
         if (!path.empty())
         {
-            Scene::Save(path, m_ActiveScene);
+            // Two saves of the same file would write the same temporary file
+            if (m_SaveTask)
+                m_SaveTask->Wait();
+
+            m_SaveTask = Scene::SaveAsync(path, m_ActiveScene);
+            m_TimeSinceAutosave = 0.0f;
         }
         else
         {
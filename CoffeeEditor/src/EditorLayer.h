@@ -6,6 +6,7 @@
 #include "CoffeeEngine/Events/KeyEvent.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
 #include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneSaveTask.h"
 #include "Panels/ContentBrowserPanel.h"
 #include "Panels/MonitorPanel.h"
 #include "Panels/SceneTreePanel.h"
@@ -57,6 +58,9 @@ namespace Coffee {
         Ref<Scene> m_EditorScene;
         Ref<Scene> m_ActiveScene;
 
+        Ref<SceneSaveTask> m_SaveTask; ///< The save running in the background, if any.
+        float m_TimeSinceAutosave = 0.0f;
+
         EditorCamera m_EditorCamera;
 
         enum class SceneState
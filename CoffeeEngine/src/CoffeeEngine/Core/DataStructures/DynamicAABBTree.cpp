@@ -0,0 +1,396 @@
+#include "CoffeeEngine/Core/DataStructures/DynamicAABBTree.h"
+#include "CoffeeEngine/Math/Frustum.h"
+#include "CoffeeEngine/Renderer/DebugRenderer.h"
+
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    static AABB Union(const AABB& a, const AABB& b)
+    {
+        return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+    }
+
+    static float SurfaceArea(const AABB& aabb)
+    {
+        glm::vec3 size = aabb.max - aabb.min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    static bool Encloses(const AABB& outer, const AABB& inner)
+    {
+        return glm::all(glm::lessThanEqual(outer.min, inner.min)) && glm::all(glm::greaterThanEqual(outer.max, inner.max));
+    }
+
+    static bool Overlaps(const AABB& a, const AABB& b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+    }
+
+    DynamicAABBTree::DynamicAABBTree(float margin) : m_Margin(margin)
+    {
+    }
+
+    int32_t DynamicAABBTree::AllocateNode()
+    {
+        if (m_FreeList == NullNode)
+        {
+            m_Nodes.emplace_back();
+            return static_cast<int32_t>(m_Nodes.size()) - 1;
+        }
+
+        int32_t node = m_FreeList;
+        m_FreeList = m_Nodes[node].Parent;
+        m_Nodes[node] = Node();
+        return node;
+    }
+
+    void DynamicAABBTree::FreeNode(int32_t node)
+    {
+        m_Nodes[node].Parent = m_FreeList;
+        m_Nodes[node].Height = -1;
+        m_FreeList = node;
+    }
+
+    void DynamicAABBTree::Insert(uint32_t id, const AABB& bounds)
+    {
+        auto it = m_Leaves.find(id);
+        if (it != m_Leaves.end())
+        {
+            Move(id, bounds);
+            return;
+        }
+
+        int32_t leaf = AllocateNode();
+        m_Nodes[leaf].Bounds = AABB(bounds.min - glm::vec3(m_Margin), bounds.max + glm::vec3(m_Margin));
+        m_Nodes[leaf].Id = id;
+
+        InsertLeaf(leaf);
+        m_Leaves[id] = leaf;
+        m_Version++;
+    }
+
+    void DynamicAABBTree::Remove(uint32_t id)
+    {
+        auto it = m_Leaves.find(id);
+        if (it == m_Leaves.end())
+            return;
+
+        RemoveLeaf(it->second);
+        FreeNode(it->second);
+        m_Leaves.erase(it);
+        m_Version++;
+    }
+
+    bool DynamicAABBTree::Move(uint32_t id, const AABB& bounds)
+    {
+        auto it = m_Leaves.find(id);
+        if (it == m_Leaves.end())
+        {
+            Insert(id, bounds);
+            return true;
+        }
+
+        int32_t leaf = it->second;
+        if (Encloses(m_Nodes[leaf].Bounds, bounds))
+            return false;
+
+        RemoveLeaf(leaf);
+        m_Nodes[leaf].Bounds = AABB(bounds.min - glm::vec3(m_Margin), bounds.max + glm::vec3(m_Margin));
+        InsertLeaf(leaf);
+        m_Version++;
+        return true;
+    }
+
+    void DynamicAABBTree::Clear()
+    {
+        m_Nodes.clear();
+        m_Leaves.clear();
+        m_Root = NullNode;
+        m_FreeList = NullNode;
+        m_Version++;
+    }
+
+    void DynamicAABBTree::InsertLeaf(int32_t leaf)
+    {
+        if (m_Root == NullNode)
+        {
+            m_Root = leaf;
+            m_Nodes[leaf].Parent = NullNode;
+            return;
+        }
+
+        // Descend to the sibling that makes the tree grow the least in surface area
+        const AABB leafBounds = m_Nodes[leaf].Bounds;
+        int32_t sibling = m_Root;
+        while (!m_Nodes[sibling].IsLeaf())
+        {
+            const Node& node = m_Nodes[sibling];
+
+            float area = SurfaceArea(node.Bounds);
+            float combinedArea = SurfaceArea(Union(node.Bounds, leafBounds));
+
+            // Cost of pairing the leaf with this node, and the minimum cost pushed down to its children
+            float cost = 2.0f * combinedArea;
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto childCost = [&](int32_t child) {
+                const AABB& childBounds = m_Nodes[child].Bounds;
+                float unionArea = SurfaceArea(Union(childBounds, leafBounds));
+                return m_Nodes[child].IsLeaf() ? unionArea + inheritanceCost
+                                               : unionArea - SurfaceArea(childBounds) + inheritanceCost;
+            };
+
+            float leftCost = childCost(node.Left);
+            float rightCost = childCost(node.Right);
+
+            if (cost < leftCost && cost < rightCost)
+                break;
+
+            sibling = leftCost < rightCost ? node.Left : node.Right;
+        }
+
+        int32_t oldParent = m_Nodes[sibling].Parent;
+        int32_t newParent = AllocateNode();
+        m_Nodes[newParent].Parent = oldParent;
+        m_Nodes[newParent].Bounds = Union(leafBounds, m_Nodes[sibling].Bounds);
+        m_Nodes[newParent].Height = m_Nodes[sibling].Height + 1;
+        m_Nodes[newParent].Left = sibling;
+        m_Nodes[newParent].Right = leaf;
+        m_Nodes[sibling].Parent = newParent;
+        m_Nodes[leaf].Parent = newParent;
+
+        if (oldParent == NullNode)
+        {
+            m_Root = newParent;
+        }
+        else if (m_Nodes[oldParent].Left == sibling)
+        {
+            m_Nodes[oldParent].Left = newParent;
+        }
+        else
+        {
+            m_Nodes[oldParent].Right = newParent;
+        }
+
+        RefitAncestors(m_Nodes[leaf].Parent);
+    }
+
+    void DynamicAABBTree::RemoveLeaf(int32_t leaf)
+    {
+        if (leaf == m_Root)
+        {
+            m_Root = NullNode;
+            return;
+        }
+
+        int32_t parent = m_Nodes[leaf].Parent;
+        int32_t grandParent = m_Nodes[parent].Parent;
+        int32_t sibling = m_Nodes[parent].Left == leaf ? m_Nodes[parent].Right : m_Nodes[parent].Left;
+
+        // The sibling takes the place of the parent
+        if (grandParent == NullNode)
+        {
+            m_Root = sibling;
+            m_Nodes[sibling].Parent = NullNode;
+        }
+        else
+        {
+            if (m_Nodes[grandParent].Left == parent)
+                m_Nodes[grandParent].Left = sibling;
+            else
+                m_Nodes[grandParent].Right = sibling;
+
+            m_Nodes[sibling].Parent = grandParent;
+        }
+
+        FreeNode(parent);
+        RefitAncestors(grandParent);
+    }
+
+    void DynamicAABBTree::RefitAncestors(int32_t node)
+    {
+        while (node != NullNode)
+        {
+            node = Balance(node);
+
+            Node& current = m_Nodes[node];
+            const Node& left = m_Nodes[current.Left];
+            const Node& right = m_Nodes[current.Right];
+
+            current.Bounds = Union(left.Bounds, right.Bounds);
+            current.Height = 1 + std::max(left.Height, right.Height);
+
+            node = current.Parent;
+        }
+    }
+
+    int32_t DynamicAABBTree::Balance(int32_t a)
+    {
+        // Rotates the taller child up when the heights of the children differ by more than one
+        Node& nodeA = m_Nodes[a];
+        if (nodeA.IsLeaf() || nodeA.Height < 2)
+            return a;
+
+        int32_t b = nodeA.Left;
+        int32_t c = nodeA.Right;
+        int32_t balance = m_Nodes[c].Height - m_Nodes[b].Height;
+
+        if (balance > 1 || balance < -1)
+        {
+            // The taller child goes up and the node becomes its child
+            int32_t up = balance > 1 ? c : b;
+            int32_t other = balance > 1 ? b : c;
+
+            Node& nodeUp = m_Nodes[up];
+            int32_t f = nodeUp.Left;
+            int32_t g = nodeUp.Right;
+
+            nodeUp.Left = a;
+            nodeUp.Parent = nodeA.Parent;
+            nodeA.Parent = up;
+
+            if (nodeUp.Parent == NullNode)
+            {
+                m_Root = up;
+            }
+            else if (m_Nodes[nodeUp.Parent].Left == a)
+            {
+                m_Nodes[nodeUp.Parent].Left = up;
+            }
+            else
+            {
+                m_Nodes[nodeUp.Parent].Right = up;
+            }
+
+            // The taller grandchild stays with the rotated node, the shorter one replaces it under the old node
+            int32_t keep = m_Nodes[f].Height > m_Nodes[g].Height ? f : g;
+            int32_t move = keep == f ? g : f;
+
+            nodeUp.Right = keep;
+            if (balance > 1)
+            {
+                nodeA.Right = move;
+            }
+            else
+            {
+                nodeA.Left = move;
+            }
+            m_Nodes[move].Parent = a;
+
+            nodeA.Bounds = Union(m_Nodes[other].Bounds, m_Nodes[move].Bounds);
+            nodeA.Height = 1 + std::max(m_Nodes[other].Height, m_Nodes[move].Height);
+
+            nodeUp.Bounds = Union(nodeA.Bounds, m_Nodes[keep].Bounds);
+            nodeUp.Height = 1 + std::max(nodeA.Height, m_Nodes[keep].Height);
+
+            return up;
+        }
+
+        return a;
+    }
+
+    void DynamicAABBTree::Query(const Frustum& frustum, std::vector<uint32_t>& outIds, FrustumCoherence* coherence) const
+    {
+        ZoneScoped;
+
+        // A still camera over a tree that did not change sees the same objects
+        if (coherence && coherence->Valid && coherence->LastVersion == m_Version &&
+            std::equal(coherence->LastFrustumPlanes, coherence->LastFrustumPlanes + 6, frustum.GetPlanes()))
+        {
+            outIds.insert(outIds.end(), coherence->LastResult.begin(), coherence->LastResult.end());
+            return;
+        }
+
+        const size_t firstResult = outIds.size();
+
+        if (coherence)
+            coherence->LastPlanes.resize(m_Nodes.size(), 0);
+
+        if (m_Root != NullNode)
+        {
+            m_QueryStack.clear();
+            m_QueryStack.emplace_back(m_Root, Frustum::AllPlanes);
+
+            while (!m_QueryStack.empty())
+            {
+                auto [index, planeMask] = m_QueryStack.back();
+                m_QueryStack.pop_back();
+
+                const Node& node = m_Nodes[index];
+
+                // A mask without planes means the node is inside a parent that is fully inside the frustum
+                if (planeMask != 0)
+                {
+                    uint8_t lastPlane = 0;
+                    uint8_t& nodePlane = coherence ? coherence->LastPlanes[index] : lastPlane;
+
+                    if (frustum.Classify(node.Bounds, planeMask, nodePlane) == IntersectionType::Outside)
+                        continue;
+                }
+
+                if (node.IsLeaf())
+                {
+                    outIds.push_back(node.Id);
+                }
+                else
+                {
+                    m_QueryStack.emplace_back(node.Left, planeMask);
+                    m_QueryStack.emplace_back(node.Right, planeMask);
+                }
+            }
+        }
+
+        if (coherence)
+        {
+            coherence->LastResult.assign(outIds.begin() + firstResult, outIds.end());
+            std::copy(frustum.GetPlanes(), frustum.GetPlanes() + 6, coherence->LastFrustumPlanes);
+            coherence->LastVersion = m_Version;
+            coherence->Valid = true;
+        }
+    }
+
+    void DynamicAABBTree::Query(const AABB& bounds, std::vector<uint32_t>& outIds) const
+    {
+        ZoneScoped;
+
+        if (m_Root == NullNode)
+            return;
+
+        m_QueryStack.clear();
+        m_QueryStack.emplace_back(m_Root, Frustum::AllPlanes);
+
+        while (!m_QueryStack.empty())
+        {
+            const Node& node = m_Nodes[m_QueryStack.back().first];
+            m_QueryStack.pop_back();
+
+            if (!Overlaps(node.Bounds, bounds))
+                continue;
+
+            if (node.IsLeaf())
+            {
+                outIds.push_back(node.Id);
+            }
+            else
+            {
+                m_QueryStack.emplace_back(node.Left, Frustum::AllPlanes);
+                m_QueryStack.emplace_back(node.Right, Frustum::AllPlanes);
+            }
+        }
+    }
+
+    void DynamicAABBTree::DebugDraw() const
+    {
+        for (const Node& node : m_Nodes)
+        {
+            if (node.Height < 0)
+                continue;
+
+            glm::vec4 color = node.IsLeaf() ? glm::vec4(0.0f, 1.0f, 0.0f, 1.0f) : glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+            DebugRenderer::DrawBox(node.Bounds.min, node.Bounds.max, color);
+        }
+    }
+
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Coffee {
+
+    class Frustum;
+
+    /**
+     * @brief State of the frustum queries of one view, kept between frames to exploit their coherence.
+     */
+    struct FrustumCoherence
+    {
+        std::vector<uint8_t> LastPlanes; ///< The plane that rejected each node the last time, it is tested first.
+        std::vector<uint32_t> LastResult; ///< The objects returned by the last query.
+        glm::vec4 LastFrustumPlanes[6] = {}; ///< The planes of the last query.
+        uint64_t LastVersion = 0; ///< The version of the tree in the last query.
+        bool Valid = false;
+    };
+
+    /**
+     * @brief Bounding volume hierarchy of moving objects.
+     *
+     * Every object is a leaf with its bounds enlarged by a margin, so the small moves stay inside the enlarged bounds
+     * and do not touch the tree. The internal nodes are kept balanced with rotations, so inserting, removing and moving
+     * an object is O(log n). The tree has no fixed bounds, the root grows with the objects.
+     */
+    class DynamicAABBTree
+    {
+    public:
+        /**
+         * @brief Constructor for DynamicAABBTree.
+         * @param margin The distance the bounds of the leaves are enlarged in every direction.
+         */
+        DynamicAABBTree(float margin = 0.1f);
+
+        /**
+         * @brief Inserts an object or replaces its bounds if it is already in the tree.
+         * @param id The identifier of the object.
+         * @param bounds The world bounds of the object.
+         */
+        void Insert(uint32_t id, const AABB& bounds);
+
+        /**
+         * @brief Removes an object.
+         * @param id The identifier of the object.
+         */
+        void Remove(uint32_t id);
+
+        /**
+         * @brief Updates the bounds of an object.
+         * @param id The identifier of the object.
+         * @param bounds The new world bounds of the object.
+         * @return True if the object left its enlarged bounds and was reinserted.
+         */
+        bool Move(uint32_t id, const AABB& bounds);
+
+        /**
+         * @brief Checks if an object is in the tree.
+         * @param id The identifier of the object.
+         * @return True if the object is in the tree.
+         */
+        bool Contains(uint32_t id) const { return m_Leaves.find(id) != m_Leaves.end(); }
+
+        /**
+         * @brief Removes all the objects.
+         */
+        void Clear();
+
+        /**
+         * @brief Gathers the objects whose enlarged bounds are inside a frustum.
+         *
+         * The children of a node skip the planes the node is fully inside of, so the subtrees fully inside the frustum
+         * are gathered without testing their nodes. With a coherence state the plane that rejected a node in the last
+         * query is tested first, and the last result is reused when neither the frustum nor the tree changed.
+         *
+         * @param frustum The frustum.
+         * @param outIds The identifiers of the objects, appended in no particular order.
+         * @param coherence The state of the view between queries, null to query without it.
+         */
+        void Query(const Frustum& frustum, std::vector<uint32_t>& outIds, FrustumCoherence* coherence = nullptr) const;
+
+        /**
+         * @brief Gathers the objects whose enlarged bounds overlap a box.
+         * @param bounds The box.
+         * @param outIds The identifiers of the objects, appended in no particular order.
+         */
+        void Query(const AABB& bounds, std::vector<uint32_t>& outIds) const;
+
+        /**
+         * @brief Visits the objects whose enlarged bounds pass a test, without allocating.
+         * @param test Called with the bounds of each node, returning false skips the node and its subtree.
+         * @param callback Called with the identifier of each object that passes the test, returning false stops the traversal.
+         */
+        template<typename NodeTest, typename Callback>
+        void Traverse(NodeTest&& test, Callback&& callback) const
+        {
+            if (m_Root == NullNode)
+                return;
+
+            // Every pop pushes at most two nodes, so the stack never holds more than the height of the tree plus one
+            int32_t stack[MaxTraversalDepth];
+            int32_t count = 0;
+            stack[count++] = m_Root;
+
+            while (count > 0)
+            {
+                const Node& node = m_Nodes[stack[--count]];
+                if (!test(node.Bounds))
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    if (!callback(node.Id))
+                        return;
+                }
+                else
+                {
+                    stack[count++] = node.Left;
+                    stack[count++] = node.Right;
+                }
+            }
+        }
+
+        /**
+         * @brief Visits the objects whose enlarged bounds are hit by a ray, without allocating.
+         *
+         * The callback returns the new length of the ray, so once a hit is found the nodes behind it are skipped.
+         *
+         * @param origin The origin of the ray.
+         * @param direction The direction of the ray, the distances are in units of its length.
+         * @param maxDistance The length of the ray.
+         * @param callback Called with the identifier of each object and the distance where the ray enters its enlarged
+         *                 bounds. Returns the new length of the ray, a negative length stops the cast.
+         */
+        template<typename Callback>
+        void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback&& callback) const
+        {
+            if (m_Root == NullNode)
+                return;
+
+            const glm::vec3 inverseDirection = 1.0f / direction;
+
+            int32_t stack[MaxTraversalDepth];
+            int32_t count = 0;
+            stack[count++] = m_Root;
+
+            while (count > 0)
+            {
+                const Node& node = m_Nodes[stack[--count]];
+
+                float distance;
+                if (!node.Bounds.IntersectRay(origin, inverseDirection, maxDistance, distance))
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    maxDistance = callback(node.Id, distance);
+                    if (maxDistance < 0.0f)
+                        return;
+                }
+                else
+                {
+                    stack[count++] = node.Left;
+                    stack[count++] = node.Right;
+                }
+            }
+        }
+
+        /**
+         * @brief Visits the objects around a point from the nearest subtrees to the farthest ones, without allocating.
+         *
+         * The callback returns the new search radius, so a k-nearest search can shrink it to its k-th object and skip
+         * the subtrees that are farther away.
+         *
+         * @param point The point.
+         * @param maxDistanceSquared The squared search radius.
+         * @param callback Called with the identifier of each object and the squared distance from the point to its
+         *                 enlarged bounds. Returns the new squared search radius, a negative radius stops the search.
+         */
+        template<typename Callback>
+        void Nearest(const glm::vec3& point, float maxDistanceSquared, Callback&& callback) const
+        {
+            if (m_Root == NullNode)
+                return;
+
+            int32_t stack[MaxTraversalDepth];
+            int32_t count = 0;
+            stack[count++] = m_Root;
+
+            while (count > 0)
+            {
+                const Node& node = m_Nodes[stack[--count]];
+
+                float distanceSquared = node.Bounds.DistanceSquared(point);
+                if (distanceSquared > maxDistanceSquared)
+                    continue;
+
+                if (node.IsLeaf())
+                {
+                    maxDistanceSquared = callback(node.Id, distanceSquared);
+                    if (maxDistanceSquared < 0.0f)
+                        return;
+                }
+                else
+                {
+                    // The nearest child is pushed last so it is visited first
+                    bool leftFirst = m_Nodes[node.Left].Bounds.DistanceSquared(point) <= m_Nodes[node.Right].Bounds.DistanceSquared(point);
+                    stack[count++] = leftFirst ? node.Right : node.Left;
+                    stack[count++] = leftFirst ? node.Left : node.Right;
+                }
+            }
+        }
+
+        /**
+         * @brief Gets the bounds of all the objects.
+         * @return The bounds of the root, empty if there are no objects.
+         */
+        AABB GetBounds() const { return m_Root != NullNode ? m_Nodes[m_Root].Bounds : AABB(); }
+
+        /**
+         * @brief Gets the number of objects.
+         * @return The number of objects.
+         */
+        uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_Leaves.size()); }
+
+        /**
+         * @brief Gets the height of the tree.
+         * @return The number of levels from the root to the deepest leaf, 0 if there are no objects.
+         */
+        int32_t GetHeight() const { return m_Root != NullNode ? m_Nodes[m_Root].Height + 1 : 0; }
+
+        /**
+         * @brief Gets the version of the tree, it changes every time a leaf is added, removed or reinserted.
+         * @return The version of the tree.
+         */
+        uint64_t GetVersion() const { return m_Version; }
+
+        /**
+         * @brief Draws the bounds of the nodes, the leaves in green and the internal nodes in red.
+         */
+        void DebugDraw() const;
+
+    private:
+        static constexpr int32_t NullNode = -1;
+        static constexpr int32_t MaxTraversalDepth = 128; ///< The balanced tree of a million objects is around 30 levels high.
+
+        struct Node
+        {
+            AABB Bounds;
+            int32_t Parent = NullNode; ///< The parent node, or the next free node when the node is not used.
+            int32_t Left = NullNode;
+            int32_t Right = NullNode;
+            int32_t Height = 0; ///< 0 for the leaves, -1 for the free nodes.
+            uint32_t Id = 0;
+
+            bool IsLeaf() const { return Left == NullNode; }
+        };
+
+        int32_t AllocateNode();
+        void FreeNode(int32_t node);
+
+        void InsertLeaf(int32_t leaf);
+        void RemoveLeaf(int32_t leaf);
+        int32_t Balance(int32_t node);
+        void RefitAncestors(int32_t node);
+
+    private:
+        std::vector<Node> m_Nodes;
+        std::unordered_map<uint32_t, int32_t> m_Leaves; ///< Leaf node of each object.
+        int32_t m_Root = NullNode;
+        int32_t m_FreeList = NullNode;
+        float m_Margin;
+        uint64_t m_Version = 0;
+
+        mutable std::vector<std::pair<int32_t, uint8_t>> m_QueryStack; ///< Nodes to visit and the frustum planes they still have to be tested against.
+    };
+
+}
@@ -0,0 +1,291 @@
+#include "CoffeeEngine/Core/DataStructures/SparseGrid.h"
+#include "CoffeeEngine/Math/Frustum.h"
+#include "CoffeeEngine/Renderer/DebugRenderer.h"
+
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    static AABB Union(const AABB& a, const AABB& b)
+    {
+        return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+    }
+
+    static bool Overlaps(const AABB& a, const AABB& b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+    }
+
+    // True if the inner box reaches the faces of the outer one, removing it can shrink the outer box
+    static bool TouchesBorder(const AABB& outer, const AABB& inner)
+    {
+        return glm::any(glm::lessThanEqual(inner.min, outer.min)) || glm::any(glm::greaterThanEqual(inner.max, outer.max));
+    }
+
+    SparseGrid::SparseGrid(float cellSize) : m_CellSize(cellSize)
+    {
+    }
+
+    uint64_t SparseGrid::GetCellKey(const glm::ivec3& coord)
+    {
+        // 21 bits per axis, offset so the negative coordinates are packed as positive ones
+        constexpr int32_t offset = 1 << 20;
+        constexpr uint64_t mask = (1ull << 21) - 1;
+
+        return (static_cast<uint64_t>(coord.x + offset) & mask) |
+               ((static_cast<uint64_t>(coord.y + offset) & mask) << 21) |
+               ((static_cast<uint64_t>(coord.z + offset) & mask) << 42);
+    }
+
+    uint64_t SparseGrid::GetCellKey(const AABB& bounds) const
+    {
+        glm::vec3 size = bounds.max - bounds.min;
+        if (size.x > m_CellSize || size.y > m_CellSize || size.z > m_CellSize)
+            return LargeCellKey;
+
+        return GetCellKey(GetCellCoord(bounds.GetCenter()));
+    }
+
+    uint32_t SparseGrid::GetOrCreateCell(uint64_t key, const glm::ivec3& coord)
+    {
+        auto it = m_CellIndices.find(key);
+        if (it != m_CellIndices.end())
+            return it->second;
+
+        uint32_t index = static_cast<uint32_t>(m_Cells.size());
+        Cell& cell = m_Cells.emplace_back();
+        cell.Key = key;
+        cell.Coord = coord;
+        m_CellIndices[key] = index;
+        return index;
+    }
+
+    void SparseGrid::AddToCell(uint32_t id, const AABB& bounds)
+    {
+        uint64_t key = GetCellKey(bounds);
+        uint32_t cellIndex = GetOrCreateCell(key, GetCellCoord(bounds.GetCenter()));
+
+        Cell& cell = m_Cells[cellIndex];
+        cell.Bounds = cell.Ids.empty() ? bounds : Union(cell.Bounds, bounds);
+        cell.Ids.push_back(id);
+        cell.ObjectBounds.push_back(bounds);
+
+        m_Objects[id] = ObjectLocation{cellIndex, static_cast<uint32_t>(cell.Ids.size()) - 1};
+    }
+
+    void SparseGrid::RemoveFromCell(uint32_t id, const ObjectLocation& location)
+    {
+        Cell& cell = m_Cells[location.Cell];
+        const AABB removedBounds = cell.ObjectBounds[location.Slot];
+
+        // The last object of the cell takes the slot of the removed one
+        uint32_t lastSlot = static_cast<uint32_t>(cell.Ids.size()) - 1;
+        if (location.Slot != lastSlot)
+        {
+            cell.Ids[location.Slot] = cell.Ids[lastSlot];
+            cell.ObjectBounds[location.Slot] = cell.ObjectBounds[lastSlot];
+            m_Objects[cell.Ids[location.Slot]].Slot = location.Slot;
+        }
+        cell.Ids.pop_back();
+        cell.ObjectBounds.pop_back();
+
+        if (!cell.Ids.empty())
+        {
+            if (TouchesBorder(cell.Bounds, removedBounds))
+                RecalculateBounds(cell);
+            return;
+        }
+
+        // The empty cell is released, the last cell takes its slot
+        m_CellIndices.erase(cell.Key);
+
+        uint32_t lastCell = static_cast<uint32_t>(m_Cells.size()) - 1;
+        if (location.Cell != lastCell)
+        {
+            m_Cells[location.Cell] = std::move(m_Cells[lastCell]);
+
+            Cell& moved = m_Cells[location.Cell];
+            m_CellIndices[moved.Key] = location.Cell;
+            for (uint32_t movedId : moved.Ids)
+            {
+                m_Objects[movedId].Cell = location.Cell;
+            }
+        }
+        m_Cells.pop_back();
+    }
+
+    void SparseGrid::RecalculateBounds(Cell& cell)
+    {
+        cell.Bounds = cell.ObjectBounds[0];
+        for (const AABB& bounds : cell.ObjectBounds)
+        {
+            cell.Bounds = Union(cell.Bounds, bounds);
+        }
+    }
+
+    void SparseGrid::Insert(uint32_t id, const AABB& bounds)
+    {
+        if (Contains(id))
+        {
+            Move(id, bounds);
+            return;
+        }
+
+        AddToCell(id, bounds);
+    }
+
+    void SparseGrid::Remove(uint32_t id)
+    {
+        auto it = m_Objects.find(id);
+        if (it == m_Objects.end())
+            return;
+
+        RemoveFromCell(id, it->second);
+        m_Objects.erase(id);
+    }
+
+    bool SparseGrid::Move(uint32_t id, const AABB& bounds)
+    {
+        auto it = m_Objects.find(id);
+        if (it == m_Objects.end())
+        {
+            AddToCell(id, bounds);
+            return true;
+        }
+
+        ObjectLocation location = it->second;
+        Cell& cell = m_Cells[location.Cell];
+
+        if (GetCellKey(bounds) != cell.Key)
+        {
+            RemoveFromCell(id, location);
+            AddToCell(id, bounds);
+            return true;
+        }
+
+        // The object stays in its cell, only the bounds change
+        const AABB oldBounds = cell.ObjectBounds[location.Slot];
+        cell.ObjectBounds[location.Slot] = bounds;
+
+        if (TouchesBorder(cell.Bounds, oldBounds))
+            RecalculateBounds(cell);
+        else
+            cell.Bounds = Union(cell.Bounds, bounds);
+
+        return false;
+    }
+
+    void SparseGrid::Clear()
+    {
+        m_Cells.clear();
+        m_CellIndices.clear();
+        m_Objects.clear();
+    }
+
+    template<typename Callback>
+    void SparseGrid::ForEachCell(const AABB& range, Callback&& callback) const
+    {
+        auto large = m_CellIndices.find(LargeCellKey);
+        if (large != m_CellIndices.end())
+            callback(m_Cells[large->second]);
+
+        // The objects of a cell reach at most the neighbour cells, so the range grows by one cell on every side
+        constexpr int32_t limit = (1 << 20) - 1;
+        const glm::ivec3 first = glm::clamp(GetCellCoord(range.min) - 1, glm::ivec3(-limit), glm::ivec3(limit));
+        const glm::ivec3 last = glm::clamp(GetCellCoord(range.max) + 1, glm::ivec3(-limit), glm::ivec3(limit));
+        const glm::dvec3 extent = glm::dvec3(last - first + 1);
+
+        // A large range visits the cells that exist instead of looking up all the cells it covers
+        if (extent.x * extent.y * extent.z > static_cast<double>(m_Cells.size()))
+        {
+            for (const Cell& cell : m_Cells)
+            {
+                if (cell.Key != LargeCellKey)
+                    callback(cell);
+            }
+            return;
+        }
+
+        for (int32_t z = first.z; z <= last.z; z++)
+        {
+            for (int32_t y = first.y; y <= last.y; y++)
+            {
+                for (int32_t x = first.x; x <= last.x; x++)
+                {
+                    auto it = m_CellIndices.find(GetCellKey(glm::ivec3(x, y, z)));
+                    if (it != m_CellIndices.end())
+                        callback(m_Cells[it->second]);
+                }
+            }
+        }
+    }
+
+    void SparseGrid::Query(const Frustum& frustum, std::vector<uint32_t>& outIds) const
+    {
+        ZoneScoped;
+
+        const glm::vec3* points = frustum.GetPoints();
+        AABB range(points[0], points[0]);
+        for (int i = 1; i < 8; i++)
+        {
+            range.min = glm::min(range.min, points[i]);
+            range.max = glm::max(range.max, points[i]);
+        }
+
+        ForEachCell(range, [&](const Cell& cell) {
+            IntersectionType type = frustum.Classify(cell.Bounds);
+            if (type == IntersectionType::Outside)
+                return;
+
+            if (type == IntersectionType::Inside)
+            {
+                outIds.insert(outIds.end(), cell.Ids.begin(), cell.Ids.end());
+                return;
+            }
+
+            for (size_t i = 0; i < cell.Ids.size(); i++)
+            {
+                if (frustum.Classify(cell.ObjectBounds[i]) != IntersectionType::Outside)
+                    outIds.push_back(cell.Ids[i]);
+            }
+        });
+    }
+
+    void SparseGrid::Query(const AABB& bounds, std::vector<uint32_t>& outIds) const
+    {
+        ZoneScoped;
+
+        ForEachCell(bounds, [&](const Cell& cell) {
+            if (!Overlaps(cell.Bounds, bounds))
+                return;
+
+            for (size_t i = 0; i < cell.Ids.size(); i++)
+            {
+                if (Overlaps(cell.ObjectBounds[i], bounds))
+                    outIds.push_back(cell.Ids[i]);
+            }
+        });
+    }
+
+    void SparseGrid::DebugDraw() const
+    {
+        for (const Cell& cell : m_Cells)
+        {
+            if (cell.Key == LargeCellKey)
+            {
+                DebugRenderer::DrawBox(cell.Bounds.min, cell.Bounds.max, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+            }
+            else
+            {
+                glm::vec3 cellMin = glm::vec3(cell.Coord) * m_CellSize;
+                DebugRenderer::DrawBox(cellMin, cellMin + glm::vec3(m_CellSize), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+            }
+
+            for (const AABB& bounds : cell.ObjectBounds)
+            {
+                DebugRenderer::DrawBox(bounds.min, bounds.max, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+            }
+        }
+    }
+
+}
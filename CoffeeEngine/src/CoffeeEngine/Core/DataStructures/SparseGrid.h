@@ -0,0 +1,150 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Coffee {
+
+    class Frustum;
+
+    /**
+     * @brief Unbounded uniform grid of objects, only the cells that hold objects exist.
+     *
+     * Every object lives in the cell that contains the center of its bounds, and the cells are looked up in a hash map
+     * by their integer coordinates, so the world has no bounds and the memory grows with the objects and not with the
+     * area they cover. An object smaller than a cell never reaches past the neighbours of its cell, so a query only
+     * visits the cells around its range. The objects bigger than a cell are kept apart and always tested.
+     *
+     * Inserting, removing and moving an object are O(1), moving it inside its cell only updates its bounds.
+     */
+    class SparseGrid
+    {
+    public:
+        /**
+         * @brief Constructor for SparseGrid.
+         * @param cellSize The size of the cells in world units.
+         */
+        SparseGrid(float cellSize = 64.0f);
+
+        /**
+         * @brief Inserts an object or replaces its bounds if it is already in the grid.
+         * @param id The identifier of the object.
+         * @param bounds The world bounds of the object.
+         */
+        void Insert(uint32_t id, const AABB& bounds);
+
+        /**
+         * @brief Removes an object.
+         * @param id The identifier of the object.
+         */
+        void Remove(uint32_t id);
+
+        /**
+         * @brief Updates the bounds of an object.
+         * @param id The identifier of the object.
+         * @param bounds The new world bounds of the object.
+         * @return True if the object changed of cell.
+         */
+        bool Move(uint32_t id, const AABB& bounds);
+
+        /**
+         * @brief Checks if an object is in the grid.
+         * @param id The identifier of the object.
+         * @return True if the object is in the grid.
+         */
+        bool Contains(uint32_t id) const { return m_Objects.find(id) != m_Objects.end(); }
+
+        /**
+         * @brief Removes all the objects.
+         */
+        void Clear();
+
+        /**
+         * @brief Gathers the objects whose bounds are inside a frustum.
+         *
+         * The cells outside the frustum are skipped as a whole and the objects of the cells fully inside it are
+         * gathered without testing them.
+         *
+         * @param frustum The frustum.
+         * @param outIds The identifiers of the objects, appended in no particular order.
+         */
+        void Query(const Frustum& frustum, std::vector<uint32_t>& outIds) const;
+
+        /**
+         * @brief Gathers the objects whose bounds overlap a box.
+         * @param bounds The box.
+         * @param outIds The identifiers of the objects, appended in no particular order.
+         */
+        void Query(const AABB& bounds, std::vector<uint32_t>& outIds) const;
+
+        /**
+         * @brief Gets the integer coordinates of the cell that contains a point.
+         *
+         * The coordinates are kept in 21 bits per axis, the cells farther than a million cells from the origin wrap
+         * around and share their key with other cells, which only makes the queries test more objects.
+         *
+         * @param point The point in world space.
+         * @return The coordinates of the cell.
+         */
+        glm::ivec3 GetCellCoord(const glm::vec3& point) const { return glm::ivec3(glm::floor(point / m_CellSize)); }
+
+        float GetCellSize() const { return m_CellSize; }
+
+        /**
+         * @brief Gets the number of cells that hold objects.
+         * @return The number of cells.
+         */
+        uint32_t GetCellCount() const { return static_cast<uint32_t>(m_Cells.size()); }
+
+        /**
+         * @brief Gets the number of objects.
+         * @return The number of objects.
+         */
+        uint32_t GetObjectCount() const { return static_cast<uint32_t>(m_Objects.size()); }
+
+        /**
+         * @brief Draws the cells that hold objects in blue and the bounds of their objects in green.
+         */
+        void DebugDraw() const;
+
+    private:
+        static constexpr uint32_t NullCell = UINT32_MAX;
+        static constexpr uint64_t LargeCellKey = UINT64_MAX; ///< Key of the cell of the objects bigger than a cell.
+
+        struct Cell
+        {
+            uint64_t Key = 0;
+            glm::ivec3 Coord = glm::ivec3(0);
+            AABB Bounds; ///< Union of the bounds of the objects, they can reach past the cell.
+            std::vector<uint32_t> Ids;
+            std::vector<AABB> ObjectBounds; ///< Bounds of each object, parallel to the ids.
+        };
+
+        struct ObjectLocation
+        {
+            uint32_t Cell = NullCell;
+            uint32_t Slot = 0; ///< Index of the object in the arrays of its cell.
+        };
+
+        static uint64_t GetCellKey(const glm::ivec3& coord);
+        uint64_t GetCellKey(const AABB& bounds) const;
+
+        uint32_t GetOrCreateCell(uint64_t key, const glm::ivec3& coord);
+        void AddToCell(uint32_t id, const AABB& bounds);
+        void RemoveFromCell(uint32_t id, const ObjectLocation& location);
+        void RecalculateBounds(Cell& cell);
+
+        template<typename Callback>
+        void ForEachCell(const AABB& range, Callback&& callback) const;
+
+    private:
+        float m_CellSize;
+        std::vector<Cell> m_Cells; ///< The cells that hold objects, removing a cell moves the last one into its slot.
+        std::unordered_map<uint64_t, uint32_t> m_CellIndices; ///< Index of each cell by its key.
+        std::unordered_map<uint32_t, ObjectLocation> m_Objects; ///< Cell and slot of each object.
+    };
+
+}
@@ -0,0 +1,277 @@
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/SystemInfo.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    struct JobEntry
+    {
+        JobSystem::Job Function;
+        JobCounter* Counter = nullptr;
+    };
+
+    /**
+     * @brief Jobs of one worker. The owner takes the newest job and the other threads steal the oldest one.
+     */
+    struct WorkerQueue
+    {
+        std::deque<JobEntry> Jobs;
+        std::mutex Mutex;
+    };
+
+    struct JobSystemData
+    {
+        std::vector<std::thread> Workers;
+        std::vector<Scope<WorkerQueue>> Queues;
+        WorkerQueue BackgroundQueue; ///< Only taken by the workers, so Wait never runs a background job.
+        std::atomic<uint32_t> QueuedJobs = 0;
+        std::atomic<uint32_t> NextQueue = 0;
+        std::mutex WakeMutex;
+        std::condition_variable WakeCondition;
+        std::atomic<bool> Running = false;
+    };
+
+    static JobSystemData s_JobSystemData;
+
+    JobSystemSettings JobSystem::s_Settings;
+
+    // Index of the queue owned by the current thread, -1 for the threads outside the pool
+    static thread_local int s_WorkerIndex = -1;
+
+    static bool TryPopJob(JobEntry& entry)
+    {
+        auto& queues = s_JobSystemData.Queues;
+        const size_t queueCount = queues.size();
+
+        if (s_WorkerIndex >= 0)
+        {
+            WorkerQueue& own = *queues[s_WorkerIndex];
+            std::lock_guard<std::mutex> lock(own.Mutex);
+            if (!own.Jobs.empty())
+            {
+                entry = std::move(own.Jobs.back());
+                own.Jobs.pop_back();
+                s_JobSystemData.QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        // Steal from the other queues, starting after the own one so the thieves spread over the pool
+        const size_t first = s_WorkerIndex >= 0 ? s_WorkerIndex + 1 : 0;
+        for (size_t i = 0; i < queueCount; i++)
+        {
+            WorkerQueue& victim = *queues[(first + i) % queueCount];
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+            if (!victim.Jobs.empty())
+            {
+                entry = std::move(victim.Jobs.front());
+                victim.Jobs.pop_front();
+                s_JobSystemData.QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool TryPopBackgroundJob(JobEntry& entry)
+    {
+        WorkerQueue& queue = s_JobSystemData.BackgroundQueue;
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (queue.Jobs.empty())
+            return false;
+
+        entry = std::move(queue.Jobs.front());
+        queue.Jobs.pop_front();
+        s_JobSystemData.QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    static void ExecuteJob(JobEntry& entry)
+    {
+        entry.Function();
+
+        if (entry.Counter)
+            entry.Counter->Pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    static void WorkerLoop(int workerIndex)
+    {
+        s_WorkerIndex = workerIndex;
+
+        while (true)
+        {
+            // The frame jobs go first, the background ones only take the workers that are idle
+            JobEntry entry;
+            if (TryPopJob(entry) || TryPopBackgroundJob(entry))
+            {
+                ExecuteJob(entry);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(s_JobSystemData.WakeMutex);
+            s_JobSystemData.WakeCondition.wait(lock, [] {
+                return !s_JobSystemData.Running || s_JobSystemData.QueuedJobs.load(std::memory_order_relaxed) > 0;
+            });
+
+            if (!s_JobSystemData.Running && s_JobSystemData.QueuedJobs.load(std::memory_order_relaxed) == 0)
+                return;
+        }
+    }
+
+    void JobSystem::Init(uint32_t threadCount)
+    {
+        ZoneScoped;
+
+        if (s_JobSystemData.Running)
+            return;
+
+        if (threadCount == 0)
+            threadCount = s_Settings.ThreadCount;
+
+        if (threadCount == 0)
+        {
+            uint32_t logicalProcessors = SystemInfo::GetLogicalProcessorCount();
+            threadCount = logicalProcessors > 1 ? logicalProcessors - 1 : 1u;
+        }
+
+        s_JobSystemData.Queues.clear();
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            s_JobSystemData.Queues.push_back(CreateScope<WorkerQueue>());
+        }
+
+        s_JobSystemData.Running = true;
+        s_JobSystemData.Workers.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            s_JobSystemData.Workers.emplace_back(WorkerLoop, static_cast<int>(i));
+        }
+    }
+
+    void JobSystem::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_JobSystemData.WakeMutex);
+            s_JobSystemData.Running = false;
+        }
+        s_JobSystemData.WakeCondition.notify_all();
+
+        for (std::thread& worker : s_JobSystemData.Workers)
+        {
+            worker.join();
+        }
+        s_JobSystemData.Workers.clear();
+        s_JobSystemData.Queues.clear();
+    }
+
+    void JobSystem::Submit(Job job, JobCounter* counter)
+    {
+        if (counter)
+            counter->Pending.fetch_add(1, std::memory_order_relaxed);
+
+        // Without workers the job is executed in place so the callers do not depend on the Init order
+        if (!s_JobSystemData.Running)
+        {
+            JobEntry entry{std::move(job), counter};
+            ExecuteJob(entry);
+            return;
+        }
+
+        // The workers push to their own queue, the other threads spread the jobs over all of them
+        size_t queueIndex = s_WorkerIndex >= 0 ? s_WorkerIndex
+                                               : s_JobSystemData.NextQueue.fetch_add(1, std::memory_order_relaxed) % s_JobSystemData.Queues.size();
+
+        {
+            // Incremented before the push, a thread that pops the job right away would make the counter wrap below zero.
+            // Under the wake mutex so a worker can not miss the notification while going to sleep.
+            std::lock_guard<std::mutex> lock(s_JobSystemData.WakeMutex);
+            s_JobSystemData.QueuedJobs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        WorkerQueue& queue = *s_JobSystemData.Queues[queueIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            queue.Jobs.push_back({std::move(job), counter});
+        }
+
+        s_JobSystemData.WakeCondition.notify_one();
+    }
+
+    void JobSystem::SubmitBackground(Job job, JobCounter* counter)
+    {
+        if (counter)
+            counter->Pending.fetch_add(1, std::memory_order_relaxed);
+
+        if (!s_JobSystemData.Running)
+        {
+            JobEntry entry{std::move(job), counter};
+            ExecuteJob(entry);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_JobSystemData.WakeMutex);
+            s_JobSystemData.QueuedJobs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        WorkerQueue& queue = s_JobSystemData.BackgroundQueue;
+        {
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            queue.Jobs.push_back({std::move(job), counter});
+        }
+
+        s_JobSystemData.WakeCondition.notify_one();
+    }
+
+    void JobSystem::Wait(JobCounter& counter)
+    {
+        ZoneScoped;
+
+        while (!counter.IsDone())
+        {
+            JobEntry entry;
+            if (TryPopJob(entry))
+            {
+                ExecuteJob(entry);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const RangeJob& job)
+    {
+        ZoneScoped;
+
+        if (count == 0)
+            return;
+
+        batchSize = std::max(1u, batchSize);
+
+        JobCounter counter;
+        for (uint32_t begin = 0; begin < count; begin += batchSize)
+        {
+            uint32_t end = std::min(begin + batchSize, count);
+            Submit([&job, begin, end]() { job(begin, end); }, &counter);
+        }
+
+        Wait(counter);
+    }
+
+    uint32_t JobSystem::GetThreadCount()
+    {
+        return static_cast<uint32_t>(s_JobSystemData.Workers.size());
+    }
+
+}
@@ -0,0 +1,117 @@
+/**
+ * @defgroup core Core
+ * @brief Core components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace Coffee {
+
+    /**
+     * @brief Counter used to wait for a group of jobs.
+     */
+    struct JobCounter
+    {
+        std::atomic<uint32_t> Pending = 0; ///< Number of jobs of the group that did not finish yet.
+
+        /**
+         * @brief Checks if every job of the group has finished.
+         * @return True if no job is pending.
+         */
+        bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    /**
+     * @brief Structure containing the job system settings.
+     */
+    struct JobSystemSettings
+    {
+        uint32_t ThreadCount = 0; ///< Number of worker threads used by Init, 0 uses one thread less than the logical processor count.
+    };
+
+    /**
+     * @class JobSystem
+     * @brief Pool of worker threads that executes jobs in parallel.
+     *
+     * Every worker owns a queue, it runs its newest jobs first and steals the oldest jobs of the other workers when its
+     * queue is empty. The threads waiting for a group of jobs help executing the queued jobs, so jobs can submit and
+     * wait for other jobs without deadlocking the pool.
+     *
+     * The long jobs that nobody waits for in a frame, like saving a file, go to a separate background queue. Only the
+     * workers take them, once their own queues are empty, so a thread waiting for its jobs never ends up running one.
+     */
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+        using RangeJob = std::function<void(uint32_t begin, uint32_t end)>;
+
+        /**
+         * @brief Initializes the JobSystem.
+         * @param threadCount Number of worker threads, 0 uses the count of the settings.
+         */
+        static void Init(uint32_t threadCount = 0);
+
+        /**
+         * @brief Stops and joins the worker threads.
+         */
+        static void Shutdown();
+
+        /**
+         * @brief Queues a job.
+         * @param job The job to execute.
+         * @param counter Optional counter incremented now and decremented when the job finishes.
+         */
+        static void Submit(Job job, JobCounter* counter = nullptr);
+
+        /**
+         * @brief Queues a long job that only the worker threads execute, Wait never runs it in the waiting thread.
+         * @param job The job to execute.
+         * @param counter Optional counter incremented now and decremented when the job finishes.
+         */
+        static void SubmitBackground(Job job, JobCounter* counter = nullptr);
+
+        /**
+         * @brief Blocks until every job of the counter has finished, executing queued jobs meanwhile.
+         *
+         * Only the jobs of the worker queues are executed, the background jobs are left to the workers.
+         *
+         * @param counter The counter to wait for.
+         */
+        static void Wait(JobCounter& counter);
+
+        /**
+         * @brief Splits the range [0, count) in batches and executes them in parallel.
+         *
+         * The call returns once every batch has finished.
+         *
+         * @param count The number of elements.
+         * @param batchSize The number of elements of each batch.
+         * @param job The job executed for every batch.
+         */
+        static void ParallelFor(uint32_t count, uint32_t batchSize, const RangeJob& job);
+
+        /**
+         * @brief Gets the number of worker threads.
+         * @return The number of worker threads.
+         */
+        static uint32_t GetThreadCount();
+
+        /**
+         * @brief Get the job system settings, the thread count is applied by the next Init.
+         * @return A reference to the job system settings.
+         */
+        static JobSystemSettings& GetSettings() { return s_Settings; }
+
+    private:
+        static JobSystemSettings s_Settings; ///< Job system settings.
+    };
+
+}
+
+/** @} */
@@ -0,0 +1,383 @@
+// DeferredLightingShader.inl
+#pragma once
+
+const char* deferredLightingShaderSource = R""(
+#[vertex]
+
+#version 450 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec2 aTexCoord;
+
+out vec2 TexCoord;
+
+void main()
+{
+    TexCoord = aTexCoord;
+    gl_Position = vec4(aPosition.x, aPosition.y, 0.0, 1.0);
+}
+
+#[fragment]
+
+#version 450 core
+layout(location = 0) out vec4 FragColor;
+layout(location = 1) out vec4 EntityID;
+
+in vec2 TexCoord;
+
+layout (std140, binding = 0) uniform camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPos;
+};
+
+uniform sampler2D gAlbedoMetallic;
+uniform sampler2D gNormalRoughnessAO;
+uniform sampler2D gEmissive;
+uniform sampler2D gEntityID;
+uniform sampler2D gDepth;
+
+uniform mat4 inverseViewProjection;
+
+#define MAX_LIGHTS 32
+
+struct Light
+{
+    vec3 color;
+    vec3 direction;
+    vec3 position;
+
+    float range;
+    float attenuation;
+    float intensity;
+
+    float angle;
+
+    int type;
+    int shadowIndex;
+    int shadowCount;
+    float shadowBias;
+};
+
+layout (std140, binding = 1) uniform RenderData
+{
+    Light lights[MAX_LIGHTS];
+    int lightCount;
+};
+
+#define MAX_SHADOW_VIEWS 64
+
+struct ShadowView
+{
+    mat4 viewProjection;
+    vec4 atlasRect;
+};
+
+layout (std140, binding = 2) uniform ShadowData
+{
+    ShadowView shadowViews[MAX_SHADOW_VIEWS];
+    vec4 cascadeSplits[MAX_LIGHTS];
+};
+
+layout (binding = 8) uniform sampler2DShadow shadowAtlas;
+
+layout (std140, binding = 3) uniform EnvironmentData
+{
+    vec4 irradianceSH[9];
+    float prefilteredMaxLod;
+    int hasEnvironment;
+};
+
+layout (binding = 6) uniform samplerCube prefilteredMap;
+layout (binding = 7) uniform sampler2D brdfLUT;
+
+float SampleShadowView(int viewIndex, vec3 worldPos, float bias)
+{
+    vec4 lightClip = shadowViews[viewIndex].viewProjection * vec4(worldPos, 1.0);
+    vec3 coords = (lightClip.xyz / lightClip.w) * 0.5 + 0.5;
+
+    if(coords.x < 0.0 || coords.x > 1.0 || coords.y < 0.0 || coords.y > 1.0 || coords.z > 1.0)
+    {
+        return 1.0;
+    }
+
+    vec4 atlasRect = shadowViews[viewIndex].atlasRect;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 minUV = atlasRect.xy + texelSize * 0.5;
+    vec2 maxUV = atlasRect.xy + atlasRect.zw - texelSize * 0.5;
+    vec2 uv = atlasRect.xy + coords.xy * atlasRect.zw;
+
+    // 3x3 PCF clamped to the tile so the neighbour views do not bleed in
+    float shadow = 0.0;
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            shadow += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texelSize, minUV, maxUV), coords.z - bias));
+        }
+    }
+    return shadow / 9.0;
+}
+
+float ShadowFactor(int lightIndex, vec3 worldPos, vec3 normal, float viewDepth)
+{
+    int shadowIndex = lights[lightIndex].shadowIndex;
+    if(shadowIndex < 0)
+    {
+        return 1.0;
+    }
+
+    float bias = lights[lightIndex].shadowBias;
+
+    // Small normal offset to hide the acne on the surfaces at grazing angles
+    vec3 offsetPos = worldPos + normal * bias * 10.0;
+
+    if(lights[lightIndex].type == 0)
+    {
+        for(int i = 0; i < lights[lightIndex].shadowCount; i++)
+        {
+            if(viewDepth < cascadeSplits[lightIndex][i])
+            {
+                return SampleShadowView(shadowIndex + i, offsetPos, bias);
+            }
+        }
+        return 1.0;
+    }
+    else if(lights[lightIndex].type == 1)
+    {
+        // Pick the cube face with the same order as the cubemaps: +X, -X, +Y, -Y, +Z, -Z
+        vec3 d = worldPos - lights[lightIndex].position;
+        vec3 a = abs(d);
+        int face;
+        if(a.x >= a.y && a.x >= a.z) face = d.x > 0.0 ? 0 : 1;
+        else if(a.y >= a.z) face = d.y > 0.0 ? 2 : 3;
+        else face = d.z > 0.0 ? 4 : 5;
+
+        return SampleShadowView(shadowIndex + face, offsetPos, bias);
+    }
+
+    return SampleShadowView(shadowIndex, offsetPos, bias);
+}
+
+uniform bool showNormals;
+
+const float PI = 3.14159265359;
+
+vec3 DecodeNormal(vec2 f)
+{
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+float DistributionGGX(vec3 N, vec3 H, float roughness)
+{
+    float a = roughness*roughness;
+    float a2 = a*a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+
+    float num = a2;
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return num / denom;
+}
+
+float GeometrySchlickGGX(float NdotV, float roughness)
+{
+    float r = (roughness + 1.0);
+    float k = (r*r) / 8.0;
+
+    float num = NdotV;
+    float denom = NdotV * (1.0 - k) + k;
+
+    return num / denom;
+}
+
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+
+// Smooth window so point lights fade to zero at their range instead of being cut
+float RangeWindow(float distance, float range)
+{
+    float ratio = distance / range;
+    float ratio4 = ratio * ratio * ratio * ratio;
+    float window = clamp(1.0 - ratio4, 0.0, 1.0);
+    return window * window;
+}
+
+// Irradiance from the SH9 coefficients baked by EnvironmentLighting, they are already convolved with the cosine lobe
+vec3 IrradianceSH(vec3 n)
+{
+    return max(irradianceSH[0].rgb * 0.282095
+             + irradianceSH[1].rgb * 0.488603 * n.y
+             + irradianceSH[2].rgb * 0.488603 * n.z
+             + irradianceSH[3].rgb * 0.488603 * n.x
+             + irradianceSH[4].rgb * 1.092548 * n.x * n.y
+             + irradianceSH[5].rgb * 1.092548 * n.y * n.z
+             + irradianceSH[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+             + irradianceSH[7].rgb * 1.092548 * n.x * n.z
+             + irradianceSH[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y), vec3(0.0));
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 AmbientLighting(vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    if(hasEnvironment == 0)
+    {
+        return vec3(0.03) * albedo;
+    }
+
+    float NdotV = max(dot(N, V), 0.0);
+
+    vec3 F = fresnelSchlickRoughness(NdotV, F0, roughness);
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    vec3 diffuse = IrradianceSH(N) * albedo / PI;
+
+    vec3 R = reflect(-V, N);
+    vec3 prefiltered = textureLod(prefilteredMap, R, roughness * prefilteredMaxLod).rgb;
+    vec2 brdf = texture(brdfLUT, vec2(NdotV, roughness)).rg;
+    vec3 specular = prefiltered * (F0 * brdf.x + brdf.y);
+
+    return kD * diffuse + specular;
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    float depth = texelFetch(gDepth, texel, 0).r;
+
+    // Nothing was written to the G-buffer here, leave the pixel to the skybox
+    if(depth >= 1.0)
+    {
+        discard;
+    }
+
+    vec4 albedoMetallic = texelFetch(gAlbedoMetallic, texel, 0);
+    vec4 normalRoughnessAO = texelFetch(gNormalRoughnessAO, texel, 0);
+    vec3 emissive = texelFetch(gEmissive, texel, 0).rgb;
+
+    vec3 albedo = albedoMetallic.rgb;
+    float metallic = albedoMetallic.a;
+    vec3 N = DecodeNormal(normalRoughnessAO.xy);
+    float roughness = normalRoughnessAO.z;
+    float ao = normalRoughnessAO.w;
+
+    // Reconstruct the world position from the depth buffer
+    vec4 clipPos = vec4(TexCoord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 worldPos = inverseViewProjection * clipPos;
+    vec3 WorldPos = worldPos.xyz / worldPos.w;
+
+    vec3 V = normalize(cameraPos - WorldPos);
+
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+
+    float viewDepth = -(view * vec4(WorldPos, 1.0)).z;
+
+    vec3 Lo = vec3(0.0);
+    for(int i = 0; i < lightCount; i++)
+    {
+        vec3 L = vec3(0.0);
+
+        vec3 radiance = vec3(0.0);
+
+        if(lights[i].type == 0)
+        {
+            /*====Directional Light====*/
+
+            L = normalize(-lights[i].direction);
+            radiance = lights[i].color * lights[i].intensity;
+        }
+        else if(lights[i].type == 1)
+        {
+            /*====Point Light====*/
+
+            float distance = length(lights[i].position - WorldPos);
+
+            // Skip the BRDF for the pixels outside of the light volume
+            if(distance > lights[i].range)
+            {
+                continue;
+            }
+
+            L = normalize(lights[i].position - WorldPos);
+            float attenuation = 1.0 / (distance * distance) * RangeWindow(distance, lights[i].range);
+            radiance = lights[i].color * attenuation * lights[i].intensity;
+        }
+        else if(lights[i].type == 2)
+        {
+            /*====Spot Light====*/
+
+            float distance = length(lights[i].position - WorldPos);
+
+            if(distance > lights[i].range)
+            {
+                continue;
+            }
+
+            L = normalize(lights[i].position - WorldPos);
+            float theta = dot(L, normalize(-lights[i].direction));
+            float outerCutOff = cos(radians(lights[i].angle));
+            float innerCutOff = cos(radians(lights[i].angle * 0.8));
+            float spot = clamp((theta - outerCutOff) / max(innerCutOff - outerCutOff, 0.0001), 0.0, 1.0);
+            float attenuation = 1.0 / (distance * distance) * RangeWindow(distance, lights[i].range) * spot;
+            radiance = lights[i].color * attenuation * lights[i].intensity;
+        }
+
+        radiance *= ShadowFactor(i, WorldPos, N, viewDepth);
+
+        vec3 H = normalize(V + L);
+
+        float NDF = DistributionGGX(N, H, roughness);
+        float G = GeometrySmith(N, V, L, roughness);
+        vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+        vec3 kS = F;
+        vec3 kD = vec3(1.0) - kS;
+        kD *= 1.0 - metallic;
+
+        vec3 numerator = NDF * G * F;
+        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+        vec3 specular = numerator / denominator;
+
+        float NdotL = max(dot(N, L), 0.0);
+        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    }
+
+    vec3 ambient = AmbientLighting(N, V, albedo, metallic, roughness, F0) * ao;
+    vec3 color = ambient + Lo + emissive;
+
+    FragColor = vec4(color, 1.0);
+    EntityID = texelFetch(gEntityID, texel, 0);
+
+    // Write the G-buffer depth so the skybox, the forward objects and the overlays are depth tested against it
+    gl_FragDepth = depth;
+
+    //REMOVE: This is for the first release of the engine it should be handled differently
+    if(showNormals)
+    {
+        FragColor = vec4((N * 0.5) + 0.5, 1.0);
+    }
+}
+)"";
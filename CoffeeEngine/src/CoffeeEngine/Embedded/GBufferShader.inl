@@ -0,0 +1,125 @@
+// GBufferShader.inl
+#pragma once
+
+const char* gBufferShaderSource = R""(
+#[vertex]
+
+#version 450 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec2 aTexCoord;
+layout (location = 2) in vec3 aNormals;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+
+layout (std140, binding = 0) uniform camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPos;
+};
+
+struct VertexData
+{
+    vec2 TexCoords;
+    vec3 Normal;
+    mat3 TBN;
+};
+
+layout (location = 2) out VertexData Output;
+
+uniform mat4 model;
+uniform mat3 normalMatrix;
+
+void main()
+{
+    Output.Normal = normalMatrix * aNormals;
+    Output.TexCoords = aTexCoord;
+
+    gl_Position = projection * view * model * vec4(aPosition, 1.0);
+
+    vec3 T = normalize(vec3(model * vec4(aTangent, 0.0)));
+    vec3 B = normalize(vec3(model * vec4(aBitangent, 0.0)));
+    vec3 N = normalize(vec3(model * vec4(aNormals, 0.0)));
+
+    Output.TBN = mat3(T, B, N);
+}
+
+#[fragment]
+
+#version 450 core
+layout(location = 0) out vec4 GAlbedoMetallic;
+layout(location = 1) out vec4 GNormalRoughnessAO;
+layout(location = 2) out vec4 GEmissive;
+layout(location = 3) out vec4 EntityID;
+
+uniform vec3 entityID;
+
+struct VertexData
+{
+    vec2 TexCoords;
+    vec3 Normal;
+    mat3 TBN;
+};
+
+layout (location = 2) in VertexData VertexInput;
+
+// Same layout as the StandardShader material so the Material class can feed both shaders
+struct Material
+{
+    sampler2D albedoMap;
+    sampler2D normalMap;
+    sampler2D metallicMap;
+    sampler2D roughnessMap;
+    sampler2D aoMap;
+    sampler2D emissiveMap;
+
+    vec4 color;
+    float metallic;
+    float roughness;
+    float ao;
+    vec3 emissive;
+
+    int hasAlbedo;
+    int hasNormal;
+    int hasMetallic;
+    int hasRoughness;
+    int hasAO;
+    int hasEmissive;
+};
+
+uniform Material material;
+
+// Octahedral normal encoding, the result is in the [-1, 1] range so it can be stored as is in a float target
+vec2 OctWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 EncodeNormal(vec3 n)
+{
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    n.xy = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+    return n.xy;
+}
+
+void main()
+{
+    vec3 albedo = material.hasAlbedo * (texture(material.albedoMap, VertexInput.TexCoords).rgb * material.color.rgb) + (1 - material.hasAlbedo) * material.color.rgb;
+
+    vec3 normal;
+    if (material.hasNormal == 1) {
+        normal = VertexInput.TBN * (texture(material.normalMap, VertexInput.TexCoords).rgb * 2.0 - 1.0);
+    } else {
+        normal = VertexInput.Normal;
+    }
+    float metallic = material.hasMetallic * (texture(material.metallicMap, VertexInput.TexCoords).b * material.metallic) + (1 - material.hasMetallic) * material.metallic;
+    float roughness = material.hasRoughness * (texture(material.roughnessMap, VertexInput.TexCoords).g * material.roughness) + (1 - material.hasRoughness) * material.roughness;
+    float ao = material.hasAO * (texture(material.aoMap, VertexInput.TexCoords).r * material.ao) + (1 - material.hasAO) * material.ao;
+    vec3 emissive = material.hasEmissive * (texture(material.emissiveMap, VertexInput.TexCoords).rgb * material.emissive) + (1 - material.hasEmissive) * material.emissive;
+
+    GAlbedoMetallic = vec4(albedo, metallic);
+    GNormalRoughnessAO = vec4(EncodeNormal(normalize(normal)), roughness, ao);
+    GEmissive = vec4(emissive, 1.0);
+    EntityID = vec4(entityID, 1.0f);
+}
+)"";
@@ -0,0 +1,25 @@
+// ShadowDepthShader.inl
+#pragma once
+
+const char* shadowDepthShaderSource = R""(
+#[vertex]
+
+#version 450 core
+layout (location = 0) in vec3 aPosition;
+
+uniform mat4 lightViewProjection;
+uniform mat4 model;
+
+void main()
+{
+    gl_Position = lightViewProjection * model * vec4(aPosition, 1.0);
+}
+
+#[fragment]
+
+#version 450 core
+
+void main()
+{
+}
+)"";
@@ -60,6 +60,13 @@ void main()
 layout(location = 0) out vec4 FragColor;
 layout(location = 1) out vec4 EntityID;
 
+layout (std140, binding = 0) uniform camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPos;
+};
+
 uniform vec3 entityID;
 
 struct VertexData
@@ -116,6 +123,9 @@ struct Light
     float angle;
 
     int type;
+    int shadowIndex;
+    int shadowCount;
+    float shadowBias;
 };
 
 layout (std140, binding = 1) uniform RenderData
@@ -124,6 +134,100 @@ layout (std140, binding = 1) uniform RenderData
     int lightCount;
 };
 
+#define MAX_SHADOW_VIEWS 64
+
+struct ShadowView
+{
+    mat4 viewProjection;
+    vec4 atlasRect;
+};
+
+layout (std140, binding = 2) uniform ShadowData
+{
+    ShadowView shadowViews[MAX_SHADOW_VIEWS];
+    vec4 cascadeSplits[MAX_LIGHTS];
+};
+
+layout (binding = 8) uniform sampler2DShadow shadowAtlas;
+
+layout (std140, binding = 3) uniform EnvironmentData
+{
+    vec4 irradianceSH[9];
+    float prefilteredMaxLod;
+    int hasEnvironment;
+};
+
+layout (binding = 6) uniform samplerCube prefilteredMap;
+layout (binding = 7) uniform sampler2D brdfLUT;
+
+float SampleShadowView(int viewIndex, vec3 worldPos, float bias)
+{
+    vec4 lightClip = shadowViews[viewIndex].viewProjection * vec4(worldPos, 1.0);
+    vec3 coords = (lightClip.xyz / lightClip.w) * 0.5 + 0.5;
+
+    if(coords.x < 0.0 || coords.x > 1.0 || coords.y < 0.0 || coords.y > 1.0 || coords.z > 1.0)
+    {
+        return 1.0;
+    }
+
+    vec4 atlasRect = shadowViews[viewIndex].atlasRect;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 minUV = atlasRect.xy + texelSize * 0.5;
+    vec2 maxUV = atlasRect.xy + atlasRect.zw - texelSize * 0.5;
+    vec2 uv = atlasRect.xy + coords.xy * atlasRect.zw;
+
+    // 3x3 PCF clamped to the tile so the neighbour views do not bleed in
+    float shadow = 0.0;
+    for(int x = -1; x <= 1; x++)
+    {
+        for(int y = -1; y <= 1; y++)
+        {
+            shadow += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texelSize, minUV, maxUV), coords.z - bias));
+        }
+    }
+    return shadow / 9.0;
+}
+
+float ShadowFactor(int lightIndex, vec3 worldPos, vec3 normal, float viewDepth)
+{
+    int shadowIndex = lights[lightIndex].shadowIndex;
+    if(shadowIndex < 0)
+    {
+        return 1.0;
+    }
+
+    float bias = lights[lightIndex].shadowBias;
+
+    // Small normal offset to hide the acne on the surfaces at grazing angles
+    vec3 offsetPos = worldPos + normal * bias * 10.0;
+
+    if(lights[lightIndex].type == 0)
+    {
+        for(int i = 0; i < lights[lightIndex].shadowCount; i++)
+        {
+            if(viewDepth < cascadeSplits[lightIndex][i])
+            {
+                return SampleShadowView(shadowIndex + i, offsetPos, bias);
+            }
+        }
+        return 1.0;
+    }
+    else if(lights[lightIndex].type == 1)
+    {
+        // Pick the cube face with the same order as the cubemaps: +X, -X, +Y, -Y, +Z, -Z
+        vec3 d = worldPos - lights[lightIndex].position;
+        vec3 a = abs(d);
+        int face;
+        if(a.x >= a.y && a.x >= a.z) face = d.x > 0.0 ? 0 : 1;
+        else if(a.y >= a.z) face = d.y > 0.0 ? 2 : 3;
+        else face = d.z > 0.0 ? 4 : 5;
+
+        return SampleShadowView(shadowIndex + face, offsetPos, bias);
+    }
+
+    return SampleShadowView(shadowIndex, offsetPos, bias);
+}
+
 uniform bool showNormals;
 
 const float PI = 3.14159265359;
@@ -168,6 +272,54 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
     return ggx1 * ggx2;
 }
 
+// Smooth window so point lights fade to zero at their range instead of being cut
+float RangeWindow(float distance, float range)
+{
+    float ratio = distance / range;
+    float ratio4 = ratio * ratio * ratio * ratio;
+    float window = clamp(1.0 - ratio4, 0.0, 1.0);
+    return window * window;
+}
+
+// Irradiance from the SH9 coefficients baked by EnvironmentLighting, they are already convolved with the cosine lobe
+vec3 IrradianceSH(vec3 n)
+{
+    return max(irradianceSH[0].rgb * 0.282095
+             + irradianceSH[1].rgb * 0.488603 * n.y
+             + irradianceSH[2].rgb * 0.488603 * n.z
+             + irradianceSH[3].rgb * 0.488603 * n.x
+             + irradianceSH[4].rgb * 1.092548 * n.x * n.y
+             + irradianceSH[5].rgb * 1.092548 * n.y * n.z
+             + irradianceSH[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0)
+             + irradianceSH[7].rgb * 1.092548 * n.x * n.z
+             + irradianceSH[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y), vec3(0.0));
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
+{
+    return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 AmbientLighting(vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    if(hasEnvironment == 0)
+    {
+        return vec3(0.03) * albedo;
+    }
+
+    float NdotV = max(dot(N, V), 0.0);
+
+    vec3 F = fresnelSchlickRoughness(NdotV, F0, roughness);
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    vec3 diffuse = IrradianceSH(N) * albedo / PI;
+
+    vec3 R = reflect(-V, N);
+    vec3 prefiltered = textureLod(prefilteredMap, R, roughness * prefilteredMaxLod).rgb;
+    vec2 brdf = texture(brdfLUT, vec2(NdotV, roughness)).rg;
+    vec3 specular = prefiltered * (F0 * brdf.x + brdf.y);
+
+    return kD * diffuse + specular;
+}
 
 void main()
 {
@@ -191,6 +343,8 @@ void main()
     vec3 F0 = vec3(0.04);
     F0 = mix(F0, albedo, metallic);
 
+    float viewDepth = -(view * vec4(VertexInput.WorldPos, 1.0)).z;
+
     vec3 Lo = vec3(0.0);
     for(int i = 0; i < lightCount; i++)
     {
@@ -211,15 +365,26 @@ void main()
 
             L = normalize(lights[i].position - VertexInput.WorldPos);
             float distance = length(lights[i].position - VertexInput.WorldPos);
-            float attenuation = 1.0 / (distance * distance);
+            float attenuation = 1.0 / (distance * distance) * RangeWindow(distance, lights[i].range);
             radiance = lights[i].color * attenuation * lights[i].intensity;
         }
         else if(lights[i].type == 2)
         {
             /*====Spot Light====*/
 
+            float distance = length(lights[i].position - VertexInput.WorldPos);
+
+            L = normalize(lights[i].position - VertexInput.WorldPos);
+            float theta = dot(L, normalize(-lights[i].direction));
+            float outerCutOff = cos(radians(lights[i].angle));
+            float innerCutOff = cos(radians(lights[i].angle * 0.8));
+            float spot = clamp((theta - outerCutOff) / max(innerCutOff - outerCutOff, 0.0001), 0.0, 1.0);
+            float attenuation = 1.0 / (distance * distance) * RangeWindow(distance, lights[i].range) * spot;
+            radiance = lights[i].color * attenuation * lights[i].intensity;
         }
 
+        radiance *= ShadowFactor(i, VertexInput.WorldPos, N, viewDepth);
+
         vec3 H = normalize(V + L);
 
         float NDF = DistributionGGX(N, H, roughness);
@@ -238,7 +403,7 @@ void main()
         Lo += (kD * albedo / PI + specular) * radiance * NdotL;
     }
 
-    vec3 ambient = vec3(0.03) * albedo * ao;
+    vec3 ambient = AmbientLighting(N, V, albedo, metallic, roughness, F0) * ao;
     vec3 color = ambient + Lo + emissive;
 
     FragColor = vec4(vec3(color), 1.0);
@@ -0,0 +1,37 @@
+#include "FileUtils.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#endif
+
+namespace Coffee {
+
+    bool ReplaceFileAtomically(const std::filesystem::path& source, const std::filesystem::path& destination, std::error_code& error)
+    {
+        error.clear();
+
+#ifdef _WIN32
+        // Write through so the move is on disk when the call returns, not only in the cache of the file system
+        if (!MoveFileExW(source.c_str(), destination.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        {
+            error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+            return false;
+        }
+#else
+        // rename replaces the destination atomically on POSIX
+        if (std::rename(source.c_str(), destination.c_str()) != 0)
+        {
+            error = std::error_code(errno, std::generic_category());
+            return false;
+        }
+#endif
+
+        return true;
+    }
+
+}
@@ -0,0 +1,30 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <system_error>
+
+namespace Coffee {
+
+    /**
+     * @brief Moves a file over another one in a single step.
+     *
+     * Readers see either the old or the new destination, never a missing or partial file, so a complete file written
+     * next to the destination can replace it safely. std::filesystem::rename gives no such guarantee on Windows,
+     * where MoveFileExW is used instead.
+     *
+     * @param source The file to move, on the same volume as the destination.
+     * @param destination The file to replace, it is created if it does not exist.
+     * @param error Set to the reason of the failure.
+     * @return True if the destination was replaced.
+     */
+    bool ReplaceFileAtomically(const std::filesystem::path& source, const std::filesystem::path& destination, std::error_code& error);
+
+}
+
+/** @} */
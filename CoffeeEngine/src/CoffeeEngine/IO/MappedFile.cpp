@@ -0,0 +1,115 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Coffee {
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#ifdef _WIN32
+    bool MappedFile::Open(const std::filesystem::path& path)
+    {
+        Close();
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_File = file;
+        m_Mapping = mapping;
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle(m_Mapping);
+        if (m_File)
+            CloseHandle(m_File);
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Mapping = nullptr;
+        m_File = nullptr;
+    }
+#else
+    bool MappedFile::Open(const std::filesystem::path& path)
+    {
+        Close();
+
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+
+        struct stat status;
+        if (fstat(file, &status) != 0 || status.st_size == 0)
+        {
+            close(file);
+            return false;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+        // The mapping keeps its own reference to the file
+        close(file);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        // The file is read front to back
+        madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = static_cast<size_t>(status.st_size);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            munmap(const_cast<uint8_t*>(m_Data), m_Size);
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+#endif
+
+}
@@ -0,0 +1,65 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace Coffee {
+
+    /**
+     * @class MappedFile
+     * @brief Read only view of a whole file mapped in memory.
+     *
+     * The pages are read by the operating system when they are first touched, so the file is never copied into a
+     * buffer and reading it does not allocate.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * @brief Maps a file, the previous one is unmapped.
+         * @param path The path of the file.
+         * @return True if the file was mapped.
+         */
+        bool Open(const std::filesystem::path& path);
+
+        /**
+         * @brief Unmaps the file, the pointers to its data become invalid.
+         */
+        void Close();
+
+        bool IsOpen() const { return m_Data != nullptr; }
+
+        /**
+         * @brief Gets the contents of the file.
+         * @return The first byte of the file, its address is aligned to the page size.
+         */
+        const uint8_t* GetData() const { return m_Data; }
+
+        size_t GetSize() const { return m_Size; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+
+#ifdef _WIN32
+        void* m_File = nullptr;
+        void* m_Mapping = nullptr;
+#endif
+    };
+
+}
+
+/** @} */
@@ -55,9 +55,15 @@ namespace Coffee {
         }
     }
 
+    // Older cache entries stored the whole cross image, the suffix keeps them from being read as the packed faces
+    static std::string GetCubemapCacheName(const UUID& uuid)
+    {
+        return std::to_string(uuid) + "_Cubemap";
+    }
+
     Ref<Cubemap> ResourceImporter::ImportCubemap(const std::filesystem::path& path, const UUID& uuid)
     {
-        std::filesystem::path cachedFilePath = CacheManager::GetCachedFilePath(std::to_string(uuid));
+        std::filesystem::path cachedFilePath = CacheManager::GetCachedFilePath(GetCubemapCacheName(uuid));
 
         if (std::filesystem::exists(cachedFilePath))
         {
@@ -68,15 +74,13 @@ namespace Coffee {
         {
             COFFEE_WARN("ResourceImporter::ImportCubemap: Cubemap {0} not found in cache. Creating new cubemap.", path.string());
             Ref<Cubemap> cubemap = CreateRef<Cubemap>(path);
-            ResourceSaver::SaveToCache(std::to_string(uuid), cubemap);
+            ResourceSaver::SaveToCache(GetCubemapCacheName(uuid), cubemap);
             return cubemap;
         }
     }
     Ref<Cubemap> ResourceImporter::ImportCubemap(const UUID& uuid)
     {
-        std::string uuidString = std::to_string(uuid);
-
-        std::filesystem::path cachedFilePath = CacheManager::GetCachedFilePath(uuidString);
+        std::filesystem::path cachedFilePath = CacheManager::GetCachedFilePath(GetCubemapCacheName(uuid));
 
         if(std::filesystem::exists(cachedFilePath))
         {
@@ -0,0 +1,43 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include <cereal/archives/json.hpp>
+#include <cereal/cereal.hpp>
+#include <cstring>
+#include <type_traits>
+
+namespace Coffee {
+
+    /**
+     * @brief Serializes a named value that may be missing in files written by older versions.
+     *
+     * When loading from JSON the value is only read if it is the next node, otherwise it keeps its default.
+     * Any other archive serializes the value as a regular name-value pair.
+     *
+     * @tparam Archive The type of the archive.
+     * @tparam T The type of the value.
+     * @param archive The archive to serialize to or from.
+     * @param name The name of the value.
+     * @param value The value to serialize.
+     */
+    template<class Archive, class T>
+    void OptionalNVP(Archive& archive, const char* name, T& value)
+    {
+        if constexpr (std::is_same_v<Archive, cereal::JSONInputArchive>)
+        {
+            const char* nextName = archive.getNodeName();
+            if (nextName == nullptr || std::strcmp(nextName, name) != 0)
+                return;
+        }
+
+        archive(cereal::make_nvp(name, value));
+    }
+
+}
+
+/** @} */
@@ -4,6 +4,8 @@
 #include <cereal/access.hpp>
 
 #include <array>
+#include <cstddef>
+#include <vector>
 
 namespace Coffee {
 
@@ -135,6 +137,49 @@ namespace Coffee {
             return IntersectionType::Inside;
         }
 
+        /**
+         * @brief Intersects a ray with the AABB using the slab method.
+         * @param origin The origin of the ray.
+         * @param inverseDirection The inverse of each component of the direction of the ray.
+         * @param maxDistance The length of the ray in units of its direction.
+         * @param outDistance The distance where the ray enters the AABB, 0 if the origin is inside.
+         * @return True if the ray hits the AABB before the max distance.
+         */
+        bool IntersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& outDistance) const
+        {
+            glm::vec3 t0 = (min - origin) * inverseDirection;
+            glm::vec3 t1 = (max - origin) * inverseDirection;
+            glm::vec3 tMin = glm::min(t0, t1);
+            glm::vec3 tMax = glm::max(t0, t1);
+
+            float entry = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+            float exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+
+            outDistance = entry;
+            return entry <= exit;
+        }
+
+        /**
+         * @brief Gets the point of the AABB closest to a point.
+         * @param point The point.
+         * @return The point itself if it is inside the AABB.
+         */
+        glm::vec3 ClosestPoint(const glm::vec3& point) const
+        {
+            return glm::clamp(point, min, max);
+        }
+
+        /**
+         * @brief Gets the squared distance from the AABB to a point.
+         * @param point The point.
+         * @return 0 if the point is inside the AABB.
+         */
+        float DistanceSquared(const glm::vec3& point) const
+        {
+            glm::vec3 offset = point - ClosestPoint(point);
+            return glm::dot(offset, offset);
+        }
+
         private:
             friend class cereal::access;
 
@@ -145,6 +190,58 @@ namespace Coffee {
             }
     };
 
+    /**
+     * @brief Array of world space AABBs stored as structure of arrays.
+     *
+     * Each coordinate of the corners is kept in its own contiguous array, so the culling loops read the bounds linearly
+     * and can test several boxes at once.
+     */
+    struct AABBSoA
+    {
+        std::vector<float> MinX, MinY, MinZ; ///< The minimum points of the AABBs.
+        std::vector<float> MaxX, MaxY, MaxZ; ///< The maximum points of the AABBs.
+
+        size_t Size() const { return MinX.size(); }
+        bool Empty() const { return MinX.empty(); }
+
+        AABB Get(size_t index) const
+        {
+            return AABB({MinX[index], MinY[index], MinZ[index]}, {MaxX[index], MaxY[index], MaxZ[index]});
+        }
+
+        void Set(size_t index, const AABB& aabb)
+        {
+            MinX[index] = aabb.min.x; MinY[index] = aabb.min.y; MinZ[index] = aabb.min.z;
+            MaxX[index] = aabb.max.x; MaxY[index] = aabb.max.y; MaxZ[index] = aabb.max.z;
+        }
+
+        void PushBack(const AABB& aabb)
+        {
+            MinX.push_back(aabb.min.x); MinY.push_back(aabb.min.y); MinZ.push_back(aabb.min.z);
+            MaxX.push_back(aabb.max.x); MaxY.push_back(aabb.max.y); MaxZ.push_back(aabb.max.z);
+        }
+
+        /**
+         * @brief Removes an AABB by moving the last one into its slot.
+         * @param index The index of the AABB to remove.
+         */
+        void SwapRemove(size_t index)
+        {
+            size_t last = Size() - 1;
+            if (index != last)
+                Set(index, Get(last));
+
+            MinX.pop_back(); MinY.pop_back(); MinZ.pop_back();
+            MaxX.pop_back(); MaxY.pop_back(); MaxZ.pop_back();
+        }
+
+        void Clear()
+        {
+            MinX.clear(); MinY.clear(); MinZ.clear();
+            MaxX.clear(); MaxY.clear(); MaxZ.clear();
+        }
+    };
+
     /**
      * @brief Structure representing an oriented bounding box (OBB).
      */
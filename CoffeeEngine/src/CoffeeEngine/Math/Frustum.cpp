@@ -0,0 +1,196 @@
+#include "CoffeeEngine/Math/Frustum.h"
+
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define COFFEE_FRUSTUM_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define COFFEE_FRUSTUM_SSE 1
+#endif
+
+namespace Coffee
+{
+    IntersectionType Frustum::Classify(const AABB& aabb) const
+    {
+        const glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+        const glm::vec3 extents = (aabb.max - aabb.min) * 0.5f;
+
+        IntersectionType result = IntersectionType::Inside;
+        for (int i = 0; i < Count; i++)
+        {
+            const glm::vec3 normal(m_planes[i]);
+
+            // Signed distance of the center and projected radius of the box, both scaled by the length of the normal
+            float distance = glm::dot(normal, center) + m_planes[i].w;
+            float radius = glm::dot(glm::abs(normal), extents);
+
+            if (distance + radius < 0.0f)
+                return IntersectionType::Outside;
+            if (distance - radius < 0.0f)
+                result = IntersectionType::Intersect;
+        }
+
+        return result;
+    }
+
+    IntersectionType Frustum::Classify(const AABB& aabb, uint8_t& planeMask, uint8_t& lastPlane) const
+    {
+        const glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+        const glm::vec3 extents = (aabb.max - aabb.min) * 0.5f;
+
+        // Returns false when the box is outside the plane and clears the plane from the mask when it is fully inside
+        auto testPlane = [&](int i) {
+            const glm::vec3 normal(m_planes[i]);
+            float distance = glm::dot(normal, center) + m_planes[i].w;
+            float radius = glm::dot(glm::abs(normal), extents);
+
+            if (distance + radius < 0.0f)
+                return false;
+            if (distance - radius >= 0.0f)
+                planeMask &= ~(1u << i);
+            return true;
+        };
+
+        if ((planeMask & (1u << lastPlane)) && !testPlane(lastPlane))
+            return IntersectionType::Outside;
+
+        for (int i = 0; i < Count; i++)
+        {
+            if (i == lastPlane || !(planeMask & (1u << i)))
+                continue;
+
+            if (!testPlane(i))
+            {
+                lastPlane = static_cast<uint8_t>(i);
+                return IntersectionType::Outside;
+            }
+        }
+
+        return planeMask == 0 ? IntersectionType::Inside : IntersectionType::Intersect;
+    }
+
+    void Frustum::Cull(const AABBSoA& bounds, std::vector<uint64_t>& outVisibleMask) const
+    {
+        ZoneScoped;
+
+        outVisibleMask.resize((bounds.Size() + 63) / 64);
+        Cull(bounds, 0, bounds.Size(), outVisibleMask.data());
+    }
+
+    void Frustum::Cull(const AABBSoA& bounds, size_t first, size_t count, uint64_t* outVisibleMask) const
+    {
+        std::fill(outVisibleMask, outVisibleMask + (count + 63) / 64, 0ull);
+
+        const float* minX = bounds.MinX.data() + first;
+        const float* minY = bounds.MinY.data() + first;
+        const float* minZ = bounds.MinZ.data() + first;
+        const float* maxX = bounds.MaxX.data() + first;
+        const float* maxY = bounds.MaxY.data() + first;
+        const float* maxZ = bounds.MaxZ.data() + first;
+
+        size_t i = 0;
+
+#if defined(COFFEE_FRUSTUM_AVX2)
+        // 8 boxes per iteration, 64 is a multiple of 8 so the bits of a batch never cross a word
+        __m256 planeX[Count], planeY[Count], planeZ[Count], planeW[Count];
+        __m256 absX[Count], absY[Count], absZ[Count];
+        for (int p = 0; p < Count; p++)
+        {
+            planeX[p] = _mm256_set1_ps(m_planes[p].x);
+            planeY[p] = _mm256_set1_ps(m_planes[p].y);
+            planeZ[p] = _mm256_set1_ps(m_planes[p].z);
+            planeW[p] = _mm256_set1_ps(m_planes[p].w);
+            absX[p] = _mm256_set1_ps(glm::abs(m_planes[p].x));
+            absY[p] = _mm256_set1_ps(glm::abs(m_planes[p].y));
+            absZ[p] = _mm256_set1_ps(glm::abs(m_planes[p].z));
+        }
+
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256 zero = _mm256_setzero_ps();
+
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 bMinX = _mm256_loadu_ps(minX + i), bMaxX = _mm256_loadu_ps(maxX + i);
+            __m256 bMinY = _mm256_loadu_ps(minY + i), bMaxY = _mm256_loadu_ps(maxY + i);
+            __m256 bMinZ = _mm256_loadu_ps(minZ + i), bMaxZ = _mm256_loadu_ps(maxZ + i);
+
+            __m256 centerX = _mm256_mul_ps(_mm256_add_ps(bMinX, bMaxX), half);
+            __m256 centerY = _mm256_mul_ps(_mm256_add_ps(bMinY, bMaxY), half);
+            __m256 centerZ = _mm256_mul_ps(_mm256_add_ps(bMinZ, bMaxZ), half);
+            __m256 extentX = _mm256_mul_ps(_mm256_sub_ps(bMaxX, bMinX), half);
+            __m256 extentY = _mm256_mul_ps(_mm256_sub_ps(bMaxY, bMinY), half);
+            __m256 extentZ = _mm256_mul_ps(_mm256_sub_ps(bMaxZ, bMinZ), half);
+
+            // Without branches, a box is outside when it is behind any of the planes
+            __m256 outside = zero;
+            for (int p = 0; p < Count; p++)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], centerX), _mm256_mul_ps(planeY[p], centerY)),
+                                                _mm256_add_ps(_mm256_mul_ps(planeZ[p], centerZ), planeW[p]));
+                __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], extentX), _mm256_mul_ps(absY[p], extentY)),
+                                              _mm256_mul_ps(absZ[p], extentZ));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+            }
+
+            uint64_t visible = static_cast<uint64_t>(~_mm256_movemask_ps(outside) & 0xFF);
+            outVisibleMask[i / 64] |= visible << (i % 64);
+        }
+#elif defined(COFFEE_FRUSTUM_SSE)
+        // 4 boxes per iteration, 64 is a multiple of 4 so the bits of a batch never cross a word
+        __m128 planeX[Count], planeY[Count], planeZ[Count], planeW[Count];
+        __m128 absX[Count], absY[Count], absZ[Count];
+        for (int p = 0; p < Count; p++)
+        {
+            planeX[p] = _mm_set1_ps(m_planes[p].x);
+            planeY[p] = _mm_set1_ps(m_planes[p].y);
+            planeZ[p] = _mm_set1_ps(m_planes[p].z);
+            planeW[p] = _mm_set1_ps(m_planes[p].w);
+            absX[p] = _mm_set1_ps(glm::abs(m_planes[p].x));
+            absY[p] = _mm_set1_ps(glm::abs(m_planes[p].y));
+            absZ[p] = _mm_set1_ps(glm::abs(m_planes[p].z));
+        }
+
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 bMinX = _mm_loadu_ps(minX + i), bMaxX = _mm_loadu_ps(maxX + i);
+            __m128 bMinY = _mm_loadu_ps(minY + i), bMaxY = _mm_loadu_ps(maxY + i);
+            __m128 bMinZ = _mm_loadu_ps(minZ + i), bMaxZ = _mm_loadu_ps(maxZ + i);
+
+            __m128 centerX = _mm_mul_ps(_mm_add_ps(bMinX, bMaxX), half);
+            __m128 centerY = _mm_mul_ps(_mm_add_ps(bMinY, bMaxY), half);
+            __m128 centerZ = _mm_mul_ps(_mm_add_ps(bMinZ, bMaxZ), half);
+            __m128 extentX = _mm_mul_ps(_mm_sub_ps(bMaxX, bMinX), half);
+            __m128 extentY = _mm_mul_ps(_mm_sub_ps(bMaxY, bMinY), half);
+            __m128 extentZ = _mm_mul_ps(_mm_sub_ps(bMaxZ, bMinZ), half);
+
+            // Without branches, a box is outside when it is behind any of the planes
+            __m128 outside = zero;
+            for (int p = 0; p < Count; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+                                             _mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], extentX), _mm_mul_ps(absY[p], extentY)),
+                                           _mm_mul_ps(absZ[p], extentZ));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+
+            uint64_t visible = static_cast<uint64_t>(~_mm_movemask_ps(outside) & 0xF);
+            outVisibleMask[i / 64] |= visible << (i % 64);
+        }
+#endif
+
+        // The remaining boxes, or all of them without SIMD
+        for (; i < count; i++)
+        {
+            AABB aabb({minX[i], minY[i], minZ[i]}, {maxX[i], maxY[i], maxZ[i]});
+            if (Classify(aabb) != IntersectionType::Outside)
+                outVisibleMask[i / 64] |= 1ull << (i % 64);
+        }
+    }
+}
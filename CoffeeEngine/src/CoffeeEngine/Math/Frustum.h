@@ -27,6 +27,9 @@
 #include "CoffeeEngine/Math/BoundingBox.h"
 #include <glm/matrix.hpp>
 
+#include <cstdint>
+#include <vector>
+
 namespace Coffee
 {
     class Frustum
@@ -40,6 +43,32 @@ namespace Coffee
         // http://iquilezles.org/www/articles/frustumcorrect/frustumcorrect.htm
         bool Contains(const AABB& aabb) const;
 
+        // Same test for the box at an index of a structure of arrays
+        bool Contains(const AABBSoA& bounds, size_t index) const { return Contains(bounds.Get(index)); }
+
+        // Center-extents test against the six planes. Inside means the box is fully in front of every plane, so the
+        // children of a node classified as Inside do not need to be tested. Conservative, a box near a corner of the
+        // frustum can be classified as Intersect while being outside.
+        IntersectionType Classify(const AABB& aabb) const;
+
+        // Classify with frame to frame coherence. planeMask has a bit for every plane that still has to be tested, the
+        // planes the box is fully inside of are cleared so the children of a node can skip them. lastPlane is the plane
+        // that rejected the box the last time, it is tested first and updated when another plane rejects it.
+        IntersectionType Classify(const AABB& aabb, uint8_t& planeMask, uint8_t& lastPlane) const;
+
+        // Mask with the bits of the six planes, the initial planeMask of a hierarchical traversal
+        static constexpr uint8_t AllPlanes = 0x3F;
+
+        // Get the 6 planes of the frustum (left, right, bottom, top, near, far)
+        const glm::vec4* GetPlanes() const { return m_planes; }
+
+        // Batch version of the center-extents test. Bit i of outVisibleMask[i / 64] is set when the box i is not
+        // outside the frustum. Uses AVX2 or SSE when they are available.
+        void Cull(const AABBSoA& bounds, std::vector<uint64_t>& outVisibleMask) const;
+
+        // Same as above for the boxes [first, first + count), bit i of the mask is the box first + i
+        void Cull(const AABBSoA& bounds, size_t first, size_t count, uint64_t* outVisibleMask) const;
+
         // Get the 8 points of the frustum
         const glm::vec3* GetPoints() const { return m_points; }
 
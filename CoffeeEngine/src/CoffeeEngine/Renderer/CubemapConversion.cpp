@@ -0,0 +1,252 @@
+#include "CoffeeEngine/Renderer/CubemapConversion.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+#include <tracy/Tracy.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #include <emmintrin.h>
+    #define COFFEE_CUBEMAP_SSE 1
+#endif
+
+namespace Coffee {
+
+    static constexpr float PI = 3.14159265359f;
+
+    // Position of the faces in the 4x3 cross in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z)
+    static const int s_CrossOffsets[6][2] = {
+        {2, 1}, // +X
+        {0, 1}, // -X
+        {1, 0}, // +Y
+        {1, 2}, // -Y
+        {1, 1}, // +Z
+        {3, 1}  // -Z
+    };
+
+    // The texels are handled as four floats (RGB + padding) so each bilinear tap is a single SSE operation
+#ifdef COFFEE_CUBEMAP_SSE
+    using Texel = __m128;
+
+    static inline Texel MakeTexel(float r, float g, float b) { return _mm_set_ps(0.0f, b, g, r); }
+    static inline Texel ScaleTexel(Texel texel, float scale) { return _mm_mul_ps(texel, _mm_set1_ps(scale)); }
+    static inline Texel LerpTexel(Texel a, Texel b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+
+    static inline glm::vec3 TexelToVec3(Texel texel)
+    {
+        alignas(16) float values[4];
+        _mm_store_ps(values, texel);
+        return glm::vec3(values[0], values[1], values[2]);
+    }
+#else
+    using Texel = glm::vec4;
+
+    static inline Texel MakeTexel(float r, float g, float b) { return Texel(r, g, b, 0.0f); }
+    static inline Texel ScaleTexel(Texel texel, float scale) { return texel * scale; }
+    static inline Texel LerpTexel(Texel a, Texel b, float t) { return a + (b - a) * t; }
+    static inline glm::vec3 TexelToVec3(Texel texel) { return glm::vec3(texel); }
+#endif
+
+    static inline Texel LoadTexel(const CubemapSource& source, int x, int y)
+    {
+        const size_t index = (static_cast<size_t>(y) * source.Width + x) * source.Channels;
+
+        // Gray and gray + alpha images are expanded to RGB
+        const int g = source.Channels >= 3 ? 1 : 0;
+        const int b = source.Channels >= 3 ? 2 : 0;
+
+        if (source.HDR)
+        {
+            const float* p = static_cast<const float*>(source.Pixels) + index;
+#ifdef COFFEE_CUBEMAP_SSE
+            if (source.Channels == 4)
+                return _mm_loadu_ps(p);
+#endif
+            return MakeTexel(p[0], p[g], p[b]);
+        }
+
+        const unsigned char* p = static_cast<const unsigned char*>(source.Pixels) + index;
+        return ScaleTexel(MakeTexel(p[0], p[g], p[b]), 1.0f / 255.0f);
+    }
+
+    // Bilinear sample of the panorama, it wraps horizontally and clamps at the poles
+    static Texel SampleEquirectangular(const CubemapSource& source, float u, float v)
+    {
+        float x = u * source.Width - 0.5f;
+        float y = glm::clamp(v * source.Height - 0.5f, 0.0f, static_cast<float>(source.Height - 1));
+
+        float xFloor = std::floor(x);
+        float fx = x - xFloor;
+        int x0 = ((static_cast<int>(xFloor) % source.Width) + source.Width) % source.Width;
+        int x1 = (x0 + 1) % source.Width;
+
+        int y0 = static_cast<int>(y);
+        int y1 = std::min(y0 + 1, source.Height - 1);
+        float fy = y - y0;
+
+        Texel top = LerpTexel(LoadTexel(source, x0, y0), LoadTexel(source, x1, y0), fx);
+        Texel bottom = LerpTexel(LoadTexel(source, x0, y1), LoadTexel(source, x1, y1), fx);
+        return LerpTexel(top, bottom, fy);
+    }
+
+    template<typename WriteTexel>
+    static bool ConvertFaces(const CubemapSource& source, WriteTexel&& write)
+    {
+        ZoneScoped;
+
+        const CubemapLayout layout = GetCubemapLayout(source.Width, source.Height);
+        const uint32_t faceSize = GetCubemapFaceSize(source);
+        if (faceSize == 0 || source.Pixels == nullptr)
+            return false;
+
+        JobSystem::ParallelFor(6 * faceSize, 16, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t row = begin; row < end; row++)
+            {
+                const uint32_t face = row / faceSize;
+                const uint32_t y = row % faceSize;
+                size_t index = (static_cast<size_t>(face) * faceSize + y) * faceSize;
+
+                if (layout == CubemapLayout::Cross)
+                {
+                    const int sourceX = s_CrossOffsets[face][0] * faceSize;
+                    const int sourceY = s_CrossOffsets[face][1] * faceSize + y;
+
+                    for (uint32_t x = 0; x < faceSize; x++, index++)
+                    {
+                        write(index, LoadTexel(source, sourceX + x, sourceY));
+                    }
+                }
+                else
+                {
+                    const float t = (y + 0.5f) / faceSize;
+
+                    for (uint32_t x = 0; x < faceSize; x++, index++)
+                    {
+                        glm::vec3 direction = CubemapFaceUVToDirection(face, (x + 0.5f) / faceSize, t);
+                        float u = std::atan2(direction.z, direction.x) / (2.0f * PI) + 0.5f;
+                        float v = std::acos(glm::clamp(direction.y, -1.0f, 1.0f)) / PI;
+
+                        write(index, SampleEquirectangular(source, u, v));
+                    }
+                }
+            }
+        });
+
+        return true;
+    }
+
+    CubemapLayout GetCubemapLayout(int width, int height)
+    {
+        if (width > 0 && width % 4 == 0 && width * 3 == height * 4)
+            return CubemapLayout::Cross;
+
+        if (height > 0 && width == height * 2)
+            return CubemapLayout::Equirectangular;
+
+        return CubemapLayout::Unknown;
+    }
+
+    uint32_t GetCubemapFaceSize(const CubemapSource& source)
+    {
+        switch (GetCubemapLayout(source.Width, source.Height))
+        {
+            case CubemapLayout::Cross: return source.Width / 4;
+            // A quarter of the panorama width keeps about the same texel density at the equator
+            case CubemapLayout::Equirectangular: return std::max(1, source.Width / 4);
+            default: return 0;
+        }
+    }
+
+    glm::vec3 CubemapFaceUVToDirection(uint32_t face, float s, float t)
+    {
+        float sc = s * 2.0f - 1.0f;
+        float tc = t * 2.0f - 1.0f;
+
+        glm::vec3 direction;
+        switch (face)
+        {
+            case 0: direction = {1.0f, -tc, -sc}; break;
+            case 1: direction = {-1.0f, -tc, sc}; break;
+            case 2: direction = {sc, 1.0f, tc}; break;
+            case 3: direction = {sc, -1.0f, -tc}; break;
+            case 4: direction = {sc, -tc, 1.0f}; break;
+            default: direction = {-sc, -tc, -1.0f}; break;
+        }
+        return glm::normalize(direction);
+    }
+
+    uint32_t CubemapDirectionToFaceUV(const glm::vec3& direction, float& s, float& t)
+    {
+        glm::vec3 a = glm::abs(direction);
+
+        uint32_t face;
+        float sc, tc, ma;
+        if (a.x >= a.y && a.x >= a.z)
+        {
+            ma = a.x;
+            if (direction.x > 0.0f) { face = 0; sc = -direction.z; tc = -direction.y; }
+            else                    { face = 1; sc = direction.z;  tc = -direction.y; }
+        }
+        else if (a.y >= a.z)
+        {
+            ma = a.y;
+            if (direction.y > 0.0f) { face = 2; sc = direction.x; tc = direction.z; }
+            else                    { face = 3; sc = direction.x; tc = -direction.z; }
+        }
+        else
+        {
+            ma = a.z;
+            if (direction.z > 0.0f) { face = 4; sc = direction.x;  tc = -direction.y; }
+            else                    { face = 5; sc = -direction.x; tc = -direction.y; }
+        }
+
+        s = 0.5f * (sc / ma + 1.0f);
+        t = 0.5f * (tc / ma + 1.0f);
+        return face;
+    }
+
+    bool ConvertToCubemapRGB9E5(const CubemapSource& source, std::vector<uint32_t>& outData)
+    {
+        const uint32_t faceSize = GetCubemapFaceSize(source);
+        outData.resize(static_cast<size_t>(faceSize) * faceSize * 6);
+
+        return ConvertFaces(source, [&](size_t index, Texel texel) {
+            outData[index] = glm::packF3x9_E1x5(glm::max(TexelToVec3(texel), glm::vec3(0.0f)));
+        });
+    }
+
+    bool ConvertToCubemapRGB8(const CubemapSource& source, std::vector<unsigned char>& outData)
+    {
+        const uint32_t faceSize = GetCubemapFaceSize(source);
+        outData.resize(static_cast<size_t>(faceSize) * faceSize * 6 * 3);
+
+        return ConvertFaces(source, [&](size_t index, Texel texel) {
+            glm::vec3 color = glm::clamp(TexelToVec3(texel), 0.0f, 1.0f) * 255.0f + 0.5f;
+            unsigned char* out = &outData[index * 3];
+            out[0] = static_cast<unsigned char>(color.r);
+            out[1] = static_cast<unsigned char>(color.g);
+            out[2] = static_cast<unsigned char>(color.b);
+        });
+    }
+
+    bool ConvertToCubemapRGB32F(const CubemapSource& source, std::vector<float>& outData)
+    {
+        const uint32_t faceSize = GetCubemapFaceSize(source);
+        outData.resize(static_cast<size_t>(faceSize) * faceSize * 6 * 3);
+
+        const bool hdr = source.HDR;
+        return ConvertFaces(source, [&](size_t index, Texel texel) {
+            glm::vec3 color = TexelToVec3(texel);
+            // LDR images are stored in sRGB, the usual 2.2 approximation is enough for lighting
+            if (!hdr)
+                color = glm::pow(color, glm::vec3(2.2f));
+
+            float* out = &outData[index * 3];
+            out[0] = color.r;
+            out[1] = color.g;
+            out[2] = color.b;
+        });
+    }
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @brief Renderer components of the CoffeeEngine.
+     * @{
+     */
+
+    /**
+     * @brief Layouts of the images a cubemap can be loaded from.
+     */
+    enum class CubemapLayout
+    {
+        Unknown,
+        Cross,          ///< 4x3 horizontal cross.
+        Equirectangular ///< 2:1 latitude-longitude panorama.
+    };
+
+    /**
+     * @brief Image a cubemap is converted from.
+     */
+    struct CubemapSource
+    {
+        const void* Pixels = nullptr; ///< Row major pixels, floats for HDR images and bytes otherwise.
+        int Width = 0; ///< Width of the image.
+        int Height = 0; ///< Height of the image.
+        int Channels = 0; ///< Number of channels of the image.
+        bool HDR = false; ///< Whether the pixels are floats.
+    };
+
+    /**
+     * @brief Detects the layout of a cubemap image from its size.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     * @return The layout of the image.
+     */
+    CubemapLayout GetCubemapLayout(int width, int height);
+
+    /**
+     * @brief Gets the face size of the cubemap converted from an image.
+     * @param source The source image.
+     * @return The face size, 0 if the layout is not supported.
+     */
+    uint32_t GetCubemapFaceSize(const CubemapSource& source);
+
+    /**
+     * @brief Gets the direction of a texel of a cubemap face.
+     * @param face The face index in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z).
+     * @param s The horizontal coordinate in [0, 1].
+     * @param t The vertical coordinate in [0, 1], 0 is the first row of the face.
+     * @return The normalized direction.
+     */
+    glm::vec3 CubemapFaceUVToDirection(uint32_t face, float s, float t);
+
+    /**
+     * @brief Gets the face and the coordinates a direction falls on, it follows the OpenGL face selection.
+     * @param direction The direction.
+     * @param s The horizontal coordinate in [0, 1].
+     * @param t The vertical coordinate in [0, 1].
+     * @return The face index.
+     */
+    uint32_t CubemapDirectionToFaceUV(const glm::vec3& direction, float& s, float& t);
+
+    /**
+     * @brief Converts an image to six RGB9E5 faces.
+     *
+     * The faces are converted in parallel, the cross faces are copied and the equirectangular ones are resampled
+     * with bilinear filtering.
+     *
+     * @param source The source image.
+     * @param outData The packed texels of the six faces one after the other.
+     * @return True if the layout of the image is supported.
+     */
+    bool ConvertToCubemapRGB9E5(const CubemapSource& source, std::vector<uint32_t>& outData);
+
+    /**
+     * @brief Converts an image to six RGB8 faces.
+     * @param source The source image.
+     * @param outData The texels of the six faces one after the other.
+     * @return True if the layout of the image is supported.
+     */
+    bool ConvertToCubemapRGB8(const CubemapSource& source, std::vector<unsigned char>& outData);
+
+    /**
+     * @brief Converts an image to six linear RGB float faces.
+     * @param source The source image.
+     * @param outData The texels of the six faces one after the other.
+     * @return True if the layout of the image is supported.
+     */
+    bool ConvertToCubemapRGB32F(const CubemapSource& source, std::vector<float>& outData);
+
+    /** @} */
+}
@@ -0,0 +1,89 @@
+#include "CoffeeEngine/Renderer/CullingService.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+
+#include <algorithm>
+#include <bit>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    CullingSettings CullingService::s_Settings;
+
+    // Visibility bits of every view, kept between calls so the culling does not allocate every frame
+    static std::vector<std::vector<uint64_t>> s_ViewMasks;
+
+    void CullingService::Cull(const AABBSoA& bounds, std::span<CullingView> views)
+    {
+        ZoneScoped;
+
+        const uint32_t count = static_cast<uint32_t>(bounds.Size());
+        const uint32_t wordCount = (count + 63) / 64;
+
+        if (s_ViewMasks.size() < views.size())
+            s_ViewMasks.resize(views.size());
+
+        for (size_t view = 0; view < views.size(); view++)
+        {
+            s_ViewMasks[view].resize(wordCount);
+            views[view].VisibleIndices.clear();
+        }
+
+        if (count == 0 || views.empty())
+            return;
+
+        // The chunks start at a multiple of 64 so every one writes its own words of the masks
+        const uint32_t chunkSize = (std::max(s_Settings.ChunkSize, 1u) + 63) & ~63u;
+        const uint32_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+        auto cullChunks = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t chunk = begin; chunk < end; chunk++)
+            {
+                uint32_t first = chunk * chunkSize;
+                uint32_t size = std::min(chunkSize, count - first);
+
+                for (size_t view = 0; view < views.size(); view++)
+                {
+                    views[view].ViewFrustum.Cull(bounds, first, size, s_ViewMasks[view].data() + first / 64);
+                }
+            }
+        };
+
+        if (s_Settings.Parallel && chunkCount > 1 && JobSystem::GetThreadCount() > 0)
+        {
+            JobSystem::ParallelFor(chunkCount, 1, cullChunks);
+        }
+        else
+        {
+            cullChunks(0, chunkCount);
+        }
+
+        // The masks are turned into index lists per view, they are short compared to the bounds
+        auto gatherViews = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t view = begin; view < end; view++)
+            {
+                const std::vector<uint64_t>& mask = s_ViewMasks[view];
+                std::vector<uint32_t>& visible = views[view].VisibleIndices;
+
+                for (uint32_t word = 0; word < wordCount; word++)
+                {
+                    uint64_t bits = mask[word];
+                    while (bits)
+                    {
+                        visible.push_back(word * 64 + std::countr_zero(bits));
+                        bits &= bits - 1;
+                    }
+                }
+            }
+        };
+
+        if (s_Settings.Parallel && views.size() > 1 && JobSystem::GetThreadCount() > 0)
+        {
+            JobSystem::ParallelFor(static_cast<uint32_t>(views.size()), 1, gatherViews);
+        }
+        else
+        {
+            gatherViews(0, static_cast<uint32_t>(views.size()));
+        }
+    }
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Math/Frustum.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @brief Renderer components of the CoffeeEngine.
+     * @{
+     */
+
+    /**
+     * @brief A view culled by the CullingService, like a camera, a shadow cascade or a light volume.
+     */
+    struct CullingView
+    {
+        Frustum ViewFrustum; ///< The frustum of the view.
+        std::vector<uint32_t> VisibleIndices; ///< Output, the indices of the bounds that are visible from the view in ascending order.
+    };
+
+    /**
+     * @brief Structure containing the culling settings.
+     */
+    struct CullingSettings
+    {
+        bool Parallel = true; ///< Split the bounds between the job system threads, disable it to debug the culling in one thread.
+        uint32_t ChunkSize = 4096; ///< Number of bounds culled by a job, rounded up to a multiple of 64.
+        bool Coherent = true; ///< Cull the camera of the render world through its spatial index, reusing the work of the last frame.
+    };
+
+    /**
+     * @brief Culls a set of bounds against several views at once.
+     *
+     * The bounds are split in chunks that are culled by the job system threads. Every chunk is tested against all the
+     * views while it is in the cache, so the bounds are read once no matter how many views there are.
+     */
+    class CullingService
+    {
+    public:
+        /**
+         * @brief Fills the visible indices of every view.
+         * @param bounds The world bounds to cull.
+         * @param views The views, their previous visible indices are replaced.
+         */
+        static void Cull(const AABBSoA& bounds, std::span<CullingView> views);
+
+        /**
+         * @brief Get the culling settings.
+         * @return A reference to the culling settings.
+         */
+        static CullingSettings& GetSettings() { return s_Settings; }
+
+    private:
+        static CullingSettings s_Settings; ///< Culling settings.
+    };
+
+    /** @} */
+}
@@ -0,0 +1,608 @@
+#include "CoffeeEngine/Renderer/EnvironmentLighting.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/Renderer/CubemapConversion.h"
+#include "CoffeeEngine/Renderer/Texture.h"
+
+#include <algorithm>
+#include <cereal/archives/binary.hpp>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+#include <stb_image.h>
+#include <string>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    static constexpr uint32_t s_BakeVersion = 1;
+    static constexpr uint32_t s_MaxSourceSize = 256; ///< The environment is downsampled to this size before baking.
+    static constexpr uint32_t s_MaxPrefilteredSize = 128;
+    static constexpr uint32_t s_PrefilteredMipCount = 5;
+    static constexpr uint32_t s_PrefilteredSampleCount = 128;
+    static constexpr uint32_t s_IrradianceSourceSize = 64;
+    static constexpr uint32_t s_BRDFLUTSize = 128;
+    static constexpr uint32_t s_BRDFSampleCount = 256;
+
+    static constexpr float PI = 3.14159265359f;
+
+    // Linear RGB faces in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z)
+    struct CubemapFaces
+    {
+        uint32_t Size = 0;
+        std::array<std::vector<float>, 6> Faces;
+    };
+
+    // A GGX sample in the tangent space of the texel with the mip it has to be read from
+    struct PrefilterSample
+    {
+        glm::vec3 L;
+        float NdotL;
+        float Lod;
+    };
+
+    static glm::vec3 SampleBilinear(const CubemapFaces& cubemap, const glm::vec3& direction)
+    {
+        float s, t;
+        uint32_t face = CubemapDirectionToFaceUV(direction, s, t);
+
+        const std::vector<float>& data = cubemap.Faces[face];
+        const int size = static_cast<int>(cubemap.Size);
+
+        float x = glm::clamp(s * size - 0.5f, 0.0f, size - 1.0f);
+        float y = glm::clamp(t * size - 0.5f, 0.0f, size - 1.0f);
+        int x0 = static_cast<int>(x);
+        int y0 = static_cast<int>(y);
+        int x1 = std::min(x0 + 1, size - 1);
+        int y1 = std::min(y0 + 1, size - 1);
+        float fx = x - x0;
+        float fy = y - y0;
+
+        auto texel = [&](int tx, int ty) {
+            const float* p = &data[(static_cast<size_t>(ty) * size + tx) * 3];
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        return glm::mix(glm::mix(texel(x0, y0), texel(x1, y0), fx), glm::mix(texel(x0, y1), texel(x1, y1), fx), fy);
+    }
+
+    static glm::vec3 SampleTrilinear(const std::vector<CubemapFaces>& mips, const glm::vec3& direction, float lod)
+    {
+        lod = glm::clamp(lod, 0.0f, static_cast<float>(mips.size() - 1));
+        uint32_t lod0 = static_cast<uint32_t>(lod);
+        uint32_t lod1 = std::min(lod0 + 1, static_cast<uint32_t>(mips.size() - 1));
+
+        glm::vec3 color = SampleBilinear(mips[lod0], direction);
+        if (lod1 == lod0)
+            return color;
+
+        return glm::mix(color, SampleBilinear(mips[lod1], direction), lod - lod0);
+    }
+
+    // Averages the source texels covered by each destination texel, it works for any size ratio
+    static void DownsampleFaces(const CubemapFaces& source, CubemapFaces& destination, uint32_t size)
+    {
+        ZoneScoped;
+
+        destination.Size = size;
+
+        JobSystem::ParallelFor(6, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t face = begin; face < end; face++)
+            {
+                const std::vector<float>& src = source.Faces[face];
+                std::vector<float>& dst = destination.Faces[face];
+                dst.assign(static_cast<size_t>(size) * size * 3, 0.0f);
+
+                for (uint32_t y = 0; y < size; y++)
+                {
+                    uint32_t y0 = y * source.Size / size;
+                    uint32_t y1 = std::max(y0 + 1, (y + 1) * source.Size / size);
+
+                    for (uint32_t x = 0; x < size; x++)
+                    {
+                        uint32_t x0 = x * source.Size / size;
+                        uint32_t x1 = std::max(x0 + 1, (x + 1) * source.Size / size);
+
+                        glm::vec3 sum(0.0f);
+                        for (uint32_t sy = y0; sy < y1; sy++)
+                        {
+                            for (uint32_t sx = x0; sx < x1; sx++)
+                            {
+                                const float* p = &src[(static_cast<size_t>(sy) * source.Size + sx) * 3];
+                                sum += glm::vec3(p[0], p[1], p[2]);
+                            }
+                        }
+                        sum /= static_cast<float>((y1 - y0) * (x1 - x0));
+
+                        float* out = &dst[(static_cast<size_t>(y) * size + x) * 3];
+                        out[0] = sum.r;
+                        out[1] = sum.g;
+                        out[2] = sum.b;
+                    }
+                }
+            }
+        });
+    }
+
+    // Solid angle of a texel projected on the unit sphere
+    static float TexelSolidAngle(uint32_t x, uint32_t y, uint32_t size)
+    {
+        auto areaElement = [](float u, float v) { return std::atan2(u * v, std::sqrt(u * u + v * v + 1.0f)); };
+
+        float invSize = 1.0f / size;
+        float u0 = 2.0f * x * invSize - 1.0f;
+        float u1 = 2.0f * (x + 1) * invSize - 1.0f;
+        float v0 = 2.0f * y * invSize - 1.0f;
+        float v1 = 2.0f * (y + 1) * invSize - 1.0f;
+
+        return areaElement(u0, v0) - areaElement(u0, v1) - areaElement(u1, v0) + areaElement(u1, v1);
+    }
+
+    // Same basis as IrradianceSH in the shaders
+    static void EvaluateSH9(const glm::vec3& n, float basis[9])
+    {
+        basis[0] = 0.282095f;
+        basis[1] = 0.488603f * n.y;
+        basis[2] = 0.488603f * n.z;
+        basis[3] = 0.488603f * n.x;
+        basis[4] = 1.092548f * n.x * n.y;
+        basis[5] = 1.092548f * n.y * n.z;
+        basis[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+        basis[7] = 1.092548f * n.x * n.z;
+        basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+    }
+
+    static glm::vec2 Hammersley(uint32_t i, uint32_t count)
+    {
+        uint32_t bits = i;
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return glm::vec2(static_cast<float>(i) / count, bits * 2.3283064365386963e-10f);
+    }
+
+    // Half vector in tangent space (N = +Z) distributed following GGX
+    static glm::vec3 ImportanceSampleGGX(const glm::vec2& xi, float roughness)
+    {
+        float a = roughness * roughness;
+
+        float phi = 2.0f * PI * xi.x;
+        float cosTheta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+
+        return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+    }
+
+    static float DistributionGGX(float NdotH, float roughness)
+    {
+        float a = roughness * roughness;
+        float a2 = a * a;
+        float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+        return a2 / (PI * denom * denom);
+    }
+
+    static float GeometrySmithIBL(float NdotV, float NdotL, float roughness)
+    {
+        float k = (roughness * roughness) / 2.0f;
+        float ggxV = NdotV / (NdotV * (1.0f - k) + k);
+        float ggxL = NdotL / (NdotL * (1.0f - k) + k);
+        return ggxV * ggxL;
+    }
+
+    // The samples only depend on the roughness when N = V, so they are computed once per mip
+    static std::vector<PrefilterSample> ComputePrefilterSamples(float roughness, uint32_t sourceSize)
+    {
+        std::vector<PrefilterSample> samples;
+        samples.reserve(s_PrefilteredSampleCount);
+
+        // Solid angle covered by a texel of the first mip of the source
+        const float texelSolidAngle = 4.0f * PI / (6.0f * sourceSize * sourceSize);
+
+        for (uint32_t i = 0; i < s_PrefilteredSampleCount; i++)
+        {
+            glm::vec3 H = ImportanceSampleGGX(Hammersley(i, s_PrefilteredSampleCount), roughness);
+            glm::vec3 L = 2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f);
+
+            if (L.z <= 0.0f)
+                continue;
+
+            // Read the samples from a blurrier mip when they cover more than one texel to avoid the fireflies
+            float pdf = DistributionGGX(H.z, roughness) / 4.0f;
+            float sampleSolidAngle = 1.0f / (s_PrefilteredSampleCount * pdf + 0.0001f);
+            float lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+
+            samples.push_back({L, L.z, lod});
+        }
+
+        return samples;
+    }
+
+    // Converts the source image again when the cubemap already dropped its CPU copy
+    static bool LoadSourceFaces(const std::filesystem::path& path, CubemapFaces& faces)
+    {
+        ZoneScoped;
+
+        if (path.empty() || !std::filesystem::exists(path))
+            return false;
+
+        CubemapSource source;
+        source.HDR = stbi_is_hdr(path.string().c_str());
+        source.Pixels = source.HDR ? static_cast<void*>(stbi_loadf(path.string().c_str(), &source.Width, &source.Height, &source.Channels, 0))
+                                   : static_cast<void*>(stbi_load(path.string().c_str(), &source.Width, &source.Height, &source.Channels, 0));
+        if (!source.Pixels)
+            return false;
+
+        std::vector<float> data;
+        const bool converted = GetCubemapFaceSize(source) == faces.Size && ConvertToCubemapRGB32F(source, data);
+        stbi_image_free(const_cast<void*>(source.Pixels));
+
+        if (!converted)
+            return false;
+
+        const size_t faceFloats = static_cast<size_t>(faces.Size) * faces.Size * 3;
+        for (uint32_t face = 0; face < 6; face++)
+        {
+            faces.Faces[face].assign(data.begin() + face * faceFloats, data.begin() + (face + 1) * faceFloats);
+        }
+        return true;
+    }
+
+    EnvironmentLighting::EnvironmentLighting(const Ref<Cubemap>& environment)
+    {
+        ZoneScoped;
+
+        if (!environment)
+            return;
+
+        std::filesystem::path cachePath = CacheManager::GetCachedFilePath(std::to_string(environment->GetUUID()) + "_EnvironmentLighting");
+
+        if (!LoadFromCache(cachePath, environment->GetFaceSize()))
+        {
+            COFFEE_CORE_INFO("EnvironmentLighting: Baking the image based lighting of {0}", environment->GetName());
+
+            if (!Bake(environment))
+            {
+                COFFEE_CORE_ERROR("EnvironmentLighting: {0} has no data to bake the image based lighting from", environment->GetName());
+                return;
+            }
+
+            SaveToCache(cachePath);
+        }
+
+        CreateTextures();
+    }
+
+    EnvironmentLighting::~EnvironmentLighting()
+    {
+        if (m_PrefilteredID)
+            glDeleteTextures(1, &m_PrefilteredID);
+        if (m_BRDFLUTID)
+            glDeleteTextures(1, &m_BRDFLUTID);
+    }
+
+    void EnvironmentLighting::Bind(uint32_t prefilteredSlot, uint32_t brdfLUTSlot)
+    {
+        if (m_PrefilteredID == 0)
+            return;
+
+        glBindTextureUnit(prefilteredSlot, m_PrefilteredID);
+        glBindTextureUnit(brdfLUTSlot, m_BRDFLUTID);
+    }
+
+    Ref<EnvironmentLighting> EnvironmentLighting::Create(const Ref<Cubemap>& environment)
+    {
+        return CreateRef<EnvironmentLighting>(environment);
+    }
+
+    bool EnvironmentLighting::LoadFromCache(const std::filesystem::path& path, uint32_t sourceFaceSize)
+    {
+        ZoneScoped;
+
+        if (!std::filesystem::exists(path))
+            return false;
+
+        BakedData data;
+        try
+        {
+            std::ifstream file(path, std::ios::binary);
+            cereal::BinaryInputArchive archive(file);
+            archive(data);
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_CORE_WARN("EnvironmentLighting: Failed to read {0} ({1})", path.string(), e.what());
+            return false;
+        }
+
+        if (data.Version != s_BakeVersion || data.SourceFaceSize != sourceFaceSize || data.PrefilteredMips.empty() ||
+            data.BRDFLUT.size() != static_cast<size_t>(data.BRDFLUTSize) * data.BRDFLUTSize * 2)
+        {
+            return false;
+        }
+
+        for (size_t mip = 0; mip < data.PrefilteredMips.size(); mip++)
+        {
+            uint32_t size = std::max(1u, data.PrefilteredSize >> mip);
+            if (data.PrefilteredMips[mip].size() != static_cast<size_t>(size) * size * 6 * 3)
+                return false;
+        }
+
+        m_BakedData = std::move(data);
+        return true;
+    }
+
+    void EnvironmentLighting::SaveToCache(const std::filesystem::path& path)
+    {
+        ZoneScoped;
+
+        std::ofstream file(path, std::ios::binary);
+        cereal::BinaryOutputArchive archive(file);
+        archive(m_BakedData);
+    }
+
+    bool EnvironmentLighting::Bake(const Ref<Cubemap>& environment)
+    {
+        ZoneScoped;
+
+        CubemapFaces source;
+        source.Size = environment->GetFaceSize();
+        if (source.Size == 0)
+            return false;
+
+        if (environment->HasCPUData())
+        {
+            for (uint32_t face = 0; face < 6; face++)
+            {
+                environment->ReadFaceRGB(face, source.Faces[face]);
+            }
+        }
+        else if (!LoadSourceFaces(environment->GetFilePath(), source))
+        {
+            return false;
+        }
+
+        BakedData& baked = m_BakedData;
+        baked = BakedData();
+        baked.Version = s_BakeVersion;
+        baked.SourceFaceSize = source.Size;
+
+        // Box filtered mip chain of the source used for the filtered importance sampling
+        std::vector<CubemapFaces> mips(1);
+        const uint32_t baseSize = std::min(source.Size, s_MaxSourceSize);
+        if (baseSize == source.Size)
+            mips[0] = std::move(source);
+        else
+            DownsampleFaces(source, mips[0], baseSize);
+
+        while (mips.back().Size > 1)
+        {
+            CubemapFaces next;
+            DownsampleFaces(mips.back(), next, mips.back().Size / 2);
+            mips.push_back(std::move(next));
+        }
+
+        /*====Diffuse irradiance (SH9)====*/
+        {
+            ZoneScopedN("Irradiance SH");
+
+            const CubemapFaces* irradianceSource = &mips.back();
+            for (const CubemapFaces& mip : mips)
+            {
+                if (mip.Size <= s_IrradianceSourceSize)
+                {
+                    irradianceSource = &mip;
+                    break;
+                }
+            }
+
+            std::array<std::array<float, 27>, 6> faceSH{};
+            JobSystem::ParallelFor(6, 1, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t face = begin; face < end; face++)
+                {
+                    const uint32_t size = irradianceSource->Size;
+                    const std::vector<float>& data = irradianceSource->Faces[face];
+
+                    for (uint32_t y = 0; y < size; y++)
+                    {
+                        for (uint32_t x = 0; x < size; x++)
+                        {
+                            glm::vec3 direction = CubemapFaceUVToDirection(face, (x + 0.5f) / size, (y + 0.5f) / size);
+                            float weight = TexelSolidAngle(x, y, size);
+                            const float* color = &data[(static_cast<size_t>(y) * size + x) * 3];
+
+                            float basis[9];
+                            EvaluateSH9(direction, basis);
+                            for (int i = 0; i < 9; i++)
+                            {
+                                for (int c = 0; c < 3; c++)
+                                {
+                                    faceSH[face][i * 3 + c] += color[c] * basis[i] * weight;
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+
+            // Convolution with the clamped cosine lobe, the result is the irradiance
+            const float bandFactors[3] = {PI, 2.0f * PI / 3.0f, PI / 4.0f};
+            for (int i = 0; i < 9; i++)
+            {
+                const float factor = bandFactors[i == 0 ? 0 : (i < 4 ? 1 : 2)];
+                for (int c = 0; c < 3; c++)
+                {
+                    float sum = 0.0f;
+                    for (uint32_t face = 0; face < 6; face++)
+                        sum += faceSH[face][i * 3 + c];
+
+                    baked.IrradianceSH[i * 3 + c] = sum * factor;
+                }
+            }
+        }
+
+        /*====Specular prefiltered cubemap====*/
+        {
+            ZoneScopedN("Prefiltered Cubemap");
+
+            baked.PrefilteredSize = std::min(s_MaxPrefilteredSize, baseSize);
+            const uint32_t mipCount = std::min(s_PrefilteredMipCount, static_cast<uint32_t>(std::log2(static_cast<float>(baked.PrefilteredSize))) + 1);
+            baked.PrefilteredMips.resize(mipCount);
+
+            for (uint32_t mip = 0; mip < mipCount; mip++)
+            {
+                const uint32_t size = std::max(1u, baked.PrefilteredSize >> mip);
+                const float roughness = mipCount > 1 ? static_cast<float>(mip) / (mipCount - 1) : 0.0f;
+                // Lowest source mip that is not sharper than the texels of this mip
+                const float minLod = std::log2(static_cast<float>(baseSize) / size);
+                const std::vector<PrefilterSample> samples = ComputePrefilterSamples(roughness, baseSize);
+
+                std::vector<uint16_t>& output = baked.PrefilteredMips[mip];
+                output.resize(static_cast<size_t>(size) * size * 6 * 3);
+
+                JobSystem::ParallelFor(6 * size, 4, [&](uint32_t begin, uint32_t end) {
+                    for (uint32_t row = begin; row < end; row++)
+                    {
+                        const uint32_t face = row / size;
+                        const uint32_t y = row % size;
+
+                        for (uint32_t x = 0; x < size; x++)
+                        {
+                            glm::vec3 N = CubemapFaceUVToDirection(face, (x + 0.5f) / size, (y + 0.5f) / size);
+
+                            glm::vec3 color(0.0f);
+                            if (mip == 0)
+                            {
+                                color = SampleTrilinear(mips, N, minLod);
+                            }
+                            else
+                            {
+                                glm::vec3 up = std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                                glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+                                glm::vec3 bitangent = glm::cross(N, tangent);
+
+                                float totalWeight = 0.0f;
+                                for (const PrefilterSample& sample : samples)
+                                {
+                                    glm::vec3 L = tangent * sample.L.x + bitangent * sample.L.y + N * sample.L.z;
+                                    color += SampleTrilinear(mips, L, std::max(sample.Lod, minLod)) * sample.NdotL;
+                                    totalWeight += sample.NdotL;
+                                }
+                                color /= std::max(totalWeight, 0.0001f);
+                            }
+
+                            // Keep the brightest texels in the half float range
+                            color = glm::min(color, glm::vec3(65504.0f));
+
+                            uint16_t* out = &output[((static_cast<size_t>(face) * size + y) * size + x) * 3];
+                            out[0] = glm::packHalf1x16(color.r);
+                            out[1] = glm::packHalf1x16(color.g);
+                            out[2] = glm::packHalf1x16(color.b);
+                        }
+                    }
+                });
+            }
+        }
+
+        /*====BRDF lookup table====*/
+        {
+            ZoneScopedN("BRDF LUT");
+
+            baked.BRDFLUTSize = s_BRDFLUTSize;
+            baked.BRDFLUT.resize(static_cast<size_t>(s_BRDFLUTSize) * s_BRDFLUTSize * 2);
+
+            // Rows are the roughness and columns are NdotV
+            JobSystem::ParallelFor(s_BRDFLUTSize, 8, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t y = begin; y < end; y++)
+                {
+                    const float roughness = (y + 0.5f) / s_BRDFLUTSize;
+
+                    for (uint32_t x = 0; x < s_BRDFLUTSize; x++)
+                    {
+                        const float NdotV = (x + 0.5f) / s_BRDFLUTSize;
+                        const glm::vec3 V(std::sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+
+                        float scale = 0.0f;
+                        float bias = 0.0f;
+                        for (uint32_t i = 0; i < s_BRDFSampleCount; i++)
+                        {
+                            glm::vec3 H = ImportanceSampleGGX(Hammersley(i, s_BRDFSampleCount), roughness);
+                            float VdotH = glm::dot(V, H);
+                            glm::vec3 L = 2.0f * VdotH * H - V;
+
+                            float NdotL = L.z;
+                            float NdotH = std::max(H.z, 0.0f);
+                            VdotH = std::max(VdotH, 0.0f);
+
+                            if (NdotL > 0.0f)
+                            {
+                                float G = GeometrySmithIBL(NdotV, NdotL, roughness);
+                                float GVis = (G * VdotH) / (NdotH * NdotV + 0.0001f);
+                                float Fc = std::pow(1.0f - VdotH, 5.0f);
+
+                                scale += (1.0f - Fc) * GVis;
+                                bias += Fc * GVis;
+                            }
+                        }
+
+                        uint16_t* out = &baked.BRDFLUT[(static_cast<size_t>(y) * s_BRDFLUTSize + x) * 2];
+                        out[0] = glm::packHalf1x16(scale / s_BRDFSampleCount);
+                        out[1] = glm::packHalf1x16(bias / s_BRDFSampleCount);
+                    }
+                }
+            });
+        }
+
+        return true;
+    }
+
+    void EnvironmentLighting::CreateTextures()
+    {
+        ZoneScoped;
+
+        const BakedData& baked = m_BakedData;
+        const uint32_t mipCount = static_cast<uint32_t>(baked.PrefilteredMips.size());
+
+        glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &m_PrefilteredID);
+        glTextureStorage2D(m_PrefilteredID, mipCount, GL_RGB16F, baked.PrefilteredSize, baked.PrefilteredSize);
+
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            const uint32_t size = std::max(1u, baked.PrefilteredSize >> mip);
+            const size_t faceStride = static_cast<size_t>(size) * size * 3;
+
+            for (uint32_t face = 0; face < 6; face++)
+            {
+                glTextureSubImage3D(m_PrefilteredID, mip, 0, 0, face, size, size, 1, GL_RGB, GL_HALF_FLOAT,
+                                    baked.PrefilteredMips[mip].data() + face * faceStride);
+            }
+        }
+
+        glTextureParameteri(m_PrefilteredID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(m_PrefilteredID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(m_PrefilteredID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(m_PrefilteredID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(m_PrefilteredID, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &m_BRDFLUTID);
+        glTextureStorage2D(m_BRDFLUTID, 1, GL_RG16F, baked.BRDFLUTSize, baked.BRDFLUTSize);
+        glTextureSubImage2D(m_BRDFLUTID, 0, 0, 0, baked.BRDFLUTSize, baked.BRDFLUTSize, GL_RG, GL_HALF_FLOAT, baked.BRDFLUT.data());
+
+        glTextureParameteri(m_BRDFLUTID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(m_BRDFLUTID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(m_BRDFLUTID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(m_BRDFLUTID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        for (int i = 0; i < 9; i++)
+        {
+            m_UniformData.irradianceSH[i] = glm::vec4(baked.IrradianceSH[i * 3 + 0], baked.IrradianceSH[i * 3 + 1], baked.IrradianceSH[i * 3 + 2], 0.0f);
+        }
+        m_UniformData.prefilteredMaxLod = static_cast<float>(mipCount - 1);
+        m_UniformData.hasEnvironment = 1;
+    }
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include <cereal/cereal.hpp>
+#include <cereal/types/array.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @brief Renderer components of the CoffeeEngine.
+     * @{
+     */
+
+    class Cubemap;
+
+    /**
+     * @brief Structure containing the environment data uploaded to the shaders.
+     */
+    struct EnvironmentUniformData
+    {
+        glm::vec4 irradianceSH[9]; ///< SH9 coefficients of the irradiance, already convolved with the cosine lobe.
+        float prefilteredMaxLod = 0.0f; ///< Mip level of the prefiltered map that matches a roughness of 1.
+        int hasEnvironment = 0; ///< Whether the environment maps are valid.
+        float padding[2]; ///< Padding to match the std140 layout.
+    };
+
+    /**
+     * @brief Image based lighting baked from an environment cubemap.
+     *
+     * The diffuse irradiance is stored as SH9 coefficients, the specular lighting as a GGX prefiltered cubemap whose mips
+     * go from a roughness of 0 to 1 and the split sum BRDF in a 2D lookup table. Everything is computed on the CPU with
+     * the JobSystem the first time and stored in the cache as half floats, the next runs only upload the cached data.
+     */
+    class EnvironmentLighting
+    {
+    public:
+        /**
+         * @brief Loads the baked lighting of the environment from the cache or bakes it.
+         * @param environment The environment cubemap.
+         */
+        EnvironmentLighting(const Ref<Cubemap>& environment);
+
+        /**
+         * @brief Destructor for the EnvironmentLighting class.
+         */
+        ~EnvironmentLighting();
+
+        /**
+         * @brief Binds the prefiltered cubemap and the BRDF lookup table.
+         * @param prefilteredSlot The texture slot of the prefiltered cubemap.
+         * @param brdfLUTSlot The texture slot of the BRDF lookup table.
+         */
+        void Bind(uint32_t prefilteredSlot, uint32_t brdfLUTSlot);
+
+        /**
+         * @brief Gets the data to upload to the environment uniform buffer.
+         * @return The environment uniform data.
+         */
+        const EnvironmentUniformData& GetUniformData() const { return m_UniformData; }
+
+        /**
+         * @brief Creates the baked lighting of an environment cubemap.
+         * @param environment The environment cubemap.
+         * @return A reference to the created environment lighting.
+         */
+        static Ref<EnvironmentLighting> Create(const Ref<Cubemap>& environment);
+
+    private:
+        /**
+         * @brief Baked data stored in the cache.
+         */
+        struct BakedData
+        {
+            uint32_t Version = 0; ///< Version of the bake, older versions are baked again.
+            uint32_t SourceFaceSize = 0; ///< Face size of the environment the data was baked from.
+            std::array<float, 27> IrradianceSH{}; ///< RGB SH9 coefficients.
+            uint32_t PrefilteredSize = 0; ///< Face size of the first mip of the prefiltered cubemap.
+            std::vector<std::vector<uint16_t>> PrefilteredMips; ///< Half float RGB texels of the six faces of every mip.
+            uint32_t BRDFLUTSize = 0; ///< Size of the BRDF lookup table.
+            std::vector<uint16_t> BRDFLUT; ///< Half float RG texels of the BRDF lookup table.
+
+            template<class Archive>
+            void serialize(Archive& archive)
+            {
+                archive(Version, SourceFaceSize, IrradianceSH, PrefilteredSize, PrefilteredMips, BRDFLUTSize, BRDFLUT);
+            }
+        };
+
+        bool LoadFromCache(const std::filesystem::path& path, uint32_t sourceFaceSize);
+        void SaveToCache(const std::filesystem::path& path);
+        bool Bake(const Ref<Cubemap>& environment);
+        void CreateTextures();
+
+    private:
+        BakedData m_BakedData;
+        EnvironmentUniformData m_UniformData;
+        uint32_t m_PrefilteredID = 0;
+        uint32_t m_BRDFLUTID = 0;
+    };
+
+    /** @} */
+}
@@ -83,6 +83,11 @@ namespace Coffee {
     }
 
     void Material::Use()
+    {
+        Use(m_Shader);
+    }
+
+    void Material::Use(const Ref<Shader>& shader)
     {
         ZoneScoped;
 
@@ -94,7 +99,7 @@ namespace Coffee {
         m_MaterialTextureFlags.hasAO = (m_MaterialTextures.ao != nullptr);
         m_MaterialTextureFlags.hasEmissive = (m_MaterialTextures.emissive != nullptr);
 
-        m_Shader->Bind();
+        shader->Bind();
 
         // Bind Textures
         if(m_MaterialTextureFlags.hasAlbedo)m_MaterialTextures.albedo->Bind(0);
@@ -105,19 +110,19 @@ namespace Coffee {
         if(m_MaterialTextureFlags.hasEmissive)m_MaterialTextures.emissive->Bind(5);
 
         // Set Material Properties
-        m_Shader->setVec4("material.color", m_MaterialProperties.color);
-        m_Shader->setFloat("material.metallic", m_MaterialProperties.metallic);
-        m_Shader->setFloat("material.roughness", m_MaterialProperties.roughness);
-        m_Shader->setFloat("material.ao", m_MaterialProperties.ao);
-        m_Shader->setVec3("material.emissive", m_MaterialProperties.emissive);
+        shader->setVec4("material.color", m_MaterialProperties.color);
+        shader->setFloat("material.metallic", m_MaterialProperties.metallic);
+        shader->setFloat("material.roughness", m_MaterialProperties.roughness);
+        shader->setFloat("material.ao", m_MaterialProperties.ao);
+        shader->setVec3("material.emissive", m_MaterialProperties.emissive);
 
         // Set Material Texture Flags
-        m_Shader->setInt("material.hasAlbedo", m_MaterialTextureFlags.hasAlbedo);
-        m_Shader->setInt("material.hasNormal", m_MaterialTextureFlags.hasNormal);
-        m_Shader->setInt("material.hasMetallic", m_MaterialTextureFlags.hasMetallic);
-        m_Shader->setInt("material.hasRoughness", m_MaterialTextureFlags.hasRoughness);
-        m_Shader->setInt("material.hasAO", m_MaterialTextureFlags.hasAO);
-        m_Shader->setInt("material.hasEmissive", m_MaterialTextureFlags.hasEmissive);
+        shader->setInt("material.hasAlbedo", m_MaterialTextureFlags.hasAlbedo);
+        shader->setInt("material.hasNormal", m_MaterialTextureFlags.hasNormal);
+        shader->setInt("material.hasMetallic", m_MaterialTextureFlags.hasMetallic);
+        shader->setInt("material.hasRoughness", m_MaterialTextureFlags.hasRoughness);
+        shader->setInt("material.hasAO", m_MaterialTextureFlags.hasAO);
+        shader->setInt("material.hasEmissive", m_MaterialTextureFlags.hasEmissive);
     }
 
     Ref<Material> Material::Create(const std::string& name, MaterialTextures* materialTextures)
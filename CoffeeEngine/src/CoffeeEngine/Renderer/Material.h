@@ -162,12 +162,24 @@ namespace Coffee {
          */
         void Use();
 
+        /**
+         * @brief Uses the material with another shader that shares the standard material interface.
+         * @param shader The shader to bind and upload the material data to (e.g. the G-buffer shader).
+         */
+        void Use(const Ref<Shader>& shader);
+
         /**
          * @brief Gets the shader associated with the material.
          * @return A reference to the shader.
          */
         Ref<Shader> GetShader() { return m_Shader; }
 
+        /**
+         * @brief Checks if the material is rendered with the standard PBR shader.
+         * @return True if the material uses the standard shader.
+         */
+        bool UsesStandardShader() const { return m_Shader && m_Shader == s_StandardShader; }
+
         MaterialTextures& GetMaterialTextures() { return m_MaterialTextures; }
         MaterialProperties& GetMaterialProperties() { return m_MaterialProperties; }
 
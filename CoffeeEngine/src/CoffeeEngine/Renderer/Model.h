@@ -142,7 +142,7 @@ namespace Coffee {
         std::weak_ptr<Model> m_Parent; ///< The parent model.
         std::vector<Ref<Model>> m_Children; ///< The children models.
 
-        glm::mat4 m_Transform; ///< The transformation matrix of the model.
+        glm::mat4 m_Transform = glm::mat4(1.0f); ///< The transformation matrix of the model.
 
         std::string m_NodeName; ///< The name of the node.
     };
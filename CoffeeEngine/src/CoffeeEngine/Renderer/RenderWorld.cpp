@@ -0,0 +1,196 @@
+#include "CoffeeEngine/Renderer/RenderWorld.h"
+
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    // Shared by all the worlds so a version never repeats, even after a scene is reloaded
+    static uint64_t s_StaticVersionCounter = 0;
+
+    static bool IsStaticCaster(const RenderCommand& command)
+    {
+        return command.castShadows && command.isStatic;
+    }
+
+    static uint64_t HashPointer(const void* pointer, uint32_t bits)
+    {
+        return std::hash<const void*>{}(pointer) & ((1ull << bits) - 1);
+    }
+
+    RenderWorld::RenderWorld()
+    {
+        m_StaticVersion = ++s_StaticVersionCounter;
+    }
+
+    uint64_t RenderWorld::CalculateSortKey(const RenderCommand& command)
+    {
+        // Shader in the highest bits, then material and mesh, so the commands that share state end up together
+        Material* material = command.material.get();
+        const Shader* shader = material ? material->GetShader().get() : nullptr;
+
+        return (HashPointer(shader, 16) << 48) | (HashPointer(material, 24) << 24) | HashPointer(command.mesh.get(), 24);
+    }
+
+    void RenderWorld::OnProxyAdded(const RenderCommand& command)
+    {
+        if (IsStaticCaster(command))
+            m_StaticVersion = ++s_StaticVersionCounter;
+        else if (command.castShadows)
+            m_DynamicCasterCount++;
+    }
+
+    void RenderWorld::OnProxyRemoved(const RenderCommand& command)
+    {
+        if (IsStaticCaster(command))
+            m_StaticVersion = ++s_StaticVersionCounter;
+        else if (command.castShadows)
+            m_DynamicCasterCount--;
+    }
+
+    void RenderWorld::AddProxy(const RenderCommand& command)
+    {
+        if (!command.mesh)
+        {
+            RemoveProxy(command.entityID);
+            return;
+        }
+
+        AABB bounds = command.mesh->GetAABB().CalculateTransformedAABB(command.transform);
+        uint64_t sortKey = CalculateSortKey(command);
+
+        auto it = m_ProxyIndices.find(command.entityID);
+        if (it != m_ProxyIndices.end())
+        {
+            uint32_t index = it->second;
+            OnProxyRemoved(m_Commands[index]);
+
+            m_Commands[index] = command;
+            m_WorldBounds.Set(index, bounds);
+            m_SortKeys[index] = sortKey;
+        }
+        else
+        {
+            m_ProxyIndices[command.entityID] = static_cast<uint32_t>(m_Commands.size());
+
+            m_Commands.push_back(command);
+            m_WorldBounds.PushBack(bounds);
+            m_SortKeys.push_back(sortKey);
+        }
+
+        m_SpatialIndex.Insert(command.entityID, bounds);
+        OnProxyAdded(command);
+    }
+
+    void RenderWorld::RemoveProxy(uint32_t entityID)
+    {
+        auto it = m_ProxyIndices.find(entityID);
+        if (it == m_ProxyIndices.end())
+            return;
+
+        uint32_t index = it->second;
+        uint32_t last = static_cast<uint32_t>(m_Commands.size()) - 1;
+
+        OnProxyRemoved(m_Commands[index]);
+        m_ProxyIndices.erase(it);
+        m_SpatialIndex.Remove(entityID);
+
+        if (index != last)
+        {
+            m_Commands[index] = std::move(m_Commands[last]);
+            m_SortKeys[index] = m_SortKeys[last];
+            m_ProxyIndices[m_Commands[index].entityID] = index;
+        }
+
+        m_Commands.pop_back();
+        m_WorldBounds.SwapRemove(index);
+        m_SortKeys.pop_back();
+    }
+
+    void RenderWorld::UpdateTransform(uint32_t entityID, const glm::mat4& transform)
+    {
+        auto it = m_ProxyIndices.find(entityID);
+        if (it == m_ProxyIndices.end())
+            return;
+
+        RenderCommand& command = m_Commands[it->second];
+        command.transform = transform;
+        AABB bounds = command.mesh->GetAABB().CalculateTransformedAABB(transform);
+        m_WorldBounds.Set(it->second, bounds);
+        m_SpatialIndex.Move(entityID, bounds);
+
+        if (IsStaticCaster(command))
+            m_StaticVersion = ++s_StaticVersionCounter;
+    }
+
+    void RenderWorld::UpdateMaterial(uint32_t entityID, const Ref<Material>& material)
+    {
+        auto it = m_ProxyIndices.find(entityID);
+        if (it == m_ProxyIndices.end())
+            return;
+
+        RenderCommand& command = m_Commands[it->second];
+        command.material = material;
+        m_SortKeys[it->second] = CalculateSortKey(command);
+    }
+
+    void RenderWorld::Clear()
+    {
+        m_Commands.clear();
+        m_WorldBounds.Clear();
+        m_SortKeys.clear();
+        m_ProxyIndices.clear();
+        m_SpatialIndex.Clear();
+
+        m_StaticVersion = ++s_StaticVersionCounter;
+        m_DynamicCasterCount = 0;
+    }
+
+    void RenderWorld::Cull(std::vector<CullingView>& views) const
+    {
+        ZoneScoped;
+
+        std::span<CullingView> linearViews(views);
+
+        if (CullingService::GetSettings().Coherent && !views.empty())
+        {
+            CullingView& camera = views[0];
+            camera.VisibleIndices.clear();
+
+            // The tree returns the proxies by their enlarged bounds, their exact bounds are tested again
+            m_QueryScratch.clear();
+            m_SpatialIndex.Query(camera.ViewFrustum, m_QueryScratch, &m_CameraCoherence);
+
+            for (uint32_t entityID : m_QueryScratch)
+            {
+                uint32_t index = m_ProxyIndices.at(entityID);
+                if (camera.ViewFrustum.Classify(m_WorldBounds.Get(index)) != IntersectionType::Outside)
+                    camera.VisibleIndices.push_back(index);
+            }
+
+            linearViews = linearViews.subspan(1);
+        }
+
+        CullingService::Cull(m_WorldBounds, linearViews);
+
+        for (CullingView& view : views)
+        {
+            m_SortScratch.clear();
+            for (uint32_t index : view.VisibleIndices)
+            {
+                m_SortScratch.emplace_back(m_SortKeys[index], index);
+            }
+
+            std::sort(m_SortScratch.begin(), m_SortScratch.end());
+
+            for (size_t i = 0; i < m_SortScratch.size(); i++)
+            {
+                view.VisibleIndices[i] = m_SortScratch[i].second;
+            }
+        }
+    }
+
+
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "CoffeeEngine/Core/DataStructures/DynamicAABBTree.h"
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Renderer/CullingService.h"
+#include "CoffeeEngine/Renderer/Renderer.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @brief Renderer components of the CoffeeEngine.
+     * @{
+     */
+
+    /**
+     * @brief Persistent render proxies of the meshes of a scene.
+     *
+     * Every mesh entity owns one proxy with its world transform, world bounds, mesh, material and sort key. The proxies
+     * are stored densely in parallel arrays and are only touched when the entity changes, so a frame only has to cull
+     * and sort them. Removing a proxy moves the last one into its slot. The world bounds are also kept in a dynamic
+     * bounding volume hierarchy for the spatial queries.
+     */
+    class RenderWorld
+    {
+    public:
+        RenderWorld();
+
+        /**
+         * @brief Adds the proxy of an entity or replaces it if it already exists.
+         * @param command The mesh, material, transform and flags of the proxy. The entityID identifies the proxy.
+         */
+        void AddProxy(const RenderCommand& command);
+
+        /**
+         * @brief Removes the proxy of an entity.
+         * @param entityID The entity that owns the proxy.
+         */
+        void RemoveProxy(uint32_t entityID);
+
+        /**
+         * @brief Checks if an entity has a proxy.
+         * @param entityID The entity.
+         * @return True if the entity has a proxy.
+         */
+        bool HasProxy(uint32_t entityID) const { return m_ProxyIndices.find(entityID) != m_ProxyIndices.end(); }
+
+        /**
+         * @brief Gets the world bounds of the proxy of an entity.
+         * @param entityID The entity that owns the proxy.
+         * @param outBounds The world bounds of the proxy.
+         * @return True if the entity has a proxy.
+         */
+        bool GetProxyBounds(uint32_t entityID, AABB& outBounds) const
+        {
+            auto it = m_ProxyIndices.find(entityID);
+            if (it == m_ProxyIndices.end())
+                return false;
+
+            outBounds = m_WorldBounds.Get(it->second);
+            return true;
+        }
+
+        /**
+         * @brief Updates the world transform and bounds of a proxy.
+         * @param entityID The entity that owns the proxy.
+         * @param transform The new world transform.
+         */
+        void UpdateTransform(uint32_t entityID, const glm::mat4& transform);
+
+        /**
+         * @brief Updates the material of a proxy.
+         * @param entityID The entity that owns the proxy.
+         * @param material The new material, null uses the default material.
+         */
+        void UpdateMaterial(uint32_t entityID, const Ref<Material>& material);
+
+        /**
+         * @brief Removes all the proxies.
+         */
+        void Clear();
+
+        /**
+         * @brief Gathers the visible proxies of several views in one pass over their bounds.
+         *
+         * With coherent culling enabled the first view is the camera and it is culled through the spatial index,
+         * which reuses the work of the last frame when the camera barely moves.
+         *
+         * @param views The views, their visible indices are sorted by the sort key of the proxies to minimize state changes.
+         */
+        void Cull(std::vector<CullingView>& views) const;
+
+        /**
+         * @brief Gets the render commands of the proxies.
+         * @return The dense array of render commands.
+         */
+        const std::vector<RenderCommand>& GetCommands() const { return m_Commands; }
+
+        /**
+         * @brief Gets the world bounds of the proxies, they match the order of the commands.
+         *
+         * They are computed when a proxy is added or moved, so the culling never transforms the bounds of the meshes.
+         *
+         * @return The world bounds as structure of arrays.
+         */
+        const AABBSoA& GetBounds() const { return m_WorldBounds; }
+
+        /**
+         * @brief Gets the number of proxies.
+         * @return The number of proxies.
+         */
+        uint32_t GetProxyCount() const { return static_cast<uint32_t>(m_Commands.size()); }
+
+        /**
+         * @brief Gets the version of the static shadow casters.
+         *
+         * It changes every time a static caster is added, removed or modified and it is unique among all the render
+         * worlds, so it can be used as the key of cached data.
+         *
+         * @return The version of the static shadow casters.
+         */
+        uint64_t GetStaticVersion() const { return m_StaticVersion; }
+
+        /**
+         * @brief Gets the number of proxies that cast shadows and are not static.
+         * @return The number of dynamic shadow casters.
+         */
+        uint32_t GetDynamicCasterCount() const { return m_DynamicCasterCount; }
+
+        /**
+         * @brief Gets the bounding volume hierarchy of the proxies, the objects are identified by their entityID.
+         * @return The spatial index of the proxies.
+         */
+        const DynamicAABBTree& GetSpatialIndex() const { return m_SpatialIndex; }
+
+    private:
+        static uint64_t CalculateSortKey(const RenderCommand& command);
+
+        void OnProxyAdded(const RenderCommand& command);
+        void OnProxyRemoved(const RenderCommand& command);
+
+    private:
+        std::vector<RenderCommand> m_Commands; ///< Transform, mesh, material and flags of each proxy.
+        AABBSoA m_WorldBounds; ///< World bounds of each proxy.
+        std::vector<uint64_t> m_SortKeys; ///< Shader, material and mesh key of each proxy.
+        std::unordered_map<uint32_t, uint32_t> m_ProxyIndices; ///< Dense index of the proxy of each entity.
+        DynamicAABBTree m_SpatialIndex; ///< World bounds of the proxies keyed by entity.
+
+        uint64_t m_StaticVersion = 0;
+        uint32_t m_DynamicCasterCount = 0;
+
+        mutable FrustumCoherence m_CameraCoherence; ///< Frame to frame state of the camera queries to the spatial index.
+        mutable std::vector<uint32_t> m_QueryScratch;
+        mutable std::vector<std::pair<uint64_t, uint32_t>> m_SortScratch;
+    };
+
+    /** @} */
+}
@@ -1,20 +1,27 @@
 #include "Renderer.h"
+#include "CoffeeEngine/Math/Frustum.h"
 #include "CoffeeEngine/Renderer/Material.h"
 #include "CoffeeEngine/Scene/PrimitiveMesh.h"
 #include "CoffeeEngine/Renderer/DebugRenderer.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
+#include "CoffeeEngine/Renderer/EnvironmentLighting.h"
 #include "CoffeeEngine/Renderer/Framebuffer.h"
 #include "CoffeeEngine/Renderer/Mesh.h"
+#include "CoffeeEngine/Renderer/RenderWorld.h"
 #include "CoffeeEngine/Renderer/RendererAPI.h"
 #include "CoffeeEngine/Renderer/Shader.h"
+#include "CoffeeEngine/Renderer/ShadowRenderer.h"
 #include "CoffeeEngine/Renderer/Texture.h"
 #include "CoffeeEngine/Renderer/UniformBuffer.h"
 
 #include "CoffeeEngine/Embedded/ToneMappingShader.inl"
 #include "CoffeeEngine/Embedded/FinalPassShader.inl"
 #include "CoffeeEngine/Embedded/MissingShader.inl"
+#include "CoffeeEngine/Embedded/GBufferShader.inl"
+#include "CoffeeEngine/Embedded/DeferredLightingShader.inl"
 
 #include <cstdint>
+#include <iterator>
 #include <glm/fwd.hpp>
 #include <glm/matrix.hpp>
 #include <tracy/Tracy.hpp>
@@ -30,6 +37,7 @@ namespace Coffee {
 
     Ref<Framebuffer> Renderer::s_MainFramebuffer;
     Ref<Framebuffer> Renderer::s_PostProcessingFramebuffer;
+    Ref<Framebuffer> Renderer::s_GBuffer;
     Ref<Texture2D> Renderer::s_MainRenderTexture;
     Ref<Texture2D> Renderer::s_EntityIDTexture;
     Ref<Texture2D> Renderer::s_PostProcessingTexture;
@@ -39,11 +47,36 @@ namespace Coffee {
 
     Ref<Shader> Renderer::s_ToneMappingShader;
     Ref<Shader> Renderer::s_FinalPassShader;
+    Ref<Shader> Renderer::s_GBufferShader;
+    Ref<Shader> Renderer::s_DeferredLightingShader;
 
     static Ref<Cubemap> s_EnvironmentMap;
+    static Ref<EnvironmentLighting> s_EnvironmentLighting;
     static Ref<Mesh> s_SkyboxMesh;
     static Ref<Shader> s_SkyboxShader;
 
+    // G-buffer attachments: albedo + metallic, octahedral normal + roughness + ao, emissive, entity ID
+    enum GBufferAttachment : uint32_t
+    {
+        GBufferAlbedoMetallic = 0,
+        GBufferNormalRoughnessAO = 1,
+        GBufferEmissive = 2,
+        GBufferEntityID = 3
+    };
+
+    static glm::vec3 EntityIDToVec3(uint32_t entityID)
+    {
+        uint32_t r = (entityID & 0x000000FF) >> 0;
+        uint32_t g = (entityID & 0x0000FF00) >> 8;
+        uint32_t b = (entityID & 0x00FF0000) >> 16;
+        return glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
+    }
+
+    static bool IsDeferredCommand(const RenderCommand& command)
+    {
+        return command.material && command.material->UsesStandardShader();
+    }
+
     void Renderer::Init()
     {
         /*std::vector<std::filesystem::path> paths = {
@@ -66,15 +99,25 @@ namespace Coffee {
 
         RendererAPI::Init();
         DebugRenderer::Init();
+        ShadowRenderer::Init();
 
         s_RendererData.CameraUniformBuffer = UniformBuffer::Create(sizeof(RendererData::CameraData), 0);
         s_RendererData.RenderDataUniformBuffer = UniformBuffer::Create(sizeof(RendererData::RenderData), 1);
+        s_RendererData.EnvironmentUniformBuffer = UniformBuffer::Create(sizeof(EnvironmentUniformData), 3);
+
+        // Loaded from the cache after the first run, the environment does not change so it is uploaded once
+        s_EnvironmentLighting = EnvironmentLighting::Create(s_EnvironmentMap);
+        s_RendererData.EnvironmentUniformBuffer->SetData(&s_EnvironmentLighting->GetUniformData(), sizeof(EnvironmentUniformData));
+
+        // The faces are already on the GPU and in the cache
+        if(s_EnvironmentMap) s_EnvironmentMap->ReleaseCPUData();
 
         Ref<Shader> missingShader = CreateRef<Shader>("MissingShader", std::string(missingShaderSource));
         s_RendererData.DefaultMaterial = CreateRef<Material>("Missing Material", missingShader); //TODO: Port it to use the Material::Create
 
         s_MainFramebuffer = Framebuffer::Create(1280, 720, { ImageFormat::RGBA32F, ImageFormat::RGB8, ImageFormat::DEPTH24STENCIL8 });
         s_PostProcessingFramebuffer = Framebuffer::Create(1280, 720, { ImageFormat::RGBA8 });
+        s_GBuffer = Framebuffer::Create(1280, 720, { ImageFormat::RGBA8, ImageFormat::RGBA16F, ImageFormat::RGBA16F, ImageFormat::RGB8, ImageFormat::DEPTH24STENCIL8 });
 
         s_MainRenderTexture = s_MainFramebuffer->GetColorTexture(0);
         s_EntityIDTexture = s_MainFramebuffer->GetColorTexture(1);
@@ -86,10 +129,31 @@ namespace Coffee {
 
         s_ToneMappingShader = CreateRef<Shader>("ToneMappingShader", std::string(toneMappingShaderSource));
         s_FinalPassShader = CreateRef<Shader>("FinalPassShader", std::string(finalPassShaderSource));
+
+        s_GBufferShader = CreateRef<Shader>("GBufferShader", std::string(gBufferShaderSource));
+        s_GBufferShader->Bind();
+        s_GBufferShader->setInt("material.albedoMap", 0);
+        s_GBufferShader->setInt("material.normalMap", 1);
+        s_GBufferShader->setInt("material.metallicMap", 2);
+        s_GBufferShader->setInt("material.roughnessMap", 3);
+        s_GBufferShader->setInt("material.aoMap", 4);
+        s_GBufferShader->setInt("material.emissiveMap", 5);
+        s_GBufferShader->Unbind();
+
+        s_DeferredLightingShader = CreateRef<Shader>("DeferredLightingShader", std::string(deferredLightingShaderSource));
+        s_DeferredLightingShader->Bind();
+        s_DeferredLightingShader->setInt("gAlbedoMetallic", 0);
+        s_DeferredLightingShader->setInt("gNormalRoughnessAO", 1);
+        s_DeferredLightingShader->setInt("gEmissive", 2);
+        s_DeferredLightingShader->setInt("gEntityID", 3);
+        s_DeferredLightingShader->setInt("gDepth", 4);
+        s_DeferredLightingShader->Unbind();
     }
 
     void Renderer::Shutdown()
     {
+        s_EnvironmentLighting.reset();
+        ShadowRenderer::Shutdown();
     }
 
     void Renderer::BeginScene(EditorCamera& camera)
@@ -111,6 +175,7 @@ namespace Coffee {
         s_RendererData.CameraUniformBuffer->SetData(&s_RendererData.cameraData, sizeof(RendererData::CameraData));
 
         s_RendererData.renderData.lightCount = 0;
+        s_RendererData.shadowedLights.clear();
     }
 
     void Renderer::BeginScene(Camera& camera, const glm::mat4& transform)
@@ -128,10 +193,40 @@ namespace Coffee {
         s_RendererData.CameraUniformBuffer->SetData(&s_RendererData.cameraData, sizeof(RendererData::CameraData));
 
         s_RendererData.renderData.lightCount = 0;
+        s_RendererData.shadowedLights.clear();
     }
 
     void Renderer::EndScene()
     {
+        const RenderWorld* world = s_RendererData.renderWorld;
+
+        // Writes the shadow views of the lights before they are uploaded
+        ShadowRenderer::Render(world, s_RendererData.renderQueue, s_RendererData.shadowedLights, s_RendererData.cameraData, s_RendererData.renderData);
+        ShadowRenderer::Bind(8);
+        s_EnvironmentLighting->Bind(6, 7);
+
+        s_RendererData.RenderDataUniformBuffer->SetData(&s_RendererData.renderData, sizeof(RendererData::RenderData));
+
+        const bool deferred = s_RenderSettings.Path == RenderPath::Deferred;
+
+        s_RendererData.visibleProxies.clear();
+        if(world)
+        {
+            const RendererData::CameraData& cameraData = s_RendererData.cameraData;
+
+            std::vector<CullingView>& views = s_RendererData.cullingViews;
+            views.resize(1);
+            views[0].ViewFrustum = Frustum(cameraData.projection * cameraData.view);
+
+            world->Cull(views);
+            s_RendererData.visibleProxies.swap(views[0].VisibleIndices);
+        }
+
+        if(deferred)
+        {
+            DeferredGeometryPass();
+        }
+
         s_MainFramebuffer->Bind();
         s_MainFramebuffer->SetDrawBuffers({0, 1});
 
@@ -141,12 +236,19 @@ namespace Coffee {
         // Currently this is done also in the runtime, this should be done only in editor mode
         s_EntityIDTexture->Clear({-1.0f,0.0f,0.0f,0.0f});
 
-        s_RendererData.RenderDataUniformBuffer->SetData(&s_RendererData.renderData, sizeof(RendererData::RenderData));
-
-        // Sort the render queue to minimize state changes
+        if(deferred)
+        {
+            DeferredLightingPass();
+        }
 
-        for(const auto& command : s_RendererData.renderQueue)
+        auto drawCommand = [deferred](const RenderCommand& command)
         {
+            // Already shaded by the deferred lighting pass, custom shaders keep going through the forward path
+            if(deferred && IsDeferredCommand(command))
+            {
+                return;
+            }
+
             Material* material = command.material.get();
 
             if(material == nullptr)
@@ -165,13 +267,7 @@ namespace Coffee {
             //REMOVE: This is for the first release of the engine it should be handled differently
             shader->setBool("showNormals", s_RenderSettings.showNormals);
 
-            // Convert entityID to vec3
-            uint32_t r = (command.entityID & 0x000000FF) >> 0;
-            uint32_t g = (command.entityID & 0x0000FF00) >> 8;
-            uint32_t b = (command.entityID & 0x00FF0000) >> 16;
-            glm::vec3 entityIDVec3 = glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
-
-            shader->setVec3("entityID", entityIDVec3);
+            shader->setVec3("entityID", EntityIDToVec3(command.entityID));
 
             RendererAPI::DrawIndexed(command.mesh->GetVertexArray());
 
@@ -179,11 +275,27 @@ namespace Coffee {
 
             s_Stats.VertexCount += command.mesh->GetVertices().size();
             s_Stats.IndexCount += command.mesh->GetIndices().size();
+        };
+
+        // The visible proxies are already sorted by shader, material and mesh to minimize state changes
+        if(world)
+        {
+            const std::vector<RenderCommand>& commands = world->GetCommands();
+            for(uint32_t index : s_RendererData.visibleProxies)
+            {
+                drawCommand(commands[index]);
+            }
+        }
+
+        for(const auto& command : s_RendererData.renderQueue)
+        {
+            drawCommand(command);
         }
 
         // Test drawing the skybox
         RendererAPI::SetDepthMask(false);
         s_SkyboxShader->Bind();
+        if(s_EnvironmentMap) s_EnvironmentMap->Bind(0);
         RendererAPI::DrawIndexed(s_SkyboxMesh->GetVertexArray());
         RendererAPI::SetDepthMask(true);
 
@@ -229,6 +341,84 @@ namespace Coffee {
         s_MainFramebuffer->UnBind();
 
         s_RendererData.renderQueue.clear();
+        s_RendererData.renderWorld = nullptr;
+    }
+
+    void Renderer::DeferredGeometryPass()
+    {
+        ZoneScoped;
+
+        s_GBuffer->Bind();
+        s_GBuffer->SetDrawBuffers({GBufferAlbedoMetallic, GBufferNormalRoughnessAO, GBufferEmissive, GBufferEntityID});
+
+        RendererAPI::SetClearColor({0.0f, 0.0f, 0.0f, 0.0f});
+        RendererAPI::Clear();
+
+        // The G-buffer stores raw material data, blending would mix it with the cleared values
+        RendererAPI::SetBlending(false);
+
+        auto drawCommand = [](const RenderCommand& command)
+        {
+            if(!IsDeferredCommand(command))
+            {
+                return;
+            }
+
+            command.material->Use(s_GBufferShader);
+
+            s_GBufferShader->setMat4("model", command.transform);
+            s_GBufferShader->setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(command.transform))));
+            s_GBufferShader->setVec3("entityID", EntityIDToVec3(command.entityID));
+
+            RendererAPI::DrawIndexed(command.mesh->GetVertexArray());
+
+            s_Stats.DrawCalls++;
+
+            s_Stats.VertexCount += command.mesh->GetVertices().size();
+            s_Stats.IndexCount += command.mesh->GetIndices().size();
+        };
+
+        if(s_RendererData.renderWorld)
+        {
+            const std::vector<RenderCommand>& commands = s_RendererData.renderWorld->GetCommands();
+            for(uint32_t index : s_RendererData.visibleProxies)
+            {
+                drawCommand(commands[index]);
+            }
+        }
+
+        for(const auto& command : s_RendererData.renderQueue)
+        {
+            drawCommand(command);
+        }
+
+        RendererAPI::SetBlending(true);
+    }
+
+    void Renderer::DeferredLightingPass()
+    {
+        ZoneScoped;
+
+        const RendererData::CameraData& cameraData = s_RendererData.cameraData;
+
+        s_DeferredLightingShader->Bind();
+        s_DeferredLightingShader->setMat4("inverseViewProjection", glm::inverse(cameraData.projection * cameraData.view));
+
+        //REMOVE: This is for the first release of the engine it should be handled differently
+        s_DeferredLightingShader->setBool("showNormals", s_RenderSettings.showNormals);
+
+        s_GBuffer->GetColorTexture(GBufferAlbedoMetallic)->Bind(0);
+        s_GBuffer->GetColorTexture(GBufferNormalRoughnessAO)->Bind(1);
+        s_GBuffer->GetColorTexture(GBufferEmissive)->Bind(2);
+        s_GBuffer->GetColorTexture(GBufferEntityID)->Bind(3);
+        s_GBuffer->GetDepthTexture()->Bind(4);
+
+        // One screen-space pass: every lit pixel is shaded once, the lights are rejected per pixel by range
+        RendererAPI::DrawIndexed(s_ScreenQuad->GetVertexArray());
+
+        s_Stats.DrawCalls++;
+
+        s_DeferredLightingShader->Unbind();
     }
 
     //TEMPORAL
@@ -247,10 +437,35 @@ namespace Coffee {
         s_MainFramebuffer->UnBind();
     }
 
-    void Renderer::Submit(const LightComponent& light)
+    void Renderer::Submit(const LightComponent& light, uint32_t entityID)
     {
-        s_RendererData.renderData.lights[s_RendererData.renderData.lightCount] = light;
-        s_RendererData.renderData.lightCount++;
+        RendererData::RenderData& renderData = s_RendererData.renderData;
+
+        if(renderData.lightCount >= static_cast<int>(std::size(renderData.lights)))
+        {
+            COFFEE_CORE_WARN("Renderer: Maximum number of lights reached, the light is ignored");
+            return;
+        }
+
+        LightData& lightData = renderData.lights[renderData.lightCount];
+        lightData.color = light.Color;
+        lightData.direction = light.Direction;
+        lightData.position = light.Position;
+        lightData.range = light.Range;
+        lightData.attenuation = light.Attenuation;
+        lightData.intensity = light.Intensity;
+        lightData.angle = light.Angle;
+        lightData.type = light.type;
+        lightData.shadowIndex = -1;
+        lightData.shadowCount = 0;
+        lightData.shadowBias = 0.0f;
+
+        if(light.CastShadows)
+        {
+            s_RendererData.shadowedLights.push_back({ static_cast<uint32_t>(renderData.lightCount), entityID, light });
+        }
+
+        renderData.lightCount++;
     }
 
     void Renderer::Submit(const RenderCommand& command)
@@ -258,6 +473,11 @@ namespace Coffee {
         s_RendererData.renderQueue.push_back(command);
     }
 
+    void Renderer::Submit(const RenderWorld& world)
+    {
+        s_RendererData.renderWorld = &world;
+    }
+
     // Temporal, this should be removed because this is rendering immediately.
     void Renderer::Submit(const Ref<Shader>& shader, const Ref<VertexArray>& vertexArray, const glm::mat4& transform, uint32_t entityID)
     {
@@ -268,13 +488,7 @@ namespace Coffee {
         //REMOVE: This is for the first release of the engine it should be handled differently
         shader->setBool("showNormals", s_RenderSettings.showNormals);
 
-        // Convert entityID to vec3
-        uint32_t r = (entityID & 0x000000FF) >> 0;
-        uint32_t g = (entityID & 0x0000FF00) >> 8;
-        uint32_t b = (entityID & 0x00FF0000) >> 16;
-        glm::vec3 entityIDVec3 = glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
-
-        shader->setVec3("entityID", entityIDVec3);
+        shader->setVec3("entityID", EntityIDToVec3(entityID));
 
         RendererAPI::DrawIndexed(vertexArray);
 
@@ -293,5 +507,6 @@ namespace Coffee {
     {
         s_MainFramebuffer->Resize(s_viewportWidth, s_viewportHeight);
         s_PostProcessingFramebuffer->Resize(s_viewportWidth, s_viewportHeight);
+        s_GBuffer->Resize(s_viewportWidth, s_viewportHeight);
     }
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
+#include "CoffeeEngine/Renderer/CullingService.h"
 #include "CoffeeEngine/Renderer/Framebuffer.h"
 #include "CoffeeEngine/Renderer/Material.h"
 #include "CoffeeEngine/Renderer/Mesh.h"
@@ -20,12 +21,49 @@ namespace Coffee {
      * @{
      */
 
+    class RenderWorld;
+
+    /// Entity ID of the draws and lights that belong to no entity, the value of entt::null.
+    inline constexpr uint32_t NullEntityID = static_cast<uint32_t>(entt::entity{entt::null});
+
     struct RenderCommand
     {
         glm::mat4 transform;
         Ref<Mesh> mesh;
         Ref<Material> material;
         uint32_t entityID;
+        bool castShadows = true; ///< Whether the mesh is rendered into the shadow maps.
+        bool isStatic = false; ///< Whether the mesh is a static shadow caster that can be cached.
+    };
+
+    /**
+     * @brief GPU representation of a light, it matches the std140 layout of the Light struct in the shaders.
+     */
+    struct LightData
+    {
+        alignas(16) glm::vec3 color; ///< The color of the light.
+        alignas(16) glm::vec3 direction; ///< The direction of the light.
+        alignas(16) glm::vec3 position; ///< The position of the light.
+
+        float range; ///< The range of the light.
+        float attenuation; ///< The attenuation of the light.
+        float intensity; ///< The intensity of the light.
+        float angle; ///< The angle of the light.
+
+        int type; ///< The type of the light.
+        int shadowIndex = -1; ///< The first shadow view of the light, -1 if it has no shadows.
+        int shadowCount = 0; ///< The number of shadow views (cascades or cube faces) of the light.
+        float shadowBias = 0.0f; ///< The depth bias applied when sampling the shadow map.
+    };
+
+    /**
+     * @brief A submitted light that casts shadows.
+     */
+    struct ShadowedLight
+    {
+        uint32_t lightIndex; ///< Index of the light in the RenderData lights array.
+        uint32_t entityID; ///< The entity that owns the light.
+        LightComponent light; ///< The light with its shadow settings.
     };
 
     /**
@@ -48,7 +86,7 @@ namespace Coffee {
          */
         struct RenderData
         {
-            LightComponent lights[32]; ///< Array of light components.
+            LightData lights[32]; ///< Array of lights.
             int lightCount = 0; ///< Number of lights.
         };
 
@@ -57,12 +95,19 @@ namespace Coffee {
 
         Ref<UniformBuffer> CameraUniformBuffer; ///< Uniform buffer for camera data.
         Ref<UniformBuffer> RenderDataUniformBuffer; ///< Uniform buffer for render data.
+        Ref<UniformBuffer> EnvironmentUniformBuffer; ///< Uniform buffer for the image based lighting data.
 
         Ref<Material> DefaultMaterial; ///< Default material.
 
         Ref<Texture2D> RenderTexture; ///< Render texture.
 
         std::vector<RenderCommand> renderQueue; ///< Render queue.
+
+        const RenderWorld* renderWorld = nullptr; ///< Persistent render proxies of the current scene.
+        std::vector<uint32_t> visibleProxies; ///< Proxies of the render world that pass the camera culling, sorted by state.
+        std::vector<CullingView> cullingViews; ///< Views culled at the end of the scene, the camera is the first one.
+
+        std::vector<ShadowedLight> shadowedLights; ///< Lights of the current scene that cast shadows.
     };
 
     /**
@@ -75,11 +120,21 @@ namespace Coffee {
         uint32_t IndexCount = 0; ///< Number of indices.
     };
 
+    /**
+     * @brief Enum representing the lighting path used to render the opaque geometry.
+     */
+    enum class RenderPath
+    {
+        Forward, ///< Every object evaluates all the lights while it is rasterized.
+        Deferred ///< The material data is written to a G-buffer and the lights are evaluated once per visible pixel.
+    };
+
     /**
      * @brief Structure containing render settings.
      */
     struct RenderSettings
     {
+        RenderPath Path = RenderPath::Forward; ///< The lighting path used for the standard materials.
         bool PostProcessing = true; ///< Enable or disable post-processing.
         bool SSAO = false; ///< Enable or disable SSAO.
         bool Bloom = false; ///< Enable or disable bloom.
@@ -137,15 +192,22 @@ namespace Coffee {
 
         static void Submit(const RenderCommand& command);
 
-        static void Submit(const Ref<Shader>& shader, const Ref<VertexArray>& vertexArray, const glm::mat4& transform = glm::mat4(1.0f), uint32_t entityID = 4294967295);
+        /**
+         * @brief Submits the render world of the scene, its proxies are culled and drawn at the end of the scene.
+         * @param world The render world, it has to stay alive until EndScene.
+         */
+        static void Submit(const RenderWorld& world);
+
+        static void Submit(const Ref<Shader>& shader, const Ref<VertexArray>& vertexArray, const glm::mat4& transform = glm::mat4(1.0f), uint32_t entityID = NullEntityID);
 
         /**
          * @brief Submits a light component.
          * @param light The light component.
+         * @param entityID The entity that owns the light, used to keep its cached shadow maps between frames.
          */
 
          //Todo change this to a light class and not a component
-        static void Submit(const LightComponent& light);
+        static void Submit(const LightComponent& light, uint32_t entityID = NullEntityID);
 
         /**
          * @brief Resizes the renderer to the specified width and height.
@@ -195,6 +257,16 @@ namespace Coffee {
 
         static void ResizeFramebuffers();
 
+        /**
+         * @brief Writes the standard materials of the render queue to the G-buffer.
+         */
+        static void DeferredGeometryPass();
+
+        /**
+         * @brief Resolves the G-buffer lighting into the main framebuffer.
+         */
+        static void DeferredLightingPass();
+
     private:
         static RendererData s_RendererData; ///< Renderer data.
         static RendererStats s_Stats; ///< Renderer statistics.
@@ -207,11 +279,14 @@ namespace Coffee {
 
         static Ref<Framebuffer> s_MainFramebuffer; ///< Main framebuffer.
         static Ref<Framebuffer> s_PostProcessingFramebuffer; ///< Post-processing framebuffer.
+        static Ref<Framebuffer> s_GBuffer; ///< G-buffer used by the deferred path.
 
         static Ref<Mesh> s_ScreenQuad; ///< Screen quad mesh.
 
         static Ref<Shader> s_ToneMappingShader; ///< Tone mapping shader.
         static Ref<Shader> s_FinalPassShader; ///< Final pass shader.
+        static Ref<Shader> s_GBufferShader; ///< Deferred geometry pass shader.
+        static Ref<Shader> s_DeferredLightingShader; ///< Deferred lighting pass shader.
     };
 
     /** @} */
@@ -49,6 +49,9 @@ namespace Coffee {
 		glCullFace(GL_BACK);
 
 		glDepthFunc(GL_LEQUAL);
+
+		// Filters across the faces of the prefiltered environment maps
+		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
     }
 
 	void RendererAPI::SetClearColor(const glm::vec4& color)
@@ -72,6 +75,16 @@ namespace Coffee {
 		glDepthMask(enabled);
 	}
 
+	void RendererAPI::SetBlending(bool enabled)
+	{
+		ZoneScoped;
+
+		if(enabled)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+	}
+
     void RendererAPI::DrawIndexed(const Ref<VertexArray>& vertexArray)
     {
         ZoneScoped;
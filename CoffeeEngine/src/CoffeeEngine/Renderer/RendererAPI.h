@@ -40,6 +40,12 @@ namespace Coffee {
          */
         static void SetDepthMask(bool enabled);
 
+        /**
+         * @brief Enables or disables the alpha blending.
+         * @param enabled True to enable the blending, false to disable it.
+         */
+        static void SetBlending(bool enabled);
+
         /**
          * @brief Draws the indexed vertices from the specified vertex array.
          * @param vertexArray The vertex array containing the vertices to draw.
@@ -0,0 +1,584 @@
+#include "ShadowRenderer.h"
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Math/Frustum.h"
+#include "CoffeeEngine/Renderer/RendererAPI.h"
+#include "CoffeeEngine/Renderer/RenderWorld.h"
+#include "CoffeeEngine/Renderer/Shader.h"
+#include "CoffeeEngine/Renderer/UniformBuffer.h"
+
+#include "CoffeeEngine/Embedded/ShadowDepthShader.inl"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <tracy/Tracy.hpp>
+#include <unordered_map>
+
+namespace Coffee {
+
+    ShadowStats ShadowRenderer::s_Stats;
+
+    static constexpr uint32_t s_AtlasSize = 4096;
+    static constexpr uint32_t s_MinTileSize = 128;
+    static constexpr int s_MaxCascades = 4;
+
+    /**
+     * @brief State kept between frames for every shadow view.
+     */
+    struct ShadowViewCache
+    {
+        glm::mat4 viewProjection = glm::mat4(0.0f); ///< The matrix the cached tiles were rendered with.
+        uint64_t staticKey = 0; ///< Hash of the static casters, the matrix and the tile of the cached static layer.
+        uint64_t lastDynamicFrame = 0; ///< Frame of the last dynamic update.
+        bool hasDynamicCasters = false; ///< Whether the last dynamic update drew any caster on top of the static layer.
+        uint64_t lastUsedFrame = 0; ///< Frame the view was last requested, unused views are evicted.
+    };
+
+    /**
+     * @brief A shadow view requested for the current frame.
+     */
+    struct ShadowViewRequest
+    {
+        uint64_t key; ///< Identifies the view between frames (owner entity and view index).
+        size_t lightSlot; ///< Index in the shadowed lights array.
+        uint32_t resolution; ///< Requested size of the tile.
+        glm::ivec4 rect = glm::ivec4(0); ///< Tile in the atlas (x, y, width, height).
+    };
+
+    /**
+     * @brief A tile that has to be rendered this frame, the views are gathered first so they are all culled at once.
+     */
+    struct ShadowViewUpdate
+    {
+        const ShadowViewRequest* request;
+        ShadowViewCache* cache;
+        glm::mat4 viewProjection; ///< The matrix of the current frame.
+        uint64_t staticKey;
+        bool staticDirty;
+        bool dynamicDue;
+        uint32_t shadowIndex; ///< Index of the view in the shadow uniform data.
+    };
+
+    static uint32_t s_StaticAtlas = 0; ///< Depth atlas with the cached static casters.
+    static uint32_t s_DynamicAtlas = 0; ///< Depth atlas sampled by the shaders.
+    static uint32_t s_StaticFramebuffer = 0;
+    static uint32_t s_DynamicFramebuffer = 0;
+
+    static Ref<Shader> s_ShadowDepthShader;
+    static Ref<UniformBuffer> s_ShadowUniformBuffer;
+    static ShadowUniformData s_ShadowData;
+
+    static std::unordered_map<uint64_t, ShadowViewCache> s_ViewCache;
+    static uint64_t s_FrameIndex = 0;
+    static std::vector<CullingView> s_CullingViews; ///< Views of the tiles updated this frame, reused between frames.
+
+    static uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+    {
+        // FNV-1a
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static uint32_t CreateAtlas()
+    {
+        uint32_t texture;
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        glTextureStorage2D(texture, 1, GL_DEPTH_COMPONENT32F, s_AtlasSize, s_AtlasSize);
+
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTextureParameteri(texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        float clearDepth = 1.0f;
+        glClearTexImage(texture, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+
+        return texture;
+    }
+
+    static uint32_t CreateDepthFramebuffer(uint32_t depthTexture)
+    {
+        uint32_t framebuffer;
+        glCreateFramebuffers(1, &framebuffer);
+        glNamedFramebufferTexture(framebuffer, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+        glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
+        glNamedFramebufferReadBuffer(framebuffer, GL_NONE);
+        return framebuffer;
+    }
+
+    static uint32_t GetViewCount(const LightComponent& light)
+    {
+        switch (light.type)
+        {
+            case LightComponent::DirectionalLight: return std::clamp(light.ShadowCascadeCount, 1, s_MaxCascades);
+            case LightComponent::PointLight: return 6;
+            case LightComponent::SpotLight: return 1;
+        }
+        return 0;
+    }
+
+    static glm::vec3 GetUpVector(const glm::vec3& direction)
+    {
+        return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    // Fits each cascade to a bounding sphere of its slice of the camera frustum. The sphere keeps the size of the
+    // cascade constant when the camera rotates and the center is snapped to a coarse grid of whole texels, so the
+    // matrix (and the cached static layer) only changes after the camera has moved a noticeable distance.
+    static void ComputeCascades(const LightComponent& light, const RendererData::CameraData& cameraData,
+                                const std::vector<ShadowViewRequest>& requests, size_t firstRequest,
+                                glm::mat4* outMatrices, glm::vec4& outSplits)
+    {
+        const glm::mat4& projection = cameraData.projection;
+
+        float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+        float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+        float shadowDistance = std::clamp(light.ShadowDistance, nearPlane + 0.01f, farPlane);
+
+        float tanHalfX = 1.0f / projection[0][0];
+        float tanHalfY = 1.0f / projection[1][1];
+
+        glm::mat4 inverseView = glm::inverse(cameraData.view);
+
+        glm::vec3 direction = glm::normalize(light.Direction);
+        glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, GetUpVector(direction));
+
+        int cascadeCount = static_cast<int>(GetViewCount(light));
+        float previousSplit = nearPlane;
+
+        outSplits = glm::vec4(0.0f);
+
+        for (int i = 0; i < cascadeCount; i++)
+        {
+            float t = static_cast<float>(i + 1) / cascadeCount;
+            float logSplit = nearPlane * std::pow(shadowDistance / nearPlane, t);
+            float uniformSplit = nearPlane + (shadowDistance - nearPlane) * t;
+            float split = glm::mix(uniformSplit, logSplit, 0.75f);
+
+            outSplits[i] = split;
+
+            glm::vec3 corners[8];
+            glm::vec3 center(0.0f);
+            for (int c = 0; c < 8; c++)
+            {
+                float z = c < 4 ? previousSplit : split;
+                float x = (c & 1) ? z * tanHalfX : -z * tanHalfX;
+                float y = (c & 2) ? z * tanHalfY : -z * tanHalfY;
+
+                corners[c] = glm::vec3(inverseView * glm::vec4(x, y, -z, 1.0f));
+                center += corners[c];
+            }
+            center /= 8.0f;
+
+            float radius = 0.0f;
+            for (int c = 0; c < 8; c++)
+            {
+                radius = std::max(radius, glm::length(corners[c] - center));
+            }
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            float tileSize = static_cast<float>(requests[firstRequest + i].rect.z);
+            float texelSize = 2.0f * radius * 1.0625f / tileSize;
+            float snapStep = texelSize * std::max(1.0f, std::floor(radius * 0.0625f / texelSize));
+
+            // The snapped center can move up to one step away, grow the cascade so the slice stays covered
+            float paddedRadius = radius + snapStep;
+
+            glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+            lightSpaceCenter = glm::floor(lightSpaceCenter / snapStep) * snapStep;
+
+            // Pull the near plane towards the light so casters outside of the slice still cast into it
+            glm::mat4 lightProjection = glm::ortho(lightSpaceCenter.x - paddedRadius, lightSpaceCenter.x + paddedRadius,
+                                                   lightSpaceCenter.y - paddedRadius, lightSpaceCenter.y + paddedRadius,
+                                                   -lightSpaceCenter.z - paddedRadius - shadowDistance,
+                                                   -lightSpaceCenter.z + paddedRadius);
+
+            outMatrices[i] = lightProjection * lightRotation;
+
+            previousSplit = split;
+        }
+    }
+
+    static void ComputeSpotView(const LightComponent& light, glm::mat4* outMatrices)
+    {
+        glm::vec3 direction = glm::normalize(light.Direction);
+        float fov = std::min(light.Angle * 2.0f + 5.0f, 170.0f);
+
+        glm::mat4 projection = glm::perspective(glm::radians(fov), 1.0f, 0.05f, std::max(light.Range, 0.1f));
+        glm::mat4 view = glm::lookAt(light.Position, light.Position + direction, GetUpVector(direction));
+
+        outMatrices[0] = projection * view;
+    }
+
+    // Same face order as the cubemaps: +X, -X, +Y, -Y, +Z, -Z
+    static void ComputePointViews(const LightComponent& light, glm::mat4* outMatrices)
+    {
+        static const glm::vec3 directions[6] = {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+        };
+        static const glm::vec3 ups[6] = {
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+            { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }
+        };
+
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.05f, std::max(light.Range, 0.1f));
+
+        for (int face = 0; face < 6; face++)
+        {
+            outMatrices[face] = projection * glm::lookAt(light.Position, light.Position + directions[face], ups[face]);
+        }
+    }
+
+    // Shelf packing, the requests are sorted by size so power of two tiles fill the rows without gaps.
+    // Tiles that do not fit are halved until they reach the minimum size.
+    static void AllocateTiles(std::vector<ShadowViewRequest>& requests)
+    {
+        std::vector<size_t> order(requests.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return requests[a].resolution > requests[b].resolution;
+        });
+
+        uint32_t x = 0, y = 0, shelfHeight = 0;
+
+        for (size_t index : order)
+        {
+            ShadowViewRequest& request = requests[index];
+            uint32_t size = std::clamp(request.resolution, s_MinTileSize, s_AtlasSize);
+
+            while (size >= s_MinTileSize)
+            {
+                if (x + size > s_AtlasSize)
+                {
+                    x = 0;
+                    y += shelfHeight;
+                    shelfHeight = 0;
+                }
+
+                if (y + size <= s_AtlasSize)
+                    break;
+
+                size /= 2;
+            }
+
+            if (size < s_MinTileSize)
+            {
+                request.rect = glm::ivec4(0);
+                continue;
+            }
+
+            request.rect = glm::ivec4(x, y, size, size);
+            x += size;
+            shelfHeight = std::max(shelfHeight, size);
+        }
+    }
+
+    static void RenderCasters(uint32_t framebuffer, const glm::ivec4& rect, const glm::mat4& viewProjection,
+                              const RenderWorld* world, const std::vector<uint32_t>& visibleProxies,
+                              const std::vector<RenderCommand>& renderQueue, bool staticCasters)
+    {
+        ZoneScoped;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(rect.x, rect.y, rect.z, rect.w);
+
+        Frustum frustum(viewProjection);
+
+        s_ShadowDepthShader->setMat4("lightViewProjection", viewProjection);
+
+        auto drawCaster = [&](const RenderCommand& command)
+        {
+            s_ShadowDepthShader->setMat4("model", command.transform);
+            RendererAPI::DrawIndexed(command.mesh->GetVertexArray());
+        };
+
+        auto isCaster = [staticCasters](const RenderCommand& command)
+        {
+            return command.castShadows && command.isStatic == staticCasters;
+        };
+
+        // The proxies of the render world were already culled with the other views, only the immediate commands are culled here
+        if (world)
+        {
+            const std::vector<RenderCommand>& commands = world->GetCommands();
+            for (uint32_t index : visibleProxies)
+            {
+                if (isCaster(commands[index]))
+                    drawCaster(commands[index]);
+            }
+        }
+
+        for (const RenderCommand& command : renderQueue)
+        {
+            if (isCaster(command) && frustum.Contains(command.mesh->GetAABB().CalculateTransformedAABB(command.transform)))
+                drawCaster(command);
+        }
+    }
+
+    static void ClearTile(uint32_t framebuffer, const glm::ivec4& rect)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glScissor(rect.x, rect.y, rect.z, rect.w);
+        glEnable(GL_SCISSOR_TEST);
+        float clearDepth = 1.0f;
+        glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &clearDepth);
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    void ShadowRenderer::Init()
+    {
+        ZoneScoped;
+
+        s_StaticAtlas = CreateAtlas();
+        s_DynamicAtlas = CreateAtlas();
+        s_StaticFramebuffer = CreateDepthFramebuffer(s_StaticAtlas);
+        s_DynamicFramebuffer = CreateDepthFramebuffer(s_DynamicAtlas);
+
+        s_ShadowDepthShader = CreateRef<Shader>("ShadowDepthShader", std::string(shadowDepthShaderSource));
+
+        s_ShadowUniformBuffer = UniformBuffer::Create(sizeof(ShadowUniformData), 2);
+    }
+
+    void ShadowRenderer::Shutdown()
+    {
+        glDeleteFramebuffers(1, &s_StaticFramebuffer);
+        glDeleteFramebuffers(1, &s_DynamicFramebuffer);
+        glDeleteTextures(1, &s_StaticAtlas);
+        glDeleteTextures(1, &s_DynamicAtlas);
+
+        s_ViewCache.clear();
+    }
+
+    void ShadowRenderer::Render(const RenderWorld* world, const std::vector<RenderCommand>& renderQueue,
+                                const std::vector<ShadowedLight>& shadowedLights, const RendererData::CameraData& cameraData,
+                                RendererData::RenderData& renderData)
+    {
+        ZoneScoped;
+
+        s_FrameIndex++;
+        s_Stats = {};
+
+        if (shadowedLights.empty())
+            return;
+
+        // Gather the views of every light
+        std::vector<ShadowViewRequest> requests;
+        std::vector<size_t> firstRequest(shadowedLights.size());
+
+        for (size_t slot = 0; slot < shadowedLights.size(); slot++)
+        {
+            const ShadowedLight& shadowedLight = shadowedLights[slot];
+
+            // Lights without an owner are keyed by their index, they still work but lose the cache if the order changes
+            uint64_t owner = shadowedLight.entityID != NullEntityID ? shadowedLight.entityID : (0xFFFF0000ull | shadowedLight.lightIndex);
+
+            firstRequest[slot] = requests.size();
+
+            uint32_t viewCount = GetViewCount(shadowedLight.light);
+            for (uint32_t view = 0; view < viewCount; view++)
+            {
+                requests.push_back({ (owner << 8) | view, slot, shadowedLight.light.ShadowResolution });
+            }
+        }
+
+        if (requests.size() > MaxShadowViews)
+        {
+            COFFEE_CORE_WARN("ShadowRenderer: {0} shadow views requested, only {1} are supported", requests.size(), MaxShadowViews);
+        }
+
+        AllocateTiles(requests);
+
+        // Hash of the static casters, any change in the static geometry invalidates the cached layers. The render world
+        // tracks its own changes with a version so only the immediate commands are hashed every frame.
+        uint64_t staticCastersHash = 1469598103934665603ull;
+        bool hasDynamicCasters = false;
+        if (world)
+        {
+            uint64_t staticVersion = world->GetStaticVersion();
+            staticCastersHash = HashBytes(staticCastersHash, &staticVersion, sizeof(staticVersion));
+            hasDynamicCasters = world->GetDynamicCasterCount() > 0;
+        }
+
+        for (const RenderCommand& command : renderQueue)
+        {
+            if (!command.castShadows)
+                continue;
+
+            if (!command.isStatic)
+            {
+                hasDynamicCasters = true;
+                continue;
+            }
+
+            const Mesh* mesh = command.mesh.get();
+            staticCastersHash = HashBytes(staticCastersHash, &mesh, sizeof(mesh));
+            staticCastersHash = HashBytes(staticCastersHash, &command.transform, sizeof(glm::mat4));
+        }
+
+        s_ShadowDepthShader->Bind();
+
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+
+        uint32_t viewCount = 0;
+        std::vector<ShadowViewUpdate> updates;
+
+        for (size_t slot = 0; slot < shadowedLights.size(); slot++)
+        {
+            const ShadowedLight& shadowedLight = shadowedLights[slot];
+            const LightComponent& light = shadowedLight.light;
+            LightData& lightData = renderData.lights[shadowedLight.lightIndex];
+
+            uint32_t lightViewCount = GetViewCount(light);
+            size_t first = firstRequest[slot];
+
+            bool allocated = viewCount + lightViewCount <= MaxShadowViews;
+            for (uint32_t view = 0; view < lightViewCount && allocated; view++)
+            {
+                allocated = requests[first + view].rect.z > 0;
+            }
+
+            if (!allocated)
+                continue;
+
+            glm::mat4 matrices[6];
+            switch (light.type)
+            {
+                case LightComponent::DirectionalLight:
+                    ComputeCascades(light, cameraData, requests, first, matrices, s_ShadowData.cascadeSplits[shadowedLight.lightIndex]);
+                    break;
+                case LightComponent::PointLight:
+                    ComputePointViews(light, matrices);
+                    break;
+                case LightComponent::SpotLight:
+                    ComputeSpotView(light, matrices);
+                    break;
+            }
+
+            lightData.shadowIndex = static_cast<int>(viewCount);
+            lightData.shadowCount = static_cast<int>(lightViewCount);
+            lightData.shadowBias = light.ShadowBias;
+
+            uint32_t updateInterval = static_cast<uint32_t>(std::max(light.ShadowUpdateInterval, 1));
+
+            for (uint32_t view = 0; view < lightViewCount; view++)
+            {
+                const ShadowViewRequest& request = requests[first + view];
+                ShadowViewCache& cache = s_ViewCache[request.key];
+
+                uint64_t staticKey = HashBytes(staticCastersHash, &matrices[view], sizeof(glm::mat4));
+                staticKey = HashBytes(staticKey, &request.rect, sizeof(glm::ivec4));
+
+                ShadowViewUpdate update;
+                update.request = &request;
+                update.cache = &cache;
+                update.viewProjection = matrices[view];
+                update.staticKey = staticKey;
+                update.staticDirty = cache.staticKey != staticKey;
+                // Without dynamic casters the tile only has to be refreshed once to erase the last ones
+                update.dynamicDue = s_FrameIndex - cache.lastDynamicFrame >= updateInterval &&
+                                    (hasDynamicCasters || cache.hasDynamicCasters);
+                update.shadowIndex = viewCount + view;
+                updates.push_back(update);
+
+                cache.lastUsedFrame = s_FrameIndex;
+            }
+
+            viewCount += lightViewCount;
+        }
+
+        // The tiles that are rendered this frame are culled together, in one pass over the bounds of the render world.
+        // Both layers of a tile use the same matrix: the new one when the static layer is rendered again, the cached
+        // one otherwise.
+        s_CullingViews.clear();
+        std::vector<int32_t> cullingViewIndices(updates.size(), -1);
+        for (size_t i = 0; i < updates.size(); i++)
+        {
+            const ShadowViewUpdate& update = updates[i];
+            if (!update.staticDirty && !update.dynamicDue)
+                continue;
+
+            cullingViewIndices[i] = static_cast<int32_t>(s_CullingViews.size());
+            s_CullingViews.emplace_back().ViewFrustum = Frustum(update.staticDirty ? update.viewProjection : update.cache->viewProjection);
+        }
+
+        if (world && !s_CullingViews.empty())
+        {
+            CullingService::Cull(world->GetBounds(), s_CullingViews);
+        }
+
+        static const std::vector<uint32_t> s_NoProxies;
+
+        for (size_t i = 0; i < updates.size(); i++)
+        {
+            const ShadowViewUpdate& update = updates[i];
+            const glm::ivec4& rect = update.request->rect;
+            ShadowViewCache& cache = *update.cache;
+
+            const std::vector<uint32_t>& visibleProxies = cullingViewIndices[i] >= 0 ? s_CullingViews[cullingViewIndices[i]].VisibleIndices : s_NoProxies;
+
+            if (update.staticDirty)
+            {
+                ClearTile(s_StaticFramebuffer, rect);
+                RenderCasters(s_StaticFramebuffer, rect, update.viewProjection, world, visibleProxies, renderQueue, true);
+
+                cache.staticKey = update.staticKey;
+                cache.viewProjection = update.viewProjection;
+                s_Stats.StaticRenders++;
+            }
+
+            if (update.staticDirty || update.dynamicDue)
+            {
+                glCopyImageSubData(s_StaticAtlas, GL_TEXTURE_2D, 0, rect.x, rect.y, 0,
+                                   s_DynamicAtlas, GL_TEXTURE_2D, 0, rect.x, rect.y, 0,
+                                   rect.z, rect.w, 1);
+
+                RenderCasters(s_DynamicFramebuffer, rect, cache.viewProjection, world, visibleProxies, renderQueue, false);
+
+                cache.lastDynamicFrame = s_FrameIndex;
+                cache.hasDynamicCasters = hasDynamicCasters;
+                s_Stats.DynamicRenders++;
+            }
+
+            // Upload the matrix the tile was rendered with, a skipped update keeps sampling the previous one
+            ShadowUniformData::ShadowView& shadowView = s_ShadowData.views[update.shadowIndex];
+            shadowView.viewProjection = cache.viewProjection;
+            shadowView.atlasRect = glm::vec4(rect) / static_cast<float>(s_AtlasSize);
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        s_ShadowDepthShader->Unbind();
+
+        // Forget the views of removed lights so their keys do not keep stale tiles alive
+        for (auto it = s_ViewCache.begin(); it != s_ViewCache.end();)
+        {
+            if (it->second.lastUsedFrame != s_FrameIndex)
+                it = s_ViewCache.erase(it);
+            else
+                ++it;
+        }
+
+        s_Stats.Views = viewCount;
+
+        s_ShadowUniformBuffer->SetData(&s_ShadowData, sizeof(ShadowUniformData));
+    }
+
+    void ShadowRenderer::Bind(uint32_t slot)
+    {
+        glBindTextureUnit(slot, s_DynamicAtlas);
+    }
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "CoffeeEngine/Renderer/Renderer.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @brief Renderer components of the CoffeeEngine.
+     * @{
+     */
+
+    constexpr uint32_t MaxShadowViews = 64; ///< Must match MAX_SHADOW_VIEWS in the shaders.
+
+    /**
+     * @brief Structure containing the shadow data uploaded to the shaders.
+     */
+    struct ShadowUniformData
+    {
+        /**
+         * @brief A cascade, spot cone or cube face rendered into the shadow atlas.
+         */
+        struct ShadowView
+        {
+            glm::mat4 viewProjection; ///< The light view projection matrix.
+            glm::vec4 atlasRect; ///< Offset (xy) and scale (zw) of the view inside the atlas in UV space.
+        };
+
+        ShadowView views[MaxShadowViews]; ///< Array of shadow views.
+        glm::vec4 cascadeSplits[32]; ///< Far view depth of each cascade, indexed by light.
+    };
+
+    /**
+     * @brief Structure containing shadow statistics.
+     */
+    struct ShadowStats
+    {
+        uint32_t Views = 0; ///< Number of shadow views in the atlas.
+        uint32_t StaticRenders = 0; ///< Number of views whose static casters were re-rendered this frame.
+        uint32_t DynamicRenders = 0; ///< Number of views whose dynamic casters were re-rendered this frame.
+    };
+
+    /**
+     * @brief Class responsible for rendering the shadow atlas.
+     *
+     * Directional lights use cascades and spot and point lights use one and six views. All of them are packed in one
+     * depth atlas. The static casters are rendered into a cached copy of the atlas that is only refreshed when the
+     * static geometry, the light or the view changes. Each update copies the cached tile and draws the dynamic
+     * casters on top of it.
+     */
+    class ShadowRenderer
+    {
+    public:
+        /**
+         * @brief Initializes the ShadowRenderer.
+         */
+        static void Init();
+
+        /**
+         * @brief Shuts down the ShadowRenderer.
+         */
+        static void Shutdown();
+
+        /**
+         * @brief Updates the shadow atlas for the submitted lights.
+         * @param world The render world with the persistent shadow casters, it can be null.
+         * @param renderQueue The render queue with the shadow casters submitted this frame.
+         * @param shadowedLights The lights that cast shadows.
+         * @param cameraData The camera used to fit the cascades.
+         * @param renderData The light data, the shadow indices of the lights are written here.
+         */
+        static void Render(const RenderWorld* world, const std::vector<RenderCommand>& renderQueue,
+                           const std::vector<ShadowedLight>& shadowedLights, const RendererData::CameraData& cameraData,
+                           RendererData::RenderData& renderData);
+
+        /**
+         * @brief Binds the shadow atlas to the specified texture slot.
+         * @param slot The texture slot.
+         */
+        static void Bind(uint32_t slot);
+
+        /**
+         * @brief Gets the shadow statistics.
+         * @return A reference to the shadow statistics.
+         */
+        static const ShadowStats& GetStats() { return s_Stats; }
+
+    private:
+        static ShadowStats s_Stats; ///< Shadow statistics.
+    };
+
+    /** @} */
+}
@@ -3,16 +3,20 @@
 #include "CoffeeEngine/Core/Log.h"
 #include "CoffeeEngine/IO/Resource.h"
 #include "CoffeeEngine/IO/ResourceLoader.h"
+#include "CoffeeEngine/Renderer/CubemapConversion.h"
 
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/memory.hpp>
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <glad/glad.h>
 #include <stb_image.h>
+#include <glm/gtc/packing.hpp>
 #include <glm/vec4.hpp>
 #include <tracy/Tracy.hpp>
 
@@ -29,6 +33,9 @@ namespace Coffee {
             case ImageFormat::RGBA8: return GL_RGBA8; break;
             case ImageFormat::SRGBA8: return GL_SRGB8_ALPHA8; break;
             case ImageFormat::R32F: return GL_R32F; break;
+            case ImageFormat::RG16F: return GL_RG16F; break;
+            case ImageFormat::RGBA16F: return GL_RGBA16F; break;
+            case ImageFormat::RGB9E5: return GL_RGB9_E5; break;
             case ImageFormat::RGB32F: return GL_RGB32F; break;
             case ImageFormat::RGBA32F: return GL_RGBA32F; break;
             case ImageFormat::DEPTH24STENCIL8: return GL_DEPTH24_STENCIL8; break;
@@ -46,6 +53,9 @@ namespace Coffee {
             case ImageFormat::RGBA8: return GL_RGBA; break;
             case ImageFormat::SRGBA8: return GL_RGBA; break;
             case ImageFormat::R32F: return GL_RED; break;
+            case ImageFormat::RG16F: return GL_RG; break;
+            case ImageFormat::RGBA16F: return GL_RGBA; break;
+            case ImageFormat::RGB9E5: return GL_RGB; break;
             case ImageFormat::RGB32F: return GL_RGB; break;
             case ImageFormat::RGBA32F: return GL_RGBA; break;
             case ImageFormat::DEPTH24STENCIL8: return GL_DEPTH_STENCIL; break;
@@ -63,6 +73,9 @@ namespace Coffee {
             case ImageFormat::RGBA8: return 4; break;
             case ImageFormat::SRGBA8: return 4; break;
             case ImageFormat::R32F: return 1; break;
+            case ImageFormat::RG16F: return 2; break;
+            case ImageFormat::RGBA16F: return 4; break;
+            case ImageFormat::RGB9E5: return 3; break;
             case ImageFormat::RGB32F: return 3; break;
             case ImageFormat::RGBA32F: return 4; break;
             case ImageFormat::DEPTH24STENCIL8: return 1; break;
@@ -285,14 +298,7 @@ namespace Coffee {
 
         m_Properties.srgb = false;
 
-        if(path.extension() == ".hdr")
-        {
-            LoadHDRFromFile(path);
-        }
-        else
-        {
-            LoadStandardFromFile(path);
-        }
+        LoadFromFile(path);
     }
 
     Cubemap::~Cubemap()
@@ -303,201 +309,127 @@ namespace Coffee {
 
     void Cubemap::Bind(uint32_t slot)
     {
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureID);
+        glBindTextureUnit(slot, m_textureID);
     }
 
-    void Cubemap::LoadStandardFromFile(const std::filesystem::path& path)
+    bool Cubemap::ReadFaceRGB(uint32_t face, std::vector<float>& outData) const
     {
-        // Load the combined image
-        int nrChannels;
-        unsigned char* data = stbi_load(path.string().c_str(), &m_Width, &m_Height, &nrChannels, 0);
-        if (!data) {
-            COFFEE_CORE_ERROR("Failed to load cubemap texture: {0} (REASON: {1})", m_FilePath.string(), stbi_failure_reason());
-            return;
-        }
+        const size_t faceTexels = static_cast<size_t>(m_Width) * m_Height;
+        if (face >= 6 || !HasCPUData())
+            return false;
 
-        m_Data = std::vector<unsigned char>(data, data + m_Width * m_Height * nrChannels);
-        stbi_image_free(data);
+        outData.resize(faceTexels * 3);
 
-        switch (nrChannels)
+        if (!m_PackedHDRData.empty())
         {
-            case 1:
-                m_Properties.Format = ImageFormat::R8;
-            break;
-            case 3:
-                m_Properties.Format = ImageFormat::RGB8;
-            break;
-            case 4:
-                m_Properties.Format = ImageFormat::RGBA8;
-            break;
+            const uint32_t* texels = m_PackedHDRData.data() + face * faceTexels;
+            for (size_t i = 0; i < faceTexels; ++i)
+            {
+                glm::vec3 color = glm::unpackF3x9_E1x5(texels[i]);
+                outData[i * 3 + 0] = color.r;
+                outData[i * 3 + 1] = color.g;
+                outData[i * 3 + 2] = color.b;
+            }
+        }
+        else
+        {
+            // LDR cubemaps are stored in sRGB, convert them to linear with the usual 2.2 approximation
+            const unsigned char* texels = m_Data.data() + face * faceTexels * 3;
+            for (size_t i = 0; i < faceTexels * 3; ++i)
+            {
+                outData[i] = std::pow(texels[i] / 255.0f, 2.2f);
+            }
         }
 
-        LoadStandardFromData(m_Data);
+        return true;
     }
 
-    void Cubemap::LoadHDRFromFile(const std::filesystem::path& path)
+    void Cubemap::ReleaseCPUData()
     {
-        int nrChannels;
-        float* data = stbi_loadf(path.string().c_str(), &m_Width, &m_Height, &nrChannels, 0);
-        if (!data) {
-            COFFEE_CORE_ERROR("Failed to load cubemap texture: {0} (REASON: {1})", m_FilePath.string(), stbi_failure_reason());
-            return;
-        }
-        
-        m_HDRData = std::vector<float>(data, data + m_Width * m_Height * nrChannels);
-        stbi_image_free(data);
-
-        switch (nrChannels)
-        {
-            case 1:
-                m_Properties.Format = ImageFormat::R32F;
-                break;
-            case 3:
-                m_Properties.Format = ImageFormat::RGB32F;
-                break;
-            case 4:
-                m_Properties.Format = ImageFormat::RGBA32F;
-                break;
-        }
-        
-        LoadHDRFromData(m_HDRData);
+        std::vector<unsigned char>().swap(m_Data);
+        std::vector<uint32_t>().swap(m_PackedHDRData);
     }
 
-    void Cubemap::LoadStandardFromData(const std::vector<unsigned char>& data)
+    void Cubemap::LoadFromFile(const std::filesystem::path& path)
     {
-        m_Data = data;
-
-        int nrChannels = ImageFormatToChannelCount(m_Properties.Format);
+        ZoneScoped;
 
-        int mipLevels = 1 + floor(log2(std::max(m_Width, m_Height)));
+        const bool hdr = stbi_is_hdr(path.string().c_str());
 
-        GLenum internalFormat = ImageFormatToOpenGLInternalFormat(m_Properties.Format);
-        GLenum format = ImageFormatToOpenGLFormat(m_Properties.Format);
+        CubemapSource source;
+        source.HDR = hdr;
+        source.Pixels = hdr ? static_cast<void*>(stbi_loadf(path.string().c_str(), &source.Width, &source.Height, &source.Channels, 0))
+                            : static_cast<void*>(stbi_load(path.string().c_str(), &source.Width, &source.Height, &source.Channels, 0));
 
-        // Verify layout dimensions (should be square with faces in cross shape)
-        int faceSize = m_Width / 4;
-        if (m_Width != faceSize * 4 || m_Height != faceSize * 3) {
-            COFFEE_CORE_ERROR("Cubemap texture layout is invalid: {0}", m_FilePath.string());
-            m_Data.clear();
+        if (!source.Pixels) {
+            COFFEE_CORE_ERROR("Failed to load cubemap texture: {0} (REASON: {1})", m_FilePath.string(), stbi_failure_reason());
             return;
         }
 
-        glGenTextures(1, &m_textureID);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureID);
+        if (GetCubemapLayout(source.Width, source.Height) == CubemapLayout::Unknown) {
+            COFFEE_CORE_ERROR("Cubemap texture layout is invalid, expected a 4x3 cross or a 2:1 equirectangular image: {0}", m_FilePath.string());
+            stbi_image_free(const_cast<void*>(source.Pixels));
+            return;
+        }
 
-        uint32_t targets[6] = {
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X, // +X
-            GL_TEXTURE_CUBE_MAP_NEGATIVE_X, // -X
-            GL_TEXTURE_CUBE_MAP_POSITIVE_Y, // +Y
-            GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, // -Y
-            GL_TEXTURE_CUBE_MAP_POSITIVE_Z, // +Z
-            GL_TEXTURE_CUBE_MAP_NEGATIVE_Z  // -Z
-        };
-
-        int offsets[6][2] = {
-            {2, 1}, // +X
-            {0, 1}, // -X
-            {1, 0}, // +Y
-            {1, 2}, // -Y
-            {1, 1}, // +Z
-            {3, 1}  // -Z
-        };
-
-        for (int i = 0; i < 6; ++i) {
-            int offsetX = offsets[i][0] * faceSize;
-            int offsetY = offsets[i][1] * faceSize;
-
-            unsigned char* faceBuffer = new unsigned char[faceSize * faceSize * nrChannels];
-            for (int y = 0; y < faceSize; ++y) {
-                memcpy(
-                    faceBuffer + y * faceSize * nrChannels,
-                    m_Data.data() + ((offsetY + y) * m_Width + offsetX) * nrChannels,
-                    faceSize * nrChannels
-                );
-            }
+        // HDR faces are packed as RGB9E5, a third of the size of RGB32F with enough precision for the sky
+        if (hdr)
+        {
+            m_Properties.Format = ImageFormat::RGB9E5;
+            ConvertToCubemapRGB9E5(source, m_PackedHDRData);
+        }
+        else
+        {
+            m_Properties.Format = ImageFormat::RGB8;
+            ConvertToCubemapRGB8(source, m_Data);
+        }
 
-            glTexImage2D(
-                targets[i],
-                0, internalFormat, faceSize, faceSize,
-                0, format, GL_UNSIGNED_BYTE, faceBuffer
-            );
+        stbi_image_free(const_cast<void*>(source.Pixels));
 
-            delete[] faceBuffer;
-        }
+        m_Width = m_Height = GetCubemapFaceSize(source);
 
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        Upload();
     }
 
-    void Cubemap::LoadHDRFromData(const std::vector<float>& data)
+    void Cubemap::Upload()
     {
-        m_HDRData = data;
+        ZoneScoped;
 
-        int nrChannels = ImageFormatToChannelCount(m_Properties.Format);
-        
-        int mipLevels = 1 + floor(log2(std::max(m_Width, m_Height)));
-        
-        GLenum internalFormat = ImageFormatToOpenGLInternalFormat(m_Properties.Format);
-        GLenum format = ImageFormatToOpenGLFormat(m_Properties.Format);
-        
-        int faceSize = m_Width / 4;
-        if (m_Width != faceSize * 4 || m_Height != faceSize * 3) {
-            COFFEE_CORE_ERROR("Cubemap texture layout is invalid: {0}", m_FilePath.string());
-            m_HDRData.clear();
+        if (!HasCPUData() || m_Width <= 0)
+        {
             return;
         }
-        
-        glGenTextures(1, &m_textureID);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureID);
-        
-        uint32_t targets[6] = {
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X, // +X
-            GL_TEXTURE_CUBE_MAP_NEGATIVE_X, // -X
-            GL_TEXTURE_CUBE_MAP_POSITIVE_Y, // +Y
-            GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, // -Y
-            GL_TEXTURE_CUBE_MAP_POSITIVE_Z, // +Z
-            GL_TEXTURE_CUBE_MAP_NEGATIVE_Z  // -Z
-        };
-        
-        int offsets[6][2] = {
-            {2, 1}, // +X
-            {0, 1}, // -X
-            {1, 0}, // +Y
-            {1, 2}, // -Y
-            {1, 1}, // +Z
-            {3, 1}  // -Z
-        };
-        
-        for (int i = 0; i < 6; ++i) {
-            int offsetX = offsets[i][0] * faceSize;
-            int offsetY = offsets[i][1] * faceSize;
-        
-            float* faceBuffer = new float[faceSize * faceSize * nrChannels];
-            for (int y = 0; y < faceSize; ++y) {
-                memcpy(
-                    faceBuffer + y * faceSize * nrChannels,
-                    m_HDRData.data() + ((offsetY + y) * m_Width + offsetX) * nrChannels,
-                    faceSize * nrChannels * sizeof(float)
-                );
+
+        const bool hdr = m_Properties.Format == ImageFormat::RGB9E5;
+        const size_t faceTexels = static_cast<size_t>(m_Width) * m_Height;
+
+        glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &m_textureID);
+        glTextureStorage2D(m_textureID, 1, ImageFormatToOpenGLInternalFormat(m_Properties.Format), m_Width, m_Height);
+
+        // The RGB8 rows are not always 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (int face = 0; face < 6; ++face)
+        {
+            if (hdr)
+            {
+                glTextureSubImage3D(m_textureID, 0, 0, 0, face, m_Width, m_Height, 1, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV,
+                                    m_PackedHDRData.data() + face * faceTexels);
+            }
+            else
+            {
+                glTextureSubImage3D(m_textureID, 0, 0, 0, face, m_Width, m_Height, 1, GL_RGB, GL_UNSIGNED_BYTE,
+                                    m_Data.data() + face * faceTexels * 3);
             }
-        
-            glTexImage2D(
-                targets[i],
-                0, internalFormat, faceSize, faceSize,
-                0, format, GL_FLOAT, faceBuffer
-            );
-        
-            delete[] faceBuffer;
         }
-        
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glTextureParameteri(m_textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(m_textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     }
 
     Ref<Cubemap> Cubemap::Load(const std::filesystem::path& path)
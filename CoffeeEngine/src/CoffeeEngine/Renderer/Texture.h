@@ -27,7 +27,10 @@ namespace Coffee {
         R32F,
         RGB32F,
         RGBA32F,
-        DEPTH24STENCIL8
+        DEPTH24STENCIL8,
+        RG16F,
+        RGBA16F,
+        RGB9E5
     };
 
     struct TextureProperties
@@ -147,27 +150,53 @@ namespace Coffee {
         uint32_t GetHeight() override { return m_Height; };
         ImageFormat GetImageFormat() override { return m_Properties.Format; };
 
+        /**
+         * @brief Gets the size in texels of a face of the cubemap.
+         * @return The face size.
+         */
+        uint32_t GetFaceSize() const { return m_Width; }
+
+        /**
+         * @brief Reads a face of the cubemap from its CPU copy.
+         *
+         * The texels are linear RGB floats stored row by row in the same orientation as they are uploaded to OpenGL.
+         *
+         * @param face The face index in the OpenGL order (+X, -X, +Y, -Y, +Z, -Z).
+         * @param outData The vector receiving faceSize * faceSize * 3 floats.
+         * @return True if the cubemap still has its CPU copy.
+         */
+        bool ReadFaceRGB(uint32_t face, std::vector<float>& outData) const;
+
+        /**
+         * @brief Checks if the cubemap keeps a CPU copy of its faces.
+         * @return True if the CPU copy is available.
+         */
+        bool HasCPUData() const { return !m_Data.empty() || !m_PackedHDRData.empty(); }
+
+        /**
+         * @brief Frees the CPU copy of the faces once they are uploaded and cached.
+         */
+        void ReleaseCPUData();
+
         static Ref<Cubemap> Load(const std::filesystem::path& path);
         static Ref<Cubemap> Create(const std::filesystem::path& path);
     private:
 
-        void LoadStandardFromFile(const std::filesystem::path& path);
-        void LoadHDRFromFile(const std::filesystem::path& path);
-        void LoadStandardFromData(const std::vector<unsigned char>& data);
-        void LoadHDRFromData(const std::vector<float>& data);
+        void LoadFromFile(const std::filesystem::path& path);
+        void Upload();
 
         friend class cereal::access;
 
         template<class Archive>
         void save(Archive& archive) const
         {
-            archive(m_Properties, m_Data, m_HDRData, m_Width, m_Height, cereal::base_class<Texture>(this));
+            archive(m_Properties, m_Data, m_PackedHDRData, m_Width, m_Height, cereal::base_class<Texture>(this));
         }
 
         template <class Archive>
         void load(Archive& archive)
         {
-            archive(m_Properties, m_Data, m_HDRData, m_Width, m_Height, cereal::base_class<Texture>(this));
+            archive(m_Properties, m_Data, m_PackedHDRData, m_Width, m_Height, cereal::base_class<Texture>(this));
         }
 
         template <class Archive>
@@ -175,26 +204,18 @@ namespace Coffee {
         {
             construct();
 
-            data(construct->m_Properties, construct->m_Data, construct->m_HDRData, construct->m_Width, construct->m_Height,
+            data(construct->m_Properties, construct->m_Data, construct->m_PackedHDRData, construct->m_Width, construct->m_Height,
                  cereal::base_class<Texture>(construct.ptr()));
 
-            const ImageFormat& format = construct->m_Properties.Format;
-            if (format == ImageFormat::R8 || format == ImageFormat::RG8 || format == ImageFormat::RGB8 || format == ImageFormat::RGBA8)
-            {
-                construct->LoadStandardFromData(construct->m_Data);
-            }
-            else
-            {
-                construct->LoadHDRFromData(construct->m_HDRData);
-            }
+            construct->Upload();
         }
 
     private:
         TextureProperties m_Properties;
-        std::vector<unsigned char> m_Data;
-        std::vector<float> m_HDRData;
-        uint32_t m_textureID;
-        int m_Width, m_Height;
+        std::vector<unsigned char> m_Data; ///< RGB8 texels of the six faces.
+        std::vector<uint32_t> m_PackedHDRData; ///< RGB9E5 texels of the six faces.
+        uint32_t m_textureID = 0;
+        int m_Width = 0, m_Height = 0; ///< Size of a face.
     };
 
 }
@@ -19,6 +19,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include "src/CoffeeEngine/IO/Serialization/GLMSerialization.h"
+#include "CoffeeEngine/IO/Serialization/OptionalNVP.h"
 #include "CoffeeEngine/IO/ResourceLoader.h"
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -52,6 +53,15 @@ namespace Coffee {
         }
     };
 
+    /**
+     * @brief Tag of the entities that are kept in the scene but take no part in it, like the pooled entities waiting
+     * to be spawned. Their meshes are removed from the render world and their lights, cameras and scripts are skipped.
+     * @ingroup scene
+     */
+    struct InactiveComponent
+    {
+    };
+
     /**
      * @brief Component representing a transform.
      * @ingroup scene
@@ -60,6 +70,7 @@ namespace Coffee {
     {
     private:
         glm::mat4 worldMatrix = glm::mat4(1.0f); ///< The world transformation matrix.
+        bool dirty = true; ///< Whether the local transform changed since the world matrix was computed.
     public:
         glm::vec3 Position = { 0.0f, 0.0f, 0.0f }; ///< The position vector.
         glm::vec3 Rotation = { 0.0f, 0.0f, 0.0f }; ///< The rotation vector.
@@ -95,8 +106,21 @@ namespace Coffee {
 
             glm::decompose(transform, Scale, orientation, Position, skew, perspective);
             Rotation = glm::degrees(glm::eulerAngles(orientation));
+            dirty = true;
         }
 
+        /**
+         * @brief Marks the local transform as changed so the world transform of the entity and its children is
+         * recomputed in the next scene tree update. Needed after writing Position, Rotation or Scale directly.
+         */
+        void MarkDirty() { dirty = true; }
+
+        /**
+         * @brief Checks if the local transform changed since the world transform was computed.
+         * @return True if the world transform is outdated.
+         */
+        bool IsDirty() const { return dirty; }
+
         /**
          * @brief Gets the world transformation matrix.
          * @return The world transformation matrix.
@@ -113,6 +137,7 @@ namespace Coffee {
         void SetWorldTransform(const glm::mat4& transform)
         {
             worldMatrix = transform * GetLocalTransform();
+            dirty = false;
         }
 
         /**
@@ -158,6 +183,8 @@ namespace Coffee {
     {
         Ref<Mesh> mesh; ///< The mesh reference.
         bool drawAABB = false; ///< Flag to draw the axis-aligned bounding box (AABB).
+        bool castShadows = true; ///< Flag to render the mesh into the shadow maps.
+        bool isStatic = false; ///< Flag for meshes that never move, their shadows are cached between frames.
 
         MeshComponent()
         {
@@ -185,7 +212,8 @@ namespace Coffee {
         template<class Archive>
         void save(Archive& archive) const
         {
-            archive(cereal::make_nvp("Mesh", mesh->GetUUID()));
+            // A mesh that was not found when the scene was loaded is written as the null UUID
+            archive(cereal::make_nvp("Mesh", mesh ? mesh->GetUUID() : UUID::null), cereal::make_nvp("CastShadows", castShadows), cereal::make_nvp("Static", isStatic));
         }
 
         template<class Archive>
@@ -193,9 +221,10 @@ namespace Coffee {
         {
             UUID meshUUID;
             archive(cereal::make_nvp("Mesh", meshUUID));
+            OptionalNVP(archive, "CastShadows", castShadows);
+            OptionalNVP(archive, "Static", isStatic);
 
-            Ref<Mesh> mesh = ResourceRegistry::Get<Mesh>(meshUUID);
-            this->mesh = mesh;
+            this->mesh = meshUUID != UUID::null ? ResourceRegistry::Get<Mesh>(meshUUID) : nullptr;
         }
     };
 
@@ -257,7 +286,7 @@ namespace Coffee {
             SpotLight = 2 ///< Spot light.
         };
 
-        // Align to 16 bytes(glm::vec4) instead of 12 bytes(glm::vec3) to match the std140 layout in the shader (a vec3 is 16 bytes in std140)
+        // The GPU copy of the light is the Renderer LightData, these members are only kept aligned to make that copy cheap
         alignas(16) glm::vec3 Color = {1.0f, 1.0f, 1.0f}; ///< The color of the light.
         alignas(16) glm::vec3 Direction = {0.0f, -1.0f, 0.0f}; ///< The direction of the light.
         alignas(16) glm::vec3 Position = {0.0f, 0.0f, 0.0f}; ///< The position of the light.
@@ -270,6 +299,13 @@ namespace Coffee {
 
         int type = static_cast<int>(Type::DirectionalLight); ///< The type of the light.
 
+        bool CastShadows = false; ///< Flag to render shadows for the light.
+        int ShadowCascadeCount = 3; ///< Number of cascades used by a directional light (1 to 4).
+        uint32_t ShadowResolution = 1024; ///< Size in texels of each cascade or face in the shadow atlas.
+        int ShadowUpdateInterval = 1; ///< Frames between re-renders of the dynamic casters (1 updates every frame).
+        float ShadowDistance = 50.0f; ///< Distance from the camera covered by the directional light cascades.
+        float ShadowBias = 0.002f; ///< Depth bias applied when sampling the shadow map.
+
         LightComponent() = default;
         LightComponent(const LightComponent&) = default;
 
@@ -282,6 +318,13 @@ namespace Coffee {
         void serialize(Archive& archive)
         {
             archive(cereal::make_nvp("Color", Color), cereal::make_nvp("Direction", Direction), cereal::make_nvp("Position", Position), cereal::make_nvp("Range", Range), cereal::make_nvp("Attenuation", Attenuation), cereal::make_nvp("Intensity", Intensity), cereal::make_nvp("Angle", Angle), cereal::make_nvp("Type", type));
+
+            OptionalNVP(archive, "CastShadows", CastShadows);
+            OptionalNVP(archive, "ShadowCascadeCount", ShadowCascadeCount);
+            OptionalNVP(archive, "ShadowResolution", ShadowResolution);
+            OptionalNVP(archive, "ShadowUpdateInterval", ShadowUpdateInterval);
+            OptionalNVP(archive, "ShadowDistance", ShadowDistance);
+            OptionalNVP(archive, "ShadowBias", ShadowBias);
         }
     };
 }
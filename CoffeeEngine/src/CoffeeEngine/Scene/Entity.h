@@ -88,6 +88,16 @@ namespace Coffee {
             m_Scene->m_Registry.remove<T>(m_EntityHandle);
         }
 
+        /**
+         * @brief Notify that a component was modified in place so the systems listening to it are updated.
+         * @tparam T The component type.
+         */
+        template<typename T>
+        void PatchComponent()
+        {
+            m_Scene->m_Registry.patch<T>(m_EntityHandle);
+        }
+
         bool IsValid() const 
         {
             return m_Scene->m_Registry.valid(m_EntityHandle);
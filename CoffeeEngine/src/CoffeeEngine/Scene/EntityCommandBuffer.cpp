@@ -0,0 +1,132 @@
+#include "EntityCommandBuffer.h"
+
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    EntityCommandBuffer::EntityCommandBuffer(Scene* scene) : m_Scene(scene)
+    {
+    }
+
+    Entity EntityCommandBuffer::CreateEntity(const std::string& name)
+    {
+        entt::entity handle = m_Scene->m_Registry.create();
+
+        Command command;
+        command.Type = CommandType::Create;
+        command.Target = handle;
+        command.Name = name.empty() ? "Entity" : name;
+        m_Commands.push_back(std::move(command));
+
+        return Entity{handle, m_Scene};
+    }
+
+    void EntityCommandBuffer::DestroyEntity(Entity entity)
+    {
+        Record(CommandType::Destroy, entity, nullptr);
+    }
+
+    void EntityCommandBuffer::SetParent(Entity entity, Entity parent)
+    {
+        Command command;
+        command.Type = CommandType::SetParent;
+        command.Target = entity;
+        command.Parent = parent;
+        m_Commands.push_back(std::move(command));
+    }
+
+    void EntityCommandBuffer::Record(CommandType type, entt::entity entity, std::function<void(entt::registry&)> function)
+    {
+        Command command;
+        command.Type = type;
+        command.Target = entity;
+        command.Function = std::move(function);
+        m_Commands.push_back(std::move(command));
+    }
+
+    entt::entity EntityCommandBuffer::GetHandle(const Entity& entity)
+    {
+        return entity;
+    }
+
+    void EntityCommandBuffer::Playback()
+    {
+        ZoneScoped;
+
+        if (m_Commands.empty())
+            return;
+
+        // Swapped out first so the commands recorded by the signals of the playback go to the next one
+        std::vector<Command> commands;
+        commands.swap(m_Commands);
+
+        entt::registry& registry = m_Scene->m_Registry;
+
+        // The commands run in the order they were recorded, only the runs of creations or destructions are batched
+        for (auto it = commands.begin(); it != commands.end();)
+        {
+            const CommandType type = it->Type;
+            auto runEnd = std::find_if(it, commands.end(), [type](const Command& command) { return command.Type != type; });
+
+            if (type == CommandType::Create)
+            {
+                // The default components of the run are inserted at once, before any later command can use them
+                std::vector<entt::entity> created;
+                std::vector<TagComponent> tags;
+                for (; it != runEnd; ++it)
+                {
+                    created.push_back(it->Target);
+                    tags.emplace_back().Tag = std::move(it->Name);
+                }
+
+                registry.insert<TransformComponent>(created.begin(), created.end());
+                registry.insert<TagComponent>(created.begin(), created.end(), tags.begin());
+                registry.insert<HierarchyComponent>(created.begin(), created.end());
+                continue;
+            }
+
+            if (type == CommandType::Destroy)
+            {
+                std::vector<entt::entity> destroyed;
+                for (; it != runEnd; ++it)
+                {
+                    destroyed.push_back(it->Target);
+                }
+
+                // The entities already destroyed are skipped by DestroySubtrees
+                m_Scene->DestroySubtrees(destroyed);
+                continue;
+            }
+
+            for (; it != runEnd; ++it)
+            {
+                Command& command = *it;
+
+                // An entity destroyed while the buffer was recording, or by an earlier command, is skipped
+                if (!registry.valid(command.Target))
+                    continue;
+
+                switch (command.Type)
+                {
+                    case CommandType::AddComponent:
+                    case CommandType::RemoveComponent:
+                        command.Function(registry);
+                        break;
+                    case CommandType::SetParent:
+                        if (command.Parent == entt::null || registry.valid(command.Parent))
+                            HierarchyComponent::Reparent(registry, command.Target, command.Parent);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+}
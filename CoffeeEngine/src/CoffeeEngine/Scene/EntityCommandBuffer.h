@@ -0,0 +1,135 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    class Entity;
+    class Scene;
+
+    /**
+     * @brief Records structural changes of a scene and applies them later in one batch.
+     *
+     * Creating, destroying, adding or removing components and reparenting while the entities are being iterated is not
+     * safe, so the systems record the changes here and the scene plays them back at its sync points. The playback keeps
+     * the recording order, so a component removed and added again or an entity destroyed before a reparenting behave as
+     * if the commands ran immediately. The consecutive creations get their default components in bulk and the
+     * consecutive destructions are removed in bulk without fixing the links of every node.
+     */
+    class EntityCommandBuffer
+    {
+    public:
+        /**
+         * @brief Constructor for EntityCommandBuffer.
+         * @param scene The scene the commands are applied to.
+         */
+        EntityCommandBuffer(Scene* scene);
+
+        /**
+         * @brief Record the creation of an entity.
+         *
+         * The handle is reserved immediately so it can be used by the following commands, the default components are
+         * added in the playback.
+         *
+         * @param name The name of the entity.
+         * @return The entity, it has no components until the buffer is played back.
+         */
+        Entity CreateEntity(const std::string& name = std::string());
+
+        /**
+         * @brief Record the destruction of an entity and all its children.
+         * @param entity The entity to destroy.
+         */
+        void DestroyEntity(Entity entity);
+
+        /**
+         * @brief Record the addition of a component.
+         * @tparam T The component type.
+         * @tparam Args The component constructor arguments.
+         * @param entity The entity.
+         * @param args The component constructor arguments, they are copied into the command.
+         */
+        template<typename T, typename... Args>
+        void AddComponent(const Entity& entity, Args&&... args)
+        {
+            entt::entity handle = GetHandle(entity);
+            Record(CommandType::AddComponent, handle, [handle, ... args = std::forward<Args>(args)](entt::registry& registry) mutable {
+                registry.emplace_or_replace<T>(handle, std::move(args)...);
+            });
+        }
+
+        /**
+         * @brief Record the removal of a component.
+         * @tparam T The component type.
+         * @param entity The entity.
+         */
+        template<typename T>
+        void RemoveComponent(const Entity& entity)
+        {
+            entt::entity handle = GetHandle(entity);
+            Record(CommandType::RemoveComponent, handle, [handle](entt::registry& registry) {
+                registry.remove<T>(handle);
+            });
+        }
+
+        /**
+         * @brief Record the change of the parent of an entity.
+         * @param entity The entity to reparent.
+         * @param parent The new parent entity, a null entity makes it a root.
+         */
+        void SetParent(Entity entity, Entity parent);
+
+        /**
+         * @brief Apply all the recorded commands and clear the buffer.
+         */
+        void Playback();
+
+        /**
+         * @brief Check if there are commands waiting to be applied.
+         * @return True if the buffer is empty.
+         */
+        bool IsEmpty() const { return m_Commands.empty(); }
+
+    private:
+        /**
+         * @brief Type of a command.
+         */
+        enum class CommandType
+        {
+            Create,
+            AddComponent,
+            RemoveComponent,
+            SetParent,
+            Destroy
+        };
+
+        struct Command
+        {
+            CommandType Type;
+            entt::entity Target = entt::null;
+            entt::entity Parent = entt::null;
+            std::function<void(entt::registry&)> Function;
+            std::string Name;
+        };
+
+        void Record(CommandType type, entt::entity entity, std::function<void(entt::registry&)> function);
+
+        // Entity is incomplete here, Entity.h includes the scene
+        static entt::entity GetHandle(const Entity& entity);
+
+    private:
+        Scene* m_Scene;
+        std::vector<Command> m_Commands;
+    };
+
+    /** @} */ // end of scene group
+}
@@ -0,0 +1,150 @@
+#include "CoffeeEngine/Scene/EntityPool.h"
+
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Prefab.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <algorithm>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    EntityPool::EntityPool(Scene* scene, const Ref<Prefab>& prefab, uint32_t growSize)
+        : m_Scene(scene), m_Prefab(prefab)
+    {
+        SetGrowSize(growSize);
+
+        m_Scene->m_Registry.on_destroy<TransformComponent>().connect<&EntityPool::OnDestroy>(*this);
+    }
+
+    EntityPool::EntityPool(Scene* scene, const EntityPool& other)
+        : m_Scene(scene), m_Prefab(other.m_Prefab), m_GrowSize(other.m_GrowSize), m_Free(other.m_Free),
+          m_Instances(other.m_Instances), m_Stats(other.m_Stats)
+    {
+        m_Scene->m_Registry.on_destroy<TransformComponent>().connect<&EntityPool::OnDestroy>(*this);
+    }
+
+    EntityPool::~EntityPool()
+    {
+        m_Scene->m_Registry.on_destroy<TransformComponent>().disconnect<&EntityPool::OnDestroy>(*this);
+    }
+
+    Entity EntityPool::Spawn(const glm::mat4& transform)
+    {
+        ZoneScoped;
+
+        entt::registry& registry = m_Scene->m_Registry;
+
+        if (m_Free.empty())
+        {
+            Grow(m_GrowSize);
+            m_Stats.Grows++;
+        }
+
+        entt::entity root = m_Free.back();
+        m_Free.pop_back();
+
+        registry.get<TransformComponent>(root).SetLocalTransform(transform);
+        SetActive(root, true);
+
+        m_Stats.Active++;
+        m_Stats.Spawns++;
+
+        return Entity(root, m_Scene);
+    }
+
+    void EntityPool::Despawn(Entity root)
+    {
+        ZoneScoped;
+
+        entt::entity handle = (entt::entity)root;
+        entt::registry& registry = m_Scene->m_Registry;
+
+        if (m_Instances.find(handle) == m_Instances.end())
+        {
+            COFFEE_CORE_WARN("EntityPool::Despawn: The entity {0} is not an instance of the pool", (uint32_t)handle);
+            return;
+        }
+
+        if (!registry.valid(handle) || registry.all_of<InactiveComponent>(handle))
+            return;
+
+        SetActive(handle, false);
+        m_Free.push_back(handle);
+
+        m_Stats.Active--;
+        m_Stats.Despawns++;
+    }
+
+    void EntityPool::Reserve(uint32_t count)
+    {
+        if (count > m_Free.size())
+            Grow(count - static_cast<uint32_t>(m_Free.size()));
+    }
+
+    void EntityPool::Grow(uint32_t count)
+    {
+        ZoneScoped;
+
+        entt::registry& registry = m_Scene->m_Registry;
+
+        // Created inactive, so no render proxy is built and removed right away
+        const std::vector<glm::mat4> placements(count, glm::mat4(1.0f));
+        std::vector<Entity> roots = m_Scene->Instantiate(*m_Prefab, placements, Entity(), true);
+
+        for (Entity& root : roots)
+        {
+            entt::entity handle = (entt::entity)root;
+
+            // Every root of the prefab is an instance of its own, with its whole subtree
+            std::vector<entt::entity>& entities = m_Instances[handle];
+            entities.push_back(handle);
+            for (size_t i = 0; i < entities.size(); i++)
+            {
+                for (entt::entity child = registry.get<HierarchyComponent>(entities[i]).m_First; child != entt::null;
+                     child = registry.get<HierarchyComponent>(child).m_Next)
+                {
+                    entities.push_back(child);
+                }
+            }
+
+            m_Free.push_back(handle);
+        }
+
+        m_Stats.Capacity += static_cast<uint32_t>(roots.size());
+    }
+
+    void EntityPool::SetActive(entt::entity root, bool active)
+    {
+        entt::registry& registry = m_Scene->m_Registry;
+        std::vector<entt::entity>& entities = m_Instances[root];
+
+        // The entities of the instance destroyed by something else than the pool are forgotten
+        std::erase_if(entities, [&registry](entt::entity entity) { return !registry.valid(entity); });
+
+        if (active)
+            registry.remove<InactiveComponent>(entities.begin(), entities.end());
+        else
+            registry.insert<InactiveComponent>(entities.begin(), entities.end());
+    }
+
+    void EntityPool::OnDestroy(entt::registry& registry, entt::entity entity)
+    {
+        auto it = m_Instances.find(entity);
+        if (it == m_Instances.end())
+            return;
+
+        // The root of an instance destroyed by something else than the pool, the instance is forgotten
+        auto free = std::find(m_Free.begin(), m_Free.end(), entity);
+        if (free != m_Free.end())
+            m_Free.erase(free);
+        else
+            m_Stats.Active--;
+
+        m_Stats.Capacity--;
+        m_Instances.erase(it);
+    }
+
+}
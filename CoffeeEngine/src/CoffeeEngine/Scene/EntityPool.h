@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Scene/Entity.h"
+
+#include <cstdint>
+#include <entt/entity/fwd.hpp>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    class Prefab;
+    class Scene;
+
+    /**
+     * @brief Statistics of an entity pool.
+     */
+    struct EntityPoolStats
+    {
+        uint32_t Capacity = 0; ///< Number of instances created by the pool, active or not.
+        uint32_t Active = 0; ///< Number of spawned instances.
+        uint32_t Grows = 0; ///< Number of times the pool ran out of instances and created more.
+        uint64_t Spawns = 0;
+        uint64_t Despawns = 0;
+    };
+
+    /**
+     * @brief Recycles the instances of a prefab for the entities spawned and despawned often, like projectiles.
+     *
+     * The instances are created in batches with Scene::Instantiate. Despawning an instance tags its entities with
+     * InactiveComponent instead of destroying them, so their components stay allocated and spawning it again only
+     * removes the tag and moves its root. The pool keeps handles only, the instances belong to the scene, and an
+     * instance destroyed by something else than the pool is forgotten when its root is destroyed.
+     */
+    class EntityPool
+    {
+    public:
+        /**
+         * @brief Constructor for EntityPool.
+         * @param scene The scene of the instances.
+         * @param prefab The prefab of the instances.
+         * @param growSize Number of instances created when the pool runs out of them.
+         */
+        EntityPool(Scene* scene, const Ref<Prefab>& prefab, uint32_t growSize = 32);
+
+        /**
+         * @brief Constructor for the pool of a copied scene, see Scene::Copy.
+         * @param scene The copy, its entities have the same handles as the ones of the original scene.
+         * @param other The pool of the original scene.
+         */
+        EntityPool(Scene* scene, const EntityPool& other);
+
+        EntityPool(const EntityPool&) = delete;
+        EntityPool& operator=(const EntityPool&) = delete;
+
+        ~EntityPool();
+
+        /**
+         * @brief Activates a free instance, the pool grows if there is none.
+         * @param transform The local transform of the root of the instance.
+         * @return The root entity of the instance.
+         */
+        Entity Spawn(const glm::mat4& transform);
+
+        /**
+         * @brief Deactivates an instance and returns it to the pool.
+         * @param root The root entity returned by Spawn.
+         */
+        void Despawn(Entity root);
+
+        /**
+         * @brief Creates instances until the pool has a number of free ones.
+         * @param count The number of free instances.
+         */
+        void Reserve(uint32_t count);
+
+        /**
+         * @brief Sets the number of instances created when the pool runs out of them.
+         * @param growSize The number of instances, at least one.
+         */
+        void SetGrowSize(uint32_t growSize) { m_GrowSize = growSize > 0 ? growSize : 1; }
+        uint32_t GetGrowSize() const { return m_GrowSize; }
+
+        uint32_t GetFreeCount() const { return static_cast<uint32_t>(m_Free.size()); }
+        const EntityPoolStats& GetStats() const { return m_Stats; }
+        const Ref<Prefab>& GetPrefab() const { return m_Prefab; }
+
+    private:
+        void Grow(uint32_t count);
+        void SetActive(entt::entity root, bool active);
+        void OnDestroy(entt::registry& registry, entt::entity entity);
+
+    private:
+        Scene* m_Scene;
+        Ref<Prefab> m_Prefab;
+        uint32_t m_GrowSize;
+
+        std::vector<entt::entity> m_Free; ///< The roots of the inactive instances.
+        std::unordered_map<entt::entity, std::vector<entt::entity>> m_Instances; ///< The entities of each instance by its root.
+        EntityPoolStats m_Stats;
+    };
+
+    /** @} */
+}
@@ -0,0 +1,95 @@
+#include "CoffeeEngine/Scene/Prefab.h"
+
+#include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/Renderer/Model.h"
+
+#include <tracy/Tracy.hpp>
+#include <unordered_map>
+
+namespace Coffee {
+
+    static std::unordered_map<UUID, Ref<Prefab>> s_Prefabs;
+
+    Prefab::Prefab(const Ref<Model>& model)
+    {
+        ZoneScoped;
+
+        AddModel(model, -1);
+    }
+
+    Ref<Prefab> Prefab::Get(const Ref<Model>& model)
+    {
+        auto it = s_Prefabs.find(model->GetUUID());
+        if (it != s_Prefabs.end())
+            return it->second;
+
+        Ref<Prefab> prefab = CreateRef<Prefab>(model);
+        s_Prefabs[model->GetUUID()] = prefab;
+        return prefab;
+    }
+
+    void Prefab::ClearCache()
+    {
+        s_Prefabs.clear();
+    }
+
+    uint32_t Prefab::AddNode(const std::string& name, const glm::mat4& localTransform, int32_t parent)
+    {
+        uint32_t index = static_cast<uint32_t>(m_Nodes.size());
+
+        PrefabNode& node = m_Nodes.emplace_back();
+        node.Parent = parent;
+
+        m_Tags.emplace_back(name.empty() ? "Entity" : name);
+
+        // Decomposed once here instead of once per instance
+        m_Transforms.emplace_back().SetLocalTransform(localTransform);
+
+        if (parent >= 0)
+        {
+            PrefabNode& parentNode = m_Nodes[parent];
+            node.Prev = parentNode.Last;
+
+            if (parentNode.Last >= 0)
+                m_Nodes[parentNode.Last].Next = static_cast<int32_t>(index);
+            else
+                parentNode.First = static_cast<int32_t>(index);
+
+            parentNode.Last = static_cast<int32_t>(index);
+            parentNode.ChildCount++;
+        }
+
+        return index;
+    }
+
+    void Prefab::AddModel(const Ref<Model>& model, int32_t parent)
+    {
+        uint32_t modelIndex = AddNode(model->GetName(), model->GetTransform(), parent);
+
+        auto& meshes = model->GetMeshes();
+        bool hasMultipleMeshes = meshes.size() > 1;
+
+        for (auto& mesh : meshes)
+        {
+            uint32_t meshIndex = modelIndex;
+
+            if (hasMultipleMeshes)
+                meshIndex = AddNode(mesh->GetName(), glm::mat4(1.0f), static_cast<int32_t>(modelIndex));
+
+            m_MeshNodes.push_back(meshIndex);
+            m_Meshes.emplace_back(mesh);
+
+            if (mesh->GetMaterial())
+            {
+                m_MaterialNodes.push_back(meshIndex);
+                m_Materials.emplace_back(mesh->GetMaterial());
+            }
+        }
+
+        for (auto& child : model->GetChildren())
+        {
+            AddModel(child, static_cast<int32_t>(modelIndex));
+        }
+    }
+
+}
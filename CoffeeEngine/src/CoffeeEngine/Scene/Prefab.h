@@ -0,0 +1,86 @@
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Scene/Components.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    class Model;
+
+    /**
+     * @brief Relative hierarchy links of a prefab node, the links are indices of nodes of the same prefab.
+     */
+    struct PrefabNode
+    {
+        int32_t Parent = -1; ///< -1 for the roots of the prefab, they are attached to the parent of the instance.
+        int32_t First = -1;
+        int32_t Last = -1;
+        int32_t Next = -1;
+        int32_t Prev = -1;
+        uint32_t ChildCount = 0;
+    };
+
+    /**
+     * @brief Flat entity template of a model, instantiated in bulk by Scene::Instantiate.
+     *
+     * Compiling the model walks its tree once, decomposes the node transforms and resolves the links between the
+     * nodes as indices. Every instance is then a copy of the component arrays with the indices turned into the
+     * handles of the new entities, without walking the model again.
+     */
+    class Prefab
+    {
+    public:
+        /**
+         * @brief Compiles a model into a prefab.
+         * @param model The model.
+         */
+        Prefab(const Ref<Model>& model);
+
+        /**
+         * @brief Gets the prefab of a model, compiled the first time it is requested.
+         * @param model The model.
+         * @return The prefab shared by every placement of the model.
+         */
+        static Ref<Prefab> Get(const Ref<Model>& model);
+
+        /**
+         * @brief Releases the compiled prefabs and the meshes and materials they reference.
+         */
+        static void ClearCache();
+
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+
+        const std::vector<PrefabNode>& GetNodes() const { return m_Nodes; }
+        const std::vector<TagComponent>& GetTags() const { return m_Tags; }
+        const std::vector<TransformComponent>& GetTransforms() const { return m_Transforms; }
+
+        const std::vector<uint32_t>& GetMeshNodes() const { return m_MeshNodes; } ///< The nodes that have a mesh.
+        const std::vector<MeshComponent>& GetMeshes() const { return m_Meshes; }
+        const std::vector<uint32_t>& GetMaterialNodes() const { return m_MaterialNodes; } ///< The nodes that have a material.
+        const std::vector<MaterialComponent>& GetMaterials() const { return m_Materials; }
+
+    private:
+        uint32_t AddNode(const std::string& name, const glm::mat4& localTransform, int32_t parent);
+        void AddModel(const Ref<Model>& model, int32_t parent);
+
+    private:
+        std::vector<PrefabNode> m_Nodes; ///< Every parent is listed before its children.
+        std::vector<TagComponent> m_Tags;
+        std::vector<TransformComponent> m_Transforms;
+
+        std::vector<uint32_t> m_MeshNodes;
+        std::vector<MeshComponent> m_Meshes;
+        std::vector<uint32_t> m_MaterialNodes;
+        std::vector<MaterialComponent> m_Materials;
+    };
+
+    /** @} */
+}
@@ -1,7 +1,7 @@
 #include "Scene.h"
 
 #include "CoffeeEngine/Core/Base.h"
-#include "CoffeeEngine/Core/DataStructures/Octree.h"
+#include "CoffeeEngine/IO/FileUtils.h"
 #include "CoffeeEngine/Math/Frustum.h"
 #include "CoffeeEngine/Renderer/DebugRenderer.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
@@ -10,8 +10,12 @@
 #include "CoffeeEngine/Renderer/Renderer.h"
 #include "CoffeeEngine/Scene/Components.h"
 #include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/EntityPool.h"
+#include "CoffeeEngine/Scene/Prefab.h"
 #include "CoffeeEngine/Scene/PrimitiveMesh.h"
+#include "CoffeeEngine/Scene/SceneBinaryFormat.h"
 #include "CoffeeEngine/Scene/SceneCamera.h"
+#include "CoffeeEngine/Scene/SceneSaveTask.h"
 #include "CoffeeEngine/Scene/SceneTree.h"
 #include "CoffeeEngine/Scripting/Lua/LuaBackend.h"
 #include "CoffeeEngine/Scripting/ScriptManager.h"
@@ -19,12 +23,15 @@
 #include "entt/entity/fwd.hpp"
 #include "entt/entity/snapshot.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <glm/detail/type_quat.hpp>
 #include <glm/fwd.hpp>
 #include <string>
 #include <tracy/Tracy.hpp>
+#include <type_traits>
+#include <unordered_set>
 
 #include <CoffeeEngine/Scripting/Script.h>
 #include <cereal/archives/json.hpp>
@@ -32,19 +39,174 @@
 
 namespace Coffee {
 
-    Scene::Scene() : m_Octree({glm::vec3(-50.0f), glm::vec3(50.0f)}, 10, 5)
+    Scene::Scene()
     {
+        m_RenderWorld = CreateScope<RenderWorld>();
         m_SceneTree = CreateScope<SceneTree>(this);
+        m_CommandBuffer = CreateScope<EntityCommandBuffer>(this);
+        m_WorldPartition = CreateScope<WorldPartition>(this);
+
+        // The render proxies are only touched when the components change, the inspector patches the in place edits
+        m_Registry.on_construct<MeshComponent>().connect<&Scene::OnMeshComponentChanged>(*this);
+        m_Registry.on_update<MeshComponent>().connect<&Scene::OnMeshComponentChanged>(*this);
+        m_Registry.on_destroy<MeshComponent>().connect<&Scene::OnMeshComponentDestroyed>(*this);
+        m_Registry.on_construct<MaterialComponent>().connect<&Scene::OnMaterialComponentChanged>(*this);
+        m_Registry.on_update<MaterialComponent>().connect<&Scene::OnMaterialComponentChanged>(*this);
+        m_Registry.on_destroy<MaterialComponent>().connect<&Scene::OnMaterialComponentDestroyed>(*this);
+        m_Registry.on_construct<InactiveComponent>().connect<&Scene::OnEntityDeactivated>(*this);
+        m_Registry.on_destroy<InactiveComponent>().connect<&Scene::OnEntityActivated>(*this);
+
+        // The runtime systems run in parallel and their views only look the storages up, creating one on first use
+        // would modify the pool map of the registry while another system reads it
+        m_Registry.storage<TagComponent>();
+        m_Registry.storage<TransformComponent>();
+        m_Registry.storage<HierarchyComponent>();
+        m_Registry.storage<CameraComponent>();
+        m_Registry.storage<LightComponent>();
+        m_Registry.storage<ScriptComponent>();
+
+        RegisterRuntimeSystems();
     }
 
-/*     Scene::Scene(Ref<Scene> other)
+    Scene::~Scene() = default;
+
+    // Copies a whole component storage to a registry that has the same entities, except the excluded ones
+    template<typename T>
+    static void CopyStorage(const entt::registry& source, entt::registry& destination, const std::unordered_set<entt::entity>& excluded)
     {
-        auto& srcRegistry = other->m_Registry;
-        auto& dstRegistry = m_Registry;
+        auto view = source.view<T>();
+
+        std::vector<entt::entity> entities(view.begin(), view.end());
+        if (!excluded.empty())
+            std::erase_if(entities, [&excluded](entt::entity entity) { return excluded.contains(entity); });
+
+        // The tags have no instances to copy
+        if constexpr (std::is_empty_v<T>)
+        {
+            destination.insert<T>(entities.begin(), entities.end());
+        }
+        else
+        {
+            std::vector<T> components;
+            components.reserve(entities.size());
+            for (auto entity : entities)
+            {
+                components.push_back(view.template get<T>(entity));
+            }
+
+            destination.insert<T>(entities.begin(), entities.end(), components.begin());
+        }
+    }
+
+    // Copies the entities and the serialized components to an empty registry, the entities keep their handles.
+    // The subtrees of the excluded roots are left out and cut from the children of the entities that are copied.
+    static void CopyRegistry(const entt::registry& source, entt::registry& destination, const std::vector<entt::entity>& excludedRoots = {})
+    {
+        ZoneScoped;
+
+        std::unordered_set<entt::entity> excluded;
+        std::vector<entt::entity> subtree;
+        for (entt::entity root : excludedRoots)
+        {
+            if (!source.valid(root))
+                continue;
+
+            subtree.assign(1, root);
+            for (size_t i = 0; i < subtree.size(); i++)
+            {
+                excluded.insert(subtree[i]);
+                for (entt::entity child = source.get<HierarchyComponent>(subtree[i]).m_First; child != entt::null;
+                     child = source.get<HierarchyComponent>(child).m_Next)
+                {
+                    subtree.push_back(child);
+                }
+            }
+        }
+
+        // The registry is empty, so every hint is free and the copies get the same handles
+        for (auto entity : source.view<entt::entity>())
+        {
+            if (excluded.contains(entity))
+                continue;
+
+            [[maybe_unused]] entt::entity copy = destination.create(entity);
+            COFFEE_CORE_ASSERT(copy == entity, "CopyRegistry: The copy of an entity got a different handle!");
+        }
+
+        // The transforms go first and the materials before the meshes, the render proxies read both when they are created.
+        // The inactive entities are tagged before, so they get no proxy.
+        CopyStorage<TagComponent>(source, destination, excluded);
+        CopyStorage<TransformComponent>(source, destination, excluded);
+        CopyStorage<HierarchyComponent>(source, destination, excluded);
+        CopyStorage<CameraComponent>(source, destination, excluded);
+        CopyStorage<InactiveComponent>(source, destination, excluded);
+        CopyStorage<MaterialComponent>(source, destination, excluded);
+        CopyStorage<MeshComponent>(source, destination, excluded);
+        CopyStorage<LightComponent>(source, destination, excluded);
+
+        // The excluded roots with a copied parent are left out of its children
+        for (entt::entity root : excludedRoots)
+        {
+            if (!source.valid(root))
+                continue;
 
-        auto view = srcRegistry.view<entt::entity>();
-        dstRegistry.insert(view->data(), view->data() + view->size(), view->raw(), view->raw() + view.size());
-    } */
+            entt::entity parent = source.get<HierarchyComponent>(root).m_Parent;
+            if (parent == entt::null || excluded.contains(parent))
+                continue;
+
+            HierarchyComponent& parentHierarchy = destination.get<HierarchyComponent>(parent);
+            parentHierarchy.m_First = entt::null;
+            parentHierarchy.m_Last = entt::null;
+            parentHierarchy.m_ChildCount = 0;
+
+            for (entt::entity child = source.get<HierarchyComponent>(parent).m_First; child != entt::null;
+                 child = source.get<HierarchyComponent>(child).m_Next)
+            {
+                if (excluded.contains(child))
+                    continue;
+
+                HierarchyComponent& childHierarchy = destination.get<HierarchyComponent>(child);
+                childHierarchy.m_Prev = parentHierarchy.m_Last;
+                childHierarchy.m_Next = entt::null;
+
+                if (parentHierarchy.m_Last != entt::null)
+                    destination.get<HierarchyComponent>(parentHierarchy.m_Last).m_Next = child;
+                else
+                    parentHierarchy.m_First = child;
+
+                parentHierarchy.m_Last = child;
+                parentHierarchy.m_ChildCount++;
+            }
+        }
+    }
+
+    Ref<Scene> Scene::Copy(const Ref<Scene>& other)
+    {
+        ZoneScoped;
+
+        Ref<Scene> scene = CreateRef<Scene>();
+
+        // The streamed sectors are left out, the partition of the copy loads them again around its camera
+        const std::vector<entt::entity> streamedRoots = other->m_WorldPartition->GetLoadedRoots();
+
+        // The links are already complete, OnConstruct would append the children a second time
+        scene->m_Registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+        CopyRegistry(other->m_Registry, scene->m_Registry, streamedRoots);
+        scene->m_Registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+
+        // The handles are kept by the copy, so the pools of the copy track the same instances
+        for (const auto& [prefab, pool] : other->m_EntityPools)
+        {
+            scene->m_EntityPools[prefab] = CreateScope<EntityPool>(scene.get(), *pool);
+        }
+
+        scene->m_FilePath = other->m_FilePath;
+
+        if (other->m_WorldPartition->IsOpen())
+            scene->m_WorldPartition->Open(other->m_WorldPartition->GetPath());
+
+        return scene;
+    }
 
     Entity Scene::CreateEntity(const std::string& name)
     {
@@ -58,19 +220,229 @@ namespace Coffee {
         return entity;
     }
 
+    std::vector<Entity> Scene::CreateEntities(const std::vector<HierarchyNodeDescription>& nodes, Entity parent)
+    {
+        ZoneScoped;
+
+        const size_t count = nodes.size();
+
+        std::vector<entt::entity> handles(count);
+        m_Registry.create(handles.begin(), handles.end());
+
+        std::vector<TransformComponent> transforms(count);
+        std::vector<TagComponent> tags(count);
+        std::vector<HierarchyComponent> hierarchies(count);
+        std::vector<int32_t> lastChild(count, -1);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const HierarchyNodeDescription& node = nodes[i];
+
+            transforms[i].SetLocalTransform(node.LocalTransform);
+            tags[i].Tag = node.Name.empty() ? "Entity" : node.Name;
+
+            if (node.Parent < 0)
+                continue;
+
+            COFFEE_CORE_ASSERT(static_cast<size_t>(node.Parent) < i, "The parents must be listed before their children!");
+
+            // The children are linked here, the same as HierarchyComponent::AppendChild does once they are in the registry
+            HierarchyComponent& parentHierarchy = hierarchies[node.Parent];
+            HierarchyComponent& hierarchy = hierarchies[i];
+
+            hierarchy.m_Parent = handles[node.Parent];
+            hierarchy.m_Prev = parentHierarchy.m_Last;
+
+            if (lastChild[node.Parent] >= 0)
+            {
+                hierarchies[lastChild[node.Parent]].m_Next = handles[i];
+            }
+            else
+            {
+                parentHierarchy.m_First = handles[i];
+            }
+
+            parentHierarchy.m_Last = handles[i];
+            parentHierarchy.m_ChildCount++;
+            lastChild[node.Parent] = static_cast<int32_t>(i);
+        }
+
+        m_Registry.insert<TransformComponent>(handles.begin(), handles.end(), transforms.begin());
+        m_Registry.insert<TagComponent>(handles.begin(), handles.end(), tags.begin());
+
+        // The links are already complete, OnConstruct would append the children a second time
+        m_Registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+        m_Registry.insert<HierarchyComponent>(handles.begin(), handles.end(), hierarchies.begin());
+        m_Registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+
+        std::vector<Entity> entities;
+        entities.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            entities.emplace_back(handles[i], this);
+
+            if (nodes[i].Parent < 0 && (entt::entity)parent != entt::null)
+            {
+                entities.back().SetParent(parent);
+            }
+        }
+
+        return entities;
+    }
+
+    std::vector<Entity> Scene::Instantiate(const Prefab& prefab, const std::vector<glm::mat4>& placements, Entity parent, bool inactive)
+    {
+        ZoneScoped;
+
+        const size_t nodeCount = prefab.GetNodeCount();
+        const size_t instanceCount = placements.size();
+        const std::vector<PrefabNode>& nodes = prefab.GetNodes();
+
+        std::vector<entt::entity> handles(nodeCount * instanceCount);
+        m_Registry.create(handles.begin(), handles.end());
+
+        std::vector<TransformComponent> transforms;
+        std::vector<TagComponent> tags;
+        std::vector<HierarchyComponent> hierarchies(handles.size());
+        transforms.reserve(handles.size());
+        tags.reserve(handles.size());
+
+        std::vector<Entity> roots;
+
+        for (size_t instance = 0; instance < instanceCount; instance++)
+        {
+            const size_t base = instance * nodeCount;
+            auto handle = [&](int32_t node) -> entt::entity { return node >= 0 ? handles[base + node] : entt::null; };
+
+            transforms.insert(transforms.end(), prefab.GetTransforms().begin(), prefab.GetTransforms().end());
+            tags.insert(tags.end(), prefab.GetTags().begin(), prefab.GetTags().end());
+
+            for (size_t i = 0; i < nodeCount; i++)
+            {
+                const PrefabNode& node = nodes[i];
+                HierarchyComponent& hierarchy = hierarchies[base + i];
+
+                hierarchy.m_Parent = handle(node.Parent);
+                hierarchy.m_First = handle(node.First);
+                hierarchy.m_Last = handle(node.Last);
+                hierarchy.m_Next = handle(node.Next);
+                hierarchy.m_Prev = handle(node.Prev);
+                hierarchy.m_ChildCount = node.ChildCount;
+
+                if (node.Parent >= 0)
+                    continue;
+
+                // Only the roots are placed, the rest of the instance follows them
+                if (placements[instance] != glm::mat4(1.0f))
+                    transforms[base + i].SetLocalTransform(placements[instance] * transforms[base + i].GetLocalTransform());
+
+                roots.emplace_back(handles[base + i], this);
+            }
+        }
+
+        m_Registry.insert<TransformComponent>(handles.begin(), handles.end(), transforms.begin());
+        m_Registry.insert<TagComponent>(handles.begin(), handles.end(), tags.begin());
+
+        // The links are already complete, OnConstruct would append the children a second time
+        m_Registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+        m_Registry.insert<HierarchyComponent>(handles.begin(), handles.end(), hierarchies.begin());
+        m_Registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+
+        if (inactive)
+            m_Registry.insert<InactiveComponent>(handles.begin(), handles.end());
+
+        // The materials go before the meshes, so the render proxies are created with their material
+        auto insertInstances = [&]<typename T>(const std::vector<uint32_t>& prefabNodes, const std::vector<T>& components) {
+            std::vector<entt::entity> entities;
+            std::vector<T> instances;
+            entities.reserve(prefabNodes.size() * instanceCount);
+            instances.reserve(prefabNodes.size() * instanceCount);
+
+            for (size_t instance = 0; instance < instanceCount; instance++)
+            {
+                for (uint32_t node : prefabNodes)
+                {
+                    entities.push_back(handles[instance * nodeCount + node]);
+                }
+                instances.insert(instances.end(), components.begin(), components.end());
+            }
+
+            m_Registry.insert<T>(entities.begin(), entities.end(), instances.begin());
+        };
+
+        insertInstances(prefab.GetMaterialNodes(), prefab.GetMaterials());
+        insertInstances(prefab.GetMeshNodes(), prefab.GetMeshes());
+
+        if ((entt::entity)parent != entt::null)
+        {
+            for (Entity& root : roots)
+            {
+                root.SetParent(parent);
+            }
+        }
+
+        return roots;
+    }
+
+    EntityPool& Scene::GetEntityPool(const Ref<Prefab>& prefab)
+    {
+        Scope<EntityPool>& pool = m_EntityPools[prefab.get()];
+        if (!pool)
+            pool = CreateScope<EntityPool>(this, prefab);
+
+        return *pool;
+    }
+
     void Scene::DestroyEntity(Entity entity)
     {
-        auto& hierarchyComponent = m_Registry.get<HierarchyComponent>(entity);
-        auto curr = hierarchyComponent.m_First;
+        DestroySubtrees({(entt::entity)entity});
+    }
+
+    void Scene::DestroySubtrees(const std::vector<entt::entity>& roots)
+    {
+        ZoneScoped;
 
-        while(curr != entt::null)
+        const std::unordered_set<entt::entity> rootSet(roots.begin(), roots.end());
+        std::unordered_set<entt::entity> visited;
+        std::vector<entt::entity> entities;
+
+        for(entt::entity root : roots)
         {
-            Entity e{curr, this};
-            curr = m_Registry.get<HierarchyComponent>(curr).m_Next;
-            DestroyEntity(e);
+            if(!m_Registry.valid(root) || !visited.insert(root).second)
+                continue;
+
+            // The subtree of a root inside another subtree of the list is destroyed with that one
+            bool nested = false;
+            for(entt::entity parent = m_Registry.get<HierarchyComponent>(root).m_Parent; parent != entt::null;
+                parent = m_Registry.get<HierarchyComponent>(parent).m_Parent)
+            {
+                if(rootSet.find(parent) != rootSet.end())
+                {
+                    nested = true;
+                    break;
+                }
+            }
+            if(nested)
+                continue;
+
+            // Only the root is unlinked from its siblings, the rest of the subtree goes away with it
+            HierarchyComponent::OnDestroy(m_Registry, root);
+
+            size_t first = entities.size();
+            entities.push_back(root);
+            for(size_t i = first; i < entities.size(); i++)
+            {
+                for(entt::entity child = m_Registry.get<HierarchyComponent>(entities[i]).m_First; child != entt::null;
+                    child = m_Registry.get<HierarchyComponent>(child).m_Next)
+                {
+                    entities.push_back(child);
+                }
+            }
         }
 
-        m_Registry.destroy((entt::entity)entity);
+        m_Registry.on_destroy<HierarchyComponent>().disconnect<&HierarchyComponent::OnDestroy>();
+        m_Registry.destroy(entities.begin(), entities.end());
+        m_Registry.on_destroy<HierarchyComponent>().connect<&HierarchyComponent::OnDestroy>();
     }
 
     void Scene::OnInitEditor()
@@ -82,13 +454,7 @@ namespace Coffee {
         light.GetComponent<TransformComponent>().Position = {0.0f, 0.8f, -2.1f};
         
         Entity camera = CreateEntity("Camera");
-        camera.AddComponent<CameraComponent>();
-
-        // TEST ------------------------------
-        for(int i = 0; i < 25; i++)
-        {
-            m_Octree.Insert({{rand() % 20 - 10, rand() % 20 - 10, rand() % 20 - 10}});
-        } */
+        camera.AddComponent<CameraComponent>(); */
     }
 
     void Scene::OnInitRuntime()
@@ -96,51 +462,29 @@ namespace Coffee {
         ZoneScoped;
 
         m_SceneTree->Update();
-
-        auto view = m_Registry.view<MeshComponent>();
-
-        for (auto& entity : view)
-        {
-            auto& meshComponent = view.get<MeshComponent>(entity);
-            auto& transformComponent = m_Registry.get<TransformComponent>(entity);
-
-            ObjectContainer<Ref<Mesh>> objectContainer = {transformComponent.GetWorldTransform(), meshComponent.GetMesh()->GetAABB(), meshComponent.GetMesh()};
-
-            m_Octree.Insert(objectContainer);
-        }
+        UpdateRenderWorld();
     }
 
     void Scene::OnUpdateEditor(EditorCamera& camera, float dt)
     {
         ZoneScoped;
 
+        m_CommandBuffer->Playback();
+
+        // The streamed sectors are added before the scene tree update, so their entities are placed in this frame
+        if (m_WorldPartition->IsOpen())
+            m_WorldPartition->Update(camera.GetPosition());
+
         m_SceneTree->Update();
+        UpdateRenderWorld();
 
         Renderer::BeginScene(camera);
 
-        // TEST ------------------------------
-        m_Octree.DebugDraw();
-
-        // Get all entities with ModelComponent and TransformComponent
-        auto view = m_Registry.view<MeshComponent, TransformComponent>();
-
-        // Loop through each entity with the specified components
-        for (auto& entity : view)
-        {
-            // Get the ModelComponent and TransformComponent for the current entity
-            auto& meshComponent = view.get<MeshComponent>(entity);
-            auto& transformComponent = view.get<TransformComponent>(entity);
-            auto materialComponent = m_Registry.try_get<MaterialComponent>(entity);
-
-            Ref<Mesh> mesh = meshComponent.GetMesh();
-            Ref<Material> material = (materialComponent) ? materialComponent->material : nullptr;
-            
-            //Renderer::Submit(material, mesh, transformComponent.GetWorldTransform(), (uint32_t)entity);
-            Renderer::Submit(RenderCommand{transformComponent.GetWorldTransform(), mesh, material, (uint32_t)entity});
-        }
+        // The meshes are kept in the render world, the renderer culls and sorts its proxies
+        Renderer::Submit(*m_RenderWorld);
 
         //Get all entities with LightComponent and TransformComponent
-        auto lightView = m_Registry.view<LightComponent, TransformComponent>();
+        auto lightView = m_Registry.view<LightComponent, TransformComponent>(entt::exclude<InactiveComponent>);
 
         //Loop through each entity with the specified components
         for(auto& entity : lightView)
@@ -151,7 +495,7 @@ namespace Coffee {
             lightComponent.Position = transformComponent.GetWorldTransform()[3];
             lightComponent.Direction = glm::normalize(glm::vec3(-transformComponent.GetWorldTransform()[1]));
 
-            Renderer::Submit(lightComponent);
+            Renderer::Submit(lightComponent, (uint32_t)entity);
         }
 
         Renderer::EndScene();
@@ -161,95 +505,176 @@ namespace Coffee {
     {
         ZoneScoped;
 
-        m_SceneTree->Update();
+        m_SystemScheduler.Run(dt);
+    }
 
-        Camera* camera = nullptr;
-        glm::mat4 cameraTransform;
-        auto cameraView = m_Registry.view<TransformComponent, CameraComponent>();
-        for(auto entity : cameraView)
-        {
-            auto [transform, cameraComponent] = cameraView.get<TransformComponent, CameraComponent>(entity);
-            
+    void Scene::RegisterRuntimeSystems()
+    {
+        // Structural changes, nothing else can run while the entities are created and destroyed
+        m_SystemScheduler.AddSystem("Command Buffer", [this](float) {
+            m_CommandBuffer->Playback();
+        }, SystemFlags::Exclusive);
+
+        // The sectors are streamed around the camera of the last frame, before the scene tree places their entities
+        m_SystemScheduler.AddSystem("World Partition", [this](float) {
+            if (!m_WorldPartition->IsOpen())
+                return;
+
+            glm::vec3 cameraPosition(0.0f);
+            auto cameraView = m_Registry.view<TransformComponent, CameraComponent>(entt::exclude<InactiveComponent>);
+            for (auto entity : cameraView)
+            {
+                cameraPosition = cameraView.get<TransformComponent>(entity).GetWorldTransform()[3];
+            }
+
+            m_WorldPartition->Update(cameraPosition);
+        }, SystemFlags::Exclusive | SystemFlags::MainThread);
+
+        m_SystemScheduler.AddSystem<Reads<HierarchyComponent>, Writes<TransformComponent, SceneTree>>("Scene Tree", [this](float) {
+            m_SceneTree->Update();
+        });
+
+        // Reads the transforms changed by the scene tree update, the SceneTree access orders it after that system
+        m_SystemScheduler.AddSystem<Reads<TransformComponent, SceneTree>, Writes<RenderWorld>>("Render World", [this](float) {
+            UpdateRenderWorld();
+        });
+
+        m_SystemScheduler.AddSystem<Reads<TransformComponent, CameraComponent, InactiveComponent>, Writes<Camera>>("Camera", [this](float) {
             //TODO: Multiple cameras support (for now, the last camera found will be used)
-            camera = &cameraComponent.Camera;
-            cameraTransform = transform.GetWorldTransform();
-        }
+            m_RuntimeCamera = nullptr;
+            auto cameraView = m_Registry.view<TransformComponent, CameraComponent>(entt::exclude<InactiveComponent>);
+            for(auto entity : cameraView)
+            {
+                auto [transform, cameraComponent] = cameraView.get<TransformComponent, CameraComponent>(entity);
 
-        if(!camera)
-        {
-            COFFEE_ERROR("No camera entity found!");
+                m_RuntimeCamera = &cameraComponent.Camera;
+                m_RuntimeCameraTransform = transform.GetWorldTransform();
+            }
+        });
 
-            SceneCamera sceneCamera;
-            camera = &sceneCamera;
+        m_SystemScheduler.AddSystem<Reads<TransformComponent, InactiveComponent>, Writes<LightComponent>>("Lights", [this](float) {
+            auto lightView = m_Registry.view<LightComponent, TransformComponent>(entt::exclude<InactiveComponent>);
+            for(auto& entity : lightView)
+            {
+                auto& lightComponent = lightView.get<LightComponent>(entity);
+                auto& transformComponent = lightView.get<TransformComponent>(entity);
 
-            cameraTransform = glm::mat4(1.0f);
-        }
+                lightComponent.Position = transformComponent.GetWorldTransform()[3];
+                lightComponent.Direction = glm::normalize(glm::vec3(-transformComponent.GetWorldTransform()[1]));
+            }
+        });
 
-        //TODO: Add this to a function bc it is repeated in OnUpdateEditor
-        Renderer::BeginScene(*camera, cameraTransform);
+        // The scripts can touch any component, so they run alone
+        m_SystemScheduler.AddSystem("Scripts", [this](float) {
+            auto scriptView = m_Registry.view<ScriptComponent>(entt::exclude<InactiveComponent>);
 
-        m_Octree.DebugDraw();
+            // The spatial queries of the scripts run on this scene
+            ScriptManager::RegisterVariable("scene", (void*)this);
 
-        // Get all the static meshes from the Octree
+            for (auto& entity : scriptView)
+            {
+                Entity scriptEntity{entity, this};
+                ScriptManager::RegisterVariable("entity", (void*)&scriptEntity);
 
-        glm::mat4 testProjection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+                auto& scriptComponent = scriptView.get<ScriptComponent>(entity);
 
-        Frustum frustum = Frustum(camera->GetProjection() /* testProjection */ * glm::inverse(cameraTransform));
-        DebugRenderer::DrawFrustum(frustum, glm::vec4(1.0f), 1.0f);
+                scriptComponent.script.OnUpdate();
+            }
 
-        auto meshes = m_Octree.Query(frustum);
+            // The structural changes of the scripts are applied once they are all done iterating
+            m_CommandBuffer->Playback();
+        }, SystemFlags::Exclusive | SystemFlags::MainThread);
 
-        for(auto& mesh : meshes)
-        {
-            Renderer::Submit(RenderCommand{mesh.transform, mesh.object, mesh.object->GetMaterial(), 0});
-        }
-        
-/*         // Get all entities with ModelComponent and TransformComponent
-        auto view = m_Registry.view<MeshComponent, TransformComponent>();
+        m_SystemScheduler.AddSystem<Reads<RenderWorld, LightComponent, CameraComponent, InactiveComponent, Camera>>("Render", [this](float) {
+            Camera* camera = m_RuntimeCamera;
+            glm::mat4 cameraTransform = m_RuntimeCameraTransform;
 
-        // Loop through each entity with the specified components
-        for (auto& entity : view)
-        {
-            // Get the ModelComponent and TransformComponent for the current entity
-            auto& meshComponent = view.get<MeshComponent>(entity);
-            auto& transformComponent = view.get<TransformComponent>(entity);
-            auto materialComponent = m_Registry.try_get<MaterialComponent>(entity);
+            if(!camera)
+            {
+                COFFEE_ERROR("No camera entity found!");
 
-            Ref<Mesh> mesh = meshComponent.GetMesh();
-            Ref<Material> material = (materialComponent) ? materialComponent->material : nullptr;
-            
-            Renderer::Submit(RenderCommand{transformComponent.GetWorldTransform(), mesh, material, (uint32_t)entity});
-        } */
+                camera = &m_DefaultCamera;
+                cameraTransform = glm::mat4(1.0f);
+            }
 
-        //Get all entities with LightComponent and TransformComponent
-        auto lightView = m_Registry.view<LightComponent, TransformComponent>();
+            Renderer::BeginScene(*camera, cameraTransform);
 
-        //Loop through each entity with the specified components
-        for(auto& entity : lightView)
-        {
-            auto& lightComponent = lightView.get<LightComponent>(entity);
-            auto& transformComponent = lightView.get<TransformComponent>(entity);
+            Frustum frustum = Frustum(camera->GetProjection() * glm::inverse(cameraTransform));
+            DebugRenderer::DrawFrustum(frustum, glm::vec4(1.0f), 1.0f);
 
-            lightComponent.Position = transformComponent.GetWorldTransform()[3];
-            lightComponent.Direction = glm::normalize(glm::vec3(-transformComponent.GetWorldTransform()[1]));
+            Renderer::Submit(*m_RenderWorld);
 
-            Renderer::Submit(lightComponent);
-        }
+            auto lightView = m_Registry.view<LightComponent>(entt::exclude<InactiveComponent>);
+            for(auto& entity : lightView)
+            {
+                Renderer::Submit(lightView.get<LightComponent>(entity), (uint32_t)entity);
+            }
 
-        // Get all entities with ScriptComponent
-        auto scriptView = m_Registry.view<ScriptComponent>();
+            Renderer::EndScene();
+        }, SystemFlags::MainThread);
+    }
 
-        for (auto& entity : scriptView)
-        {
-            Entity scriptEntity{entity, this};
-            ScriptManager::RegisterVariable("entity", (void*)&scriptEntity);
+    void Scene::OnMeshComponentChanged(entt::registry& registry, entt::entity entity)
+    {
+        // The inactive entities have no proxy, it is created when they are activated
+        if (registry.all_of<InactiveComponent>(entity))
+            return;
 
-            auto& scriptComponent = scriptView.get<ScriptComponent>(entity);
+        AddRenderProxy(registry, entity);
+    }
 
-            scriptComponent.script.OnUpdate();
-        }
+    void Scene::AddRenderProxy(entt::registry& registry, entt::entity entity)
+    {
+        auto& meshComponent = registry.get<MeshComponent>(entity);
+        auto transformComponent = registry.try_get<TransformComponent>(entity);
+        auto materialComponent = registry.try_get<MaterialComponent>(entity);
+
+        RenderCommand command;
+        command.transform = transformComponent ? transformComponent->GetWorldTransform() : glm::mat4(1.0f);
+        command.mesh = meshComponent.GetMesh();
+        command.material = materialComponent ? materialComponent->material : nullptr;
+        command.entityID = (uint32_t)entity;
+        command.castShadows = meshComponent.castShadows;
+        command.isStatic = meshComponent.isStatic;
+
+        m_RenderWorld->AddProxy(command);
+    }
 
-        Renderer::EndScene();
+    void Scene::OnMeshComponentDestroyed(entt::registry& registry, entt::entity entity)
+    {
+        m_RenderWorld->RemoveProxy((uint32_t)entity);
+    }
+
+    void Scene::OnMaterialComponentChanged(entt::registry& registry, entt::entity entity)
+    {
+        m_RenderWorld->UpdateMaterial((uint32_t)entity, registry.get<MaterialComponent>(entity).material);
+    }
+
+    void Scene::OnMaterialComponentDestroyed(entt::registry& registry, entt::entity entity)
+    {
+        m_RenderWorld->UpdateMaterial((uint32_t)entity, nullptr);
+    }
+
+    void Scene::OnEntityActivated(entt::registry& registry, entt::entity entity)
+    {
+        // Called while the entity still has the tag
+        if (registry.all_of<MeshComponent>(entity))
+            AddRenderProxy(registry, entity);
+    }
+
+    void Scene::OnEntityDeactivated(entt::registry& registry, entt::entity entity)
+    {
+        m_RenderWorld->RemoveProxy((uint32_t)entity);
+    }
+
+    void Scene::UpdateRenderWorld()
+    {
+        ZoneScoped;
+
+        for (entt::entity entity : m_SceneTree->GetChangedTransforms())
+        {
+            m_RenderWorld->UpdateTransform((uint32_t)entity, m_Registry.get<TransformComponent>(entity).GetWorldTransform());
+        }
     }
 
     void Scene::OnEvent(Event& e)
@@ -273,100 +698,195 @@ namespace Coffee {
 
         Ref<Scene> scene = CreateRef<Scene>();
 
-        std::ifstream sceneFile(path);
-        cereal::JSONInputArchive archive(sceneFile);
-
-        entt::snapshot_loader{scene->m_Registry}
-            .get<entt::entity>(archive)
-            .get<TagComponent>(archive)
-            .get<TransformComponent>(archive)
-            .get<HierarchyComponent>(archive)
-            .get<CameraComponent>(archive)
-            .get<MeshComponent>(archive)
-            .get<MaterialComponent>(archive)
-            .get<LightComponent>(archive);
-        
-        scene->m_FilePath = path;
-
-        auto view = scene->m_Registry.view<entt::entity>();
-        for (auto entity : view)
+        if (SceneBinaryFormat::IsBinary(path))
         {
-            auto& tag = scene->m_Registry.get<TagComponent>(entity);
-            auto& hierarchy = scene->m_Registry.get<HierarchyComponent>(entity);
-
-            COFFEE_INFO("Entity {0}, {1}", (uint32_t)entity, tag.Tag);
+            if (!SceneBinaryFormat::Load(path, *scene))
+                COFFEE_CORE_ERROR("Scene::Load: Could not load the binary scene {0}", path.string());
+        }
+        else
+        {
+            std::ifstream sceneFile(path);
+            cereal::JSONInputArchive archive(sceneFile);
+
+            // The serialized links are already complete, OnConstruct would append the children a second time
+            scene->m_Registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+
+            entt::snapshot_loader loader{scene->m_Registry};
+            loader.get<entt::entity>(archive)
+                .get<TagComponent>(archive)
+                .get<TransformComponent>(archive)
+                .get<HierarchyComponent>(archive)
+                .get<CameraComponent>(archive)
+                .get<MeshComponent>(archive)
+                .get<MaterialComponent>(archive)
+                .get<LightComponent>(archive);
+
+            // The scenes saved before the pools have no inactive entities
+            if (archive.getNodeName())
+                loader.get<InactiveComponent>(archive);
+
+            scene->m_Registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+            HierarchyComponent::RebuildChildLinks(scene->m_Registry);
         }
 
+        scene->m_FilePath = path;
+
+        // The sectors of a partitioned scene are streamed in by the updates
+        scene->m_WorldPartition->Open(WorldPartition::GetDirectory(path));
+
         return scene;
     }
 
-    void Scene::Save(const std::filesystem::path& path, Ref<Scene> scene)
+    // The streamed entities are kept in their sector files, the scene file only has the ones that are always loaded.
+    // Saving to another path copies the sectors next to the new file, the loaded sectors stay in the scene.
+    static bool PrepareWorldPartition(WorldPartition& worldPartition, const std::filesystem::path& path)
     {
-        ZoneScoped;
+        if (!worldPartition.IsOpen())
+            return true;
 
-        std::ofstream sceneFile(path);
-        cereal::JSONOutputArchive archive(sceneFile);
-
-        //archive(*scene);
-
-        //TEMPORAL
-        entt::snapshot{scene->m_Registry}
-            .get<entt::entity>(archive)
-            .get<TagComponent>(archive)
-            .get<TransformComponent>(archive)
-            .get<HierarchyComponent>(archive)
-            .get<CameraComponent>(archive)
-            .get<MeshComponent>(archive)
-            .get<MaterialComponent>(archive)
-            .get<LightComponent>(archive);
-        
-        scene->m_FilePath = path;
+        std::filesystem::path directory = WorldPartition::GetDirectory(path);
+        if (directory == worldPartition.GetPath())
+            return true;
 
-        auto view = scene->m_Registry.view<entt::entity>();
-        for (auto entity : view)
+        std::error_code error;
+        std::filesystem::copy(worldPartition.GetPath(), directory,
+                              std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, error);
+        if (error)
         {
-            auto& tag = scene->m_Registry.get<TagComponent>(entity);
-            auto& hierarchy = scene->m_Registry.get<HierarchyComponent>(entity);
-
-            COFFEE_INFO("Entity {0}, {1}", (uint32_t)entity, tag.Tag);
+            COFFEE_CORE_ERROR("Scene::Save: Could not copy the sectors from {0} to {1}: {2}", worldPartition.GetPath().string(),
+                              directory.string(), error.message());
+            return false;
         }
+
+        worldPartition.Relocate(directory);
+        return true;
     }
 
-    // Is possible that this function will be moved to the SceneTreePanel but for now it will stay here
-    void AddModelToTheSceneTree(Scene* scene, Ref<Model> model)
+    // Writes a scene file next to its destination and moves it over the destination once it is complete
+    static bool WriteSceneFile(const std::filesystem::path& path, const entt::registry& registry, std::atomic<float>& progress)
     {
-        static Entity parent;
-
-        Entity modelEntity = scene->CreateEntity(model->GetName());
+        ZoneScoped;
 
-        if((entt::entity)parent != entt::null)modelEntity.SetParent(parent);
-        modelEntity.GetComponent<TransformComponent>().SetLocalTransform(model->GetTransform());
+        std::filesystem::path temporaryPath = path;
+        temporaryPath += ".tmp";
 
-        auto& meshes = model->GetMeshes();
-        bool hasMultipleMeshes = meshes.size() > 1;
+        bool written = false;
 
-        for(auto& mesh : meshes)
+        // The binary format is picked by the extension, loading detects it by the content of the file
+        if (path.extension() == ".TeaSceneBin")
         {
-            Entity entity = hasMultipleMeshes ? scene->CreateEntity(mesh->GetName()) : modelEntity;
-
-            entity.AddComponent<MeshComponent>(mesh);
-
-            if(mesh->GetMaterial())
+            written = SceneBinaryFormat::Save(temporaryPath, registry);
+        }
+        else
+        {
+            std::ofstream sceneFile(temporaryPath);
             {
-                entity.AddComponent<MaterialComponent>(mesh->GetMaterial());
+                cereal::JSONOutputArchive archive(sceneFile);
+                entt::snapshot snapshot{registry};
+
+                constexpr float Steps = 9.0f;
+                snapshot.get<entt::entity>(archive);
+                progress.store(1.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<TagComponent>(archive);
+                progress.store(2.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<TransformComponent>(archive);
+                progress.store(3.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<HierarchyComponent>(archive);
+                progress.store(4.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<CameraComponent>(archive);
+                progress.store(5.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<MeshComponent>(archive);
+                progress.store(6.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<MaterialComponent>(archive);
+                progress.store(7.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<LightComponent>(archive);
+                progress.store(8.0f / Steps, std::memory_order_relaxed);
+                snapshot.get<InactiveComponent>(archive);
             }
 
-            if(hasMultipleMeshes)
-            {
-                entity.SetParent(modelEntity);
-            }
+            sceneFile.close();
+            written = !sceneFile.fail();
+        }
+
+        std::error_code error;
+        if (!written)
+        {
+            COFFEE_CORE_ERROR("Scene::Save: Could not write {0}", temporaryPath.string());
+            std::filesystem::remove(temporaryPath, error);
+            return false;
         }
 
-        for(auto& c : model->GetChildren())
+        if (!ReplaceFileAtomically(temporaryPath, path, error))
         {
-            parent = modelEntity;
-            AddModelToTheSceneTree(scene, c);
+            COFFEE_CORE_ERROR("Scene::Save: Could not replace {0}: {1}", path.string(), error.message());
+            std::filesystem::remove(temporaryPath, error);
+            return false;
         }
+
+        progress.store(1.0f, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Scene::WriteFile(const std::filesystem::path& path, const std::vector<entt::entity>& excludedRoots) const
+    {
+        ZoneScoped;
+
+        std::atomic<float> progress = 0.0f;
+        if (excludedRoots.empty())
+            return WriteSceneFile(path, m_Registry, progress);
+
+        entt::registry snapshot;
+        CopyRegistry(m_Registry, snapshot, excludedRoots);
+        return WriteSceneFile(path, snapshot, progress);
+    }
+
+    bool Scene::Save(const std::filesystem::path& path, Ref<Scene> scene)
+    {
+        ZoneScoped;
+
+        if (!PrepareWorldPartition(*scene->m_WorldPartition, path))
+            return false;
+
+        // The loaded sectors are already in their files
+        if (!scene->WriteFile(path, scene->m_WorldPartition->GetLoadedRoots()))
+            return false;
+
+        scene->m_FilePath = path;
+        return true;
+    }
+
+    Ref<SceneSaveTask> Scene::SaveAsync(const std::filesystem::path& path, Ref<Scene> scene)
+    {
+        ZoneScoped;
+
+        // A task that fails before starting is already done and reports the failure
+        Ref<SceneSaveTask> task = CreateRef<SceneSaveTask>(path);
+        if (!PrepareWorldPartition(*scene->m_WorldPartition, path))
+            return task;
+
+        // Only the copy of the components is taken here, the serialization and the file run on a worker.
+        // The loaded sectors are already in their files and stay in the scene.
+        CopyRegistry(scene->m_Registry, task->m_Snapshot, scene->m_WorldPartition->GetLoadedRoots());
+
+        // The task waits for the job when it is destroyed, so the job can hold it by pointer
+        SceneSaveTask* savingTask = task.get();
+        JobSystem::SubmitBackground([savingTask]() {
+            ZoneScopedN("Save Scene");
+
+            bool succeeded = WriteSceneFile(savingTask->m_Path, savingTask->m_Snapshot, savingTask->m_Progress);
+            savingTask->m_Succeeded.store(succeeded, std::memory_order_release);
+        }, &task->m_Counter);
+
+        scene->m_FilePath = path;
+        return task;
+    }
+
+    // Is possible that this function will be moved to the SceneTreePanel but for now it will stay here
+    void AddModelToTheSceneTree(Scene* scene, Ref<Model> model)
+    {
+        ZoneScoped;
+
+        scene->Instantiate(*Prefab::Get(model), {glm::mat4(1.0f)});
     }
 
 }
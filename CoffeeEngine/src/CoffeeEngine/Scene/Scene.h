@@ -1,14 +1,20 @@
 #pragma once
 
-#include "CoffeeEngine/Core/DataStructures/Octree.h"
 #include "CoffeeEngine/Events/Event.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
+#include "CoffeeEngine/Renderer/RenderWorld.h"
+#include "CoffeeEngine/Scene/EntityCommandBuffer.h"
+#include "CoffeeEngine/Scene/SceneCamera.h"
 #include "CoffeeEngine/Scene/SceneTree.h"
+#include "CoffeeEngine/Scene/SystemScheduler.h"
+#include "CoffeeEngine/Scene/WorldPartition.h"
 #include "entt/entity/fwd.hpp"
 
 #include <entt/entt.hpp>
 #include <filesystem>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Coffee {
 
@@ -18,7 +24,10 @@ namespace Coffee {
      */
 
     class Entity;
+    class EntityPool;
     class Model;
+    class Prefab;
+    class SceneSaveTask;
 
     /**
      * @brief Class representing a scene.
@@ -33,11 +42,22 @@ namespace Coffee {
         Scene();
 
         /**
-         * @brief Default destructor.
+         * @brief Destructor, defined with the entity pools complete.
          */
-        ~Scene() = default;
+        ~Scene();
 
-        //Scene(Ref<Scene> other);
+        /**
+         * @brief Copy a scene in memory, used to enter the play mode without touching the edited scene.
+         *
+         * The entities keep their handles, so the hierarchy links are valid in the copy as they are and every
+         * component storage is copied in one pass. The meshes and materials are shared with the original scene.
+         * The components that are not saved with the scene, like the scripts, are not copied either.
+         *
+         * @param other The scene to copy, it is not modified. The world partition sectors it has loaded are left out
+         * of the copy, whose own partition streams them again.
+         * @return The copy of the scene.
+         */
+        static Ref<Scene> Copy(const Ref<Scene>& other);
 
         /**
          * @brief Create an entity in the scene.
@@ -47,11 +67,79 @@ namespace Coffee {
         Entity CreateEntity(const std::string& name = std::string());
 
         /**
-         * @brief Destroy an entity in the scene.
+         * @brief Create a whole subtree of entities in one pass.
+         *
+         * The entities and their components are created in bulk and the hierarchy links are written directly, which
+         * avoids attaching the children one by one.
+         *
+         * @param nodes The entities to create, every parent is listed before its children.
+         * @param parent The entity the top nodes are attached to, a null entity creates them as roots.
+         * @return The created entities in the order of the descriptions.
+         */
+        std::vector<Entity> CreateEntities(const std::vector<HierarchyNodeDescription>& nodes, Entity parent);
+
+        /**
+         * @brief Place several instances of a prefab in one pass.
+         *
+         * The entities of every instance are created in a single call and each component type is inserted with one
+         * call for all the instances, with the hierarchy links of the prefab turned into the new handles.
+         *
+         * @param prefab The prefab.
+         * @param placements The transform of each instance, applied on top of the local transform of the prefab roots.
+         * @param parent The entity the instances are attached to, a null entity creates them as roots.
+         * @param inactive Creates the instances tagged with InactiveComponent, before their meshes, so no render proxy is built for them.
+         * @return The root entities of the instances, one per root of the prefab and instance, in placement order.
+         */
+        std::vector<Entity> Instantiate(const Prefab& prefab, const std::vector<glm::mat4>& placements, Entity parent = Entity(),
+                                        bool inactive = false);
+
+        /**
+         * @brief Get the pool of the instances of a prefab, created the first time it is requested.
+         * @param prefab The prefab.
+         * @return The entity pool of the prefab.
+         */
+        EntityPool& GetEntityPool(const Ref<Prefab>& prefab);
+
+        /**
+         * @brief Get the entity pools of the scene.
+         * @return The pools by their prefab.
+         */
+        const std::unordered_map<const Prefab*, Scope<EntityPool>>& GetEntityPools() const { return m_EntityPools; }
+
+        /**
+         * @brief Get the scheduler of the runtime systems, the gameplay systems are added to it.
+         * @return The system scheduler.
+         */
+        SystemScheduler& GetSystemScheduler() { return m_SystemScheduler; }
+
+        /**
+         * @brief Destroy an entity and all its children.
          * @param entity The entity to destroy.
          */
         void DestroyEntity(Entity entity);
 
+        /**
+         * @brief Get the buffer where the structural changes made during the update are recorded.
+         *
+         * The commands are applied at the sync points of the scene update: before the scene tree is updated and,
+         * in runtime, after the scripts.
+         *
+         * @return The command buffer of the scene.
+         */
+        EntityCommandBuffer& GetCommandBuffer() { return *m_CommandBuffer; }
+
+        /**
+         * @brief Get the scene tree that updates the world transforms.
+         * @return The scene tree of the scene.
+         */
+        SceneTree& GetSceneTree() { return *m_SceneTree; }
+
+        /**
+         * @brief Get the partition that streams the sectors of the scene around the camera.
+         * @return The world partition of the scene, it is not open if the scene was never partitioned.
+         */
+        WorldPartition& GetWorldPartition() { return *m_WorldPartition; }
+
         /**
          * @brief Initialize the scene.
          */
@@ -90,31 +178,100 @@ namespace Coffee {
         }
 
         /**
-         * @brief Load a scene from a file.
+         * @brief Load a scene from a file, JSON or binary.
          * @param path The path to the file.
          * @return The loaded scene.
          */
         static Ref<Scene> Load(const std::filesystem::path& path);
 
         /**
-         * @brief Save a scene to a file.
+         * @brief Save a scene to a file, in the binary format if the extension is .TeaSceneBin and in JSON otherwise.
+         * @param path The path to the file.
+         * @param scene The scene to save.
+         * @return True if the file was written, the previous file is left untouched otherwise.
+         */
+        static bool Save(const std::filesystem::path& path, Ref<Scene> scene);
+
+        /**
+         * @brief Save a scene to a file in the background.
+         *
+         * The components are copied before returning and a worker thread writes the copy, so the scene can keep
+         * changing during the save. The loaded world partition sectors are left out of the file and stay loaded, the same as
+         * Save does.
+         *
          * @param path The path to the file.
          * @param scene The scene to save.
+         * @return The task that reports the progress and the result of the save.
          */
-        static void Save(const std::filesystem::path& path, Ref<Scene> scene);
+        static Ref<SceneSaveTask> SaveAsync(const std::filesystem::path& path, Ref<Scene> scene);
 
         const std::filesystem::path& GetFilePath() { return m_FilePath; }
+
+        /**
+         * @brief Get the render proxies of the meshes of the scene.
+         * @return The render world.
+         */
+        const RenderWorld& GetRenderWorld() const { return *m_RenderWorld; }
+    private:
+        void OnMeshComponentChanged(entt::registry& registry, entt::entity entity);
+        void OnMeshComponentDestroyed(entt::registry& registry, entt::entity entity);
+        void OnMaterialComponentChanged(entt::registry& registry, entt::entity entity);
+        void OnMaterialComponentDestroyed(entt::registry& registry, entt::entity entity);
+        void AddRenderProxy(entt::registry& registry, entt::entity entity);
+        void OnEntityActivated(entt::registry& registry, entt::entity entity);
+        void OnEntityDeactivated(entt::registry& registry, entt::entity entity);
+
+        /**
+         * @brief Register the systems of the runtime update: scene tree, render world, camera, lights, scripts and render.
+         */
+        void RegisterRuntimeSystems();
+
+        /**
+         * @brief Move the render proxies of the entities whose world transform changed in the last scene tree update.
+         */
+        void UpdateRenderWorld();
+
+        /**
+         * @brief Destroy whole subtrees at once.
+         *
+         * Only the roots are unlinked from their parents, the links inside the subtrees are dropped with them.
+         *
+         * @param roots The roots of the subtrees, the ones inside another subtree of the list are skipped.
+         */
+        void DestroySubtrees(const std::vector<entt::entity>& roots);
+
+        /**
+         * @brief Write the scene file without some subtrees, the scene itself is not modified.
+         * @param path The path to the file.
+         * @param excludedRoots The roots of the subtrees left out of the file.
+         * @return True if the file was written, the previous file is left untouched otherwise.
+         */
+        bool WriteFile(const std::filesystem::path& path, const std::vector<entt::entity>& excludedRoots) const;
     private:
+        // Declared before the registry so it is still alive while the registry notifies the destruction of its components
+        Scope<RenderWorld> m_RenderWorld;
         entt::registry m_Registry;
         Scope<SceneTree> m_SceneTree;
-        Octree<Ref<Mesh>> m_Octree;
+        Scope<EntityCommandBuffer> m_CommandBuffer;
+        Scope<WorldPartition> m_WorldPartition;
+        std::unordered_map<const Prefab*, Scope<EntityPool>> m_EntityPools;
+        SystemScheduler m_SystemScheduler;
+
+        // The camera found by the camera system for the render system
+        Camera* m_RuntimeCamera = nullptr;
+        glm::mat4 m_RuntimeCameraTransform = glm::mat4(1.0f);
+        SceneCamera m_DefaultCamera;
 
         // Temporal: Scenes should be Resources and the Base Resource class already has a path variable.
         std::filesystem::path m_FilePath;
 
         friend class Entity;
+        friend class EntityCommandBuffer;
+        friend class EntityPool;
         friend class SceneTree;
         friend class SceneTreePanel;
+        friend class SceneBinaryFormat;
+        friend class WorldPartition;
 
         //REMOVE PLEASE, THIS IS ONLY TO TEST THE OCTREE!!!!
         friend class EditorLayer;
@@ -0,0 +1,571 @@
+#include "CoffeeEngine/Scene/SceneBinaryFormat.h"
+
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/MappedFile.h"
+#include "CoffeeEngine/IO/ResourceRegistry.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <algorithm>
+#include <cereal/archives/binary.hpp>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <streambuf>
+#include <tracy/Tracy.hpp>
+#include <type_traits>
+#include <vector>
+
+namespace Coffee {
+
+    static constexpr char s_Magic[8] = {'C', 'O', 'F', 'S', 'C', 'E', 'N', 'E'};
+
+    // The components copied as raw bytes
+    static_assert(std::is_trivially_copyable_v<TransformComponent>);
+    static_assert(std::is_trivially_copyable_v<HierarchyComponent>);
+    static_assert(std::is_trivially_copyable_v<LightComponent>);
+
+    struct TagRecord
+    {
+        uint32_t Offset; ///< Offset of the name in the string table.
+        uint32_t Length;
+    };
+
+    struct MeshRecord
+    {
+        uint64_t Mesh; ///< UUID of the mesh.
+        uint8_t CastShadows;
+        uint8_t Static;
+        uint8_t Padding[6];
+    };
+
+    // Hash of the size and alignment of a raw component and of the offset and size of its members. The private
+    // members are covered by the offsets of the public ones that follow them and by the size of the component.
+    template<typename T, typename... Members>
+    static uint32_t HashLayout(Members T::*... members)
+    {
+        const T component{};
+        const char* base = reinterpret_cast<const char*>(&component);
+
+        uint32_t hash = 2166136261u;
+        auto combine = [&hash](size_t value) { hash = (hash ^ static_cast<uint32_t>(value)) * 16777619u; };
+
+        combine(sizeof(T));
+        combine(alignof(T));
+        (..., (combine(reinterpret_cast<const char*>(&(component.*members)) - base), combine(sizeof(component.*members))));
+        return hash;
+    }
+
+    template<typename T>
+    static uint32_t GetLayoutHash();
+
+    template<>
+    uint32_t GetLayoutHash<TransformComponent>()
+    {
+        return HashLayout(&TransformComponent::Position, &TransformComponent::Rotation, &TransformComponent::Scale);
+    }
+
+    template<>
+    uint32_t GetLayoutHash<HierarchyComponent>()
+    {
+        return HashLayout(&HierarchyComponent::m_Parent, &HierarchyComponent::m_First, &HierarchyComponent::m_Last,
+                          &HierarchyComponent::m_Next, &HierarchyComponent::m_Prev, &HierarchyComponent::m_ChildCount);
+    }
+
+    template<>
+    uint32_t GetLayoutHash<LightComponent>()
+    {
+        return HashLayout(&LightComponent::Color, &LightComponent::Direction, &LightComponent::Position, &LightComponent::Range,
+                          &LightComponent::Attenuation, &LightComponent::Intensity, &LightComponent::Angle, &LightComponent::type,
+                          &LightComponent::CastShadows, &LightComponent::ShadowCascadeCount, &LightComponent::ShadowResolution,
+                          &LightComponent::ShadowUpdateInterval, &LightComponent::ShadowDistance, &LightComponent::ShadowBias);
+    }
+
+    static size_t Align(size_t value)
+    {
+        return (value + 15) & ~static_cast<size_t>(15);
+    }
+
+    // Stream over a block of the mapped file, for the components that go through cereal
+    struct MemoryStreamBuffer : std::streambuf
+    {
+        MemoryStreamBuffer(const uint8_t* data, size_t size)
+        {
+            char* begin = reinterpret_cast<char*>(const_cast<uint8_t*>(data));
+            setg(begin, begin, begin + size);
+        }
+    };
+
+    /**
+     * @brief Builds a binary scene in memory, the header and the block table are written at the end.
+     */
+    class SceneBlockWriter
+    {
+    public:
+        SceneBlockWriter(uint32_t blockCount)
+            : m_Buffer(Align(sizeof(SceneFileHeader) + blockCount * sizeof(SceneBlockHeader)), 0) {}
+
+        void WriteBlock(SceneBlockType type, uint32_t count, uint32_t elementSize, const entt::entity* entities,
+                        const void* elements, size_t elementBytes, uint32_t layoutHash = 0)
+        {
+            SceneBlockHeader block{};
+            block.Type = static_cast<uint32_t>(type);
+            block.Count = count;
+            block.ElementSize = elementSize;
+            block.LayoutHash = layoutHash;
+            block.Offset = m_Buffer.size();
+
+            if (entities)
+            {
+                Append(entities, count * sizeof(entt::entity));
+                m_Buffer.resize(Align(m_Buffer.size()), 0);
+            }
+            Append(elements, elementBytes);
+
+            block.Size = m_Buffer.size() - block.Offset;
+            m_Buffer.resize(Align(m_Buffer.size()), 0);
+
+            m_Blocks.push_back(block);
+        }
+
+        template<typename T>
+        void WriteRawBlock(SceneBlockType type, const entt::registry& registry)
+        {
+            std::vector<entt::entity> entities;
+            std::vector<T> components;
+
+            auto view = registry.view<T>();
+            for (auto entity : view)
+            {
+                entities.push_back(entity);
+                components.push_back(view.template get<T>(entity));
+            }
+
+            WriteBlock(type, static_cast<uint32_t>(entities.size()), sizeof(T), entities.data(), components.data(), components.size() * sizeof(T),
+                       GetLayoutHash<T>());
+        }
+
+        const std::vector<uint8_t>& Finish(uint32_t entityCount, uint32_t entityRange)
+        {
+            SceneFileHeader header{};
+            std::memcpy(header.Magic, s_Magic, sizeof(s_Magic));
+            header.Version = SceneBinaryFormat::Version;
+            header.EntityCount = entityCount;
+            header.BlockCount = static_cast<uint32_t>(m_Blocks.size());
+            header.EntityRange = entityRange;
+
+            std::memcpy(m_Buffer.data(), &header, sizeof(header));
+            std::memcpy(m_Buffer.data() + sizeof(header), m_Blocks.data(), m_Blocks.size() * sizeof(SceneBlockHeader));
+            return m_Buffer;
+        }
+
+    private:
+        void Append(const void* data, size_t size)
+        {
+            if (size == 0)
+                return;
+
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+        }
+
+    private:
+        std::vector<uint8_t> m_Buffer;
+        std::vector<SceneBlockHeader> m_Blocks;
+    };
+
+    bool SceneBinaryFormat::IsBinary(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        char magic[sizeof(s_Magic)] = {};
+        file.read(magic, sizeof(magic));
+        return file && std::memcmp(magic, s_Magic, sizeof(s_Magic)) == 0;
+    }
+
+    bool SceneBinaryFormat::Save(const std::filesystem::path& path, const entt::registry& registry)
+    {
+        ZoneScoped;
+
+        SceneBlockWriter writer(10);
+
+        // In ascending order, so loading creates them front to back
+        std::vector<entt::entity> entities;
+        for (auto entity : registry.view<entt::entity>())
+        {
+            entities.push_back(entity);
+        }
+        std::sort(entities.begin(), entities.end());
+
+        writer.WriteBlock(SceneBlockType::Entities, static_cast<uint32_t>(entities.size()), sizeof(entt::entity), nullptr,
+                          entities.data(), entities.size() * sizeof(entt::entity));
+
+        {
+            std::string strings;
+            std::vector<entt::entity> tagEntities;
+            std::vector<TagRecord> tags;
+
+            auto view = registry.view<TagComponent>();
+            for (auto entity : view)
+            {
+                const std::string& tag = view.get<TagComponent>(entity).Tag;
+                tagEntities.push_back(entity);
+                tags.push_back({static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(tag.size())});
+                strings += tag;
+            }
+
+            writer.WriteBlock(SceneBlockType::StringTable, static_cast<uint32_t>(strings.size()), 1, nullptr, strings.data(), strings.size());
+            writer.WriteBlock(SceneBlockType::Tag, static_cast<uint32_t>(tags.size()), sizeof(TagRecord), tagEntities.data(),
+                              tags.data(), tags.size() * sizeof(TagRecord));
+        }
+
+        writer.WriteRawBlock<TransformComponent>(SceneBlockType::Transform, registry);
+        writer.WriteRawBlock<HierarchyComponent>(SceneBlockType::Hierarchy, registry);
+
+        {
+            std::vector<entt::entity> cameraEntities;
+            std::ostringstream stream;
+            {
+                cereal::BinaryOutputArchive archive(stream);
+
+                auto view = registry.view<CameraComponent>();
+                for (auto entity : view)
+                {
+                    cameraEntities.push_back(entity);
+                    archive(view.get<CameraComponent>(entity));
+                }
+            }
+
+            const std::string cameras = stream.str();
+            writer.WriteBlock(SceneBlockType::Camera, static_cast<uint32_t>(cameraEntities.size()), 0, cameraEntities.data(),
+                              cameras.data(), cameras.size());
+        }
+
+        {
+            std::vector<entt::entity> meshEntities;
+            std::vector<MeshRecord> meshes;
+
+            auto view = registry.view<MeshComponent>();
+            for (auto entity : view)
+            {
+                const MeshComponent& meshComponent = view.get<MeshComponent>(entity);
+
+                MeshRecord record{};
+                record.Mesh = meshComponent.mesh->GetUUID();
+                record.CastShadows = meshComponent.castShadows;
+                record.Static = meshComponent.isStatic;
+
+                meshEntities.push_back(entity);
+                meshes.push_back(record);
+            }
+
+            writer.WriteBlock(SceneBlockType::Mesh, static_cast<uint32_t>(meshes.size()), sizeof(MeshRecord), meshEntities.data(),
+                              meshes.data(), meshes.size() * sizeof(MeshRecord));
+        }
+
+        {
+            std::vector<entt::entity> materialEntities;
+            std::vector<uint64_t> materials;
+
+            auto view = registry.view<MaterialComponent>();
+            for (auto entity : view)
+            {
+                materialEntities.push_back(entity);
+                materials.push_back(view.get<MaterialComponent>(entity).material->GetUUID());
+            }
+
+            writer.WriteBlock(SceneBlockType::Material, static_cast<uint32_t>(materials.size()), sizeof(uint64_t), materialEntities.data(),
+                              materials.data(), materials.size() * sizeof(uint64_t));
+        }
+
+        writer.WriteRawBlock<LightComponent>(SceneBlockType::Light, registry);
+
+        {
+            auto view = registry.view<InactiveComponent>();
+            std::vector<entt::entity> inactiveEntities(view.begin(), view.end());
+            writer.WriteBlock(SceneBlockType::Inactive, static_cast<uint32_t>(inactiveEntities.size()), 0, inactiveEntities.data(), nullptr, 0);
+        }
+
+        const uint32_t entityRange = entities.empty() ? 0 : static_cast<uint32_t>(entt::to_entity(entities.back())) + 1;
+        const std::vector<uint8_t>& buffer = writer.Finish(static_cast<uint32_t>(entities.size()), entityRange);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+        if (!file)
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: Could not write {0}", path.string());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool SceneBinaryFormat::Load(const std::filesystem::path& path, Scene& scene)
+    {
+        ZoneScoped;
+
+        MappedFile file;
+        if (!file.Open(path))
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: Could not open {0}", path.string());
+            return false;
+        }
+
+        const uint8_t* data = file.GetData();
+        const size_t size = file.GetSize();
+
+        SceneFileHeader header;
+        if (size < sizeof(header))
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: {0} is truncated", path.string());
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.Magic, s_Magic, sizeof(s_Magic)) != 0 || header.Version != Version)
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: {0} is not a binary scene of version {1}", path.string(), Version);
+            return false;
+        }
+
+        if (sizeof(header) + static_cast<size_t>(header.BlockCount) * sizeof(SceneBlockHeader) > size)
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: {0} is truncated", path.string());
+            return false;
+        }
+
+        const SceneBlockHeader* blocks = reinterpret_cast<const SceneBlockHeader*>(data + sizeof(header));
+
+        // Every block must be inside the file and large enough for its entities and its raw components
+        for (uint32_t i = 0; i < header.BlockCount; i++)
+        {
+            const SceneBlockHeader& block = blocks[i];
+            bool hasEntities = block.Type != static_cast<uint32_t>(SceneBlockType::Entities) &&
+                               block.Type != static_cast<uint32_t>(SceneBlockType::StringTable);
+            size_t required = (hasEntities ? Align(block.Count * sizeof(entt::entity)) : 0) + static_cast<size_t>(block.Count) * block.ElementSize;
+
+            if (block.Offset % 16 != 0 || block.Offset > size || block.Size > size - block.Offset || required > block.Size)
+            {
+                COFFEE_CORE_ERROR("SceneBinaryFormat: {0} has an invalid block", path.string());
+                return false;
+            }
+        }
+
+        auto findBlock = [&](SceneBlockType type) -> const SceneBlockHeader* {
+            for (uint32_t i = 0; i < header.BlockCount; i++)
+            {
+                if (blocks[i].Type == static_cast<uint32_t>(type))
+                    return &blocks[i];
+            }
+            return nullptr;
+        };
+
+        const SceneBlockHeader* entityBlock = findBlock(SceneBlockType::Entities);
+        if (!entityBlock || entityBlock->ElementSize != sizeof(entt::entity) || entityBlock->Count != header.EntityCount ||
+            header.EntityRange > entt::to_entity(entt::entity{entt::null}))
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: {0} has no entities", path.string());
+            return false;
+        }
+
+        // Everything is checked before the registry is touched, so a rejected file leaves the scene empty.
+        // The handles of the file by entity index, the component blocks can only use these.
+        std::vector<entt::entity> known(header.EntityRange, entt::null);
+
+        const entt::entity* handles = reinterpret_cast<const entt::entity*>(data + entityBlock->Offset);
+        for (uint32_t i = 0; i < entityBlock->Count; i++)
+        {
+            const size_t index = entt::to_entity(handles[i]);
+            if (index >= known.size() || known[index] != entt::null || entt::to_version(handles[i]) == entt::to_version(entt::entity{entt::tombstone}))
+            {
+                COFFEE_CORE_ERROR("SceneBinaryFormat: {0} has a repeated or out of range entity", path.string());
+                return false;
+            }
+            known[index] = handles[i];
+        }
+
+        auto isKnown = [&](entt::entity entity) {
+            const size_t index = entt::to_entity(entity);
+            return index < known.size() && known[index] == entity;
+        };
+
+        // Returns the entities of a component block, or null if the block is missing, owned by unknown entities or
+        // has more than one component for an entity
+        std::vector<uint8_t> owned;
+        auto getEntities = [&](const SceneBlockHeader* block) -> const entt::entity* {
+            if (!block)
+                return nullptr;
+
+            owned.assign(known.size(), 0);
+
+            const entt::entity* entities = reinterpret_cast<const entt::entity*>(data + block->Offset);
+            for (uint32_t i = 0; i < block->Count; i++)
+            {
+                if (!isKnown(entities[i]) || owned[entt::to_entity(entities[i])]++)
+                {
+                    COFFEE_CORE_ERROR("SceneBinaryFormat: {0} has components of an unknown or repeated entity", path.string());
+                    return nullptr;
+                }
+            }
+            return entities;
+        };
+
+        auto getElements = [&](const SceneBlockHeader* block) {
+            return data + block->Offset + Align(block->Count * sizeof(entt::entity));
+        };
+
+        // The trivially copyable components are only read with the same layout as the build that wrote them
+        auto getRawEntities = [&]<typename T>(SceneBlockType type) -> const entt::entity* {
+            const SceneBlockHeader* block = findBlock(type);
+            if (!block)
+                return nullptr;
+
+            if (block->ElementSize != sizeof(T) || block->LayoutHash != GetLayoutHash<T>())
+            {
+                COFFEE_CORE_ERROR("SceneBinaryFormat: {0} was written with a different layout of the components, save it again from JSON", path.string());
+                return nullptr;
+            }
+            return getEntities(block);
+        };
+
+        const SceneBlockHeader* transformBlock = findBlock(SceneBlockType::Transform);
+        const SceneBlockHeader* hierarchyBlock = findBlock(SceneBlockType::Hierarchy);
+        const entt::entity* transformEntities = getRawEntities.template operator()<TransformComponent>(SceneBlockType::Transform);
+        const entt::entity* hierarchyEntities = getRawEntities.template operator()<HierarchyComponent>(SceneBlockType::Hierarchy);
+        if (!transformEntities || !hierarchyEntities)
+        {
+            COFFEE_CORE_ERROR("SceneBinaryFormat: {0} has no valid transforms or hierarchy", path.string());
+            return false;
+        }
+
+        // The links are inserted as they are, they must not point outside of the file
+        const HierarchyComponent* hierarchies = reinterpret_cast<const HierarchyComponent*>(getElements(hierarchyBlock));
+        for (uint32_t i = 0; i < hierarchyBlock->Count; i++)
+        {
+            const HierarchyComponent& hierarchy = hierarchies[i];
+            for (entt::entity link : {hierarchy.m_Parent, hierarchy.m_First, hierarchy.m_Last, hierarchy.m_Next, hierarchy.m_Prev})
+            {
+                if (link != entt::null && !isKnown(link))
+                {
+                    COFFEE_CORE_ERROR("SceneBinaryFormat: {0} has a hierarchy link to an unknown entity", path.string());
+                    return false;
+                }
+            }
+        }
+
+        entt::registry& registry = scene.m_Registry;
+
+        for (uint32_t i = 0; i < entityBlock->Count; i++)
+        {
+            registry.create(handles[i]);
+        }
+
+        // The optional raw components are skipped when they are invalid
+        auto insertRaw = [&]<typename T>(SceneBlockType type) {
+            if (const entt::entity* entities = getRawEntities.template operator()<T>(type))
+            {
+                const SceneBlockHeader* block = findBlock(type);
+                const T* components = reinterpret_cast<const T*>(getElements(block));
+                registry.insert<T>(entities, entities + block->Count, components);
+            }
+        };
+
+        const SceneBlockHeader* stringBlock = findBlock(SceneBlockType::StringTable);
+        const SceneBlockHeader* tagBlock = findBlock(SceneBlockType::Tag);
+        if (const entt::entity* entities = stringBlock ? getEntities(tagBlock) : nullptr; entities && tagBlock->ElementSize == sizeof(TagRecord))
+        {
+            const char* strings = reinterpret_cast<const char*>(data + stringBlock->Offset);
+            const TagRecord* records = reinterpret_cast<const TagRecord*>(getElements(tagBlock));
+
+            std::vector<TagComponent> tags;
+            tags.reserve(tagBlock->Count);
+            for (uint32_t i = 0; i < tagBlock->Count; i++)
+            {
+                const TagRecord& record = records[i];
+                bool inTable = record.Offset <= stringBlock->Count && record.Length <= stringBlock->Count - record.Offset;
+                tags.emplace_back(inTable ? std::string(strings + record.Offset, record.Length) : std::string("Entity"));
+            }
+
+            registry.insert<TagComponent>(entities, entities + tagBlock->Count, tags.begin());
+        }
+
+        registry.insert<TransformComponent>(transformEntities, transformEntities + transformBlock->Count,
+                                            reinterpret_cast<const TransformComponent*>(getElements(transformBlock)));
+
+        // The links are already complete, OnConstruct would append the children a second time
+        registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+        registry.insert<HierarchyComponent>(hierarchyEntities, hierarchyEntities + hierarchyBlock->Count, hierarchies);
+        registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+
+        const SceneBlockHeader* cameraBlock = findBlock(SceneBlockType::Camera);
+        if (const entt::entity* entities = getEntities(cameraBlock))
+        {
+            const uint8_t* cameras = getElements(cameraBlock);
+            MemoryStreamBuffer buffer(cameras, cameraBlock->Size - (cameras - (data + cameraBlock->Offset)));
+            std::istream stream(&buffer);
+
+            try
+            {
+                cereal::BinaryInputArchive archive(stream);
+                for (uint32_t i = 0; i < cameraBlock->Count; i++)
+                {
+                    CameraComponent camera;
+                    archive(camera);
+                    registry.emplace<CameraComponent>(entities[i], camera);
+                }
+            }
+            catch (const cereal::Exception& e)
+            {
+                COFFEE_CORE_ERROR("SceneBinaryFormat: Invalid cameras in {0}: {1}", path.string(), e.what());
+            }
+        }
+
+        // The inactive entities are tagged before the meshes are inserted, so they get no render proxy.
+        // The files written before the pools have no such block.
+        const SceneBlockHeader* inactiveBlock = findBlock(SceneBlockType::Inactive);
+        if (const entt::entity* entities = getEntities(inactiveBlock))
+        {
+            registry.insert<InactiveComponent>(entities, entities + inactiveBlock->Count);
+        }
+
+        // The materials go before the meshes, so the render proxies are created with their material
+        const SceneBlockHeader* materialBlock = findBlock(SceneBlockType::Material);
+        if (const entt::entity* entities = getEntities(materialBlock); entities && materialBlock->ElementSize == sizeof(uint64_t))
+        {
+            const uint64_t* records = reinterpret_cast<const uint64_t*>(getElements(materialBlock));
+
+            std::vector<MaterialComponent> materials;
+            materials.reserve(materialBlock->Count);
+            for (uint32_t i = 0; i < materialBlock->Count; i++)
+            {
+                materials.emplace_back(ResourceRegistry::Get<Material>(UUID(records[i])));
+            }
+
+            registry.insert<MaterialComponent>(entities, entities + materialBlock->Count, materials.begin());
+        }
+
+        const SceneBlockHeader* meshBlock = findBlock(SceneBlockType::Mesh);
+        if (const entt::entity* entities = getEntities(meshBlock); entities && meshBlock->ElementSize == sizeof(MeshRecord))
+        {
+            const MeshRecord* records = reinterpret_cast<const MeshRecord*>(getElements(meshBlock));
+
+            std::vector<MeshComponent> meshes;
+            meshes.reserve(meshBlock->Count);
+            for (uint32_t i = 0; i < meshBlock->Count; i++)
+            {
+                MeshComponent& meshComponent = meshes.emplace_back(ResourceRegistry::Get<Mesh>(UUID(records[i].Mesh)));
+                meshComponent.castShadows = records[i].CastShadows != 0;
+                meshComponent.isStatic = records[i].Static != 0;
+            }
+
+            registry.insert<MeshComponent>(entities, entities + meshBlock->Count, meshes.begin());
+        }
+
+        insertRaw.template operator()<LightComponent>(SceneBlockType::Light);
+
+        return true;
+    }
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <entt/entity/fwd.hpp>
+#include <filesystem>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    class Scene;
+
+    /**
+     * @brief Header at the start of a binary scene file.
+     */
+    struct SceneFileHeader
+    {
+        char Magic[8]; ///< "COFSCENE".
+        uint32_t Version;
+        uint32_t EntityCount;
+        uint32_t BlockCount; ///< Number of entries of the block table that follows the header.
+        uint32_t EntityRange; ///< One past the largest entity index, every handle of the file is below it.
+    };
+
+    /**
+     * @brief Entry of the block table of a binary scene file.
+     *
+     * A component block starts with the entities that own the components, followed by the components starting at the
+     * next multiple of 16 bytes. The blocks themselves start at a multiple of 16 bytes from the start of the file.
+     */
+    struct SceneBlockHeader
+    {
+        uint32_t Type; ///< The SceneBlockType of the block.
+        uint32_t Count; ///< Number of entities of the block, or of bytes for the string table.
+        uint32_t ElementSize; ///< Size of the components stored as raw bytes, 0 for the ones stored serialized.
+        uint32_t LayoutHash; ///< Hash of the member layout of the components stored as raw bytes, 0 for the other blocks.
+        uint64_t Offset; ///< Offset of the block from the start of the file.
+        uint64_t Size; ///< Size of the block in bytes.
+    };
+
+    enum class SceneBlockType : uint32_t
+    {
+        Entities = 0,
+        StringTable,
+        Tag,
+        Transform,
+        Hierarchy,
+        Camera,
+        Mesh,
+        Material,
+        Light,
+        Inactive ///< Entities only, InactiveComponent has no data.
+    };
+
+    /**
+     * @brief Binary scene files, the fast alternative to the JSON scenes.
+     *
+     * Every component type is stored in a contiguous block and the names of the entities in a string table. Loading
+     * maps the file in memory and inserts each block in the registry in one call, the components that are trivially
+     * copyable, like the transforms, are copied straight from the mapped file into their storage. The raw components
+     * depend on the memory layout of the build that wrote them, a file with a different layout is rejected and has to
+     * be saved again from its JSON version. The entities, transforms and hierarchy are required, a file where any of
+     * them is missing or invalid is not loaded at all.
+     */
+    class SceneBinaryFormat
+    {
+    public:
+        static constexpr uint32_t Version = 2;
+
+        /**
+         * @brief Checks if a file is a binary scene.
+         * @param path The path of the file.
+         * @return True if the file starts with the magic of the binary scenes.
+         */
+        static bool IsBinary(const std::filesystem::path& path);
+
+        /**
+         * @brief Writes the entities and components of a scene.
+         * @param path The path of the file.
+         * @param registry The registry of the scene, or a copy of it.
+         * @return True if the file was written.
+         */
+        static bool Save(const std::filesystem::path& path, const entt::registry& registry);
+
+        /**
+         * @brief Reads a binary scene into an empty scene.
+         * @param path The path of the file.
+         * @param scene The scene that receives the entities.
+         * @return True if the file was valid and read.
+         */
+        static bool Load(const std::filesystem::path& path, Scene& scene);
+    };
+
+    /** @} */
+}
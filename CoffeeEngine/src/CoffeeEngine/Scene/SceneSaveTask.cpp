@@ -0,0 +1,16 @@
+#include "CoffeeEngine/Scene/SceneSaveTask.h"
+
+namespace Coffee {
+
+    SceneSaveTask::~SceneSaveTask()
+    {
+        Wait();
+    }
+
+    void SceneSaveTask::Wait()
+    {
+        if (!m_Counter.IsDone())
+            JobSystem::Wait(m_Counter);
+    }
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "CoffeeEngine/Core/JobSystem.h"
+
+#include <atomic>
+#include <entt/entity/registry.hpp>
+#include <filesystem>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    /**
+     * @brief A scene being saved in the background, created by Scene::SaveAsync.
+     *
+     * The task owns a copy of the components taken when the save started, the scene can be edited while a worker
+     * thread writes the copy. The file is written next to its destination and renamed over it once it is complete,
+     * so a failed or interrupted save never leaves a truncated scene behind.
+     */
+    class SceneSaveTask
+    {
+    public:
+        SceneSaveTask(const std::filesystem::path& path) : m_Path(path) {}
+
+        /**
+         * @brief Waits for the worker, the snapshot it writes belongs to the task.
+         */
+        ~SceneSaveTask();
+
+        SceneSaveTask(const SceneSaveTask&) = delete;
+        SceneSaveTask& operator=(const SceneSaveTask&) = delete;
+
+        /**
+         * @brief Checks if the file was written or the save failed.
+         * @return True if the worker finished.
+         */
+        bool IsDone() const { return m_Counter.IsDone(); }
+
+        /**
+         * @brief Waits until the worker finishes.
+         */
+        void Wait();
+
+        /**
+         * @brief Gets the progress of the save.
+         * @return The written fraction of the scene, between 0 and 1.
+         */
+        float GetProgress() const { return m_Progress.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Checks the result of a finished save.
+         * @return True if the file was written, only valid once the task is done.
+         */
+        bool Succeeded() const { return m_Succeeded.load(std::memory_order_acquire); }
+
+        const std::filesystem::path& GetPath() const { return m_Path; }
+
+    private:
+        std::filesystem::path m_Path;
+        entt::registry m_Snapshot; ///< The copy of the components being written.
+        JobCounter m_Counter;
+        std::atomic<float> m_Progress = 0.0f;
+        std::atomic<bool> m_Succeeded = false;
+
+        friend class Scene;
+    };
+
+    /** @} */
+}
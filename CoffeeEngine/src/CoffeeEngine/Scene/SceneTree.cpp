@@ -1,9 +1,11 @@
 #include "SceneTree.h"
+#include "CoffeeEngine/Core/JobSystem.h"
 #include "CoffeeEngine/Core/Log.h"
 #include "CoffeeEngine/Scene/Components.h"
 #include "CoffeeEngine/Scene/Scene.h"
 #include "entt/entity/entity.hpp"
 #include "entt/entity/fwd.hpp"
+#include <algorithm>
 #include <tracy/Tracy.hpp>
 
 namespace Coffee {
@@ -12,6 +14,7 @@ namespace Coffee {
     {
         m_Parent = parent;
         m_First = entt::null;
+        m_Last = entt::null;
         m_Next = entt::null;
         m_Prev = entt::null;
     }
@@ -19,6 +22,7 @@ namespace Coffee {
     {
         m_Parent = entt::null;
         m_First = entt::null;
+        m_Last = entt::null;
         m_Next = entt::null;
         m_Prev = entt::null;
     }
@@ -29,80 +33,92 @@ namespace Coffee {
 
         if(hierarchy.m_Parent != entt::null)
         {
-            auto& parentHierarchy = registry.get<HierarchyComponent>(hierarchy.m_Parent);
+            AppendChild(registry, hierarchy.m_Parent, entity);
+        }
+    }
 
-            if(parentHierarchy.m_First == entt::null)
-            {
-                parentHierarchy.m_First = entity;
-            }
-            else
-            {
-                //Get the last child of the parent
-                auto lastEntity = parentHierarchy.m_First;
-                auto lastHierarchy = registry.try_get<HierarchyComponent>(lastEntity);
-                while(lastHierarchy != nullptr && lastHierarchy->m_Next != entt::null)
-                {
-                    auto nextEntity = lastHierarchy->m_Next;
-                    auto nextHierarchy = registry.try_get<HierarchyComponent>(nextEntity);
+    void HierarchyComponent::AppendChild(entt::registry& registry, entt::entity parent, entt::entity child)
+    {
+        auto& parentHierarchy = registry.get<HierarchyComponent>(parent);
+        auto& childHierarchy = registry.get<HierarchyComponent>(child);
 
-                    if(nextHierarchy == nullptr)
-                    {
-                        break;
-                    }
+        childHierarchy.m_Parent = parent;
+        childHierarchy.m_Prev = parentHierarchy.m_Last;
+        childHierarchy.m_Next = entt::null;
 
-                    lastEntity = nextEntity;
-                    lastHierarchy = nextHierarchy;
-                }
-                if (lastEntity == entity)
-                {
-                    return;
-                }
-                lastHierarchy->m_Next = entity;
-                lastHierarchy->m_Prev = lastEntity;
-            }
+        if(parentHierarchy.m_Last != entt::null)
+        {
+            registry.get<HierarchyComponent>(parentHierarchy.m_Last).m_Next = child;
         }
+        else
+        {
+            parentHierarchy.m_First = child;
+        }
+
+        parentHierarchy.m_Last = child;
+        parentHierarchy.m_ChildCount++;
     }
 
     void HierarchyComponent::OnDestroy(entt::registry& registry, entt::entity entity)
     {
         auto& hierarchy = registry.get<HierarchyComponent>(entity);
-        // if is the first child
-        if(hierarchy.m_Prev == entt::null || !registry.valid(hierarchy.m_Prev))
+
+        if(hierarchy.m_Parent == entt::null || !registry.valid(hierarchy.m_Parent))
         {
-            if(hierarchy.m_Parent != entt::null && registry.valid(hierarchy.m_Parent))
-            {
-                auto parent_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Parent);
-                if(parent_hierarchy != nullptr)
-                {
-                    parent_hierarchy->m_First = hierarchy.m_Next;
-                    if(hierarchy.m_Next != entt::null)
-                    {
-                        auto next_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Next);
-                        if(next_hierarchy != nullptr)
-                        {
-                            next_hierarchy->m_Prev = entt::null;
-                        }
-                    }
-                }
-            }
+            return;
+        }
+
+        auto parentHierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Parent);
+        if(parentHierarchy == nullptr)
+        {
+            return;
+        }
+
+        auto prevHierarchy = hierarchy.m_Prev != entt::null ? registry.try_get<HierarchyComponent>(hierarchy.m_Prev) : nullptr;
+        auto nextHierarchy = hierarchy.m_Next != entt::null ? registry.try_get<HierarchyComponent>(hierarchy.m_Next) : nullptr;
+
+        if(prevHierarchy != nullptr)
+        {
+            prevHierarchy->m_Next = hierarchy.m_Next;
         }
         else
         {
-            auto prev_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Prev);
-            if(prev_hierarchy != nullptr)
-            {
-                prev_hierarchy->m_Next = hierarchy.m_Next;
-            }
-            if(hierarchy.m_Next != entt::null)
+            parentHierarchy->m_First = hierarchy.m_Next;
+        }
+
+        if(nextHierarchy != nullptr)
+        {
+            nextHierarchy->m_Prev = hierarchy.m_Prev;
+        }
+        else
+        {
+            parentHierarchy->m_Last = hierarchy.m_Prev;
+        }
+
+        parentHierarchy->m_ChildCount--;
+    }
+
+    void HierarchyComponent::RebuildChildLinks(entt::registry& registry)
+    {
+        ZoneScoped;
+
+        auto view = registry.view<HierarchyComponent>();
+        for(auto entity : view)
+        {
+            auto& hierarchy = view.get<HierarchyComponent>(entity);
+            hierarchy.m_Last = entt::null;
+            hierarchy.m_ChildCount = 0;
+
+            entt::entity child = hierarchy.m_First;
+            while(child != entt::null)
             {
-                auto next_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Next);
-                if(next_hierarchy != nullptr)
-                {
-                    next_hierarchy->m_Prev = hierarchy.m_Prev;
-                }
+                hierarchy.m_Last = child;
+                hierarchy.m_ChildCount++;
+                child = registry.get<HierarchyComponent>(child).m_Next;
             }
         }
     }
+
     void HierarchyComponent::OnUpdate(entt::registry& registry, entt::entity entity)
     {
         
@@ -122,9 +138,24 @@ namespace Coffee {
 
         if(parent != entt::null)
         {
-            hierarchyComponent->m_Parent = parent;
-            HierarchyComponent::OnConstruct(registry, entity);
+            HierarchyComponent::AppendChild(registry, parent, entity);
+        }
+
+        // The world transform depends on the new parent
+        if(auto transformComponent = registry.try_get<TransformComponent>(entity))
+        {
+            transformComponent->MarkDirty();
         }
+
+        // Notifies the scene tree that the structure of the hierarchy changed
+        registry.patch<HierarchyComponent>(entity);
+    }
+
+    SceneTreeSettings SceneTree::s_Settings;
+
+    static void OnTransformUpdated(entt::registry& registry, entt::entity entity)
+    {
+        registry.get<TransformComponent>(entity).MarkDirty();
     }
 
     SceneTree::SceneTree(Scene* scene) : m_Context(scene)
@@ -133,51 +164,405 @@ namespace Coffee {
         registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
         registry.on_update<HierarchyComponent>().connect<&HierarchyComponent::OnUpdate>();
         registry.on_destroy<HierarchyComponent>().connect<&HierarchyComponent::OnDestroy>();
+
+        // Patching a transform marks it dirty, the same as writing it through its setters
+        registry.on_update<TransformComponent>().connect<&OnTransformUpdated>();
+
+        // The structural changes are applied to the flat hierarchy in the next update
+        registry.on_construct<HierarchyComponent>().connect<&SceneTree::OnNodeChanged>(*this);
+        registry.on_update<HierarchyComponent>().connect<&SceneTree::OnNodeChanged>(*this);
+        registry.on_destroy<HierarchyComponent>().connect<&SceneTree::OnNodeDestroyed>(*this);
+        registry.on_construct<TransformComponent>().connect<&SceneTree::OnNodeChanged>(*this);
+        registry.on_destroy<TransformComponent>().connect<&SceneTree::OnTransformDestroyed>(*this);
     }
 
-    void SceneTree::Update()
+    void SceneTree::OnNodeChanged(entt::registry& registry, entt::entity entity)
+    {
+        m_PendingNodes.push_back(entity);
+    }
+
+    void SceneTree::OnNodeDestroyed(entt::registry& registry, entt::entity entity)
+    {
+        const FlatLocation* location = FindNode(entity);
+        if(location == nullptr)
+        {
+            return;
+        }
+
+        // The node goes away now, its pointer is no longer valid in the next update
+        RemoveNode(*location);
+
+        // The children left without a parent node are removed in the next update
+        auto hierarchy = registry.try_get<HierarchyComponent>(entity);
+        if(hierarchy == nullptr)
+        {
+            m_HasOrphanedNodes = true;
+            return;
+        }
+
+        for(entt::entity child = hierarchy->m_First; child != entt::null;)
+        {
+            auto childHierarchy = registry.try_get<HierarchyComponent>(child);
+            if(childHierarchy == nullptr)
+            {
+                // The child is being destroyed with its parent, the rest of the links can't be followed
+                m_HasOrphanedNodes = true;
+                break;
+            }
+            m_PendingNodes.push_back(child);
+            child = childHierarchy->m_Next;
+        }
+    }
+
+    void SceneTree::OnTransformDestroyed(entt::registry& registry, entt::entity entity)
+    {
+        OnNodeDestroyed(registry, entity);
+
+        // The storage fills the slot of the destroyed transform with the last one, the node of that one follows it
+        const entt::sparse_set& storage = registry.storage<TransformComponent>();
+        const entt::entity last = storage.data()[storage.size() - 1];
+        if(last != entity)
+        {
+            if(const FlatLocation* location = FindNode(last))
+            {
+                m_Levels[location->Level].Transforms[location->Index] = &registry.get<TransformComponent>(entity);
+            }
+        }
+    }
+
+    const SceneTree::FlatLocation* SceneTree::FindNode(entt::entity entity) const
+    {
+        const size_t index = entt::to_entity(entity);
+        if(index >= m_Locations.size())
+        {
+            return nullptr;
+        }
+
+        const FlatLocation& location = m_Locations[index];
+        if(location.Level >= m_Levels.size() || location.Index >= m_Levels[location.Level].Nodes.size())
+        {
+            return nullptr;
+        }
+
+        // Removed nodes and reused entity indices don't match the entity of the node
+        return m_Levels[location.Level].Nodes[location.Index].Entity == entity ? &location : nullptr;
+    }
+
+    void SceneTree::RemoveNode(FlatLocation location)
+    {
+        FlatLevel& level = m_Levels[location.Level];
+        level.Nodes[location.Index].Entity = entt::null;
+        level.Transforms[location.Index] = nullptr;
+        level.Changed[location.Index] = false;
+
+        m_NodeCount--;
+        m_EditedNodes++;
+    }
+
+    void SceneTree::RemoveSubtree(entt::entity root)
     {
         auto& registry = m_Context->m_Registry;
-        auto view = registry.view<HierarchyComponent>();
-        for(auto entity : view)
+
+        const FlatLocation* location = FindNode(root);
+        if(location == nullptr)
         {
-            const auto hierarchy = registry.get<HierarchyComponent>(entity);
+            // The children of an entity outside of the flat hierarchy are not in it either
+            return;
+        }
+        RemoveNode(*location);
 
-            if(hierarchy.m_Parent == entt::null)
+        if(auto hierarchy = registry.try_get<HierarchyComponent>(root))
+        {
+            for(entt::entity child = hierarchy->m_First; child != entt::null; child = registry.get<HierarchyComponent>(child).m_Next)
             {
-                UpdateTransform(entity);
+                RemoveSubtree(child);
             }
         }
     }
 
-    void SceneTree::UpdateTransform(entt::entity entity)
+    void SceneTree::RemoveOrphanedNodes()
+    {
+        ZoneScoped;
+
+        for(uint32_t level = 1; level < m_Levels.size(); level++)
+        {
+            const FlatLevel& parentLevel = m_Levels[level - 1];
+            FlatLevel& currentLevel = m_Levels[level];
+
+            for(uint32_t i = 0; i < currentLevel.Nodes.size(); i++)
+            {
+                if(currentLevel.Transforms[i] != nullptr && parentLevel.Transforms[currentLevel.Nodes[i].Parent] == nullptr)
+                {
+                    RemoveNode({level, i});
+                }
+            }
+        }
+
+        m_HasOrphanedNodes = false;
+    }
+
+    void SceneTree::AppendSubtree(entt::entity root, uint32_t level, int32_t parent)
     {
         auto& registry = m_Context->m_Registry;
-        
-        auto& hierarchyComponent = registry.get<HierarchyComponent>(entity);
-        auto& transformComponent = registry.get<TransformComponent>(entity);
 
-        // Update the world transform of the entity
+        if(level >= m_Levels.size())
+        {
+            m_Levels.resize(level + 1);
+        }
+
+        FlatLevel& flatLevel = m_Levels[level];
+        const uint32_t index = static_cast<uint32_t>(flatLevel.Nodes.size());
+        flatLevel.Nodes.push_back({root, parent});
+        flatLevel.Transforms.push_back(&registry.get<TransformComponent>(root));
+        flatLevel.Changed.push_back(false);
 
-        if(hierarchyComponent.m_Parent != entt::null)
+        const size_t entityIndex = entt::to_entity(root);
+        if(entityIndex >= m_Locations.size())
         {
-            auto& parentTransformComponent = registry.get<TransformComponent>(hierarchyComponent.m_Parent);
+            m_Locations.resize(entityIndex + 1);
+        }
+        m_Locations[entityIndex] = {level, index};
+
+        m_NodeCount++;
+        m_EditedNodes++;
 
-            transformComponent.SetWorldTransform(parentTransformComponent.GetWorldTransform());
+        for(entt::entity child = registry.get<HierarchyComponent>(root).m_First; child != entt::null;
+            child = registry.get<HierarchyComponent>(child).m_Next)
+        {
+            if(registry.all_of<TransformComponent>(child))
+            {
+                AppendSubtree(child, level + 1, static_cast<int32_t>(index));
+            }
         }
-        else
+    }
+
+    void SceneTree::ApplyStructuralChanges()
+    {
+        ZoneScoped;
+
+        auto& registry = m_Context->m_Registry;
+
+        if(m_HasOrphanedNodes)
         {
-            transformComponent.SetWorldTransform(glm::mat4(1.0f));
+            RemoveOrphanedNodes();
         }
 
-        // Recursively update all the children
+        // Every changed subtree is taken out first, so the ones that moved are appended again under their new parent
+        for(entt::entity entity : m_PendingNodes)
+        {
+            if(registry.valid(entity))
+            {
+                RemoveSubtree(entity);
+            }
+        }
 
-        entt::entity child = hierarchyComponent.m_First;
-        while(child != entt::null)
+        for(entt::entity entity : m_PendingNodes)
         {
-            UpdateTransform(child);
-            child = registry.get<HierarchyComponent>(child).m_Next;
+            if(!registry.valid(entity) || !registry.all_of<TransformComponent, HierarchyComponent>(entity) || FindNode(entity) != nullptr)
+            {
+                continue;
+            }
+
+            const entt::entity parent = registry.get<HierarchyComponent>(entity).m_Parent;
+            if(parent == entt::null)
+            {
+                AppendSubtree(entity, 0, -1);
+            }
+            else if(const FlatLocation* parentLocation = FindNode(parent))
+            {
+                // Copied, appending may reallocate the locations
+                const FlatLocation location = *parentLocation;
+                AppendSubtree(entity, location.Level + 1, static_cast<int32_t>(location.Index));
+            }
+            // Otherwise the parent is not in the flat hierarchy, or it is pending and its subtree is appended with it
         }
+
+        m_PendingNodes.clear();
+    }
+
+    void SceneTree::Update()
+    {
+        ZoneScoped;
+
+        m_ChangedTransforms.clear();
+
+        // Too many changes at once are cheaper to apply with a rebuild
+        const float rebuildThreshold = s_Settings.RebuildThreshold * static_cast<float>(m_NodeCount);
+        if(!m_NeedsRebuild && (m_PendingNodes.size() > 0 || m_HasOrphanedNodes))
+        {
+            if(static_cast<float>(m_PendingNodes.size()) > rebuildThreshold)
+            {
+                m_NeedsRebuild = true;
+            }
+            else
+            {
+                ApplyStructuralChanges();
+            }
+        }
+
+        // Once the nodes added or removed in place pass the threshold the order in memory is restored
+        if(m_NeedsRebuild || static_cast<float>(m_EditedNodes) > rebuildThreshold)
+        {
+            RebuildFlatHierarchy();
+        }
+
+        uint32_t batchCount = s_Settings.ThreadCount > 0 ? s_Settings.ThreadCount : JobSystem::GetThreadCount() + 1;
+
+        for(uint32_t level = 0; level < m_Levels.size(); level++)
+        {
+            const uint32_t levelSize = static_cast<uint32_t>(m_Levels[level].Nodes.size());
+
+            if(s_Settings.ParallelUpdate && batchCount > 1 && levelSize >= s_Settings.MinParallelNodes)
+            {
+                uint32_t batchSize = (levelSize + batchCount - 1) / batchCount;
+                JobSystem::ParallelFor(levelSize, batchSize, [this, level](uint32_t begin, uint32_t end) {
+                    for(uint32_t i = begin; i < end; i++)
+                    {
+                        UpdateFlatNode(level, i);
+                    }
+                });
+            }
+            else
+            {
+                for(uint32_t i = 0; i < levelSize; i++)
+                {
+                    UpdateFlatNode(level, i);
+                }
+            }
+        }
+
+        // Gathered afterwards in the flat order so the list is the same in both modes
+        for(const FlatLevel& flatLevel : m_Levels)
+        {
+            for(size_t i = 0; i < flatLevel.Nodes.size(); i++)
+            {
+                if(flatLevel.Changed[i])
+                {
+                    m_ChangedTransforms.push_back(flatLevel.Nodes[i].Entity);
+                }
+            }
+        }
+    }
+
+    void SceneTree::UpdateFlatNode(uint32_t level, uint32_t index)
+    {
+        FlatLevel& flatLevel = m_Levels[level];
+        TransformComponent* transformComponent = flatLevel.Transforms[index];
+
+        // Removed nodes stay in place until the next rebuild
+        if(transformComponent == nullptr)
+        {
+            return;
+        }
+
+        const int32_t parent = flatLevel.Nodes[index].Parent;
+
+        // A node is only recomputed if it was edited or the world transform of its parent changed
+        if(!transformComponent->IsDirty() && (parent < 0 || !m_Levels[level - 1].Changed[parent]))
+        {
+            flatLevel.Changed[index] = false;
+            return;
+        }
+
+        const glm::mat4 previousWorldTransform = transformComponent->GetWorldTransform();
+
+        transformComponent->SetWorldTransform(parent < 0 ? glm::mat4(1.0f) : m_Levels[level - 1].Transforms[parent]->GetWorldTransform());
+
+        flatLevel.Changed[index] = transformComponent->GetWorldTransform() != previousWorldTransform;
+    }
+
+    void SceneTree::RebuildFlatHierarchy()
+    {
+        ZoneScoped;
+
+        auto& registry = m_Context->m_Registry;
+
+        for(FlatLevel& flatLevel : m_Levels)
+        {
+            flatLevel.Nodes.clear();
+        }
+
+        uint32_t levelCount = 0;
+        auto addNode = [this, &levelCount](uint32_t level, entt::entity entity, int32_t parent) {
+            if(level >= m_Levels.size())
+            {
+                m_Levels.resize(level + 1);
+            }
+            levelCount = std::max(levelCount, level + 1);
+            m_Levels[level].Nodes.push_back({entity, parent});
+        };
+
+        auto view = registry.view<TransformComponent, HierarchyComponent>();
+        for(auto entity : view)
+        {
+            if(view.get<HierarchyComponent>(entity).m_Parent == entt::null)
+            {
+                addNode(0, entity, -1);
+            }
+        }
+
+        // Breadth first: every level is built from the previous one
+        for(uint32_t level = 0; level < levelCount; level++)
+        {
+            for(size_t i = 0; i < m_Levels[level].Nodes.size(); i++)
+            {
+                entt::entity child = registry.get<HierarchyComponent>(m_Levels[level].Nodes[i].Entity).m_First;
+                while(child != entt::null)
+                {
+                    if(registry.all_of<TransformComponent>(child))
+                    {
+                        addNode(level + 1, child, static_cast<int32_t>(i));
+                    }
+                    child = registry.get<HierarchyComponent>(child).m_Next;
+                }
+            }
+        }
+        m_Levels.resize(levelCount);
+
+        // Sort the transform storage in the same order so the update walks the components forward in memory
+        std::vector<uint32_t> order;
+        uint32_t nodeCount = 0;
+        m_Locations.clear();
+        for(uint32_t level = 0; level < levelCount; level++)
+        {
+            const std::vector<FlatNode>& nodes = m_Levels[level].Nodes;
+            for(uint32_t i = 0; i < nodes.size(); i++)
+            {
+                size_t index = entt::to_entity(nodes[i].Entity);
+                if(index >= order.size())
+                {
+                    order.resize(index + 1, UINT32_MAX);
+                    m_Locations.resize(index + 1);
+                }
+                order[index] = nodeCount++;
+                m_Locations[index] = {level, i};
+            }
+        }
+
+        registry.sort<TransformComponent>([&order](const entt::entity lhs, const entt::entity rhs) {
+            size_t lhsIndex = entt::to_entity(lhs);
+            size_t rhsIndex = entt::to_entity(rhs);
+            uint32_t lhsOrder = lhsIndex < order.size() ? order[lhsIndex] : UINT32_MAX;
+            uint32_t rhsOrder = rhsIndex < order.size() ? order[rhsIndex] : UINT32_MAX;
+            return lhsOrder < rhsOrder;
+        });
+
+        // The components moved during the sort, the pointers are taken afterwards
+        for(FlatLevel& flatLevel : m_Levels)
+        {
+            flatLevel.Transforms.resize(flatLevel.Nodes.size());
+            for(size_t i = 0; i < flatLevel.Nodes.size(); i++)
+            {
+                flatLevel.Transforms[i] = &registry.get<TransformComponent>(flatLevel.Nodes[i].Entity);
+            }
+            flatLevel.Changed.assign(flatLevel.Nodes.size(), false);
+        }
+
+        m_PendingNodes.clear();
+        m_NodeCount = nodeCount;
+        m_EditedNodes = 0;
+        m_HasOrphanedNodes = false;
+        m_NeedsRebuild = false;
     }
 
-}
\ No newline at end of file
+}
@@ -3,11 +3,16 @@
 #include "CoffeeEngine/Core/Base.h"
 #include "entt/entity/fwd.hpp"
 #include <cereal/cereal.hpp>
+#include <cstdint>
 #include <entt/entt.hpp>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
 
 namespace Coffee {
 
     class Scene;
+    struct TransformComponent;
 
     /**
      * @defgroup scene Scene
@@ -38,6 +43,14 @@ namespace Coffee {
          */
         static void OnConstruct(entt::registry& registry, entt::entity entity);
 
+        /**
+         * @brief Appends a child at the end of the children of a parent in constant time.
+         * @param registry The entity registry.
+         * @param parent The parent entity.
+         * @param child The child entity, it must not be linked to another parent.
+         */
+        static void AppendChild(entt::registry& registry, entt::entity parent, entt::entity child);
+
         /**
          * @brief Called when the component is destroyed.
          * @param registry The entity registry.
@@ -60,10 +73,18 @@ namespace Coffee {
          */
         static void Reparent(entt::registry& registry, entt::entity entity, entt::entity parent);
 
+        /**
+         * @brief Recompute the last child and the child count of every entity from the serialized links.
+         * @param registry The entity registry.
+         */
+        static void RebuildChildLinks(entt::registry& registry);
+
         entt::entity m_Parent;
         entt::entity m_First;
+        entt::entity m_Last; ///< The last child, new children are appended after it. Not serialized, rebuilt on load.
         entt::entity m_Next;
         entt::entity m_Prev;
+        uint32_t m_ChildCount = 0; ///< The number of children. Not serialized, rebuilt on load.
 
         /**
          * @brief Serialize the component.
@@ -87,6 +108,29 @@ namespace Coffee {
         }
     };
 
+    /**
+     * @brief Description of an entity created by Scene::CreateEntities.
+     * @ingroup scene
+     */
+    struct HierarchyNodeDescription
+    {
+        std::string Name; ///< The name of the entity.
+        glm::mat4 LocalTransform = glm::mat4(1.0f); ///< The local transform of the entity.
+        int32_t Parent = -1; ///< Index of the parent description, it must come before this one. -1 attaches the entity to the parent of the subtree.
+    };
+
+    /**
+     * @brief Structure containing the scene tree settings.
+     * @ingroup scene
+     */
+    struct SceneTreeSettings
+    {
+        bool ParallelUpdate = true; ///< Update the nodes of each depth level in parallel, disable it to debug the update in one thread.
+        uint32_t ThreadCount = 0; ///< Maximum number of threads used by the parallel update, 0 uses every thread of the job system.
+        uint32_t MinParallelNodes = 2048; ///< Depth levels with fewer nodes are updated in the calling thread.
+        float RebuildThreshold = 0.25f; ///< Fraction of the nodes that can be added or removed in place before the flat hierarchy is rebuilt and the transform storage sorted again.
+    };
+
     /**
      * @brief Class for managing the scene tree.
      * @ingroup scene
@@ -106,18 +150,125 @@ namespace Coffee {
         ~SceneTree() = default;
 
         /**
-         * @brief Update the scene tree.
+         * @brief Update the world transforms of the dirty entities and their children, the clean subtrees are skipped.
+         *
+         * The hierarchy is walked as flat arrays, one per depth level, so every parent is computed before its children
+         * in a single linear pass. The nodes of a depth level only depend on the previous levels, so large levels are
+         * split between the job system threads. The result is the same with the parallel update disabled.
+         *
+         * The structural changes are applied in place: the removed subtrees leave empty nodes and the added ones are
+         * appended to their levels. Once too many nodes were added or removed, the levels are rebuilt in breadth first
+         * order and the transform storage is sorted to match, so the update walks the components forward in memory again.
          */
         void Update();
 
         /**
-         * @brief Update the transform of an entity.
-         * @param entity The entity to update.
+         * @brief Get the entities whose world transform changed in the last update.
+         * @return The entities with a new world transform.
          */
-        void UpdateTransform(entt::entity entity);
+        const std::vector<entt::entity>& GetChangedTransforms() const { return m_ChangedTransforms; }
+
+        /**
+         * @brief Get the scene tree settings shared by all the scenes.
+         * @return A reference to the scene tree settings.
+         */
+        static SceneTreeSettings& GetSettings() { return s_Settings; }
+
+    private:
+        /**
+         * @brief Node of the flattened hierarchy.
+         */
+        struct FlatNode
+        {
+            entt::entity Entity; ///< The entity of the node, null for the nodes removed since the last rebuild.
+            int32_t Parent; ///< Index of the parent node in the previous level, -1 for the roots.
+        };
+
+        /**
+         * @brief The nodes of a depth level of the flattened hierarchy.
+         */
+        struct FlatLevel
+        {
+            std::vector<FlatNode> Nodes;
+            std::vector<TransformComponent*> Transforms; ///< Transform of each node, null for the removed nodes.
+            std::vector<uint8_t> Changed; ///< Whether the world transform of each node changed in the last update.
+        };
+
+        /**
+         * @brief Position of a node in the flattened hierarchy.
+         */
+        struct FlatLocation
+        {
+            uint32_t Level = UINT32_MAX;
+            uint32_t Index = 0;
+        };
+
+        /**
+         * @brief Rebuild the flat hierarchy and sort the transform storage to match it.
+         */
+        void RebuildFlatHierarchy();
+
+        /**
+         * @brief Apply the structural changes recorded since the last update to the flat hierarchy in place.
+         */
+        void ApplyStructuralChanges();
+
+        /**
+         * @brief Append the nodes of a subtree to the levels below the node of its parent.
+         * @param root The root of the subtree.
+         * @param level The depth level of the root.
+         * @param parent Index of the node of the parent in the previous level, -1 for a root.
+         */
+        void AppendSubtree(entt::entity root, uint32_t level, int32_t parent);
+
+        /**
+         * @brief Remove the nodes of an entity and its children from the flat hierarchy.
+         * @param root The root of the subtree.
+         */
+        void RemoveSubtree(entt::entity root);
+
+        /**
+         * @brief Remove a node, the nodes of its children are left as they are.
+         * @param location The location of the node.
+         */
+        void RemoveNode(FlatLocation location);
+
+        /**
+         * @brief Remove the nodes whose parent node was removed.
+         */
+        void RemoveOrphanedNodes();
+
+        /**
+         * @brief Find the node of an entity.
+         * @param entity The entity.
+         * @return The location of the node, or nullptr if the entity is not in the flat hierarchy.
+         */
+        const FlatLocation* FindNode(entt::entity entity) const;
+
+        /**
+         * @brief Recompute the world transform of a node of the flat hierarchy if it or its parent changed.
+         * @param level The depth level of the node.
+         * @param index The index of the node in its level.
+         */
+        void UpdateFlatNode(uint32_t level, uint32_t index);
+
+        void OnNodeChanged(entt::registry& registry, entt::entity entity);
+        void OnNodeDestroyed(entt::registry& registry, entt::entity entity);
+        void OnTransformDestroyed(entt::registry& registry, entt::entity entity);
 
     private:
         Scene* m_Context;
+        std::vector<entt::entity> m_ChangedTransforms;
+
+        std::vector<FlatLevel> m_Levels; ///< The nodes of each depth level, the parent of a node is always in the previous level.
+        std::vector<FlatLocation> m_Locations; ///< The node of each entity, by entity index.
+        std::vector<entt::entity> m_PendingNodes; ///< Entities created, reparented or orphaned since the last update.
+        uint32_t m_NodeCount = 0; ///< Number of nodes that are not removed.
+        uint32_t m_EditedNodes = 0; ///< Number of nodes added or removed in place since the last rebuild.
+        bool m_HasOrphanedNodes = false; ///< Whether a removed node may have children left in the flat hierarchy.
+        bool m_NeedsRebuild = true;
+
+        static SceneTreeSettings s_Settings;
     };
 
     /** @} */ // end of scene group
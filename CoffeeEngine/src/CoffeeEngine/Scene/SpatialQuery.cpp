@@ -0,0 +1,212 @@
+#include "CoffeeEngine/Scene/SpatialQuery.h"
+
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    OrientedBox::OrientedBox(const OBB& obb)
+    {
+        // The corners follow the order of the OBB constructor, 1, 3 and 4 are the neighbours of 0 along each axis
+        const glm::vec3 edges[3] = {obb.corners[1] - obb.corners[0], obb.corners[3] - obb.corners[0], obb.corners[4] - obb.corners[0]};
+
+        Center = (obb.corners[0] + obb.corners[6]) * 0.5f;
+        for (int i = 0; i < 3; i++)
+        {
+            float length = glm::length(edges[i]);
+            HalfExtents[i] = length * 0.5f;
+            if (length > 0.0f)
+                Axes[i] = edges[i] / length;
+        }
+
+        Bounds = AABB(obb.corners[0], obb.corners[0]);
+        for (const glm::vec3& corner : obb.corners)
+        {
+            Bounds.min = glm::min(Bounds.min, corner);
+            Bounds.max = glm::max(Bounds.max, corner);
+        }
+    }
+
+    bool OrientedBox::Overlaps(const AABB& aabb) const
+    {
+        const glm::vec3 a = aabb.GetHalfSize();
+        const glm::vec3& b = HalfExtents;
+        const glm::vec3 t = Center - aabb.GetCenter();
+
+        // Rotation from the axes of the oriented box to the world axes, the epsilon keeps the parallel edges from
+        // producing a null cross product that would separate everything
+        float R[3][3], absR[3][3];
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                R[i][j] = Axes[j][i];
+                absR[i][j] = glm::abs(R[i][j]) + 1e-6f;
+            }
+        }
+
+        // The axes of the AABB
+        for (int i = 0; i < 3; i++)
+        {
+            float rb = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+            if (glm::abs(t[i]) > a[i] + rb)
+                return false;
+        }
+
+        // The axes of the oriented box
+        for (int j = 0; j < 3; j++)
+        {
+            float ra = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+            float distance = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+            if (glm::abs(distance) > ra + b[j])
+                return false;
+        }
+
+        // The cross products of the axes of both boxes
+        for (int i = 0; i < 3; i++)
+        {
+            int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            for (int j = 0; j < 3; j++)
+            {
+                int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+                float ra = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+                float rb = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+                float distance = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+                if (glm::abs(distance) > ra + rb)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Inserts a hit in a buffer sorted by distance, dropping the farthest one when the buffer is full
+    static uint32_t InsertSorted(std::span<SpatialHit> hits, uint32_t count, const SpatialHit& hit)
+    {
+        if (count == hits.size())
+        {
+            if (hit.Distance >= hits[count - 1].Distance)
+                return count;
+            count--;
+        }
+
+        uint32_t i = count;
+        while (i > 0 && hits[i - 1].Distance > hit.Distance)
+        {
+            hits[i] = hits[i - 1];
+            i--;
+        }
+        hits[i] = hit;
+
+        return count + 1;
+    }
+
+    SpatialQuery::SpatialQuery(Scene* scene) : m_Scene(scene), m_World(&scene->GetRenderWorld())
+    {
+    }
+
+    uint32_t SpatialQuery::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::span<SpatialHit> outHits) const
+    {
+        ZoneScoped;
+
+        if (outHits.empty() || glm::dot(direction, direction) == 0.0f)
+            return 0;
+
+        const glm::vec3 normalizedDirection = glm::normalize(direction);
+        const glm::vec3 inverseDirection = 1.0f / normalizedDirection;
+
+        uint32_t count = 0;
+        m_World->GetSpatialIndex().RayCast(origin, normalizedDirection, maxDistance, [&](uint32_t id, float) {
+            AABB bounds;
+            float distance;
+            if (m_World->GetProxyBounds(id, bounds) && bounds.IntersectRay(origin, inverseDirection, maxDistance, distance))
+            {
+                count = InsertSorted(outHits, count, SpatialHit{GetEntity(id), distance, origin + normalizedDirection * distance});
+            }
+
+            // Once the buffer is full the ray is shortened to its farthest hit, the nodes behind it are skipped
+            return count == outHits.size() ? outHits[count - 1].Distance : maxDistance;
+        });
+
+        return count;
+    }
+
+    uint32_t SpatialQuery::OverlapBox(const AABB& box, std::span<Entity> outEntities) const
+    {
+        ZoneScoped;
+
+        uint32_t count = 0;
+        if (!outEntities.empty())
+        {
+            OverlapBox(box, [&](Entity entity) {
+                outEntities[count++] = entity;
+                return count < outEntities.size();
+            });
+        }
+        return count;
+    }
+
+    uint32_t SpatialQuery::OverlapBox(const OBB& box, std::span<Entity> outEntities) const
+    {
+        ZoneScoped;
+
+        uint32_t count = 0;
+        if (!outEntities.empty())
+        {
+            OverlapBox(box, [&](Entity entity) {
+                outEntities[count++] = entity;
+                return count < outEntities.size();
+            });
+        }
+        return count;
+    }
+
+    uint32_t SpatialQuery::OverlapSphere(const glm::vec3& center, float radius, std::span<Entity> outEntities) const
+    {
+        ZoneScoped;
+
+        uint32_t count = 0;
+        if (!outEntities.empty())
+        {
+            OverlapSphere(center, radius, [&](Entity entity) {
+                outEntities[count++] = entity;
+                return count < outEntities.size();
+            });
+        }
+        return count;
+    }
+
+    uint32_t SpatialQuery::Nearest(const glm::vec3& point, std::span<SpatialHit> outHits, float maxDistance) const
+    {
+        ZoneScoped;
+
+        if (outHits.empty())
+            return 0;
+
+        const float maxDistanceSquared = maxDistance * maxDistance;
+
+        uint32_t count = 0;
+        m_World->GetSpatialIndex().Nearest(point, maxDistanceSquared, [&](uint32_t id, float) {
+            AABB bounds;
+            if (m_World->GetProxyBounds(id, bounds))
+            {
+                float distanceSquared = bounds.DistanceSquared(point);
+                if (distanceSquared <= maxDistanceSquared)
+                {
+                    count = InsertSorted(outHits, count, SpatialHit{GetEntity(id), glm::sqrt(distanceSquared), bounds.ClosestPoint(point)});
+                }
+            }
+
+            // Once k entities are found the search radius shrinks to the farthest of them
+            if (count == outHits.size())
+            {
+                float farthest = outHits[count - 1].Distance;
+                return farthest * farthest;
+            }
+            return maxDistanceSquared;
+        });
+
+        return count;
+    }
+
+}
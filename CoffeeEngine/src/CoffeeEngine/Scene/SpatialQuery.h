@@ -0,0 +1,216 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Renderer/RenderWorld.h"
+#include "CoffeeEngine/Scene/Entity.h"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    /**
+     * @brief Entity found by a ray cast or a nearest query.
+     */
+    struct SpatialHit
+    {
+        Entity HitEntity; ///< The entity.
+        float Distance = 0.0f; ///< Distance from the origin of the ray, or from the query point, to the bounds of the entity.
+        glm::vec3 Point = glm::vec3(0.0f); ///< Where the ray enters the bounds, or the point of the bounds closest to the query point.
+    };
+
+    /**
+     * @brief Oriented box stored as a center, three axes and the half extents along them, for the separating axis test.
+     */
+    struct OrientedBox
+    {
+        glm::vec3 Center = glm::vec3(0.0f);
+        glm::vec3 Axes[3] = {glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)};
+        glm::vec3 HalfExtents = glm::vec3(0.0f);
+        AABB Bounds; ///< The world AABB that encloses the box.
+
+        OrientedBox() = default;
+
+        /**
+         * @brief Constructs an oriented box from the corners of an OBB.
+         * @param obb The OBB.
+         */
+        OrientedBox(const OBB& obb);
+
+        /**
+         * @brief Checks if the box overlaps an AABB.
+         * @param aabb The AABB.
+         * @return True if no axis separates the boxes.
+         */
+        bool Overlaps(const AABB& aabb) const;
+    };
+
+    /**
+     * @brief Ray casts, overlap tests and nearest queries over the spatial index of a scene.
+     *
+     * The queries walk the bounding volume hierarchy of the render world and test the exact world bounds of the
+     * entities it returns, so they only find the entities with a mesh. Every query has a callback form and a form that
+     * fills a buffer of fixed capacity, none of them allocates.
+     */
+    class SpatialQuery
+    {
+    public:
+        /**
+         * @brief Constructor for SpatialQuery.
+         * @param scene The scene to query.
+         */
+        SpatialQuery(Scene* scene);
+
+        /**
+         * @brief Visits the entities hit by a ray, in no particular order.
+         * @param origin The origin of the ray.
+         * @param direction The direction of the ray, it does not need to be normalized.
+         * @param maxDistance The length of the ray.
+         * @param callback Called with every hit, returning false stops the cast.
+         */
+        template<typename Callback>
+        void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback&& callback) const
+        {
+            if (glm::dot(direction, direction) == 0.0f)
+                return;
+
+            const glm::vec3 normalizedDirection = glm::normalize(direction);
+            const glm::vec3 inverseDirection = 1.0f / normalizedDirection;
+
+            m_World->GetSpatialIndex().RayCast(origin, normalizedDirection, maxDistance, [&](uint32_t id, float) {
+                AABB bounds;
+                float distance;
+                if (m_World->GetProxyBounds(id, bounds) && bounds.IntersectRay(origin, inverseDirection, maxDistance, distance))
+                {
+                    if (!callback(SpatialHit{GetEntity(id), distance, origin + normalizedDirection * distance}))
+                        return -1.0f;
+                }
+                return maxDistance;
+            });
+        }
+
+        /**
+         * @brief Gathers the entities nearest to the origin hit by a ray.
+         * @param origin The origin of the ray.
+         * @param direction The direction of the ray, it does not need to be normalized.
+         * @param maxDistance The length of the ray.
+         * @param outHits The hits sorted by distance, at most as many as the size of the buffer.
+         * @return The number of hits written.
+         */
+        uint32_t RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::span<SpatialHit> outHits) const;
+
+        /**
+         * @brief Gathers the entities nearest to the start hit by a segment.
+         * @param start The start of the segment.
+         * @param end The end of the segment.
+         * @param outHits The hits sorted by distance from the start, at most as many as the size of the buffer.
+         * @return The number of hits written.
+         */
+        uint32_t SegmentCast(const glm::vec3& start, const glm::vec3& end, std::span<SpatialHit> outHits) const
+        {
+            return RayCast(start, end - start, glm::length(end - start), outHits);
+        }
+
+        /**
+         * @brief Visits the entities that overlap a box.
+         * @param box The world space box.
+         * @param callback Called with every entity, returning false stops the query.
+         */
+        template<typename Callback>
+        void OverlapBox(const AABB& box, Callback&& callback) const
+        {
+            auto test = [&](const AABB& bounds) { return bounds.Intersect(box) != IntersectionType::Outside; };
+            Overlap(test, test, callback);
+        }
+
+        /**
+         * @brief Visits the entities that overlap an oriented box.
+         * @param box The world space box.
+         * @param callback Called with every entity, returning false stops the query.
+         */
+        template<typename Callback>
+        void OverlapBox(const OBB& box, Callback&& callback) const
+        {
+            // The nodes are tested against the AABB of the box, the separating axis test is left for the entities
+            OrientedBox orientedBox(box);
+            Overlap([&](const AABB& bounds) { return bounds.Intersect(orientedBox.Bounds) != IntersectionType::Outside; },
+                    [&](const AABB& bounds) { return orientedBox.Overlaps(bounds); },
+                    callback);
+        }
+
+        /**
+         * @brief Visits the entities that overlap a sphere.
+         * @param center The center of the sphere.
+         * @param radius The radius of the sphere.
+         * @param callback Called with every entity, returning false stops the query.
+         */
+        template<typename Callback>
+        void OverlapSphere(const glm::vec3& center, float radius, Callback&& callback) const
+        {
+            auto test = [&](const AABB& bounds) { return bounds.DistanceSquared(center) <= radius * radius; };
+            Overlap(test, test, callback);
+        }
+
+        /**
+         * @brief Gathers the entities that overlap a box.
+         * @param box The world space box.
+         * @param outEntities The entities in no particular order, at most as many as the size of the buffer.
+         * @return The number of entities written.
+         */
+        uint32_t OverlapBox(const AABB& box, std::span<Entity> outEntities) const;
+
+        /**
+         * @brief Gathers the entities that overlap an oriented box.
+         * @param box The world space box.
+         * @param outEntities The entities in no particular order, at most as many as the size of the buffer.
+         * @return The number of entities written.
+         */
+        uint32_t OverlapBox(const OBB& box, std::span<Entity> outEntities) const;
+
+        /**
+         * @brief Gathers the entities that overlap a sphere.
+         * @param center The center of the sphere.
+         * @param radius The radius of the sphere.
+         * @param outEntities The entities in no particular order, at most as many as the size of the buffer.
+         * @return The number of entities written.
+         */
+        uint32_t OverlapSphere(const glm::vec3& center, float radius, std::span<Entity> outEntities) const;
+
+        /**
+         * @brief Gathers the k entities nearest to a point, k being the size of the buffer.
+         * @param point The point.
+         * @param outHits The entities sorted by the distance from the point to their bounds.
+         * @param maxDistance The search radius.
+         * @return The number of entities written.
+         */
+        uint32_t Nearest(const glm::vec3& point, std::span<SpatialHit> outHits,
+                         float maxDistance = std::numeric_limits<float>::max()) const;
+
+    private:
+        Entity GetEntity(uint32_t id) const { return Entity{static_cast<entt::entity>(id), m_Scene}; }
+
+        template<typename NodeTest, typename EntityTest, typename Callback>
+        void Overlap(NodeTest&& nodeTest, EntityTest&& entityTest, Callback&& callback) const
+        {
+            m_World->GetSpatialIndex().Traverse(nodeTest, [&](uint32_t id) {
+                AABB bounds;
+                if (!m_World->GetProxyBounds(id, bounds) || !entityTest(bounds))
+                    return true;
+
+                return static_cast<bool>(callback(GetEntity(id)));
+            });
+        }
+
+    private:
+        Scene* m_Scene;
+        const RenderWorld* m_World;
+    };
+
+    /** @} */
+}
@@ -0,0 +1,139 @@
+#include "CoffeeEngine/Scene/SystemScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    void SystemScheduler::AddSystem(const std::string& name, std::function<void(float)> function, std::vector<entt::id_type> readTypes,
+                                    std::vector<entt::id_type> writeTypes, SystemFlags flags)
+    {
+        ScheduledSystem& system = m_Systems.emplace_back();
+        system.Name = name;
+        system.Function = std::move(function);
+        system.ReadTypes = std::move(readTypes);
+        system.WriteTypes = std::move(writeTypes);
+        system.Flags = flags;
+
+        m_Dirty = true;
+    }
+
+    bool SystemScheduler::RemoveSystem(const std::string& name)
+    {
+        auto it = std::find_if(m_Systems.begin(), m_Systems.end(), [&name](const ScheduledSystem& system) { return system.Name == name; });
+        if (it == m_Systems.end())
+            return false;
+
+        m_Systems.erase(it);
+        m_Dirty = true;
+        return true;
+    }
+
+    bool SystemScheduler::Conflicts(const ScheduledSystem& a, const ScheduledSystem& b)
+    {
+        if ((a.Flags & SystemFlags::Exclusive) || (b.Flags & SystemFlags::Exclusive))
+            return true;
+
+        auto contains = [](const std::vector<entt::id_type>& types, entt::id_type type) {
+            return std::find(types.begin(), types.end(), type) != types.end();
+        };
+
+        for (entt::id_type type : a.WriteTypes)
+        {
+            if (contains(b.ReadTypes, type) || contains(b.WriteTypes, type))
+                return true;
+        }
+
+        for (entt::id_type type : b.WriteTypes)
+        {
+            if (contains(a.ReadTypes, type))
+                return true;
+        }
+
+        return false;
+    }
+
+    void SystemScheduler::BuildGraph()
+    {
+        ZoneScoped;
+
+        m_Levels.clear();
+
+        for (uint32_t i = 0; i < m_Systems.size(); i++)
+        {
+            ScheduledSystem& system = m_Systems[i];
+            system.Dependencies.clear();
+            system.Level = 0;
+
+            // A system waits for the earlier systems it conflicts with, the registration order decides who goes first
+            for (uint32_t j = 0; j < i; j++)
+            {
+                if (Conflicts(m_Systems[j], system))
+                {
+                    system.Dependencies.push_back(j);
+                    system.Level = std::max(system.Level, m_Systems[j].Level + 1);
+                }
+            }
+
+            if (system.Level >= m_Levels.size())
+                m_Levels.resize(system.Level + 1);
+
+            m_Levels[system.Level].push_back(i);
+        }
+
+        m_Dirty = false;
+    }
+
+    void SystemScheduler::RunSystem(ScheduledSystem& system, float dt)
+    {
+        ZoneScoped;
+        ZoneName(system.Name.c_str(), system.Name.size());
+
+        auto start = std::chrono::high_resolution_clock::now();
+        system.Function(dt);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        system.LastTime = std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+    void SystemScheduler::Run(float dt)
+    {
+        ZoneScoped;
+
+        if (m_Dirty)
+            BuildGraph();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (const std::vector<uint32_t>& level : m_Levels)
+        {
+            // A level with one system runs in this thread, sending it to a worker would only add latency
+            if (level.size() == 1)
+            {
+                RunSystem(m_Systems[level[0]], dt);
+                continue;
+            }
+
+            JobCounter counter;
+            for (uint32_t index : level)
+            {
+                ScheduledSystem* system = &m_Systems[index];
+                if (!(system->Flags & SystemFlags::MainThread))
+                    JobSystem::Submit([this, system, dt]() { RunSystem(*system, dt); }, &counter);
+            }
+
+            for (uint32_t index : level)
+            {
+                if (m_Systems[index].Flags & SystemFlags::MainThread)
+                    RunSystem(m_Systems[index], dt);
+            }
+
+            JobSystem::Wait(counter);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        m_LastTime = std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "CoffeeEngine/Core/JobSystem.h"
+
+#include <cstdint>
+#include <entt/core/type_info.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    /**
+     * @brief List of the types a system reads, for SystemScheduler::AddSystem.
+     */
+    template<typename... Types>
+    struct Reads
+    {
+    };
+
+    /**
+     * @brief List of the types a system writes, for SystemScheduler::AddSystem.
+     */
+    template<typename... Types>
+    struct Writes
+    {
+    };
+
+    /**
+     * @brief Per system options.
+     */
+    enum class SystemFlags : uint32_t
+    {
+        None = 0,
+        MainThread = 1 << 0, ///< Runs in the thread that runs the scheduler, for the systems that use the render context or the scripts.
+        Exclusive = 1 << 1 ///< Conflicts with every other system, for the systems that can touch anything.
+    };
+
+    inline SystemFlags operator|(SystemFlags a, SystemFlags b) { return static_cast<SystemFlags>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); }
+    inline bool operator&(SystemFlags a, SystemFlags b) { return (static_cast<uint32_t>(a) & static_cast<uint32_t>(b)) != 0; }
+
+    /**
+     * @brief A system registered in a scheduler, with the data of its last run.
+     */
+    struct ScheduledSystem
+    {
+        std::string Name;
+        std::function<void(float)> Function;
+        std::vector<entt::id_type> ReadTypes;
+        std::vector<entt::id_type> WriteTypes;
+        SystemFlags Flags = SystemFlags::None;
+
+        std::vector<uint32_t> Dependencies; ///< The earlier systems that must finish before this one, direct conflicts only.
+        uint32_t Level = 0; ///< The systems of the same level run at the same time.
+        float LastTime = 0.0f; ///< Duration of the last run in milliseconds.
+    };
+
+    /**
+     * @brief Runs the systems of a frame, in parallel when their accesses allow it.
+     *
+     * Every system declares the types it reads and writes, usually components but any type can stand for a shared
+     * resource, like the render world. Two systems conflict when one writes a type the other reads or writes, and
+     * a system runs after every conflicting system registered before it, so the result is the same as running them
+     * in registration order. The graph is split in levels, the systems of a level are independent: the worker ones
+     * are sent to the job system and the main thread ones run in the calling thread while they execute.
+     *
+     * The graph is only rebuilt when a system is added or removed.
+     */
+    class SystemScheduler
+    {
+    public:
+        /**
+         * @brief Registers a system after the existing ones.
+         * @tparam ReadList Reads<...> with the types the system reads.
+         * @tparam WriteList Writes<...> with the types the system writes.
+         * @param name The name of the system, used by the profiler and the debug view.
+         * @param function The system, called with the frame time.
+         * @param flags The options of the system.
+         */
+        template<typename ReadList = Reads<>, typename WriteList = Writes<>>
+        void AddSystem(const std::string& name, std::function<void(float)> function, SystemFlags flags = SystemFlags::None)
+        {
+            AddSystem(name, std::move(function), TypeIds(ReadList{}), TypeIds(WriteList{}), flags);
+        }
+
+        /**
+         * @brief Registers a system after the existing ones.
+         * @param name The name of the system.
+         * @param function The system, called with the frame time.
+         * @param readTypes The type ids of the types the system reads.
+         * @param writeTypes The type ids of the types the system writes.
+         * @param flags The options of the system.
+         */
+        void AddSystem(const std::string& name, std::function<void(float)> function, std::vector<entt::id_type> readTypes,
+                       std::vector<entt::id_type> writeTypes, SystemFlags flags = SystemFlags::None);
+
+        /**
+         * @brief Unregisters a system.
+         * @param name The name of the system.
+         * @return True if the system was found.
+         */
+        bool RemoveSystem(const std::string& name);
+
+        /**
+         * @brief Runs every system once and waits for them.
+         * @param dt The frame time.
+         */
+        void Run(float dt);
+
+        /**
+         * @brief Gets the systems with their dependencies, levels and timings, for the debug views.
+         * @return The systems in registration order.
+         */
+        const std::vector<ScheduledSystem>& GetSystems() const { return m_Systems; }
+
+        /**
+         * @brief Gets the number of levels of the graph.
+         * @return The number of steps the frame is split in.
+         */
+        uint32_t GetLevelCount() const { return static_cast<uint32_t>(m_Levels.size()); }
+
+        /**
+         * @brief Gets the duration of the last run.
+         * @return The time between the start of the first system and the end of the last one, in milliseconds.
+         */
+        float GetLastTime() const { return m_LastTime; }
+
+    private:
+        template<typename... Types>
+        static std::vector<entt::id_type> TypeIds(Reads<Types...>) { return {entt::type_hash<Types>::value()...}; }
+
+        template<typename... Types>
+        static std::vector<entt::id_type> TypeIds(Writes<Types...>) { return {entt::type_hash<Types>::value()...}; }
+
+        static bool Conflicts(const ScheduledSystem& a, const ScheduledSystem& b);
+
+        void BuildGraph();
+        void RunSystem(ScheduledSystem& system, float dt);
+
+    private:
+        std::vector<ScheduledSystem> m_Systems;
+        std::vector<std::vector<uint32_t>> m_Levels; ///< The indices of the systems of each level.
+        bool m_Dirty = true;
+        float m_LastTime = 0.0f;
+    };
+
+    /** @} */
+}
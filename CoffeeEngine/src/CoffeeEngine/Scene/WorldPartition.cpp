@@ -0,0 +1,599 @@
+#include "CoffeeEngine/Scene/WorldPartition.h"
+
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/ResourceLoader.h"
+#include "CoffeeEngine/IO/ResourceRegistry.h"
+#include "CoffeeEngine/IO/Serialization/GLMSerialization.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+#include "entt/entity/snapshot.hpp"
+
+#include <algorithm>
+#include <cereal/archives/json.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tracy/Tracy.hpp>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Coffee {
+
+    WorldPartitionSettings WorldPartition::s_Settings;
+
+    static constexpr const char* ManifestFile = "partition.json";
+
+    /**
+     * @brief A sector file read and parsed by a background load, the components are read at the sync point.
+     */
+    struct WorldPartition::SectorData
+    {
+        std::stringstream Stream;
+        Scope<cereal::JSONInputArchive> Archive; ///< Parsed document, positioned after the resource lists.
+        std::vector<UUID> Meshes;
+        std::vector<UUID> Materials;
+        std::string Error;
+    };
+
+    // Appends the entities of the subtree of a root, parents before their children
+    static void GatherSubtree(const entt::registry& registry, entt::entity root, std::vector<entt::entity>& outEntities)
+    {
+        size_t next = outEntities.size();
+        outEntities.push_back(root);
+
+        while (next < outEntities.size())
+        {
+            entt::entity child = registry.get<HierarchyComponent>(outEntities[next++]).m_First;
+            while (child != entt::null)
+            {
+                outEntities.push_back(child);
+                child = registry.get<HierarchyComponent>(child).m_Next;
+            }
+        }
+    }
+
+    template<typename T>
+    static void CopyComponent(const entt::registry& source, const std::vector<entt::entity>& entities,
+                              entt::registry& destination, const std::vector<entt::entity>& copies)
+    {
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+            if (const T* component = source.try_get<T>(entities[i]))
+                destination.emplace<T>(copies[i], *component);
+        }
+    }
+
+    // Copies entities and their serialized components to another registry. The hierarchy links are remapped to the
+    // copies and the links to entities outside the list are cut, so the roots of the list become roots.
+    static void CopyEntities(const entt::registry& source, const std::vector<entt::entity>& entities,
+                             entt::registry& destination, std::vector<entt::entity>& outCopies)
+    {
+        outCopies.resize(entities.size());
+        destination.create(outCopies.begin(), outCopies.end());
+
+        std::unordered_map<entt::entity, entt::entity> remap;
+        remap.reserve(entities.size());
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+            remap[entities[i]] = outCopies[i];
+        }
+
+        auto map = [&remap](entt::entity entity) -> entt::entity {
+            auto it = remap.find(entity);
+            return it != remap.end() ? it->second : entt::null;
+        };
+
+        // The transforms go first, the mesh proxies read them when they are created
+        CopyComponent<TagComponent>(source, entities, destination, outCopies);
+        CopyComponent<TransformComponent>(source, entities, destination, outCopies);
+
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+            const HierarchyComponent* sourceHierarchy = source.try_get<HierarchyComponent>(entities[i]);
+            if (!sourceHierarchy)
+                continue;
+
+            HierarchyComponent hierarchy = *sourceHierarchy;
+            hierarchy.m_Parent = map(hierarchy.m_Parent);
+            hierarchy.m_First = map(hierarchy.m_First);
+            hierarchy.m_Last = map(hierarchy.m_Last);
+            hierarchy.m_Next = map(hierarchy.m_Next);
+            hierarchy.m_Prev = map(hierarchy.m_Prev);
+            destination.emplace<HierarchyComponent>(outCopies[i], hierarchy);
+        }
+
+        CopyComponent<CameraComponent>(source, entities, destination, outCopies);
+        CopyComponent<MeshComponent>(source, entities, destination, outCopies);
+        CopyComponent<MaterialComponent>(source, entities, destination, outCopies);
+        CopyComponent<LightComponent>(source, entities, destination, outCopies);
+    }
+
+    WorldPartition::WorldPartition(Scene* scene) : m_Scene(scene)
+    {
+    }
+
+    WorldPartition::~WorldPartition()
+    {
+        // The background loads write into the sectors
+        for (uint32_t index : m_ActiveSectors)
+        {
+            Sector& sector = m_Sectors[index];
+            if (sector.State == SectorState::Loading)
+                JobSystem::Wait(*sector.Counter);
+        }
+    }
+
+    std::filesystem::path WorldPartition::GetDirectory(const std::filesystem::path& scenePath)
+    {
+        std::filesystem::path directory = scenePath;
+        return directory.replace_extension(".sectors");
+    }
+
+    uint32_t WorldPartition::GetLoadedSectorCount() const
+    {
+        uint32_t count = 0;
+        for (uint32_t index : m_ActiveSectors)
+        {
+            if (m_Sectors[index].State == SectorState::Loaded)
+                count++;
+        }
+        return count;
+    }
+
+    std::vector<entt::entity> WorldPartition::GetLoadedRoots() const
+    {
+        std::vector<entt::entity> roots;
+        for (uint32_t index : m_ActiveSectors)
+        {
+            const Sector& sector = m_Sectors[index];
+            roots.insert(roots.end(), sector.Roots.begin(), sector.Roots.end());
+        }
+        return roots;
+    }
+
+    bool WorldPartition::Build(const std::filesystem::path& scenePath, float sectorSize)
+    {
+        ZoneScoped;
+
+        // The sectors that are not loaded would be missing from the new partition
+        LoadAll();
+
+        entt::registry& registry = m_Scene->m_Registry;
+        const RenderWorld& renderWorld = m_Scene->GetRenderWorld();
+
+        // The roots with meshes in their subtree are streamed, sorted by sector so the files are always written in the same order
+        std::map<std::tuple<int32_t, int32_t, int32_t>, std::vector<entt::entity>> sectorRoots;
+        std::vector<entt::entity> subtree;
+
+        auto view = registry.view<TransformComponent, HierarchyComponent>();
+        for (auto entity : view)
+        {
+            if (view.get<HierarchyComponent>(entity).m_Parent != entt::null)
+                continue;
+
+            subtree.clear();
+            GatherSubtree(registry, entity, subtree);
+
+            bool hasMeshes = false;
+            for (entt::entity node : subtree)
+            {
+                hasMeshes |= registry.all_of<MeshComponent>(node);
+            }
+
+            if (!hasMeshes)
+                continue;
+
+            // A root has no parent, its local position is its world position
+            glm::ivec3 coord = glm::ivec3(glm::floor(view.get<TransformComponent>(entity).Position / sectorSize));
+            sectorRoots[{coord.x, coord.y, coord.z}].push_back(entity);
+        }
+
+        // The sectors are written next to the partition and only replace it once the scene file is saved without
+        // them, so a failed build leaves the previous partition and scene file as they were
+        const std::filesystem::path directory = GetDirectory(scenePath);
+        std::filesystem::path stagingDirectory = directory;
+        stagingDirectory += ".tmp";
+
+        std::error_code error;
+        std::filesystem::remove_all(stagingDirectory, error);
+        if (!error)
+            std::filesystem::create_directories(stagingDirectory, error);
+
+        if (error)
+        {
+            COFFEE_CORE_ERROR("WorldPartition: Could not create {0}: {1}", stagingDirectory.string(), error.message());
+            return false;
+        }
+
+        auto discardStaging = [&stagingDirectory]() {
+            std::error_code removeError;
+            std::filesystem::remove_all(stagingDirectory, removeError);
+        };
+
+        std::vector<SectorDescription> descriptions;
+        std::vector<entt::entity> partitionedRoots;
+
+        for (const auto& [key, roots] : sectorRoots)
+        {
+            std::vector<entt::entity> entities;
+            for (entt::entity root : roots)
+            {
+                GatherSubtree(registry, root, entities);
+            }
+            partitionedRoots.insert(partitionedRoots.end(), roots.begin(), roots.end());
+
+            SectorDescription description;
+            description.Coord = glm::ivec3(std::get<0>(key), std::get<1>(key), std::get<2>(key));
+            description.Bounds = AABB(glm::vec3(description.Coord) * sectorSize, glm::vec3(description.Coord + 1) * sectorSize);
+            description.File = "sector_" + std::to_string(description.Coord.x) + "_" + std::to_string(description.Coord.y) + "_" +
+                               std::to_string(description.Coord.z) + ".json";
+            description.EntityCount = static_cast<uint32_t>(entities.size());
+
+            std::unordered_set<UUID> meshSet;
+            std::unordered_set<UUID> materialSet;
+            std::vector<UUID> meshes;
+            std::vector<UUID> materials;
+
+            for (entt::entity entity : entities)
+            {
+                if (auto* meshComponent = registry.try_get<MeshComponent>(entity))
+                {
+                    if (meshComponent->mesh && meshSet.insert(meshComponent->mesh->GetUUID()).second)
+                        meshes.push_back(meshComponent->mesh->GetUUID());
+
+                    // The meshes can reach past their sector, the distance to the camera is measured to all of them
+                    AABB bounds;
+                    if (renderWorld.GetProxyBounds(static_cast<uint32_t>(entity), bounds))
+                    {
+                        description.Bounds.min = glm::min(description.Bounds.min, bounds.min);
+                        description.Bounds.max = glm::max(description.Bounds.max, bounds.max);
+                    }
+                }
+
+                if (auto* materialComponent = registry.try_get<MaterialComponent>(entity))
+                {
+                    if (materialSet.insert(materialComponent->material->GetUUID()).second)
+                        materials.push_back(materialComponent->material->GetUUID());
+                }
+            }
+
+            // The sector is written from its own registry, so the files do not depend on the handles of the scene
+            entt::registry staging;
+            std::vector<entt::entity> copies;
+            CopyEntities(registry, entities, staging, copies);
+
+            std::ofstream sectorFile(stagingDirectory / description.File);
+            {
+                cereal::JSONOutputArchive archive(sectorFile);
+                archive(cereal::make_nvp("Meshes", meshes), cereal::make_nvp("Materials", materials));
+
+                entt::snapshot{staging}
+                    .get<entt::entity>(archive)
+                    .get<TagComponent>(archive)
+                    .get<TransformComponent>(archive)
+                    .get<HierarchyComponent>(archive)
+                    .get<CameraComponent>(archive)
+                    .get<MeshComponent>(archive)
+                    .get<MaterialComponent>(archive)
+                    .get<LightComponent>(archive);
+            }
+
+            sectorFile.close();
+            if (sectorFile.fail())
+            {
+                COFFEE_CORE_ERROR("WorldPartition: Could not write {0}", (stagingDirectory / description.File).string());
+                discardStaging();
+                return false;
+            }
+
+            descriptions.push_back(description);
+        }
+
+        std::ofstream manifestFile(stagingDirectory / ManifestFile);
+        {
+            cereal::JSONOutputArchive archive(manifestFile);
+            archive(cereal::make_nvp("SectorSize", sectorSize), cereal::make_nvp("Sectors", descriptions));
+        }
+
+        manifestFile.close();
+        if (manifestFile.fail())
+        {
+            COFFEE_CORE_ERROR("WorldPartition: Could not write {0}", (stagingDirectory / ManifestFile).string());
+            discardStaging();
+            return false;
+        }
+
+        // Without the streamed entities in the scene file, opening the scene does not duplicate them
+        if (!m_Scene->WriteFile(scenePath, partitionedRoots))
+        {
+            discardStaging();
+            return false;
+        }
+
+        std::filesystem::remove_all(directory, error);
+        if (!error)
+            std::filesystem::rename(stagingDirectory, directory, error);
+
+        if (error)
+        {
+            COFFEE_CORE_ERROR("WorldPartition: Could not move the sectors from {0} to {1}: {2}", stagingDirectory.string(),
+                              directory.string(), error.message());
+            return false;
+        }
+
+        // The streamed entities now live in the sectors, the loaded ones are part of the roots destroyed here
+        m_Scene->DestroySubtrees(partitionedRoots);
+        m_Sectors.clear();
+        m_ActiveSectors.clear();
+        m_SectorGrid.Clear();
+
+        Open(directory);
+        m_Scene->m_FilePath = scenePath;
+
+        COFFEE_CORE_INFO("WorldPartition: Built {0} sectors in {1}", descriptions.size(), directory.string());
+        return true;
+    }
+
+    bool WorldPartition::Open(const std::filesystem::path& directory)
+    {
+        ZoneScoped;
+
+        std::ifstream manifestFile(directory / ManifestFile);
+        if (!manifestFile)
+            return false;
+
+        UnloadAll();
+
+        float sectorSize = 0.0f;
+        std::vector<SectorDescription> descriptions;
+
+        cereal::JSONInputArchive archive(manifestFile);
+        archive(cereal::make_nvp("SectorSize", sectorSize), cereal::make_nvp("Sectors", descriptions));
+
+        m_Directory = directory;
+        m_Sectors.clear();
+        m_Sectors.resize(descriptions.size());
+
+        // One sector per cell, the sectors bigger than the cells of the manifest are still found by the grid
+        m_SectorGrid = SparseGrid(sectorSize > 0.0f ? sectorSize : s_Settings.LoadDistance);
+        for (uint32_t i = 0; i < descriptions.size(); i++)
+        {
+            m_Sectors[i].Description = descriptions[i];
+            m_SectorGrid.Insert(i, descriptions[i].Bounds);
+        }
+
+        return true;
+    }
+
+    void WorldPartition::Update(const glm::vec3& cameraPosition)
+    {
+        ZoneScoped;
+
+        const float loadDistanceSquared = s_Settings.LoadDistance * s_Settings.LoadDistance;
+        const float unloadDistance = std::max(s_Settings.UnloadDistance, s_Settings.LoadDistance);
+        const float unloadDistanceSquared = unloadDistance * unloadDistance;
+
+        uint32_t splices = 0;
+
+        // Only the sectors being loaded or loaded can change of state without getting close to the camera
+        for (uint32_t index : m_ActiveSectors)
+        {
+            Sector& sector = m_Sectors[index];
+            float distanceSquared = sector.Description.Bounds.DistanceSquared(cameraPosition);
+
+            if (sector.State == SectorState::Loading)
+            {
+                if (!sector.Counter->IsDone())
+                    continue;
+
+                if (distanceSquared > unloadDistanceSquared)
+                {
+                    // The camera left before the sector was added
+                    sector.Data.reset();
+                    sector.State = SectorState::Unloaded;
+                }
+                else if (splices < s_Settings.MaxSplicesPerFrame)
+                {
+                    Splice(sector);
+                    splices++;
+                }
+            }
+            else if (sector.State == SectorState::Loaded && distanceSquared > unloadDistanceSquared)
+            {
+                Unload(sector);
+            }
+        }
+
+        std::erase_if(m_ActiveSectors, [this](uint32_t index) { return m_Sectors[index].State == SectorState::Unloaded; });
+
+        // The grid returns the sectors whose bounds overlap the box around the load distance
+        const glm::vec3 loadRange(s_Settings.LoadDistance);
+        m_NearbySectors.clear();
+        m_SectorGrid.Query(AABB(cameraPosition - loadRange, cameraPosition + loadRange), m_NearbySectors);
+
+        for (uint32_t index : m_NearbySectors)
+        {
+            const Sector& sector = m_Sectors[index];
+            if (sector.State == SectorState::Unloaded && sector.Description.Bounds.DistanceSquared(cameraPosition) < loadDistanceSquared)
+                RequestLoad(index);
+        }
+    }
+
+    void WorldPartition::LoadAll()
+    {
+        ZoneScoped;
+
+        for (uint32_t index = 0; index < m_Sectors.size(); index++)
+        {
+            if (m_Sectors[index].State == SectorState::Unloaded)
+                RequestLoad(index);
+        }
+
+        for (uint32_t index : m_ActiveSectors)
+        {
+            Sector& sector = m_Sectors[index];
+            if (sector.State == SectorState::Loading)
+            {
+                JobSystem::Wait(*sector.Counter);
+                Splice(sector);
+            }
+        }
+    }
+
+    void WorldPartition::UnloadAll()
+    {
+        ZoneScoped;
+
+        for (uint32_t index : m_ActiveSectors)
+        {
+            Sector& sector = m_Sectors[index];
+            if (sector.State == SectorState::Loading)
+            {
+                JobSystem::Wait(*sector.Counter);
+                sector.Data.reset();
+                sector.State = SectorState::Unloaded;
+            }
+            else if (sector.State == SectorState::Loaded)
+            {
+                Unload(sector);
+            }
+        }
+
+        m_ActiveSectors.clear();
+    }
+
+    void WorldPartition::RequestLoad(uint32_t index)
+    {
+        Sector& sector = m_Sectors[index];
+        m_ActiveSectors.push_back(index);
+
+        sector.State = SectorState::Loading;
+        sector.Data = CreateScope<SectorData>();
+        sector.Counter = CreateScope<JobCounter>();
+
+        SectorData* data = sector.Data.get();
+        std::filesystem::path path = m_Directory / sector.Description.File;
+
+        // Reading and parsing the file do not touch the scene or the resources, so they run in the background
+        JobSystem::SubmitBackground([data, path]() {
+            ZoneScopedN("Load Sector");
+
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                data->Error = "Could not open " + path.string();
+                return;
+            }
+
+            data->Stream << file.rdbuf();
+
+            try
+            {
+                data->Archive = CreateScope<cereal::JSONInputArchive>(data->Stream);
+                (*data->Archive)(cereal::make_nvp("Meshes", data->Meshes), cereal::make_nvp("Materials", data->Materials));
+            }
+            catch (const cereal::Exception& e)
+            {
+                data->Archive.reset();
+                data->Error = e.what();
+            }
+        }, sector.Counter.get());
+    }
+
+    void WorldPartition::Splice(Sector& sector)
+    {
+        ZoneScoped;
+
+        Scope<SectorData> data = std::move(sector.Data);
+        sector.State = SectorState::Loaded;
+
+        if (!data->Archive)
+        {
+            // Marked as loaded anyway, so a broken file is not read again every frame
+            COFFEE_CORE_ERROR("WorldPartition: Failed to load the sector {0}: {1}", sector.Description.File, data->Error);
+            return;
+        }
+
+        // The resources are imported here because their GPU data can only be created in the render thread
+        for (UUID uuid : data->Materials)
+        {
+            ResourceLoader::LoadMaterial(uuid);
+            sector.Resources.push_back(uuid);
+        }
+
+        for (UUID uuid : data->Meshes)
+        {
+            ResourceLoader::LoadMesh(uuid);
+            sector.Resources.push_back(uuid);
+        }
+
+        entt::registry staging;
+        entt::snapshot_loader{staging}
+            .get<entt::entity>(*data->Archive)
+            .get<TagComponent>(*data->Archive)
+            .get<TransformComponent>(*data->Archive)
+            .get<HierarchyComponent>(*data->Archive)
+            .get<CameraComponent>(*data->Archive)
+            .get<MeshComponent>(*data->Archive)
+            .get<MaterialComponent>(*data->Archive)
+            .get<LightComponent>(*data->Archive);
+
+        HierarchyComponent::RebuildChildLinks(staging);
+
+        std::vector<entt::entity> entities;
+        auto view = staging.view<HierarchyComponent>();
+        for (auto entity : view)
+        {
+            if (view.get<HierarchyComponent>(entity).m_Parent == entt::null)
+                GatherSubtree(staging, entity, entities);
+        }
+
+        // The links are already complete, OnConstruct would append the children a second time
+        entt::registry& registry = m_Scene->m_Registry;
+        std::vector<entt::entity> copies;
+
+        registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+        CopyEntities(staging, entities, registry, copies);
+        registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+
+        for (entt::entity copy : copies)
+        {
+            if (registry.get<HierarchyComponent>(copy).m_Parent == entt::null)
+                sector.Roots.push_back(copy);
+        }
+    }
+
+    void WorldPartition::Unload(Sector& sector)
+    {
+        ZoneScoped;
+
+        entt::registry& registry = m_Scene->m_Registry;
+
+        // The scripts or the editor may have destroyed some of the roots already
+        std::vector<entt::entity> roots;
+        for (entt::entity root : sector.Roots)
+        {
+            if (registry.valid(root))
+                roots.push_back(root);
+        }
+        m_Scene->DestroySubtrees(roots);
+
+        // The resources only the registry still holds are released, the meshes first since they hold their materials
+        const auto& resources = ResourceRegistry::GetResourceRegistry();
+        for (auto it = sector.Resources.rbegin(); it != sector.Resources.rend(); ++it)
+        {
+            auto resource = resources.find(*it);
+            if (resource != resources.end() && resource->second.use_count() == 1)
+                ResourceRegistry::Remove(*it);
+        }
+
+        sector.Roots.clear();
+        sector.Resources.clear();
+        sector.State = SectorState::Unloaded;
+    }
+
+}
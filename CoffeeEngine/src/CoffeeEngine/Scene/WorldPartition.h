@@ -0,0 +1,198 @@
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/DataStructures/SparseGrid.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <cereal/access.hpp>
+#include <cereal/cereal.hpp>
+#include <entt/entity/fwd.hpp>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup scene Scene
+     * @{
+     */
+
+    class Scene;
+
+    /**
+     * @brief Structure containing the world partition settings.
+     */
+    struct WorldPartitionSettings
+    {
+        float LoadDistance = 256.0f; ///< The sectors closer than this to the camera are loaded.
+        float UnloadDistance = 320.0f; ///< The loaded sectors farther than this are unloaded. Keep it above the load distance so a camera on the border does not reload the same sector every frame.
+        uint32_t MaxSplicesPerFrame = 1; ///< Number of loaded sectors added to the registry in a frame, to spread the cost over several frames.
+    };
+
+    /**
+     * @brief Entry of a sector in the manifest of a partitioned scene.
+     */
+    struct SectorDescription
+    {
+        glm::ivec3 Coord = glm::ivec3(0); ///< The coordinates of the sector in the grid.
+        AABB Bounds; ///< The area of the sector, its distance to the camera decides when the sector is loaded.
+        std::string File; ///< The file of the sector, relative to the partition directory.
+        uint32_t EntityCount = 0;
+
+    private:
+        friend class cereal::access;
+
+        template<class Archive>
+        void serialize(Archive& archive)
+        {
+            archive(cereal::make_nvp("X", Coord.x), cereal::make_nvp("Y", Coord.y), cereal::make_nvp("Z", Coord.z),
+                    cereal::make_nvp("Bounds", Bounds), cereal::make_nvp("File", File), cereal::make_nvp("EntityCount", EntityCount));
+        }
+    };
+
+    /**
+     * @brief Streams the content of a scene in sectors around the camera.
+     *
+     * Building the partition splits the root entities that have meshes in their subtree into the sectors of a grid,
+     * by the position of the root. Every sector is written to its own file with the list of the resources it
+     * references, and its entities leave the scene and its file, which keep the rest (cameras, lights, logic) loaded
+     * all the time.
+     *
+     * The sectors are kept in a sparse grid by their bounds, so an update only visits the sectors around the camera
+     * and the ones already loaded, not the whole partition. The sectors near the camera are read and parsed by the
+     * job system threads. The parsed sectors are added to the
+     * registry at the start of the scene update, the only point where the registry is not being iterated, and the
+     * resources they reference are imported there because it needs the render context. The sectors that get far from
+     * the camera are destroyed and the resources only they were using are released.
+     *
+     * The sector files are read only, the changes made to a loaded sector are lost when it unloads. Building the
+     * partition again loads every sector first, so it writes the current state of the whole scene.
+     */
+    class WorldPartition
+    {
+    public:
+        /**
+         * @brief Constructor for WorldPartition.
+         * @param scene The scene that receives the sectors.
+         */
+        WorldPartition(Scene* scene);
+
+        /**
+         * @brief Waits for the sectors being loaded.
+         */
+        ~WorldPartition();
+
+        /**
+         * @brief Splits the scene in sectors, writes them with their manifest and saves the scene file without them.
+         * @param scenePath The scene file, the partition goes to the directory next to it and replaces the previous one.
+         * @param sectorSize The size of the sectors in world units.
+         * @return True if the partition and the scene file were written, the previous ones are left untouched otherwise.
+         */
+        bool Build(const std::filesystem::path& scenePath, float sectorSize);
+
+        /**
+         * @brief Reads the manifest of a partition, no sector is loaded until the next update.
+         * @param directory The directory of the partition.
+         * @return True if the directory has a manifest.
+         */
+        bool Open(const std::filesystem::path& directory);
+
+        /**
+         * @brief Points the partition to a copy of its directory, the loaded sectors stay loaded.
+         * @param directory The directory the sectors and their manifest were copied to.
+         */
+        void Relocate(const std::filesystem::path& directory) { m_Directory = directory; }
+
+        /**
+         * @brief Checks if the scene has a partition.
+         * @return True if a partition was opened or built.
+         */
+        bool IsOpen() const { return !m_Directory.empty(); }
+
+        /**
+         * @brief Gets the directory of the partition.
+         * @return The directory of the sectors and their manifest, empty if the partition is not open.
+         */
+        const std::filesystem::path& GetPath() const { return m_Directory; }
+
+        /**
+         * @brief Adds the sectors that finished loading and requests the sectors that entered or left the load distance.
+         *
+         * Must be called where the registry is not being iterated.
+         *
+         * @param cameraPosition The position the distances are measured from.
+         */
+        void Update(const glm::vec3& cameraPosition);
+
+        /**
+         * @brief Loads every sector and waits for them.
+         */
+        void LoadAll();
+
+        /**
+         * @brief Unloads every sector, the ones being loaded are waited for and discarded.
+         */
+        void UnloadAll();
+
+        uint32_t GetSectorCount() const { return static_cast<uint32_t>(m_Sectors.size()); }
+        uint32_t GetLoadedSectorCount() const;
+
+        /**
+         * @brief Gets the root entities of the loaded sectors.
+         * @return The roots of the streamed subtrees in the scene, some of them may have been destroyed since.
+         */
+        std::vector<entt::entity> GetLoadedRoots() const;
+
+        /**
+         * @brief Gets the directory of the partition of a scene file.
+         * @param scenePath The path of the scene.
+         * @return The directory next to the scene with its name and the .sectors extension.
+         */
+        static std::filesystem::path GetDirectory(const std::filesystem::path& scenePath);
+
+        /**
+         * @brief Get the world partition settings shared by all the scenes.
+         * @return A reference to the world partition settings.
+         */
+        static WorldPartitionSettings& GetSettings() { return s_Settings; }
+
+    private:
+        enum class SectorState
+        {
+            Unloaded,
+            Loading,
+            Loaded
+        };
+
+        struct SectorData;
+
+        struct Sector
+        {
+            SectorDescription Description;
+            SectorState State = SectorState::Unloaded;
+            Scope<JobCounter> Counter; ///< Pending background load, stable while the job holds it.
+            Scope<SectorData> Data; ///< The file parsed by the background load.
+            std::vector<entt::entity> Roots; ///< The root entities of the sector in the scene, while it is loaded.
+            std::vector<UUID> Resources; ///< The resources referenced by the sector, while it is loaded.
+        };
+
+        void RequestLoad(uint32_t index);
+        void Splice(Sector& sector);
+        void Unload(Sector& sector);
+
+    private:
+        Scene* m_Scene;
+        std::filesystem::path m_Directory;
+        std::vector<Sector> m_Sectors;
+        SparseGrid m_SectorGrid; ///< The bounds of the sectors by their index.
+        std::vector<uint32_t> m_ActiveSectors; ///< The indices of the sectors being loaded or loaded.
+        std::vector<uint32_t> m_NearbySectors; ///< The sectors found by the last grid query, kept to reuse its memory.
+
+        static WorldPartitionSettings s_Settings;
+    };
+
+    /** @} */
+}
@@ -6,6 +6,9 @@
 #include "CoffeeEngine/Core/MouseCodes.h"
 #include "CoffeeEngine/Scene/Components.h"
 #include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/SpatialQuery.h"
+
+#include <algorithm>
 
 #define SOL_PRINT_ERRORS 1
 
@@ -290,6 +293,56 @@ namespace Coffee {
         inputTable["mousecode"] = mouseCodeTable;
     }
 
+    // The scene being updated, registered by the scene before running its scripts
+    static Scene* GetScriptScene()
+    {
+        sol::object scene = LuaBackend::luaState["scene"];
+        return scene.is<void*>() ? static_cast<Scene*>(scene.as<void*>()) : nullptr;
+    }
+
+    // Buffers of the spatial queries, they grow to the largest request and are reused between calls
+    // A vector of a transform seen from a script. Writing a component goes through the transform and marks it
+    // dirty, reading one does not, so the scripts that only read a transform leave its subtree clean.
+    struct LuaTransformVector
+    {
+        TransformComponent* Transform;
+        glm::vec3 TransformComponent::* Vector;
+
+        float Get(int axis) const { return ((*Transform).*Vector)[axis]; }
+        void Set(int axis, float value) { ((*Transform).*Vector)[axis] = value; Transform->MarkDirty(); }
+    };
+
+    static void SetTransformVector(TransformComponent& transform, glm::vec3 TransformComponent::* vector, const glm::vec3& value)
+    {
+        transform.*vector = value;
+        transform.MarkDirty();
+    }
+
+    static std::vector<SpatialHit> s_SpatialHits;
+    static std::vector<Entity> s_SpatialEntities;
+
+    static sol::table HitsToTable(uint32_t count)
+    {
+        sol::table result = LuaBackend::luaState.create_table(count, 0);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const SpatialHit& hit = s_SpatialHits[i];
+            result[i + 1] = LuaBackend::luaState.create_table_with("entity", hit.HitEntity, "distance", hit.Distance,
+                                                                   "x", hit.Point.x, "y", hit.Point.y, "z", hit.Point.z);
+        }
+        return result;
+    }
+
+    static sol::table EntitiesToTable(uint32_t count)
+    {
+        sol::table result = LuaBackend::luaState.create_table(count, 0);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            result[i + 1] = s_SpatialEntities[i];
+        }
+        return result;
+    }
+
     void LuaBackend::Initialize() {
         luaState.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table);
 
@@ -335,6 +388,97 @@ namespace Coffee {
         # pragma region Bind Timer Functions
         # pragma endregion
 
+        # pragma region Bind Spatial Query Functions
+        sol::table spatialTable = luaState.create_table();
+
+        spatialTable.set_function("raycast", [](float ox, float oy, float oz, float dx, float dy, float dz, float maxDistance, sol::optional<uint32_t> maxHits) {
+            Scene* scene = GetScriptScene();
+            s_SpatialHits.resize(std::max(maxHits.value_or(16), 1u));
+            uint32_t count = scene ? SpatialQuery(scene).RayCast({ox, oy, oz}, {dx, dy, dz}, maxDistance, s_SpatialHits) : 0;
+            return HitsToTable(count);
+        });
+
+        spatialTable.set_function("segment_cast", [](float sx, float sy, float sz, float ex, float ey, float ez, sol::optional<uint32_t> maxHits) {
+            Scene* scene = GetScriptScene();
+            s_SpatialHits.resize(std::max(maxHits.value_or(16), 1u));
+            uint32_t count = scene ? SpatialQuery(scene).SegmentCast({sx, sy, sz}, {ex, ey, ez}, s_SpatialHits) : 0;
+            return HitsToTable(count);
+        });
+
+        spatialTable.set_function("overlap_box", [](float minX, float minY, float minZ, float maxX, float maxY, float maxZ, sol::optional<uint32_t> maxResults) {
+            Scene* scene = GetScriptScene();
+            s_SpatialEntities.resize(std::max(maxResults.value_or(64), 1u));
+            uint32_t count = scene ? SpatialQuery(scene).OverlapBox(AABB({minX, minY, minZ}, {maxX, maxY, maxZ}), s_SpatialEntities) : 0;
+            return EntitiesToTable(count);
+        });
+
+        spatialTable.set_function("overlap_sphere", [](float x, float y, float z, float radius, sol::optional<uint32_t> maxResults) {
+            Scene* scene = GetScriptScene();
+            s_SpatialEntities.resize(std::max(maxResults.value_or(64), 1u));
+            uint32_t count = scene ? SpatialQuery(scene).OverlapSphere({x, y, z}, radius, s_SpatialEntities) : 0;
+            return EntitiesToTable(count);
+        });
+
+        spatialTable.set_function("nearest", [](float x, float y, float z, uint32_t k, sol::optional<float> maxDistance) {
+            Scene* scene = GetScriptScene();
+            s_SpatialHits.resize(std::max(k, 1u));
+            uint32_t count = scene ? SpatialQuery(scene).Nearest({x, y, z}, s_SpatialHits, maxDistance.value_or(std::numeric_limits<float>::max())) : 0;
+            return HitsToTable(count);
+        });
+
+        luaState["spatial"] = spatialTable;
+        # pragma endregion
+
+        # pragma region Bind Command Buffer Functions
+        // The structural changes are recorded in the command buffer of the scene and applied after the scripts
+        sol::table commandsTable = luaState.create_table();
+
+        commandsTable.set_function("create_entity", [](sol::optional<std::string> name) {
+            Scene* scene = GetScriptScene();
+            return scene ? scene->GetCommandBuffer().CreateEntity(name.value_or(std::string())) : Entity();
+        });
+
+        commandsTable.set_function("destroy_entity", [](Entity entity) {
+            if (Scene* scene = GetScriptScene())
+                scene->GetCommandBuffer().DestroyEntity(entity);
+        });
+
+        commandsTable.set_function("set_parent", [](Entity entity, sol::optional<Entity> parent) {
+            if (Scene* scene = GetScriptScene())
+                scene->GetCommandBuffer().SetParent(entity, parent.value_or(Entity()));
+        });
+
+        commandsTable.set_function("add_component", [](Entity entity, const std::string& componentName) {
+            Scene* scene = GetScriptScene();
+            if (!scene)
+                return;
+
+            if (componentName == "TagComponent") {
+                scene->GetCommandBuffer().AddComponent<TagComponent>(entity);
+            } else if (componentName == "TransformComponent") {
+                scene->GetCommandBuffer().AddComponent<TransformComponent>(entity);
+            } else {
+                throw std::runtime_error("Unknown component type");
+            }
+        });
+
+        commandsTable.set_function("remove_component", [](Entity entity, const std::string& componentName) {
+            Scene* scene = GetScriptScene();
+            if (!scene)
+                return;
+
+            if (componentName == "TagComponent") {
+                scene->GetCommandBuffer().RemoveComponent<TagComponent>(entity);
+            } else if (componentName == "TransformComponent") {
+                scene->GetCommandBuffer().RemoveComponent<TransformComponent>(entity);
+            } else {
+                throw std::runtime_error("Unknown component type");
+            }
+        });
+
+        luaState["commands"] = commandsTable;
+        # pragma endregion
+
         #pragma region Bind Entity Functions
 
         luaState.new_usertype<Entity>("Entity",
@@ -396,11 +540,25 @@ namespace Coffee {
             "tag", &TagComponent::Tag
         );
 
+        luaState.new_usertype<LuaTransformVector>("transform_vector",
+            "x", sol::property([](const LuaTransformVector& self) { return self.Get(0); }, [](LuaTransformVector& self, float value) { self.Set(0, value); }),
+            "y", sol::property([](const LuaTransformVector& self) { return self.Get(1); }, [](LuaTransformVector& self, float value) { self.Set(1, value); }),
+            "z", sol::property([](const LuaTransformVector& self) { return self.Get(2); }, [](LuaTransformVector& self, float value) { self.Set(2, value); })
+        );
+
         luaState.new_usertype<TransformComponent>("transform_component",
             sol::constructors<TransformComponent(), TransformComponent(const glm::vec3&)>(),
-            "position", &TransformComponent::Position,
-            "rotation", &TransformComponent::Rotation,
-            "scale", &TransformComponent::Scale,
+            // transform.position.x = 5 writes through the proxy, copying a vector from another transform uses the
+            // whole vector setter and set_position(x, y, z) writes the three components at once
+            "position", sol::property([](TransformComponent& self) { return LuaTransformVector{&self, &TransformComponent::Position}; },
+                                      [](TransformComponent& self, const LuaTransformVector& other) { SetTransformVector(self, &TransformComponent::Position, (*other.Transform).*other.Vector); }),
+            "rotation", sol::property([](TransformComponent& self) { return LuaTransformVector{&self, &TransformComponent::Rotation}; },
+                                      [](TransformComponent& self, const LuaTransformVector& other) { SetTransformVector(self, &TransformComponent::Rotation, (*other.Transform).*other.Vector); }),
+            "scale", sol::property([](TransformComponent& self) { return LuaTransformVector{&self, &TransformComponent::Scale}; },
+                                   [](TransformComponent& self, const LuaTransformVector& other) { SetTransformVector(self, &TransformComponent::Scale, (*other.Transform).*other.Vector); }),
+            "set_position", [](TransformComponent& self, float x, float y, float z) { SetTransformVector(self, &TransformComponent::Position, {x, y, z}); },
+            "set_rotation", [](TransformComponent& self, float x, float y, float z) { SetTransformVector(self, &TransformComponent::Rotation, {x, y, z}); },
+            "set_scale", [](TransformComponent& self, float x, float y, float z) { SetTransformVector(self, &TransformComponent::Scale, {x, y, z}); },
             "get_local_transform", &TransformComponent::GetLocalTransform,
             "set_local_transform", &TransformComponent::SetLocalTransform,
             "get_world_transform", &TransformComponent::GetWorldTransform,
@@ -301,6 +301,15 @@ TransformComponent = {
     Position = {0.0, 0.0, 0.0},
     Rotation = {0.0, 0.0, 0.0},
     Scale = {1.0, 1.0, 1.0},
+    SetPosition = function(x, y, z)
+        -- Implementation here
+    end,
+    SetRotation = function(x, y, z)
+        -- Implementation here
+    end,
+    SetScale = function(x, y, z)
+        -- Implementation here
+    end,
     GetLocalTransform = function()
         -- Implementation here
         return {}
@@ -345,6 +354,52 @@ LightComponent = {
     type = 0
 }
 
+-- Spatial query functions, they only find the entities with a mesh
+-- The hits are tables with the entity, the distance and the x, y and z of the hit point, sorted by distance
+spatial = {
+    raycast = function(ox, oy, oz, dx, dy, dz, max_distance, max_hits)
+        -- Implementation here
+        return {}
+    end,
+    segment_cast = function(sx, sy, sz, ex, ey, ez, max_hits)
+        -- Implementation here
+        return {}
+    end,
+    overlap_box = function(min_x, min_y, min_z, max_x, max_y, max_z, max_results)
+        -- Implementation here
+        return {}
+    end,
+    overlap_sphere = function(x, y, z, radius, max_results)
+        -- Implementation here
+        return {}
+    end,
+    nearest = function(x, y, z, k, max_distance)
+        -- Implementation here
+        return {}
+    end
+}
+
+-- Command buffer functions, the changes are recorded and applied after the scripts of the frame, in the order they were made
+-- A created entity can be used by the following commands right away, it has no components until the changes are applied
+commands = {
+    create_entity = function(name)
+        -- Implementation here
+        return Entity
+    end,
+    destroy_entity = function(entity)
+        -- Implementation here
+    end,
+    set_parent = function(entity, parent)
+        -- Implementation here
+    end,
+    add_component = function(entity, componentName)
+        -- Implementation here
+    end,
+    remove_component = function(entity, componentName)
+        -- Implementation here
+    end
+}
+
 -- Entity functions
 Entity = {
     AddComponent = function(self, componentName)
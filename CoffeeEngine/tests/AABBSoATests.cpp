@@ -0,0 +1,24 @@
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <gtest/gtest.h>
+
+using namespace Coffee;
+
+TEST(AABBSoA, SwapRemoveMovesTheLastBox)
+{
+    AABBSoA bounds;
+    bounds.PushBack(AABB({0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}));
+    bounds.PushBack(AABB({2.0f, 2.0f, 2.0f}, {3.0f, 3.0f, 3.0f}));
+    bounds.PushBack(AABB({4.0f, 4.0f, 4.0f}, {5.0f, 5.0f, 5.0f}));
+
+    bounds.SwapRemove(0);
+
+    ASSERT_EQ(bounds.Size(), 2u);
+    EXPECT_EQ(bounds.Get(0).min, glm::vec3(4.0f));
+    EXPECT_EQ(bounds.Get(0).max, glm::vec3(5.0f));
+    EXPECT_EQ(bounds.Get(1).min, glm::vec3(2.0f));
+
+    bounds.SwapRemove(1);
+    bounds.SwapRemove(0);
+    EXPECT_TRUE(bounds.Empty());
+}
@@ -0,0 +1,242 @@
+#include "CoffeeEngine/Core/DataStructures/DynamicAABBTree.h"
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Math/Frustum.h"
+
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+namespace {
+
+    AABB RandomBox(std::mt19937& random, float extent)
+    {
+        std::uniform_real_distribution<float> position(-extent, extent);
+        std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+        glm::vec3 min(position(random), position(random), position(random));
+        return AABB(min, min + glm::vec3(size(random), size(random), size(random)));
+    }
+
+    bool Overlaps(const AABB& a, const AABB& b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::lessThanEqual(b.min, a.max));
+    }
+
+    std::vector<uint32_t> BruteForce(const std::vector<AABB>& boxes, const std::vector<bool>& alive, const AABB& query)
+    {
+        std::vector<uint32_t> ids;
+        for (uint32_t id = 0; id < boxes.size(); id++)
+        {
+            if (alive[id] && Overlaps(boxes[id], query))
+                ids.push_back(id);
+        }
+        return ids;
+    }
+
+    std::vector<uint32_t> Sorted(std::vector<uint32_t> ids)
+    {
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    // Orthographic view of the box x, y in [-10, 10] and z in [-100, -0.1], its planes are the faces of the box
+    Frustum CreateTestFrustum()
+    {
+        glm::mat4 projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        return Frustum(projection * view);
+    }
+
+}
+
+TEST(DynamicAABBTree, AABBQueryMatchesBruteForce)
+{
+    std::mt19937 random(1234);
+
+    // Without margin the enlarged bounds are the bounds, so the results are exact
+    DynamicAABBTree tree(0.0f);
+    std::vector<AABB> boxes;
+    for (uint32_t id = 0; id < 500; id++)
+    {
+        boxes.push_back(RandomBox(random, 50.0f));
+        tree.Insert(id, boxes.back());
+    }
+    std::vector<bool> alive(boxes.size(), true);
+
+    EXPECT_EQ(tree.GetObjectCount(), 500u);
+
+    for (int i = 0; i < 50; i++)
+    {
+        AABB query = RandomBox(random, 50.0f);
+        query.max += glm::vec3(10.0f);
+
+        std::vector<uint32_t> ids;
+        tree.Query(query, ids);
+        EXPECT_EQ(Sorted(ids), BruteForce(boxes, alive, query));
+    }
+}
+
+TEST(DynamicAABBTree, QueriesFollowMovesAndRemoves)
+{
+    std::mt19937 random(5678);
+
+    DynamicAABBTree tree(0.0f);
+    std::vector<AABB> boxes;
+    for (uint32_t id = 0; id < 300; id++)
+    {
+        boxes.push_back(RandomBox(random, 50.0f));
+        tree.Insert(id, boxes.back());
+    }
+    std::vector<bool> alive(boxes.size(), true);
+
+    for (uint32_t id = 0; id < boxes.size(); id += 3)
+    {
+        boxes[id] = RandomBox(random, 50.0f);
+        tree.Move(id, boxes[id]);
+    }
+    for (uint32_t id = 1; id < boxes.size(); id += 5)
+    {
+        tree.Remove(id);
+        alive[id] = false;
+    }
+
+    EXPECT_FALSE(tree.Contains(1));
+    EXPECT_TRUE(tree.Contains(0));
+
+    for (int i = 0; i < 50; i++)
+    {
+        AABB query = RandomBox(random, 50.0f);
+        query.max += glm::vec3(15.0f);
+
+        std::vector<uint32_t> ids;
+        tree.Query(query, ids);
+        EXPECT_EQ(Sorted(ids), BruteForce(boxes, alive, query));
+    }
+}
+
+TEST(DynamicAABBTree, FrustumQueryReturnsTheVisibleObjects)
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> xy(-25.0f, 25.0f);
+    std::uniform_real_distribution<float> z(-120.0f, 20.0f);
+
+    const Frustum frustum = CreateTestFrustum();
+    const AABB visibleRegion({-10.0f, -10.0f, -100.0f}, {10.0f, 10.0f, -0.1f});
+
+    DynamicAABBTree tree(0.0f);
+    std::vector<uint32_t> expected;
+    uint32_t id = 0;
+    while (id < 400)
+    {
+        glm::vec3 center(xy(random), xy(random), z(random));
+        AABB box(center - glm::vec3(0.5f), center + glm::vec3(0.5f));
+
+        // The boxes near a face could go either way, only the clear cases are checked
+        AABB shrunk(visibleRegion.min + glm::vec3(1.0f), visibleRegion.max - glm::vec3(1.0f));
+        AABB grown(visibleRegion.min - glm::vec3(1.0f), visibleRegion.max + glm::vec3(1.0f));
+        bool inside = glm::all(glm::greaterThanEqual(box.min, shrunk.min)) && glm::all(glm::lessThanEqual(box.max, shrunk.max));
+        if (!inside && Overlaps(box, grown))
+            continue;
+
+        if (inside)
+            expected.push_back(id);
+
+        tree.Insert(id++, box);
+    }
+
+    ASSERT_FALSE(expected.empty());
+
+    std::vector<uint32_t> ids;
+    tree.Query(frustum, ids);
+    EXPECT_EQ(Sorted(ids), expected);
+}
+
+TEST(DynamicAABBTree, CoherentFrustumQueryMatchesTheFullQuery)
+{
+    std::mt19937 random(77);
+
+    DynamicAABBTree tree(0.0f);
+    std::vector<AABB> boxes;
+    for (uint32_t id = 0; id < 300; id++)
+    {
+        boxes.push_back(RandomBox(random, 60.0f));
+        boxes.back().min.z -= 60.0f;
+        boxes.back().max.z -= 60.0f;
+        tree.Insert(id, boxes.back());
+    }
+
+    const Frustum frustum = CreateTestFrustum();
+    FrustumCoherence coherence;
+
+    auto expectSameResult = [&](const Frustum& view) {
+        std::vector<uint32_t> full;
+        tree.Query(view, full);
+
+        std::vector<uint32_t> coherent;
+        tree.Query(view, coherent, &coherence);
+        EXPECT_EQ(Sorted(coherent), Sorted(full));
+    };
+
+    expectSameResult(frustum);
+
+    // Nothing changed, the last result is reused
+    expectSameResult(frustum);
+
+    // A move changes the version of the tree, the cached result must not be reused
+    tree.Move(0, AABB({-1.0f, -1.0f, -50.0f}, {1.0f, 1.0f, -48.0f}));
+    tree.Move(1, AABB({500.0f, 500.0f, 500.0f}, {501.0f, 501.0f, 501.0f}));
+    expectSameResult(frustum);
+
+    // So does a different frustum, the cached planes only change the test order
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(5.0f, 0.0f, 0.0f), glm::vec3(5.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    expectSameResult(Frustum(projection * view));
+    expectSameResult(frustum);
+}
+
+TEST(DynamicAABBTree, RayCastFindsTheClosestHit)
+{
+    DynamicAABBTree tree(0.0f);
+    tree.Insert(0, AABB({10.0f, -1.0f, -1.0f}, {12.0f, 1.0f, 1.0f}));
+    tree.Insert(1, AABB({4.0f, -1.0f, -1.0f}, {6.0f, 1.0f, 1.0f}));
+    tree.Insert(2, AABB({20.0f, -1.0f, -1.0f}, {22.0f, 1.0f, 1.0f}));
+    tree.Insert(3, AABB({4.0f, 5.0f, -1.0f}, {6.0f, 7.0f, 1.0f}));
+
+    uint32_t closest = ~0u;
+    float closestDistance = 0.0f;
+    tree.RayCast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, [&](uint32_t id, float distance) {
+        closest = id;
+        closestDistance = distance;
+        return distance;
+    });
+
+    EXPECT_EQ(closest, 1u);
+    EXPECT_FLOAT_EQ(closestDistance, 4.0f);
+}
+
+TEST(DynamicAABBTree, NearestVisitsTheObjectsInRange)
+{
+    DynamicAABBTree tree(0.0f);
+    tree.Insert(0, AABB({3.0f, 0.0f, 0.0f}, {4.0f, 1.0f, 1.0f}));
+    tree.Insert(1, AABB({1.0f, 0.0f, 0.0f}, {2.0f, 1.0f, 1.0f}));
+    tree.Insert(2, AABB({50.0f, 0.0f, 0.0f}, {51.0f, 1.0f, 1.0f}));
+
+    // Shrinking the range to the closest distance found keeps only the nearest object
+    uint32_t nearest = ~0u;
+    tree.Nearest(glm::vec3(0.0f), 100.0f, [&](uint32_t id, float distanceSquared) {
+        nearest = id;
+        return distanceSquared;
+    });
+    EXPECT_EQ(nearest, 1u);
+
+    std::vector<uint32_t> ids;
+    tree.Nearest(glm::vec3(0.0f), 25.0f, [&](uint32_t id, float) {
+        ids.push_back(id);
+        return 25.0f;
+    });
+    EXPECT_EQ(Sorted(ids), (std::vector<uint32_t>{0, 1}));
+}
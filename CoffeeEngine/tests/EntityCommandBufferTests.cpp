@@ -0,0 +1,96 @@
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/EntityCommandBuffer.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <gtest/gtest.h>
+
+using namespace Coffee;
+
+TEST(EntityCommandBuffer, CreatedEntitiesGetTheirComponentsOnPlayback)
+{
+    Scene scene;
+    EntityCommandBuffer& commands = scene.GetCommandBuffer();
+
+    Entity entity = commands.CreateEntity("Projectile");
+    EXPECT_FALSE(entity.HasComponent<TagComponent>());
+    EXPECT_FALSE(commands.IsEmpty());
+
+    commands.Playback();
+
+    EXPECT_TRUE(commands.IsEmpty());
+    ASSERT_TRUE(entity.HasComponent<TagComponent>());
+    EXPECT_EQ(entity.GetComponent<TagComponent>().Tag, "Projectile");
+    EXPECT_TRUE(entity.HasComponent<TransformComponent>());
+    EXPECT_TRUE(entity.HasComponent<HierarchyComponent>());
+}
+
+TEST(EntityCommandBuffer, ComponentCommandsRunInRecordingOrder)
+{
+    Scene scene;
+    Entity kept = scene.CreateEntity("Kept");
+    Entity dropped = scene.CreateEntity("Dropped");
+    kept.AddComponent<LightComponent>();
+
+    EntityCommandBuffer& commands = scene.GetCommandBuffer();
+    commands.RemoveComponent<LightComponent>(kept);
+    commands.AddComponent<LightComponent>(kept);
+    commands.AddComponent<LightComponent>(dropped);
+    commands.RemoveComponent<LightComponent>(dropped);
+    commands.Playback();
+
+    EXPECT_TRUE(kept.HasComponent<LightComponent>());
+    EXPECT_FALSE(dropped.HasComponent<LightComponent>());
+}
+
+TEST(EntityCommandBuffer, CommandsOnACreatedEntityRunAfterItsCreation)
+{
+    Scene scene;
+    EntityCommandBuffer& commands = scene.GetCommandBuffer();
+
+    Entity first = commands.CreateEntity("First");
+    commands.AddComponent<LightComponent>(first);
+    Entity second = commands.CreateEntity("Second");
+    commands.SetParent(second, first);
+    commands.Playback();
+
+    EXPECT_TRUE(first.HasComponent<LightComponent>());
+    EXPECT_EQ(second.GetComponent<HierarchyComponent>().m_Parent, (entt::entity)first);
+    EXPECT_EQ(first.GetComponent<HierarchyComponent>().m_First, (entt::entity)second);
+}
+
+TEST(EntityCommandBuffer, ReparentingAfterADestroyDoesNotDestroyTheChild)
+{
+    Scene scene;
+    Entity parent = scene.CreateEntity("Parent");
+    Entity child = scene.CreateEntity("Child");
+    Entity destroyedChild = scene.CreateEntity("DestroyedChild");
+    destroyedChild.SetParent(parent);
+
+    // Played back out of order, the reparenting would attach the child to the parent before its destruction
+    EntityCommandBuffer& commands = scene.GetCommandBuffer();
+    commands.DestroyEntity(parent);
+    commands.SetParent(child, parent);
+    commands.Playback();
+
+    EXPECT_FALSE(parent.IsValid());
+    EXPECT_FALSE(destroyedChild.IsValid());
+    ASSERT_TRUE(child.IsValid());
+    EXPECT_EQ(child.GetComponent<HierarchyComponent>().m_Parent, entt::entity{entt::null});
+}
+
+TEST(EntityCommandBuffer, CommandsOnADestroyedEntityAreSkipped)
+{
+    Scene scene;
+    Entity entity = scene.CreateEntity("Entity");
+
+    EntityCommandBuffer& commands = scene.GetCommandBuffer();
+    commands.DestroyEntity(entity);
+    commands.AddComponent<LightComponent>(entity);
+    commands.DestroyEntity(entity);
+    commands.Playback();
+
+    EXPECT_FALSE(entity.IsValid());
+    EXPECT_TRUE(commands.IsEmpty());
+}
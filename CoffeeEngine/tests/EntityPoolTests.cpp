@@ -0,0 +1,128 @@
+#include "CoffeeEngine/Renderer/Model.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/EntityPool.h"
+#include "CoffeeEngine/Scene/Prefab.h"
+#include "CoffeeEngine/Scene/Scene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+
+using namespace Coffee;
+
+namespace {
+
+    // A model without meshes compiles to a prefab of one node, enough for the pool bookkeeping
+    Ref<Prefab> CreateTestPrefab()
+    {
+        return CreateRef<Prefab>(CreateRef<Model>());
+    }
+
+}
+
+TEST(EntityPool, SpawnGrowsAndDespawnRecycles)
+{
+    Ref<Scene> scene = CreateRef<Scene>();
+    Ref<Prefab> prefab = CreateTestPrefab();
+
+    EntityPool& pool = scene->GetEntityPool(prefab);
+    pool.SetGrowSize(4);
+
+    Entity spawned = pool.Spawn(glm::translate(glm::mat4(1.0f), {1.0f, 2.0f, 3.0f}));
+    EXPECT_EQ(pool.GetStats().Capacity, 4u);
+    EXPECT_EQ(pool.GetStats().Active, 1u);
+    EXPECT_EQ(pool.GetStats().Grows, 1u);
+    EXPECT_EQ(pool.GetFreeCount(), 3u);
+    EXPECT_FALSE(spawned.HasComponent<InactiveComponent>());
+    EXPECT_FLOAT_EQ(spawned.GetComponent<TransformComponent>().Position.y, 2.0f);
+
+    pool.Despawn(spawned);
+    EXPECT_TRUE(spawned.IsValid());
+    EXPECT_TRUE(spawned.HasComponent<InactiveComponent>());
+    EXPECT_EQ(pool.GetStats().Active, 0u);
+    EXPECT_EQ(pool.GetFreeCount(), 4u);
+
+    // The last despawned instance is the next one spawned, without growing again
+    Entity respawned = pool.Spawn(glm::mat4(1.0f));
+    EXPECT_EQ((entt::entity)respawned, (entt::entity)spawned);
+    EXPECT_FALSE(respawned.HasComponent<InactiveComponent>());
+    EXPECT_EQ(pool.GetStats().Grows, 1u);
+    EXPECT_EQ(pool.GetStats().Spawns, 2u);
+    EXPECT_EQ(pool.GetStats().Despawns, 1u);
+}
+
+TEST(EntityPool, ReservedInstancesStartInactive)
+{
+    Ref<Scene> scene = CreateRef<Scene>();
+    Ref<Prefab> prefab = CreateTestPrefab();
+
+    EntityPool& pool = scene->GetEntityPool(prefab);
+    pool.Reserve(8);
+
+    EXPECT_EQ(pool.GetStats().Capacity, 8u);
+    EXPECT_EQ(pool.GetStats().Grows, 0u);
+    EXPECT_EQ(pool.GetFreeCount(), 8u);
+
+    EXPECT_EQ(scene->GetAllEntitiesWithComponents<InactiveComponent>().size(), 8u);
+}
+
+TEST(EntityPool, InstancesDestroyedOutsideThePoolAreForgotten)
+{
+    Ref<Scene> scene = CreateRef<Scene>();
+    Ref<Prefab> prefab = CreateTestPrefab();
+
+    EntityPool& pool = scene->GetEntityPool(prefab);
+    pool.SetGrowSize(2);
+
+    Entity active = pool.Spawn(glm::mat4(1.0f));
+    Entity free = pool.Spawn(glm::mat4(1.0f));
+    pool.Despawn(free);
+
+    scene->DestroyEntity(active);
+    EXPECT_EQ(pool.GetStats().Capacity, 1u);
+    EXPECT_EQ(pool.GetStats().Active, 0u);
+    EXPECT_EQ(pool.GetFreeCount(), 1u);
+
+    scene->DestroyEntity(free);
+    EXPECT_EQ(pool.GetStats().Capacity, 0u);
+    EXPECT_EQ(pool.GetFreeCount(), 0u);
+
+    // The destroyed handles are never handed out again
+    Entity spawned = pool.Spawn(glm::mat4(1.0f));
+    EXPECT_TRUE(spawned.IsValid());
+    EXPECT_EQ(pool.GetStats().Grows, 2u);
+    EXPECT_EQ(pool.GetStats().Active, 1u);
+}
+
+TEST(EntityPool, CopiedSceneKeepsItsPools)
+{
+    Ref<Scene> scene = CreateRef<Scene>();
+    Ref<Prefab> prefab = CreateTestPrefab();
+
+    EntityPool& pool = scene->GetEntityPool(prefab);
+    pool.SetGrowSize(4);
+    Entity active = pool.Spawn(glm::mat4(1.0f));
+    Entity despawned = pool.Spawn(glm::mat4(1.0f));
+    pool.Despawn(despawned);
+
+    Ref<Scene> copy = Scene::Copy(scene);
+    ASSERT_EQ(copy->GetEntityPools().size(), 1u);
+
+    EntityPool& copiedPool = copy->GetEntityPool(prefab);
+    EXPECT_EQ(copiedPool.GetStats().Capacity, 4u);
+    EXPECT_EQ(copiedPool.GetStats().Active, 1u);
+    EXPECT_EQ(copiedPool.GetFreeCount(), 3u);
+    EXPECT_EQ(copiedPool.GetGrowSize(), 4u);
+
+    Entity copiedActive{(entt::entity)active, copy.get()};
+    Entity copiedDespawned{(entt::entity)despawned, copy.get()};
+    EXPECT_FALSE(copiedActive.HasComponent<InactiveComponent>());
+    EXPECT_TRUE(copiedDespawned.HasComponent<InactiveComponent>());
+
+    // The copy recycles its own instances, the original pool is untouched
+    Entity spawned = copiedPool.Spawn(glm::mat4(1.0f));
+    EXPECT_EQ((entt::entity)spawned, (entt::entity)despawned);
+    EXPECT_EQ(copiedPool.GetStats().Grows, 1u);
+    EXPECT_EQ(pool.GetStats().Active, 1u);
+    EXPECT_TRUE(despawned.HasComponent<InactiveComponent>());
+}
@@ -0,0 +1,124 @@
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Math/Frustum.h"
+#include "CoffeeEngine/Renderer/CullingService.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+namespace {
+
+    // Orthographic view of the box x, y in [-10, 10] and z in [-100, -0.1] moved by an offset on x
+    Frustum CreateTestFrustum(float offsetX)
+    {
+        glm::mat4 projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
+        glm::vec3 eye(offsetX, 0.0f, 0.0f);
+        glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        return Frustum(projection * view);
+    }
+
+    // Boxes that are clearly inside or outside the views, with the expected visibility of each one per view
+    struct TestBounds
+    {
+        AABBSoA Bounds;
+        std::vector<std::vector<uint32_t>> Visible;
+    };
+
+    TestBounds CreateTestBounds(const std::vector<float>& offsets, uint32_t count)
+    {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> x(-40.0f, 40.0f);
+        std::uniform_real_distribution<float> y(-25.0f, 25.0f);
+        std::uniform_real_distribution<float> z(-120.0f, 20.0f);
+
+        TestBounds result;
+        result.Visible.resize(offsets.size());
+
+        while (result.Bounds.Size() < count)
+        {
+            glm::vec3 center(x(random), y(random), z(random));
+            AABB box(center - glm::vec3(0.5f), center + glm::vec3(0.5f));
+
+            bool clear = true;
+            std::vector<bool> inside(offsets.size());
+            for (size_t view = 0; view < offsets.size(); view++)
+            {
+                glm::vec3 regionMin(offsets[view] - 10.0f, -10.0f, -100.0f);
+                glm::vec3 regionMax(offsets[view] + 10.0f, 10.0f, -0.1f);
+
+                inside[view] = glm::all(glm::greaterThanEqual(box.min, regionMin + 1.0f)) &&
+                               glm::all(glm::lessThanEqual(box.max, regionMax - 1.0f));
+                bool outside = glm::any(glm::greaterThan(box.min, regionMax + 1.0f)) ||
+                               glm::any(glm::lessThan(box.max, regionMin - 1.0f));
+                clear = clear && (inside[view] || outside);
+            }
+
+            if (!clear)
+                continue;
+
+            for (size_t view = 0; view < offsets.size(); view++)
+            {
+                if (inside[view])
+                    result.Visible[view].push_back(static_cast<uint32_t>(result.Bounds.Size()));
+            }
+            result.Bounds.PushBack(box);
+        }
+
+        return result;
+    }
+
+}
+
+TEST(Frustum, CullMaskMatchesTheVisibleBoxes)
+{
+    // Not a multiple of 64, so the last word of the mask is partial
+    TestBounds test = CreateTestBounds({0.0f}, 200);
+    const Frustum frustum = CreateTestFrustum(0.0f);
+
+    std::vector<uint64_t> mask;
+    frustum.Cull(test.Bounds, mask);
+    ASSERT_EQ(mask.size(), 4u);
+
+    std::vector<uint32_t> visible;
+    for (uint32_t i = 0; i < test.Bounds.Size(); i++)
+    {
+        if (mask[i / 64] & (1ull << (i % 64)))
+            visible.push_back(i);
+
+        EXPECT_EQ(frustum.Contains(test.Bounds, i), ((mask[i / 64] >> (i % 64)) & 1) != 0) << "Box " << i;
+    }
+
+    EXPECT_EQ(visible, test.Visible[0]);
+}
+
+TEST(CullingService, CullsEveryViewInChunks)
+{
+    CullingSettings previous = CullingService::GetSettings();
+    CullingService::GetSettings().ChunkSize = 64;
+
+    const std::vector<float> offsets = {0.0f, 25.0f, -25.0f};
+    TestBounds test = CreateTestBounds(offsets, 1000);
+
+    std::vector<CullingView> views(offsets.size());
+    for (size_t view = 0; view < offsets.size(); view++)
+    {
+        views[view].ViewFrustum = CreateTestFrustum(offsets[view]);
+    }
+
+    CullingService::Cull(test.Bounds, views);
+
+    for (size_t view = 0; view < offsets.size(); view++)
+    {
+        EXPECT_EQ(views[view].VisibleIndices, test.Visible[view]) << "View " << view;
+    }
+
+    // The results of the previous call are replaced
+    AABBSoA empty;
+    CullingService::Cull(empty, views);
+    EXPECT_TRUE(views[0].VisibleIndices.empty());
+
+    CullingService::GetSettings() = previous;
+}
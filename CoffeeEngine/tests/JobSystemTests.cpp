@@ -0,0 +1,45 @@
+#include "CoffeeEngine/Core/JobSystem.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace Coffee;
+
+TEST(JobSystem, WaitNeverRunsBackgroundJobs)
+{
+    JobSystem::Init(1);
+
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<bool> release = false;
+    std::thread::id backgroundThread;
+
+    // Busy until the frame jobs are done, the main thread would be stuck in it if Wait picked it
+    JobCounter backgroundCounter;
+    JobSystem::SubmitBackground([&]() {
+        backgroundThread = std::this_thread::get_id();
+        while (!release.load())
+            std::this_thread::yield();
+    }, &backgroundCounter);
+
+    std::atomic<uint32_t> batches = 0;
+    JobSystem::ParallelFor(64, 1, [&](uint32_t begin, uint32_t end) { batches += end - begin; });
+    EXPECT_EQ(batches.load(), 64u);
+
+    release = true;
+    JobSystem::Wait(backgroundCounter);
+    EXPECT_NE(backgroundThread, mainThread);
+
+    JobSystem::Shutdown();
+}
+
+TEST(JobSystem, JobsRunInPlaceWithoutWorkers)
+{
+    uint32_t executed = 0;
+    JobCounter counter;
+    JobSystem::Submit([&]() { executed++; }, &counter);
+    JobSystem::SubmitBackground([&]() { executed++; }, &counter);
+
+    EXPECT_TRUE(counter.IsDone());
+    EXPECT_EQ(executed, 2u);
+}
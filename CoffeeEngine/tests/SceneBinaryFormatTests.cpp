@@ -0,0 +1,279 @@
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneBinaryFormat.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace Coffee;
+
+namespace {
+
+    struct TestScene
+    {
+        Ref<Scene> Source;
+        entt::entity Root;
+        entt::entity Child;
+        entt::entity Camera;
+        entt::entity Inactive;
+    };
+
+    TestScene CreateTestScene()
+    {
+        TestScene test;
+        test.Source = CreateRef<Scene>();
+
+        Entity root = test.Source->CreateEntity("Root");
+        root.GetComponent<TransformComponent>().Position = {1.0f, 2.0f, 3.0f};
+
+        Entity child = test.Source->CreateEntity("Child");
+        child.GetComponent<TransformComponent>().Position = {-4.0f, 5.0f, 0.5f};
+        child.SetParent(root);
+
+        LightComponent& light = child.AddComponent<LightComponent>();
+        light.Color = {1.0f, 0.5f, 0.25f};
+        light.Range = 12.0f;
+        light.type = static_cast<int>(LightComponent::PointLight);
+
+        Entity camera = test.Source->CreateEntity("Camera");
+        camera.AddComponent<CameraComponent>();
+
+        Entity inactive = test.Source->CreateEntity("Inactive");
+
+        // The tag has no data, Entity::AddComponent can not return a reference to it
+        test.Source->GetCommandBuffer().AddComponent<InactiveComponent>(inactive);
+        test.Source->GetCommandBuffer().Playback();
+
+        test.Root = root;
+        test.Child = child;
+        test.Camera = camera;
+        test.Inactive = inactive;
+        return test;
+    }
+
+    void ExpectSameScene(const TestScene& test, const Ref<Scene>& loaded)
+    {
+        Entity root{test.Root, loaded.get()};
+        Entity child{test.Child, loaded.get()};
+        Entity camera{test.Camera, loaded.get()};
+        Entity inactive{test.Inactive, loaded.get()};
+
+        // The handles are kept, so the references between entities stay valid
+        ASSERT_TRUE(root.IsValid());
+        ASSERT_TRUE(child.IsValid());
+        ASSERT_TRUE(camera.IsValid());
+        ASSERT_TRUE(inactive.IsValid());
+
+        EXPECT_EQ(root.GetComponent<TagComponent>().Tag, "Root");
+        EXPECT_EQ(child.GetComponent<TagComponent>().Tag, "Child");
+        EXPECT_EQ(root.GetComponent<TransformComponent>().Position, glm::vec3(1.0f, 2.0f, 3.0f));
+        EXPECT_EQ(child.GetComponent<TransformComponent>().Position, glm::vec3(-4.0f, 5.0f, 0.5f));
+
+        EXPECT_EQ(child.GetComponent<HierarchyComponent>().m_Parent, test.Root);
+        EXPECT_EQ(root.GetComponent<HierarchyComponent>().m_First, test.Child);
+
+        ASSERT_TRUE(child.HasComponent<LightComponent>());
+        const LightComponent& light = child.GetComponent<LightComponent>();
+        EXPECT_EQ(light.Color, glm::vec3(1.0f, 0.5f, 0.25f));
+        EXPECT_FLOAT_EQ(light.Range, 12.0f);
+        EXPECT_EQ(light.type, static_cast<int>(LightComponent::PointLight));
+
+        EXPECT_TRUE(camera.HasComponent<CameraComponent>());
+        EXPECT_TRUE(inactive.HasComponent<InactiveComponent>());
+        EXPECT_FALSE(root.HasComponent<InactiveComponent>());
+    }
+
+    std::filesystem::path GetTestPath(const std::string& fileName)
+    {
+        return std::filesystem::temp_directory_path() / fileName;
+    }
+
+    // Position of the entry of a block in the block table of a binary scene
+    size_t FindBlock(const std::filesystem::path& path, SceneBlockType type, SceneBlockHeader& block)
+    {
+        std::ifstream file(path, std::ios::binary);
+        SceneFileHeader header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        for (uint32_t i = 0; i < header.BlockCount; i++)
+        {
+            const size_t position = sizeof(SceneFileHeader) + i * sizeof(SceneBlockHeader);
+            file.seekg(position);
+            file.read(reinterpret_cast<char*>(&block), sizeof(block));
+            if (block.Type == static_cast<uint32_t>(type))
+                return position;
+        }
+
+        ADD_FAILURE() << "The scene has no block of type " << static_cast<uint32_t>(type);
+        return 0;
+    }
+
+    template<typename T>
+    void WriteAt(const std::filesystem::path& path, size_t position, const T& value)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(position);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Gives the second entity of a block the handle of the first one
+    void RepeatFirstEntity(const std::filesystem::path& path, SceneBlockType type)
+    {
+        SceneBlockHeader block{};
+        FindBlock(path, type, block);
+        ASSERT_GE(block.Count, 2u);
+
+        entt::entity first;
+        {
+            std::ifstream file(path, std::ios::binary);
+            file.seekg(block.Offset);
+            file.read(reinterpret_cast<char*>(&first), sizeof(first));
+        }
+        WriteAt(path, block.Offset + sizeof(entt::entity), first);
+    }
+
+}
+
+TEST(SceneBinaryFormat, BinaryRoundTrip)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.TeaSceneBin");
+    TestScene test = CreateTestScene();
+
+    ASSERT_TRUE(Scene::Save(path, test.Source));
+    EXPECT_TRUE(SceneBinaryFormat::IsBinary(path));
+
+    Ref<Scene> loaded = Scene::Load(path);
+    ExpectSameScene(test, loaded);
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, JsonRoundTrip)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.TeaScene");
+    TestScene test = CreateTestScene();
+
+    ASSERT_TRUE(Scene::Save(path, test.Source));
+    EXPECT_FALSE(SceneBinaryFormat::IsBinary(path));
+
+    Ref<Scene> loaded = Scene::Load(path);
+    ExpectSameScene(test, loaded);
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, RejectsOtherVersions)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.Version.TeaSceneBin");
+    TestScene test = CreateTestScene();
+    ASSERT_TRUE(Scene::Save(path, test.Source));
+
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t version = SceneBinaryFormat::Version + 1;
+        file.seekp(offsetof(SceneFileHeader, Version));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+
+    Scene scene;
+    EXPECT_FALSE(SceneBinaryFormat::Load(path, scene));
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, RejectsOtherFiles)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.Magic.TeaSceneBin");
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "Not a scene, only some text that is longer than the header of a binary scene file.";
+    }
+
+    EXPECT_FALSE(SceneBinaryFormat::IsBinary(path));
+
+    Scene scene;
+    EXPECT_FALSE(SceneBinaryFormat::Load(path, scene));
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, RejectsAnotherLayoutOfTheRequiredComponents)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.Layout.TeaSceneBin");
+    TestScene test = CreateTestScene();
+    ASSERT_TRUE(Scene::Save(path, test.Source));
+
+    SceneBlockHeader block{};
+    const size_t position = FindBlock(path, SceneBlockType::Transform, block);
+    WriteAt(path, position + offsetof(SceneBlockHeader, LayoutHash), block.LayoutHash ^ 1u);
+
+    // Nothing is loaded from a file without its transforms
+    Scene scene;
+    EXPECT_FALSE(SceneBinaryFormat::Load(path, scene));
+    EXPECT_FALSE(Entity(test.Root, &scene).IsValid());
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, SkipsAnotherLayoutOfTheOptionalComponents)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.LightLayout.TeaSceneBin");
+    TestScene test = CreateTestScene();
+    ASSERT_TRUE(Scene::Save(path, test.Source));
+
+    SceneBlockHeader block{};
+    const size_t position = FindBlock(path, SceneBlockType::Light, block);
+    WriteAt(path, position + offsetof(SceneBlockHeader, LayoutHash), block.LayoutHash ^ 1u);
+
+    Scene scene;
+    EXPECT_TRUE(SceneBinaryFormat::Load(path, scene));
+
+    Entity child(test.Child, &scene);
+    ASSERT_TRUE(child.IsValid());
+    EXPECT_FALSE(child.HasComponent<LightComponent>());
+    EXPECT_EQ(child.GetComponent<TransformComponent>().Position, glm::vec3(-4.0f, 5.0f, 0.5f));
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, RejectsRepeatedEntities)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.Repeated.TeaSceneBin");
+    TestScene test = CreateTestScene();
+
+    for (SceneBlockType type : {SceneBlockType::Entities, SceneBlockType::Hierarchy})
+    {
+        ASSERT_TRUE(Scene::Save(path, test.Source));
+        RepeatFirstEntity(path, type);
+
+        Scene scene;
+        EXPECT_FALSE(SceneBinaryFormat::Load(path, scene)) << "block " << static_cast<uint32_t>(type);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(SceneBinaryFormat, RejectsEntitiesOutOfRange)
+{
+    const std::filesystem::path path = GetTestPath("CoffeeEngineTests.Range.TeaSceneBin");
+    TestScene test = CreateTestScene();
+    ASSERT_TRUE(Scene::Save(path, test.Source));
+
+    // The last entity of the file is no longer below the range of the header
+    SceneFileHeader header{};
+    {
+        std::ifstream file(path, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    WriteAt(path, offsetof(SceneFileHeader, EntityRange), header.EntityRange - 1);
+
+    Scene scene;
+    EXPECT_FALSE(SceneBinaryFormat::Load(path, scene));
+
+    std::filesystem::remove(path);
+}
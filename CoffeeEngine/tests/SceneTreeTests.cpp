@@ -0,0 +1,238 @@
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+namespace {
+
+    glm::vec3 GetWorldPosition(Entity entity)
+    {
+        return glm::vec3(entity.GetComponent<TransformComponent>().GetWorldTransform()[3]);
+    }
+
+    void SetPosition(Entity entity, const glm::vec3& position)
+    {
+        TransformComponent& transform = entity.GetComponent<TransformComponent>();
+        transform.Position = position;
+        transform.MarkDirty();
+    }
+
+    std::vector<entt::entity> GetChanged(Scene& scene)
+    {
+        std::vector<entt::entity> changed = scene.GetSceneTree().GetChangedTransforms();
+        std::sort(changed.begin(), changed.end());
+        return changed;
+    }
+
+    std::vector<entt::entity> Sorted(std::vector<entt::entity> entities)
+    {
+        std::sort(entities.begin(), entities.end());
+        return entities;
+    }
+
+    glm::vec3 GetExpectedWorldPosition(Scene& scene, Entity entity)
+    {
+        glm::mat4 world = entity.GetComponent<TransformComponent>().GetLocalTransform();
+        for(entt::entity parent = entity.GetComponent<HierarchyComponent>().m_Parent; parent != entt::null;
+            parent = Entity(parent, &scene).GetComponent<HierarchyComponent>().m_Parent)
+        {
+            world = Entity(parent, &scene).GetComponent<TransformComponent>().GetLocalTransform() * world;
+        }
+        return glm::vec3(world[3]);
+    }
+
+    bool IsInSubtree(Scene& scene, Entity entity, Entity root)
+    {
+        for(entt::entity current = entity; current != entt::null;
+            current = Entity(current, &scene).GetComponent<HierarchyComponent>().m_Parent)
+        {
+            if(current == (entt::entity)root)
+                return true;
+        }
+        return false;
+    }
+
+    struct RebuildThresholdScope
+    {
+        RebuildThresholdScope(float threshold) : Previous(SceneTree::GetSettings().RebuildThreshold)
+        {
+            SceneTree::GetSettings().RebuildThreshold = threshold;
+        }
+        ~RebuildThresholdScope() { SceneTree::GetSettings().RebuildThreshold = Previous; }
+
+        float Previous;
+    };
+
+}
+
+TEST(SceneTree, MovingAParentMovesItsChildren)
+{
+    Scene scene;
+    Entity parent = scene.CreateEntity("Parent");
+    Entity child = scene.CreateEntity("Child");
+    Entity grandchild = scene.CreateEntity("Grandchild");
+    child.SetParent(parent);
+    grandchild.SetParent(child);
+
+    SetPosition(parent, {1.0f, 0.0f, 0.0f});
+    SetPosition(child, {0.0f, 2.0f, 0.0f});
+    SetPosition(grandchild, {0.0f, 0.0f, 3.0f});
+    scene.GetSceneTree().Update();
+
+    EXPECT_EQ(GetWorldPosition(grandchild), glm::vec3(1.0f, 2.0f, 3.0f));
+
+    // Only the parent is dirty, its world transform change reaches the whole subtree
+    SetPosition(parent, {5.0f, 0.0f, 0.0f});
+    scene.GetSceneTree().Update();
+
+    EXPECT_EQ(GetWorldPosition(child), glm::vec3(5.0f, 2.0f, 0.0f));
+    EXPECT_EQ(GetWorldPosition(grandchild), glm::vec3(5.0f, 2.0f, 3.0f));
+    EXPECT_EQ(GetChanged(scene), Sorted({parent, child, grandchild}));
+    EXPECT_FALSE(grandchild.GetComponent<TransformComponent>().IsDirty());
+}
+
+TEST(SceneTree, CleanSubtreesAreSkipped)
+{
+    Scene scene;
+    Entity moved = scene.CreateEntity("Moved");
+    Entity movedChild = scene.CreateEntity("MovedChild");
+    Entity still = scene.CreateEntity("Still");
+    Entity stillChild = scene.CreateEntity("StillChild");
+    movedChild.SetParent(moved);
+    stillChild.SetParent(still);
+    scene.GetSceneTree().Update();
+
+    // Nothing changed since the last update
+    scene.GetSceneTree().Update();
+    EXPECT_TRUE(scene.GetSceneTree().GetChangedTransforms().empty());
+
+    // Reading a transform does not dirty it
+    (void)still.GetComponent<TransformComponent>().Position;
+
+    SetPosition(moved, {0.0f, 1.0f, 0.0f});
+    scene.GetSceneTree().Update();
+    EXPECT_EQ(GetChanged(scene), Sorted({moved, movedChild}));
+
+    // A write that leaves the world transform as it was is not reported
+    SetPosition(stillChild, {0.0f, 0.0f, 0.0f});
+    scene.GetSceneTree().Update();
+    EXPECT_TRUE(scene.GetSceneTree().GetChangedTransforms().empty());
+    EXPECT_FALSE(stillChild.GetComponent<TransformComponent>().IsDirty());
+}
+
+TEST(SceneTree, ReparentingUsesTheNewParent)
+{
+    Scene scene;
+    Entity first = scene.CreateEntity("First");
+    Entity second = scene.CreateEntity("Second");
+    Entity child = scene.CreateEntity("Child");
+    SetPosition(first, {1.0f, 0.0f, 0.0f});
+    SetPosition(second, {0.0f, 0.0f, -4.0f});
+    SetPosition(child, {0.0f, 1.0f, 0.0f});
+    child.SetParent(first);
+    scene.GetSceneTree().Update();
+
+    EXPECT_EQ(GetWorldPosition(child), glm::vec3(1.0f, 1.0f, 0.0f));
+
+    child.SetParent(second);
+    scene.GetSceneTree().Update();
+
+    EXPECT_EQ(GetWorldPosition(child), glm::vec3(0.0f, 1.0f, -4.0f));
+    EXPECT_EQ(GetChanged(scene), std::vector<entt::entity>{(entt::entity)child});
+
+    // Detached, the child is a root again
+    child.SetParent(Entity());
+    scene.GetSceneTree().Update();
+
+    EXPECT_EQ(GetWorldPosition(child), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+TEST(SceneTree, RemovingATransformTakesTheSubtreeOut)
+{
+    RebuildThresholdScope scope(1000.0f);
+
+    Scene scene;
+    Entity parent = scene.CreateEntity("Parent");
+    Entity child = scene.CreateEntity("Child");
+    child.SetParent(parent);
+    SetPosition(parent, {1.0f, 0.0f, 0.0f});
+    scene.GetSceneTree().Update();
+
+    // Without a transform the parent can't place its children, they keep their last world transform
+    parent.RemoveComponent<TransformComponent>();
+    SetPosition(child, {0.0f, 1.0f, 0.0f});
+    scene.GetSceneTree().Update();
+
+    EXPECT_TRUE(scene.GetSceneTree().GetChangedTransforms().empty());
+    EXPECT_EQ(GetWorldPosition(child), glm::vec3(1.0f, 0.0f, 0.0f));
+
+    parent.AddComponent<TransformComponent>();
+    scene.GetSceneTree().Update();
+
+    EXPECT_EQ(GetWorldPosition(child), glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+TEST(SceneTree, StructuralChangesMatchTheHierarchy)
+{
+    // Once applied in place and once rebuilt on every change, both must give the same world transforms
+    for(float threshold : {1000.0f, 0.0f})
+    {
+        RebuildThresholdScope scope(threshold);
+
+        Scene scene;
+        std::vector<Entity> entities;
+        std::mt19937 random(7);
+
+        for(int frame = 0; frame < 200; frame++)
+        {
+            const uint32_t operation = entities.size() < 8 ? 0 : random() % 4;
+
+            if(operation == 0)
+            {
+                Entity entity = scene.CreateEntity("Entity");
+                SetPosition(entity, {float(random() % 5), float(random() % 5), float(random() % 5)});
+                if(!entities.empty() && random() % 4 != 0)
+                {
+                    entity.SetParent(entities[random() % entities.size()]);
+                }
+                entities.push_back(entity);
+            }
+            else if(operation == 1)
+            {
+                Entity root = entities[random() % entities.size()];
+                std::vector<Entity> kept;
+                for(Entity entity : entities)
+                {
+                    if(!IsInSubtree(scene, entity, root))
+                        kept.push_back(entity);
+                }
+                scene.DestroyEntity(root);
+                entities = kept;
+            }
+            else if(operation == 2)
+            {
+                Entity entity = entities[random() % entities.size()];
+                Entity parent = entities[random() % entities.size()];
+                entity.SetParent(IsInSubtree(scene, parent, entity) ? Entity() : parent);
+            }
+            else
+            {
+                SetPosition(entities[random() % entities.size()], {float(random() % 5), 0.0f, 1.0f});
+            }
+
+            scene.GetSceneTree().Update();
+
+            for(Entity entity : entities)
+            {
+                ASSERT_EQ(GetWorldPosition(entity), GetExpectedWorldPosition(scene, entity)) << "frame " << frame;
+            }
+        }
+    }
+}
@@ -0,0 +1,214 @@
+#include "CoffeeEngine/Core/DataStructures/SparseGrid.h"
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Math/Frustum.h"
+
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+namespace {
+
+    bool Overlaps(const AABB& a, const AABB& b)
+    {
+        return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::lessThanEqual(b.min, a.max));
+    }
+
+    std::vector<uint32_t> BruteForce(const std::vector<AABB>& boxes, const std::vector<bool>& alive, const AABB& query)
+    {
+        std::vector<uint32_t> ids;
+        for (uint32_t id = 0; id < boxes.size(); id++)
+        {
+            if (alive[id] && Overlaps(boxes[id], query))
+                ids.push_back(id);
+        }
+        return ids;
+    }
+
+    std::vector<uint32_t> Query(const SparseGrid& grid, const AABB& bounds)
+    {
+        std::vector<uint32_t> ids;
+        grid.Query(bounds, ids);
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+}
+
+TEST(SparseGrid, InsertAndRemove)
+{
+    SparseGrid grid(10.0f);
+    grid.Insert(0, AABB({1.0f, 1.0f, 1.0f}, {2.0f, 2.0f, 2.0f}));
+    grid.Insert(1, AABB({3.0f, 3.0f, 3.0f}, {4.0f, 4.0f, 4.0f}));
+    grid.Insert(2, AABB({25.0f, 1.0f, 1.0f}, {26.0f, 2.0f, 2.0f}));
+
+    EXPECT_EQ(grid.GetObjectCount(), 3u);
+    EXPECT_EQ(grid.GetCellCount(), 2u);
+    EXPECT_EQ(grid.GetCellCoord({25.5f, 1.5f, 1.5f}), glm::ivec3(2, 0, 0));
+    EXPECT_EQ(grid.GetCellCoord({-0.5f, 0.0f, 0.0f}), glm::ivec3(-1, 0, 0));
+
+    grid.Remove(2);
+    EXPECT_FALSE(grid.Contains(2));
+    EXPECT_EQ(grid.GetCellCount(), 1u);
+    EXPECT_TRUE(Query(grid, AABB({20.0f, 0.0f, 0.0f}, {30.0f, 5.0f, 5.0f})).empty());
+
+    // Removing the first object of a cell moves the last one into its slot
+    grid.Remove(0);
+    EXPECT_EQ(Query(grid, AABB(glm::vec3(0.0f), glm::vec3(5.0f))), std::vector<uint32_t>{1});
+
+    grid.Remove(1);
+    grid.Remove(1);
+    EXPECT_EQ(grid.GetObjectCount(), 0u);
+    EXPECT_EQ(grid.GetCellCount(), 0u);
+}
+
+TEST(SparseGrid, MoveInsideAndAcrossCells)
+{
+    SparseGrid grid(10.0f);
+    grid.Insert(0, AABB({1.0f, 1.0f, 1.0f}, {2.0f, 2.0f, 2.0f}));
+    grid.Insert(1, AABB({5.0f, 5.0f, 5.0f}, {6.0f, 6.0f, 6.0f}));
+
+    // Inside its cell only the bounds change
+    EXPECT_FALSE(grid.Move(0, AABB({7.0f, 1.0f, 1.0f}, {8.0f, 2.0f, 2.0f})));
+    EXPECT_EQ(Query(grid, AABB({7.5f, 1.5f, 1.5f}, {7.6f, 1.6f, 1.6f})), std::vector<uint32_t>{0});
+    EXPECT_TRUE(Query(grid, AABB({1.0f, 1.0f, 1.0f}, {2.0f, 2.0f, 2.0f})).empty());
+
+    EXPECT_TRUE(grid.Move(0, AABB({-15.0f, 1.0f, 1.0f}, {-14.0f, 2.0f, 2.0f})));
+    EXPECT_EQ(grid.GetCellCount(), 2u);
+    EXPECT_EQ(Query(grid, AABB({-20.0f, 0.0f, 0.0f}, {-10.0f, 5.0f, 5.0f})), std::vector<uint32_t>{0});
+    EXPECT_TRUE(Query(grid, AABB({7.0f, 1.0f, 1.0f}, {8.0f, 2.0f, 2.0f})).empty());
+
+    // Leaving the cell of the other object releases the emptied cell
+    EXPECT_TRUE(grid.Move(1, AABB({-16.0f, 1.0f, 1.0f}, {-15.5f, 2.0f, 2.0f})));
+    EXPECT_EQ(grid.GetCellCount(), 1u);
+    EXPECT_EQ(Query(grid, AABB({-20.0f, 0.0f, 0.0f}, {-10.0f, 5.0f, 5.0f})), (std::vector<uint32_t>{0, 1}));
+
+    // Moving an object that is not in the grid inserts it
+    EXPECT_TRUE(grid.Move(2, AABB({1.0f, 1.0f, 1.0f}, {2.0f, 2.0f, 2.0f})));
+    EXPECT_TRUE(grid.Contains(2));
+}
+
+TEST(SparseGrid, ObjectsReachingIntoTheNeighbourCells)
+{
+    SparseGrid grid(10.0f);
+
+    // The center is in the cell 0 but the bounds end in the cell 1
+    grid.Insert(0, AABB({6.0f, 1.0f, 1.0f}, {13.0f, 2.0f, 2.0f}));
+    ASSERT_EQ(grid.GetCellCoord(glm::vec3(9.5f, 1.5f, 1.5f)), glm::ivec3(0, 0, 0));
+
+    EXPECT_EQ(Query(grid, AABB({12.0f, 0.0f, 0.0f}, {19.0f, 5.0f, 5.0f})), std::vector<uint32_t>{0});
+    EXPECT_TRUE(Query(grid, AABB({13.5f, 0.0f, 0.0f}, {19.0f, 5.0f, 5.0f})).empty());
+
+    // Also across negative coordinates
+    grid.Insert(1, AABB({-3.0f, -3.0f, -3.0f}, {1.0f, 1.0f, 1.0f}));
+    EXPECT_EQ(Query(grid, AABB({0.5f, 0.5f, 0.5f}, {0.6f, 0.6f, 0.6f})), std::vector<uint32_t>{1});
+}
+
+TEST(SparseGrid, LargeObjectsAreAlwaysTested)
+{
+    SparseGrid grid(10.0f);
+
+    // Far bigger than a cell, its center cell is nowhere near the query
+    grid.Insert(0, AABB({-100.0f, -1.0f, -1.0f}, {100.0f, 1.0f, 1.0f}));
+    grid.Insert(1, AABB({90.0f, 5.0f, 5.0f}, {91.0f, 6.0f, 6.0f}));
+
+    EXPECT_EQ(Query(grid, AABB({90.0f, -2.0f, -2.0f}, {95.0f, 0.0f, 0.0f})), std::vector<uint32_t>{0});
+    EXPECT_EQ(Query(grid, AABB({85.0f, -2.0f, -2.0f}, {95.0f, 10.0f, 10.0f})), (std::vector<uint32_t>{0, 1}));
+    EXPECT_TRUE(Query(grid, AABB({101.0f, -2.0f, -2.0f}, {105.0f, 2.0f, 2.0f})).empty());
+
+    // Growing past the cell size moves an object to the large cell, shrinking brings it back
+    EXPECT_TRUE(grid.Move(1, AABB({-50.0f, 5.0f, 5.0f}, {91.0f, 6.0f, 6.0f})));
+    EXPECT_EQ(Query(grid, AABB({-45.0f, 5.0f, 5.0f}, {-44.0f, 6.0f, 6.0f})), std::vector<uint32_t>{1});
+
+    EXPECT_TRUE(grid.Move(1, AABB({90.0f, 5.0f, 5.0f}, {91.0f, 6.0f, 6.0f})));
+    EXPECT_TRUE(Query(grid, AABB({-45.0f, 5.0f, 5.0f}, {-44.0f, 6.0f, 6.0f})).empty());
+
+    grid.Remove(0);
+    EXPECT_TRUE(Query(grid, AABB({90.0f, -2.0f, -2.0f}, {95.0f, 0.0f, 0.0f})).empty());
+}
+
+TEST(SparseGrid, AABBQueryMatchesBruteForce)
+{
+    std::mt19937 random(99);
+    std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+    std::uniform_real_distribution<float> largeSize(12.0f, 40.0f);
+
+    SparseGrid grid(8.0f);
+    std::vector<AABB> boxes;
+    for (uint32_t id = 0; id < 600; id++)
+    {
+        glm::vec3 min(position(random), position(random), position(random));
+        glm::vec3 extent = id % 50 == 0 ? glm::vec3(largeSize(random)) : glm::vec3(size(random), size(random), size(random));
+        boxes.emplace_back(min, min + extent);
+        grid.Insert(id, boxes.back());
+    }
+    std::vector<bool> alive(boxes.size(), true);
+
+    for (uint32_t id = 0; id < boxes.size(); id += 4)
+    {
+        glm::vec3 min(position(random), position(random), position(random));
+        boxes[id] = AABB(min, min + glm::vec3(size(random)));
+        grid.Move(id, boxes[id]);
+    }
+    for (uint32_t id = 2; id < boxes.size(); id += 7)
+    {
+        grid.Remove(id);
+        alive[id] = false;
+    }
+
+    for (int i = 0; i < 100; i++)
+    {
+        // From smaller than a cell to several cells wide
+        glm::vec3 min(position(random), position(random), position(random));
+        AABB query(min, min + glm::vec3(size(random) * (i % 10 + 1)));
+
+        EXPECT_EQ(Query(grid, query), BruteForce(boxes, alive, query));
+    }
+}
+
+TEST(SparseGrid, FrustumQueryReturnsTheVisibleObjects)
+{
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> xy(-25.0f, 25.0f);
+    std::uniform_real_distribution<float> z(-120.0f, 20.0f);
+
+    // Orthographic view of the box x, y in [-10, 10] and z in [-100, -0.1]
+    glm::mat4 projection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum(projection * view);
+
+    const AABB shrunk({-9.0f, -9.0f, -99.0f}, {9.0f, 9.0f, -1.1f});
+    const AABB grown({-11.0f, -11.0f, -101.0f}, {11.0f, 11.0f, 0.9f});
+
+    SparseGrid grid(16.0f);
+    std::vector<uint32_t> expected;
+    uint32_t id = 0;
+    while (id < 400)
+    {
+        glm::vec3 center(xy(random), xy(random), z(random));
+        AABB box(center - glm::vec3(0.5f), center + glm::vec3(0.5f));
+
+        // The boxes near a face could go either way, only the clear cases are checked
+        bool inside = glm::all(glm::greaterThanEqual(box.min, shrunk.min)) && glm::all(glm::lessThanEqual(box.max, shrunk.max));
+        if (!inside && Overlaps(box, grown))
+            continue;
+
+        if (inside)
+            expected.push_back(id);
+
+        grid.Insert(id++, box);
+    }
+
+    // A large object that crosses the frustum
+    grid.Insert(id, AABB({-50.0f, -1.0f, -50.0f}, {50.0f, 1.0f, -40.0f}));
+    expected.push_back(id);
+
+    std::vector<uint32_t> ids;
+    grid.Query(frustum, ids);
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(ids, expected);
+}
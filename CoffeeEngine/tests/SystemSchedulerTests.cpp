@@ -0,0 +1,148 @@
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Scene/SystemScheduler.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace Coffee;
+
+namespace {
+
+    // Stand-ins for the components and resources the systems declare
+    struct Position {};
+    struct Velocity {};
+    struct Bounds {};
+    struct Health {};
+
+}
+
+TEST(SystemScheduler, SystemsWithoutConflictsShareALevel)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<Position>, Writes<Velocity>>("Steer", [](float) {});
+    scheduler.AddSystem<Reads<Position>, Writes<Health>>("Damage", [](float) {});
+    scheduler.Run(0.0f);
+
+    const std::vector<ScheduledSystem>& systems = scheduler.GetSystems();
+    EXPECT_EQ(scheduler.GetLevelCount(), 1u);
+    EXPECT_EQ(systems[0].Level, 0u);
+    EXPECT_EQ(systems[1].Level, 0u);
+    EXPECT_TRUE(systems[1].Dependencies.empty());
+}
+
+TEST(SystemScheduler, WriterRunsAfterAnEarlierReader)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<Position>>("Draw", [](float) {});
+    scheduler.AddSystem<Reads<Velocity>, Writes<Position>>("Move", [](float) {});
+    scheduler.Run(0.0f);
+
+    const std::vector<ScheduledSystem>& systems = scheduler.GetSystems();
+    EXPECT_EQ(scheduler.GetLevelCount(), 2u);
+    EXPECT_EQ(systems[1].Level, 1u);
+    EXPECT_EQ(systems[1].Dependencies, std::vector<uint32_t>{0});
+}
+
+TEST(SystemScheduler, ReaderRunsAfterAnEarlierWriter)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<Velocity>, Writes<Position>>("Move", [](float) {});
+    scheduler.AddSystem<Reads<Position>, Writes<Bounds>>("Bounds", [](float) {});
+    scheduler.AddSystem<Reads<Health>>("Unrelated", [](float) {});
+    scheduler.Run(0.0f);
+
+    const std::vector<ScheduledSystem>& systems = scheduler.GetSystems();
+    EXPECT_EQ(systems[1].Level, 1u);
+    EXPECT_EQ(systems[1].Dependencies, std::vector<uint32_t>{0});
+    EXPECT_EQ(systems[2].Level, 0u);
+}
+
+TEST(SystemScheduler, WritersOfTheSameTypeAreOrdered)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<>, Writes<Position>>("First", [](float) {});
+    scheduler.AddSystem<Reads<>, Writes<Position>>("Second", [](float) {});
+    scheduler.Run(0.0f);
+
+    EXPECT_EQ(scheduler.GetLevelCount(), 2u);
+    EXPECT_EQ(scheduler.GetSystems()[1].Level, 1u);
+}
+
+TEST(SystemScheduler, ExclusiveSystemSplitsTheLevels)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<Position>>("Before", [](float) {});
+    scheduler.AddSystem("Structural", [](float) {}, SystemFlags::Exclusive);
+    scheduler.AddSystem<Reads<Position>>("After", [](float) {});
+    scheduler.Run(0.0f);
+
+    const std::vector<ScheduledSystem>& systems = scheduler.GetSystems();
+    EXPECT_EQ(scheduler.GetLevelCount(), 3u);
+    EXPECT_EQ(systems[1].Level, 1u);
+    EXPECT_EQ(systems[2].Level, 2u);
+}
+
+TEST(SystemScheduler, LevelIsOneMoreThanTheDeepestDependency)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<>, Writes<Position>>("Move", [](float) {});
+    scheduler.AddSystem<Reads<Position>, Writes<Bounds>>("Bounds", [](float) {});
+    scheduler.AddSystem<Reads<>, Writes<Health>>("Damage", [](float) {});
+    scheduler.AddSystem<Reads<Bounds, Health>>("Draw", [](float) {});
+    scheduler.Run(0.0f);
+
+    const std::vector<ScheduledSystem>& systems = scheduler.GetSystems();
+    EXPECT_EQ(systems[2].Level, 0u);
+    EXPECT_EQ(systems[3].Level, 2u);
+    EXPECT_EQ(systems[3].Dependencies, (std::vector<uint32_t>{1, 2}));
+}
+
+TEST(SystemScheduler, ConflictingSystemsRunInRegistrationOrder)
+{
+    std::vector<std::string> order;
+
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<>, Writes<Position>>("Move", [&order](float) { order.push_back("Move"); });
+    scheduler.AddSystem<Reads<Position>, Writes<Bounds>>("Bounds", [&order](float) { order.push_back("Bounds"); });
+    scheduler.AddSystem<Reads<Bounds>>("Draw", [&order](float) { order.push_back("Draw"); }, SystemFlags::MainThread);
+    scheduler.Run(0.016f);
+
+    EXPECT_EQ(order, (std::vector<std::string>{"Move", "Bounds", "Draw"}));
+}
+
+TEST(SystemScheduler, RemovingASystemRebuildsTheGraph)
+{
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<>, Writes<Position>>("Move", [](float) {});
+    scheduler.AddSystem<Reads<Position>>("Draw", [](float) {});
+    scheduler.Run(0.0f);
+    EXPECT_EQ(scheduler.GetLevelCount(), 2u);
+
+    EXPECT_TRUE(scheduler.RemoveSystem("Move"));
+    EXPECT_FALSE(scheduler.RemoveSystem("Move"));
+    scheduler.Run(0.0f);
+
+    EXPECT_EQ(scheduler.GetLevelCount(), 1u);
+    EXPECT_TRUE(scheduler.GetSystems()[0].Dependencies.empty());
+}
+
+TEST(SystemScheduler, ParallelLevelRunsEverySystemOnce)
+{
+    JobSystem::Init(2);
+
+    std::atomic<uint32_t> runs = 0;
+
+    SystemScheduler scheduler;
+    scheduler.AddSystem<Reads<Position>>("A", [&runs](float) { runs++; });
+    scheduler.AddSystem<Reads<Position>>("B", [&runs](float) { runs++; });
+    scheduler.AddSystem<Reads<Position>>("C", [&runs](float) { runs++; }, SystemFlags::MainThread);
+    scheduler.AddSystem<Reads<Position>>("D", [&runs](float) { runs++; });
+    scheduler.Run(0.0f);
+
+    JobSystem::Shutdown();
+
+    EXPECT_EQ(scheduler.GetLevelCount(), 1u);
+    EXPECT_EQ(runs.load(), 4u);
+}
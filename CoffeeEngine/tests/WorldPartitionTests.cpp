@@ -0,0 +1,178 @@
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneSaveTask.h"
+#include "CoffeeEngine/Scene/WorldPartition.h"
+
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace Coffee;
+
+namespace {
+
+    // The entities of a scene with a tag, streamed ones included
+    uint32_t CountTagged(Scene& scene, const std::string& tag)
+    {
+        uint32_t count = 0;
+        auto view = scene.GetAllEntitiesWithComponents<TagComponent>();
+        for (auto entity : view)
+        {
+            if (view.get<TagComponent>(entity).Tag == tag)
+                count++;
+        }
+        return count;
+    }
+
+    // A root with a mesh in its subtree is streamed. The mesh is left empty so no GPU resource is needed.
+    void CreateStreamedRoot(Scene& scene, const std::string& name, const glm::vec3& position)
+    {
+        Entity root = scene.CreateEntity(name);
+        root.GetComponent<TransformComponent>().Position = position;
+
+        Entity child = scene.CreateEntity(name + "Mesh");
+        child.AddComponent<MeshComponent>(Ref<Mesh>());
+        child.SetParent(root);
+    }
+
+    struct PartitionFiles
+    {
+        PartitionFiles(const std::string& fileName = "CoffeeEngineTests.Partition.TeaScene")
+            : ScenePath(std::filesystem::temp_directory_path() / fileName) { Remove(); }
+        ~PartitionFiles() { Remove(); }
+
+        void Remove()
+        {
+            std::error_code error;
+            std::filesystem::remove(ScenePath, error);
+            std::filesystem::remove_all(WorldPartition::GetDirectory(ScenePath), error);
+        }
+
+        std::filesystem::path ScenePath;
+    };
+
+}
+
+TEST(WorldPartition, BuildOpenAndStreamTheSectors)
+{
+    PartitionFiles files;
+
+    Ref<Scene> scene = CreateRef<Scene>();
+    scene->CreateEntity("Persistent");
+    CreateStreamedRoot(*scene, "Near", {10.0f, 10.0f, 10.0f});
+    CreateStreamedRoot(*scene, "Far", {1010.0f, 10.0f, 10.0f});
+    ASSERT_TRUE(Scene::Save(files.ScenePath, scene));
+
+    ASSERT_TRUE(scene->GetWorldPartition().Build(files.ScenePath, 100.0f));
+    EXPECT_EQ(scene->GetWorldPartition().GetSectorCount(), 2u);
+    EXPECT_EQ(CountTagged(*scene, "Near"), 0u);
+    EXPECT_EQ(CountTagged(*scene, "Persistent"), 1u);
+
+    // The scene file was saved without the streamed entities, opening it does not duplicate them
+    Ref<Scene> loaded = Scene::Load(files.ScenePath);
+    WorldPartition& partition = loaded->GetWorldPartition();
+    ASSERT_TRUE(partition.IsOpen());
+    EXPECT_EQ(partition.GetSectorCount(), 2u);
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 0u);
+    EXPECT_EQ(CountTagged(*loaded, "Persistent"), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "Near"), 0u);
+
+    // The first update requests the near sector and the next one adds it to the registry
+    partition.Update({0.0f, 0.0f, 0.0f});
+    partition.Update({0.0f, 0.0f, 0.0f});
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "Near"), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "NearMesh"), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "Far"), 0u);
+
+    // Far from the near sector it is unloaded and the far one takes its place
+    partition.Update({1000.0f, 0.0f, 0.0f});
+    partition.Update({1000.0f, 0.0f, 0.0f});
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "Near"), 0u);
+    EXPECT_EQ(CountTagged(*loaded, "NearMesh"), 0u);
+    EXPECT_EQ(CountTagged(*loaded, "Far"), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "Persistent"), 1u);
+
+    // The loaded sectors come back with their hierarchy
+    auto view = loaded->GetAllEntitiesWithComponents<TagComponent, HierarchyComponent>();
+    for (auto entity : view)
+    {
+        if (view.get<TagComponent>(entity).Tag == "FarMesh")
+        {
+            entt::entity parent = view.get<HierarchyComponent>(entity).m_Parent;
+            ASSERT_NE(parent, entt::null);
+            EXPECT_EQ(Entity(parent, loaded.get()).GetComponent<TagComponent>().Tag, "Far");
+        }
+    }
+
+    partition.UnloadAll();
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 0u);
+    EXPECT_EQ(CountTagged(*loaded, "Far"), 0u);
+}
+
+TEST(WorldPartition, CopyingTheSceneKeepsTheLoadedSectors)
+{
+    PartitionFiles files;
+
+    Ref<Scene> scene = CreateRef<Scene>();
+    scene->CreateEntity("Persistent");
+    CreateStreamedRoot(*scene, "Near", {10.0f, 10.0f, 10.0f});
+    ASSERT_TRUE(scene->GetWorldPartition().Build(files.ScenePath, 100.0f));
+
+    scene->GetWorldPartition().Update({0.0f, 0.0f, 0.0f});
+    scene->GetWorldPartition().Update({0.0f, 0.0f, 0.0f});
+    ASSERT_EQ(scene->GetWorldPartition().GetLoadedSectorCount(), 1u);
+
+    // The edited scene is left as it was, the copy streams the sector on its own
+    Ref<Scene> copy = Scene::Copy(scene);
+    EXPECT_EQ(scene->GetWorldPartition().GetLoadedSectorCount(), 1u);
+    EXPECT_EQ(CountTagged(*scene, "Near"), 1u);
+
+    EXPECT_EQ(CountTagged(*copy, "Persistent"), 1u);
+    EXPECT_EQ(CountTagged(*copy, "Near"), 0u);
+    EXPECT_EQ(CountTagged(*copy, "NearMesh"), 0u);
+
+    copy->GetWorldPartition().Update({0.0f, 0.0f, 0.0f});
+    copy->GetWorldPartition().Update({0.0f, 0.0f, 0.0f});
+    EXPECT_EQ(CountTagged(*copy, "Near"), 1u);
+    EXPECT_EQ(CountTagged(*scene, "Near"), 1u);
+}
+
+TEST(WorldPartition, SavingKeepsTheLoadedSectors)
+{
+    PartitionFiles files;
+    PartitionFiles otherFiles("CoffeeEngineTests.PartitionCopy.TeaScene");
+
+    Ref<Scene> scene = CreateRef<Scene>();
+    scene->CreateEntity("Persistent");
+    CreateStreamedRoot(*scene, "Near", {10.0f, 10.0f, 10.0f});
+    ASSERT_TRUE(scene->GetWorldPartition().Build(files.ScenePath, 100.0f));
+
+    WorldPartition& partition = scene->GetWorldPartition();
+    partition.Update({0.0f, 0.0f, 0.0f});
+    partition.Update({0.0f, 0.0f, 0.0f});
+    ASSERT_EQ(partition.GetLoadedSectorCount(), 1u);
+
+    // The loaded sector stays in the scene and out of its file
+    ASSERT_TRUE(Scene::Save(files.ScenePath, scene));
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 1u);
+    EXPECT_EQ(CountTagged(*scene, "Near"), 1u);
+    EXPECT_EQ(CountTagged(*Scene::Load(files.ScenePath), "Near"), 0u);
+
+    Ref<SceneSaveTask> task = Scene::SaveAsync(files.ScenePath, scene);
+    task->Wait();
+    EXPECT_TRUE(task->Succeeded());
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 1u);
+    EXPECT_EQ(CountTagged(*Scene::Load(files.ScenePath), "Near"), 0u);
+
+    // Saved somewhere else, the sectors are copied next to the new file
+    ASSERT_TRUE(Scene::Save(otherFiles.ScenePath, scene));
+    EXPECT_EQ(partition.GetPath(), WorldPartition::GetDirectory(otherFiles.ScenePath));
+    EXPECT_EQ(partition.GetLoadedSectorCount(), 1u);
+
+    Ref<Scene> loaded = Scene::Load(otherFiles.ScenePath);
+    EXPECT_EQ(loaded->GetWorldPartition().GetSectorCount(), 1u);
+    EXPECT_EQ(CountTagged(*loaded, "Near"), 0u);
+}
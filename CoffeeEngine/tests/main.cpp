@@ -0,0 +1,12 @@
+#include "CoffeeEngine/Core/Log.h"
+
+#include <gtest/gtest.h>
+
+int main(int argc, char** argv)
+{
+    // The engine reports its warnings and errors through the core logger
+    Coffee::Log::Init();
+
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}